@@ -1,5 +1,6 @@
 #include "BackgroundWidget.h"
 #include <QPainter>
+#include <QResizeEvent>
 
 BackgroundWidget::BackgroundWidget(QWidget *parent)
     : QWidget(parent)
@@ -10,12 +11,27 @@ BackgroundWidget::BackgroundWidget(QWidget *parent)
 void BackgroundWidget::setBackground(const QPixmap &pix)
 {
     m_pixmap = pix;
+    m_scaledPixmap = QPixmap();
     update();
 }
 
+void BackgroundWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_scaledPixmap = QPixmap();
+}
+
 void BackgroundWidget::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
-    if (!m_pixmap.isNull())
-        painter.drawPixmap(rect(), m_pixmap);
+    if (m_pixmap.isNull())
+        return;
+    const qreal dpr = devicePixelRatioF();
+    const QSize deviceSize = (QSizeF(size()) * dpr).toSize();
+    if (m_scaledPixmap.isNull() || m_scaledPixmap.size() != deviceSize) {
+        // 只在尺寸或DPR变化时缩放一次，之后的重绘直接贴图
+        m_scaledPixmap = m_pixmap.scaled(deviceSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        m_scaledPixmap.setDevicePixelRatio(dpr);
+    }
+    painter.drawPixmap(0, 0, m_scaledPixmap);
 } 
\ No newline at end of file
@@ -13,9 +13,11 @@ public:
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
 private:
     QPixmap m_pixmap;
+    QPixmap m_scaledPixmap; // 按当前尺寸和DPR预缩放的缓存，尺寸变化时失效
 };
 
 #endif // BACKGROUNDWIDGET_H 
\ No newline at end of file
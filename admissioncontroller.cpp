@@ -0,0 +1,254 @@
+#include "admissioncontroller.h"
+#include "appconfig.h"
+#include "processcontrol.h"
+#include "logcategories.h"
+#include <algorithm>
+
+AdmissionController *AdmissionController::instance()
+{
+    static AdmissionController *controller = new AdmissionController();
+    return controller;
+}
+
+AdmissionController::AdmissionController()
+{
+    opts = configuredOptions();
+    pollTimer.setInterval(2000);
+    connect(&pollTimer, &QTimer::timeout, this, &AdmissionController::poll);
+}
+
+AdmissionController::Options AdmissionController::configuredOptions()
+{
+    Options options;
+    options.enabled = AppConfig::boolValue("Admission", "Enabled", true);
+    options.budgetMB = qMax(0, AppConfig::intValue("Admission", "BudgetMB", 0));
+    options.reserveMB = qMax(0, AppConfig::intValue("Admission", "ReserveMB", 1024));
+    const QString preempt = AppConfig::value("Admission", "Preempt", "suspend").trimmed().toLower();
+    if (preempt == "off" || preempt == "false") options.preempt = PreemptMode::Off;
+    else if (preempt == "lower") options.preempt = PreemptMode::LowerPriority;
+    return options;
+}
+
+QString AdmissionController::priorityName(Priority priority)
+{
+    switch (priority) {
+    case Priority::Background: return QStringLiteral("background");
+    case Priority::Interactive: return QStringLiteral("interactive");
+    default: return QStringLiteral("normal");
+    }
+}
+
+double AdmissionController::estimatePeakMB(const QString &kind, const QList<QPair<double, double>> &history, double dataMB)
+{
+    double estimate = 0.0;
+    int used = 0;
+    for (const QPair<double, double> &sample : history) {
+        if (sample.second <= 0.0) continue;
+        double scaled = sample.second;
+        // 内存大体随输入数据量增长；缩放倍数限制在1/4到4倍，避免一次异常数据带偏
+        if (sample.first > 0.0 && dataMB > 0.0) scaled *= qBound(0.25, dataMB / sample.first, 4.0);
+        estimate = qMax(estimate, scaled);
+        if (++used >= 5) break;
+    }
+    if (used > 0) return estimate * 1.1;
+    // 没有历史：训练/迁移学习按输入的8倍加1GB，预测按4倍加512MB
+    if (kind == "predict") return 512.0 + 4.0 * dataMB;
+    return 1024.0 + 8.0 * dataMB;
+}
+
+void AdmissionController::setOptions(const Options &options)
+{
+    opts = options;
+    applyPreemption();
+    poll();
+}
+
+double AdmissionController::committedMB() const
+{
+    double total = 0.0;
+    for (const Entry &entry : running) total += entry.estimateMB;
+    return total;
+}
+
+double AdmissionController::outstandingMB() const
+{
+    // MemAvailable已经扣掉了正在运行的作业实际用到的部分，只需再扣它们还没用到的部分
+    double total = 0.0;
+    for (const Entry &entry : running) {
+        const double used = entry.pid > 0 ? ProcessControl::peakMemoryMB(entry.pid) : 0.0;
+        total += qMax(0.0, entry.estimateMB - used);
+    }
+    return total;
+}
+
+bool AdmissionController::fits(const Entry &entry, QString *reason) const
+{
+    if (!opts.enabled || running.isEmpty()) {
+        // 没有其他作业可等：估计值超过整机内存也只能直接运行
+        return true;
+    }
+    if (opts.budgetMB > 0.0 && committedMB() + entry.estimateMB > opts.budgetMB) {
+        if (reason) *reason = tr("memory budget %1 MB, %2 MB committed").arg(opts.budgetMB, 0, 'f', 0).arg(committedMB(), 0, 'f', 0);
+        return false;
+    }
+    const double available = ProcessControl::availableMemoryMB();
+    if (available < 0.0) return true;
+    const double usable = available - opts.reserveMB - outstandingMB();
+    if (entry.estimateMB > usable) {
+        if (reason) *reason = tr("%1 MB available").arg(qMax(0.0, usable), 0, 'f', 0);
+        return false;
+    }
+    return true;
+}
+
+int AdmissionController::submit(const QString &label, double estimateMB, Callback onAdmitted, Priority priority)
+{
+    Pending pending;
+    pending.entry.ticket = nextTicket++;
+    pending.entry.label = label;
+    pending.entry.estimateMB = estimateMB;
+    pending.entry.since = QDateTime::currentDateTime();
+    pending.entry.priority = priority;
+    pending.callback = std::move(onAdmitted);
+    const int ticket = pending.entry.ticket;
+    // 排到同优先级作业的后面、低优先级作业的前面
+    int position = 0;
+    while (position < waiting.size() && waiting.at(position).entry.priority >= priority) ++position;
+    if (position == 0 && fits(pending.entry)) {
+        admit(std::move(pending));
+    } else {
+        qCInfo(lcWorker) << "[AdmissionController] Queued" << label << "estimate" << estimateMB << "MB, priority" << int(priority);
+        waiting.insert(position, std::move(pending));
+        pollTimer.start();
+        emit queueChanged();
+    }
+    return ticket;
+}
+
+void AdmissionController::admit(Pending pending)
+{
+    qCDebug(lcWorker) << "[AdmissionController] Admitted" << pending.entry.label << "estimate" << pending.entry.estimateMB << "MB";
+    running << pending.entry;
+    const int ticket = pending.entry.ticket;
+    Callback callback = std::move(pending.callback);
+    // 回调里可能进入嵌套事件循环（训练等待Worker），不在poll或submit的调用栈里执行
+    QTimer::singleShot(0, this, [callback, ticket]() { if (callback) callback(ticket); });
+    applyPreemption();
+    emit queueChanged();
+}
+
+void AdmissionController::attachProcess(int ticket, qint64 pid)
+{
+    for (Entry &entry : running) {
+        if (entry.ticket == ticket) entry.pid = pid;
+    }
+    applyPreemption();
+}
+
+bool AdmissionController::setPaused(int ticket, bool paused)
+{
+    for (Entry &entry : running) {
+        if (entry.ticket != ticket) continue;
+        entry.paused = paused;
+        applyPreemption();
+        emit queueChanged();
+        return true;
+    }
+    for (Pending &pending : waiting) {
+        if (pending.entry.ticket != ticket) continue;
+        pending.entry.paused = paused;
+        emit queueChanged();
+        poll();
+        return true;
+    }
+    return false;
+}
+
+void AdmissionController::setAllPaused(bool paused)
+{
+    for (Entry &entry : running) entry.paused = paused;
+    for (Pending &pending : waiting) pending.entry.paused = paused;
+    applyPreemption();
+    emit queueChanged();
+    poll();
+}
+
+void AdmissionController::applyPreemption()
+{
+    // 有未暂停的交互式作业在跑，其他作业都给它让路
+    const bool interactive = opts.preempt != PreemptMode::Off
+        && std::any_of(running.begin(), running.end(), [](const Entry &entry) {
+               return entry.priority == Priority::Interactive && !entry.paused;
+           });
+    for (Entry &entry : running) {
+        entry.preempted = interactive && entry.priority < Priority::Interactive;
+        const bool suspend = entry.paused || (entry.preempted && opts.preempt == PreemptMode::Suspend);
+        const bool lower = !suspend && entry.preempted && opts.preempt == PreemptMode::LowerPriority;
+        if (suspend && entry.pid > 0 && suspendedPids.value(entry.ticket) != entry.pid) {
+            if (ProcessControl::suspendTree(entry.pid)) suspendedPids.insert(entry.ticket, entry.pid);
+        } else if (!suspend && suspendedPids.contains(entry.ticket)) {
+            const qint64 pid = suspendedPids.take(entry.ticket);
+            if (pid == entry.pid) ProcessControl::resumeTree(pid);
+        }
+        if (lower && entry.pid > 0 && loweredPids.value(entry.ticket) != entry.pid) {
+            if (ProcessControl::setTreeLowPriority(entry.pid, true)) loweredPids.insert(entry.ticket, entry.pid);
+        } else if (!lower && loweredPids.contains(entry.ticket)) {
+            const qint64 pid = loweredPids.take(entry.ticket);
+            if (pid == entry.pid && !ProcessControl::setTreeLowPriority(pid, false)) {
+                qCWarning(lcWorker) << "[AdmissionController] Could not restore CPU priority of" << entry.label << "(needs privileges)";
+            }
+        }
+    }
+}
+
+void AdmissionController::release(int ticket)
+{
+    if (ticket <= 0) return;
+    const auto isTicket = [ticket](const Entry &entry) { return entry.ticket == ticket; };
+    // 作业可能在暂停状态下结束（被取消），先让它继续，免得留下停着的进程
+    if (suspendedPids.contains(ticket)) ProcessControl::resumeTree(suspendedPids.take(ticket));
+    loweredPids.remove(ticket);
+    running.erase(std::remove_if(running.begin(), running.end(), isTicket), running.end());
+    waiting.erase(std::remove_if(waiting.begin(), waiting.end(), [ticket](const Pending &p) { return p.entry.ticket == ticket; }),
+                  waiting.end());
+    applyPreemption();
+    emit queueChanged();
+    poll();
+}
+
+void AdmissionController::poll()
+{
+    // 手动暂停的排队作业跳过，不挡后面的作业
+    for (int i = 0; i < waiting.size();) {
+        if (waiting.at(i).entry.paused) {
+            ++i;
+            continue;
+        }
+        if (!fits(waiting.at(i).entry)) break;
+        admit(waiting.takeAt(i));
+    }
+    if (waiting.isEmpty()) pollTimer.stop();
+}
+
+QList<AdmissionController::Entry> AdmissionController::waitingEntries() const
+{
+    QList<Entry> entries;
+    for (const Pending &pending : waiting) entries << pending.entry;
+    return entries;
+}
+
+bool AdmissionController::isWaiting(int ticket) const
+{
+    return std::any_of(waiting.begin(), waiting.end(), [ticket](const Pending &p) { return p.entry.ticket == ticket; });
+}
+
+QString AdmissionController::waitReason() const
+{
+    for (const Pending &pending : waiting) {
+        if (pending.entry.paused) continue;
+        QString reason;
+        fits(pending.entry, &reason);
+        return tr("%1 needs ~%2 MB (%3)").arg(pending.entry.label).arg(pending.entry.estimateMB, 0, 'f', 0).arg(reason);
+    }
+    return QString();
+}
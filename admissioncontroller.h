@@ -0,0 +1,106 @@
+#ifndef ADMISSIONCONTROLLER_H
+#define ADMISSIONCONTROLLER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QTimer>
+#include <functional>
+
+// 子进程启动前的内存准入：每个作业带一个峰值内存估计申请准入，
+// 与已准入作业尚未用到的估计量一起对照MemAvailable（减去预留）和config.ini里的总预算，
+// 放不下就按先后顺序排队，定时复查，内存释放后再依次启动。
+// 只有排在最前的作业能被准入，大作业不会被后来的小作业一直插队。
+// 作业带优先级：队列按优先级排，同级先来先准入；交互式作业（预测）运行期间，
+// 低优先级作业的进程树被暂停（或调低CPU优先级），结束后继续，进度不丢。
+// 用户也可以手动暂停/继续单个作业，暂停的排队作业不参与准入
+class AdmissionController : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Priority { Background, Normal, Interactive };
+    // 交互式作业运行时怎么让出CPU
+    enum class PreemptMode { Off, Suspend, LowerPriority };
+
+    struct Options {
+        bool enabled = true;
+        double budgetMB = 0.0;     // 所有已准入作业估计值之和的上限，0表示只看MemAvailable
+        double reserveMB = 1024.0; // 给系统和界面留的余量
+        PreemptMode preempt = PreemptMode::Suspend;
+    };
+
+    struct Entry {
+        int ticket = 0;
+        QString label;
+        double estimateMB = 0.0;
+        qint64 pid = 0;            // 已启动的子进程（进程组长），用来扣除已经用到的内存
+        QDateTime since;
+        Priority priority = Priority::Normal;
+        bool paused = false;       // 用户手动暂停
+        bool preempted = false;    // 正在给交互式作业让路
+    };
+
+    using Callback = std::function<void(int ticket)>;
+
+    static AdmissionController *instance();
+    static Options configuredOptions(); // config.ini的[Admission]节
+    static QString priorityName(Priority priority); // "background"/"normal"/"interactive"，控制接口和作业菜单里用
+
+    // 峰值内存估计：history为过去同类作业的(数据量MB, 峰值MB)，按当前数据量线性缩放，
+    // 取最近几次中的最大值再留10%余量；没有历史时按数据量给保守估计
+    static double estimatePeakMB(const QString &kind, const QList<QPair<double, double>> &history, double dataMB);
+
+    void setOptions(const Options &options);
+    const Options &options() const { return opts; }
+
+    // 申请准入，返回票号。onAdmitted总是从事件循环里异步调用（可立即准入时也一样）
+    int submit(const QString &label, double estimateMB, Callback onAdmitted, Priority priority = Priority::Normal);
+    // 子进程换了（如第一步结束开始第二步）也要再调用，正在让路或暂停的作业会立即暂停新进程
+    void attachProcess(int ticket, qint64 pid);
+    // 作业结束，或撤回还在排队的申请
+    void release(int ticket);
+    // 手动暂停/继续：运行中的暂停进程树，排队中的不再准入
+    bool setPaused(int ticket, bool paused);
+    void setAllPaused(bool paused);
+
+    QList<Entry> waitingEntries() const;
+    QList<Entry> runningEntries() const { return running; }
+    bool isWaiting(int ticket) const;
+    // 排在最前的作业为什么还在等，给状态栏显示
+    QString waitReason() const;
+
+signals:
+    void queueChanged();
+
+private slots:
+    void poll();
+
+private:
+    struct Pending {
+        Entry entry;
+        Callback callback;
+    };
+
+    AdmissionController();
+
+    Options opts;
+    QList<Pending> waiting;
+    QList<Entry> running;
+    QTimer pollTimer;
+    int nextTicket = 1;
+    QHash<int, qint64> suspendedPids; // 票号 -> 已暂停的进程
+    QHash<int, qint64> loweredPids;   // 票号 -> 已调低优先级的进程
+
+    double committedMB() const;   // 已准入作业的估计值之和
+    double outstandingMB() const; // 已准入作业还没用到的估计量
+    bool fits(const Entry &entry, QString *reason = nullptr) const;
+    void admit(Pending pending);
+    // 按手动暂停和交互式作业的运行情况暂停/继续各作业的进程
+    void applyPreemption();
+};
+
+#endif // ADMISSIONCONTROLLER_H
@@ -0,0 +1,45 @@
+#include "nodeagent.h"
+#include "appconfig.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDebug>
+
+// 计算节点agent：在其他Linux主机上运行，由界面端通过config.ini的[Cluster]节连接
+// 例：Demo01_agent --menet /opt/MENET --listen 10.0.0.5 --port 47820 --slots 2 --token <与界面端[Cluster] Token相同>
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Demo01_agent");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("MENET training agent");
+    parser.addHelpOption();
+    QCommandLineOption menetOption("menet", "MENET directory containing the exe files and data.", "dir",
+                                   QDir::currentPath() + "/MENET");
+    QCommandLineOption listenOption("listen", "Address to bind the TCP port to; a non-loopback address requires a token.",
+                                    "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "TCP port, 0 disables TCP.", "port", "47820");
+    QCommandLineOption socketOption("socket", "Also listen on this Unix socket path.", "path");
+    QCommandLineOption slotsOption("slots", "Number of jobs to run at the same time.", "n", "1");
+    QCommandLineOption tokenOption("token", "Shared secret the dispatcher must send; defaults to [Cluster] Token in config.ini.",
+                                   "token", AppConfig::value("Cluster", "Token"));
+    parser.addOptions({menetOption, listenOption, portOption, socketOption, slotsOption, tokenOption});
+    parser.process(app);
+
+    NodeAgent::Options options;
+    options.menetDir = QDir(parser.value(menetOption)).absolutePath();
+    options.bindAddress = parser.value(listenOption);
+    options.port = quint16(parser.value(portOption).toUInt());
+    options.socketPath = parser.value(socketOption);
+    options.maxJobs = parser.value(slotsOption).toInt();
+    options.token = parser.value(tokenOption);
+
+    NodeAgent agent(options);
+    QString error;
+    if (!agent.start(&error)) {
+        qCritical().noquote() << "Agent failed to start:" << error;
+        return 1;
+    }
+    return app.exec();
+}
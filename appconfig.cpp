@@ -0,0 +1,73 @@
+#include "appconfig.h"
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+
+QString AppConfig::path()
+{
+    return QDir::currentPath() + "/config.ini";
+}
+
+// 整个文件只解析一次，之后的查询都是哈希表查找；键为 "section/key"（小写）
+static QMutex configMutex;
+static QHash<QString, QString> configEntries;
+static bool configLoaded = false;
+
+static void loadLocked()
+{
+    configEntries.clear();
+    configLoaded = true;
+    QFile f(AppConfig::path());
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+    QString currentSection = "general";
+    while (!f.atEnd()) {
+        const QString line = QString::fromUtf8(f.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith(';')) continue;
+        if (line.startsWith('[') && line.endsWith(']')) {
+            currentSection = line.mid(1, line.size() - 2).trimmed().toLower();
+            continue;
+        }
+        const int eq = line.indexOf('=');
+        if (eq <= 0) continue;
+        const QString key = currentSection + "/" + line.left(eq).trimmed().toLower();
+        // 与原先逐行查找一致：同名键以第一次出现为准
+        if (!configEntries.contains(key)) configEntries.insert(key, line.mid(eq + 1).trimmed());
+    }
+}
+
+void AppConfig::reload()
+{
+    QMutexLocker locker(&configMutex);
+    loadLocked();
+}
+
+QString AppConfig::value(const QString &section, const QString &key, const QString &defaultValue)
+{
+    QMutexLocker locker(&configMutex);
+    if (!configLoaded) loadLocked();
+    return configEntries.value(section.toLower() + "/" + key.toLower(), defaultValue);
+}
+
+bool AppConfig::boolValue(const QString &section, const QString &key, bool defaultValue)
+{
+    const QString v = value(section, key).toLower();
+    if (v.isEmpty()) return defaultValue;
+    return v == "true" || v == "1" || v == "yes" || v == "on";
+}
+
+int AppConfig::intValue(const QString &section, const QString &key, int defaultValue)
+{
+    bool ok = false;
+    const int v = value(section, key).toInt(&ok);
+    return ok ? v : defaultValue;
+}
+
+QStringList AppConfig::listValue(const QString &section, const QString &key)
+{
+    QStringList items;
+    for (const QString &item : value(section, key).split(',')) {
+        if (!item.trimmed().isEmpty()) items << item.trimmed();
+    }
+    return items;
+}
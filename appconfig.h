@@ -0,0 +1,22 @@
+#ifndef APPCONFIG_H
+#define APPCONFIG_H
+
+#include <QString>
+#include <QStringList>
+
+// 读取程序目录下的config.ini。按文本逐行解析，不经过QSettings：
+// 支持 [Section] 分节和 Key=Value，键名不区分大小写，#和;开头为注释。
+// 文件在第一次查询时解析一次并缓存，修改后调用reload()
+class AppConfig
+{
+public:
+    static QString value(const QString &section, const QString &key, const QString &defaultValue = QString());
+    static bool boolValue(const QString &section, const QString &key, bool defaultValue = false);
+    static int intValue(const QString &section, const QString &key, int defaultValue = 0);
+    // 逗号分隔的列表，去掉空项
+    static QStringList listValue(const QString &section, const QString &key);
+    static QString path();
+    static void reload();
+};
+
+#endif // APPCONFIG_H
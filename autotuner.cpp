@@ -0,0 +1,360 @@
+#include "autotuner.h"
+#include "trialworkspace.h"
+#include "metricparser.h"
+#include "phenotypeconfig.h"
+#include "processcontrol.h"
+#include "resourcecontrol.h"
+#include "logcategories.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+
+AutoTuner::AutoTuner(QObject *parent) : QObject(parent)
+{
+    pollTimer.setInterval(250);
+    connect(&pollTimer, &QTimer::timeout, this, &AutoTuner::poll);
+}
+
+AutoTuner::~AutoTuner()
+{
+    if (process && process->state() != QProcess::NotRunning) {
+        process->disconnect(this);
+        ProcessControl::terminateTree(*process, 2000);
+    }
+}
+
+bool AutoTuner::start(const Options &options, QString *error)
+{
+    if (running) {
+        if (error) *error = tr("Calibration is already running");
+        return false;
+    }
+    if (options.batchSizes.isEmpty() || options.threadCounts.isEmpty()) {
+        if (error) *error = tr("No batch sizes or thread counts to probe");
+        return false;
+    }
+    opts = options;
+    probeList.clear();
+    // 同一线程数下按batch size从小到大跑，超出内存上限后更大的batch直接跳过
+    QList<int> threads = opts.threadCounts;
+    QList<int> batches = opts.batchSizes;
+    std::sort(threads.begin(), threads.end());
+    std::sort(batches.begin(), batches.end());
+    for (int t : threads) {
+        for (int b : batches) {
+            Probe probe;
+            probe.batchSize = b;
+            probe.threads = t;
+            probeList << probe;
+        }
+    }
+    workDir = opts.menetDir + QString("/tuning/%1_%2").arg(opts.phenotype, QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+    QString prepareError;
+    if (!TrialWorkspace::prepare(opts.menetDir, workDir, &prepareError)) {
+        if (error) *error = prepareError;
+        return false;
+    }
+    qCInfo(lcWorker) << "[AutoTuner] Calibrating" << opts.phenotype << "with" << probeList.size() << "probes in" << workDir;
+    running = true;
+    current = -1;
+    if (opts.runStep1) launchStep1();
+    else launchNext();
+    return true;
+}
+
+void AutoTuner::cancel()
+{
+    if (!running) return;
+    for (int i = 0; i < probeList.size(); ++i) {
+        if (probeList[i].state == ProbeState::Pending) {
+            probeList[i].state = ProbeState::Cancelled;
+            emit probeUpdated(i);
+        }
+    }
+    if (current >= 0) {
+        probeList[current].state = ProbeState::Cancelled;
+        emit probeUpdated(current);
+    }
+    if (process) {
+        stopping = true;
+        ProcessControl::terminateTreeAsync(process);
+    } else {
+        finish();
+    }
+}
+
+void AutoTuner::launchStep1()
+{
+    process = new QProcess(this);
+    process->setWorkingDirectory(workDir);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    process->setStandardOutputFile(workDir + "/step1_output.txt");
+    ResourceControl::instance()->prepareProcess(*process, "autotune");
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this](int exitCode, QProcess::ExitStatus status) { onProcessFinished(exitCode, status); });
+    connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError err) {
+        if (err == QProcess::FailedToStart) onProcessFinished(-1, QProcess::CrashExit);
+    });
+    qCDebug(lcWorker) << "[AutoTuner] Running generate_genetic_relatedness.exe once before probing";
+    process->start(workDir + "/generate_genetic_relatedness.exe", QStringList() << "--phenotype" << opts.phenotype);
+}
+
+void AutoTuner::launchNext()
+{
+    current = -1;
+    for (int i = 0; i < probeList.size(); ++i) {
+        if (probeList[i].state == ProbeState::Pending) {
+            current = i;
+            break;
+        }
+    }
+    if (current < 0) {
+        finish();
+        return;
+    }
+    Probe &probe = probeList[current];
+    TrialWorkspace::updatePhenotypeConfig(workDir, "MeNet.json", opts.phenotype, QJsonObject{{"batch size", probe.batchSize}});
+    const QString logPath = workDir + "/step2.log";
+    QFile::remove(logPath);
+    follower.reset(logPath);
+    firstEpoch = lastEpoch = -1;
+    firstEpochMs = lastEpochMs = -1;
+    stopping = false;
+
+    process = new QProcess(this);
+    process->setWorkingDirectory(workDir);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    process->setStandardOutputFile(workDir + "/step2_output.txt");
+    ProcessControl::setThreadEnvironment(*process, probe.threads);
+    ResourceControl::instance()->prepareProcess(*process, "autotune");
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this](int exitCode, QProcess::ExitStatus status) { onProcessFinished(exitCode, status); });
+    connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError err) {
+        if (err == QProcess::FailedToStart) onProcessFinished(-1, QProcess::CrashExit);
+    });
+    probe.state = ProbeState::Running;
+    qCDebug(lcWorker) << "[AutoTuner] Probe batch" << probe.batchSize << "threads" << probe.threads;
+    timer.start();
+    process->start(workDir + "/train_menet.exe", QStringList() << "--phenotype" << opts.phenotype);
+    pollTimer.start();
+    emit probeUpdated(current);
+}
+
+void AutoTuner::readEpochs()
+{
+    const qint64 now = timer.elapsed();
+    for (const QString &line : follower.readNewLines()) {
+        EpochMetrics metrics;
+        if (!parseEpochMetrics(line, metrics)) continue;
+        if (firstEpoch < 0) {
+            firstEpoch = metrics.epoch;
+            firstEpochMs = now;
+        }
+        lastEpoch = metrics.epoch;
+        lastEpochMs = now;
+    }
+    Probe &probe = probeList[current];
+    probe.seconds = now / 1000.0;
+    probe.epochs = firstEpoch < 0 ? 0 : lastEpoch - firstEpoch + 1;
+    // 第一个epoch含进程启动和数据加载，吞吐从第一个到最后一个epoch之间计算；只有一个epoch时退而用总时长
+    if (lastEpoch > firstEpoch && lastEpochMs > firstEpochMs) {
+        probe.epochsPerSec = (lastEpoch - firstEpoch) * 1000.0 / (lastEpochMs - firstEpochMs);
+    } else if (firstEpoch >= 0 && firstEpochMs > 0) {
+        probe.epochsPerSec = 1000.0 / firstEpochMs;
+    }
+}
+
+void AutoTuner::poll()
+{
+    if (current < 0 || !process || stopping) return;
+    Probe &probe = probeList[current];
+    readEpochs();
+    if (process->state() == QProcess::Running) {
+        probe.peakMB = qMax(probe.peakMB, ProcessControl::peakMemoryMB(process->processId()));
+    }
+    if (opts.memoryCapMB > 0 && probe.peakMB > opts.memoryCapMB) {
+        probe.state = ProbeState::OverMemory;
+        probe.note = tr("Peak memory %1 MB exceeds the %2 MB cap").arg(probe.peakMB, 0, 'f', 0).arg(opts.memoryCapMB);
+        stopping = true;
+        ProcessControl::terminateTreeAsync(process);
+    } else if (timer.elapsed() >= qint64(opts.probeSeconds) * 1000) {
+        stopping = true;
+        ProcessControl::terminateTreeAsync(process);
+    }
+    emit probeUpdated(current);
+}
+
+void AutoTuner::onProcessFinished(int exitCode, QProcess::ExitStatus status)
+{
+    pollTimer.stop();
+    if (process) {
+        process->deleteLater();
+        process = nullptr;
+    }
+    const bool ok = status == QProcess::NormalExit && exitCode == 0;
+    if (current < 0) {
+        // 第一步
+        emit step1Finished(ok);
+        if (!ok) {
+            for (Probe &probe : probeList) {
+                if (probe.state == ProbeState::Pending) {
+                    probe.state = ProbeState::Failed;
+                    probe.note = tr("generate_genetic_relatedness.exe failed");
+                }
+            }
+            finish();
+            return;
+        }
+        if (running && std::any_of(probeList.begin(), probeList.end(), [](const Probe &p) { return p.state == ProbeState::Pending; })) {
+            QTimer::singleShot(0, this, &AutoTuner::launchNext);
+        } else {
+            finish();
+        }
+        return;
+    }
+    Probe &probe = probeList[current];
+    readEpochs();
+    if (probe.state == ProbeState::Running) {
+        // 到时被终止或自然跑完都算完成，只要窗口内测到了epoch
+        if (probe.epochs > 0) {
+            probe.state = ProbeState::Done;
+        } else {
+            probe.state = ProbeState::Failed;
+            probe.note = (stopping || ok) ? tr("No epoch completed within %1 s").arg(opts.probeSeconds)
+                                          : tr("train_menet.exe failed (exit code %1)").arg(exitCode);
+        }
+    }
+    if (probe.state == ProbeState::OverMemory) {
+        // 内存随batch size增长，同一线程数下更大的batch不必再试
+        for (Probe &other : probeList) {
+            if (other.state == ProbeState::Pending && other.threads == probe.threads && other.batchSize > probe.batchSize) {
+                other.state = ProbeState::Skipped;
+                other.note = tr("Larger than a batch that exceeded the memory cap");
+            }
+        }
+    }
+    qCDebug(lcWorker) << "[AutoTuner] Probe finished: batch" << probe.batchSize << "threads" << probe.threads
+                      << "epochs/s" << probe.epochsPerSec << "peak MB" << probe.peakMB << probe.note;
+    emit probeUpdated(current);
+    for (int i = 0; i < probeList.size(); ++i) {
+        if (probeList[i].state == ProbeState::Skipped) emit probeUpdated(i);
+    }
+    QTimer::singleShot(0, this, &AutoTuner::launchNext);
+}
+
+void AutoTuner::finish()
+{
+    if (!running) return;
+    running = false;
+    current = -1;
+    pollTimer.stop();
+    TrialWorkspace::remove(workDir);
+    const int best = bestIndex();
+    // 中途停止的网格不完整，不覆盖已保存的结果
+    if (best >= 0 && !wasCancelled()) {
+        Profile profile;
+        profile.batchSize = probeList.at(best).batchSize;
+        profile.threads = probeList.at(best).threads;
+        profile.epochsPerSec = probeList.at(best).epochsPerSec;
+        profile.peakMB = probeList.at(best).peakMB;
+        profile.sizeClass = sizeClassFor(opts.menetDir, opts.phenotype);
+        profile.measuredAt = QDateTime::currentDateTime().toString(Qt::ISODate);
+        QString error;
+        if (!store(opts.menetDir, profile, &error)) qCWarning(lcWorker) << "[AutoTuner] Unable to store tuning:" << error;
+    }
+    qCInfo(lcWorker) << "[AutoTuner] Calibration finished, best probe" << best;
+    emit finished();
+}
+
+int AutoTuner::bestIndex() const
+{
+    int best = -1;
+    for (int i = 0; i < probeList.size(); ++i) {
+        const Probe &probe = probeList.at(i);
+        if (probe.state != ProbeState::Done || probe.epochsPerSec <= 0.0) continue;
+        if (opts.memoryCapMB > 0 && probe.peakMB > opts.memoryCapMB) continue;
+        if (best < 0 || probe.epochsPerSec > probeList.at(best).epochsPerSec) best = i;
+    }
+    return best;
+}
+
+bool AutoTuner::wasCancelled() const
+{
+    return std::any_of(probeList.begin(), probeList.end(), [](const Probe &p) { return p.state == ProbeState::Cancelled; });
+}
+
+QString AutoTuner::sizeClassFor(const QString &menetDir, const QString &phenotype)
+{
+    QDir phenDir(menetDir + "/data/phen");
+    QFileInfo phenFile;
+    for (const QFileInfo &info : phenDir.entryInfoList(QStringList() << phenotype + ".*", QDir::Files)) {
+        if (info.completeBaseName() == phenotype) {
+            phenFile = info;
+            break;
+        }
+    }
+    if (!phenFile.exists()) return QString("unknown");
+    auto bucket = [](qint64 value, qint64 minimum) {
+        qint64 bound = minimum;
+        while (bound < value) bound *= 2;
+        return bound;
+    };
+    if (phenFile.suffix().toLower() == "csv") {
+        // csv按样本行数归档
+        QFile file(phenFile.absoluteFilePath());
+        if (file.open(QIODevice::ReadOnly)) {
+            qint64 rows = 0;
+            while (!file.atEnd()) {
+                const QByteArray chunk = file.read(1024 * 1024);
+                rows += chunk.count('\n');
+            }
+            return QString("rows<=%1").arg(bucket(rows, 256));
+        }
+    }
+    return QString("bytes<=%1").arg(bucket(phenFile.size(), 64 * 1024));
+}
+
+QString AutoTuner::tuningPath(const QString &menetDir)
+{
+    return menetDir + "/tuning.json";
+}
+
+AutoTuner::Profile AutoTuner::lookup(const QString &menetDir, const QString &phenotype)
+{
+    Profile profile;
+    if (!QFile::exists(tuningPath(menetDir))) return profile;
+    const QString sizeClass = sizeClassFor(menetDir, phenotype);
+    const QJsonObject entry = PhenotypeConfig::load(tuningPath(menetDir))
+                                  .value(QSysInfo::machineHostName()).toObject()
+                                  .value(sizeClass).toObject();
+    profile.batchSize = entry.value("batch size").toInt();
+    profile.threads = entry.value("threads").toInt();
+    profile.epochsPerSec = entry.value("epochs_per_sec").toDouble();
+    profile.peakMB = entry.value("peak_mb").toDouble();
+    profile.measuredAt = entry.value("measured_at").toString();
+    profile.sizeClass = sizeClass;
+    return profile;
+}
+
+bool AutoTuner::store(const QString &menetDir, const Profile &profile, QString *error)
+{
+    // tuning.json: {主机名: {规模档: {"batch size", "threads", ...}}}，多台机器可共用同一个MENET目录
+    QJsonObject root = PhenotypeConfig::load(tuningPath(menetDir));
+    const QString host = QSysInfo::machineHostName();
+    QJsonObject hostObj = root.value(host).toObject();
+    QJsonObject entry;
+    entry["batch size"] = profile.batchSize;
+    entry["threads"] = profile.threads;
+    entry["epochs_per_sec"] = profile.epochsPerSec;
+    entry["peak_mb"] = profile.peakMB;
+    entry["measured_at"] = profile.measuredAt;
+    entry["cores"] = QThread::idealThreadCount();
+    hostObj[profile.sizeClass] = entry;
+    root[host] = hostObj;
+    return PhenotypeConfig::save(tuningPath(menetDir), root, error);
+}
@@ -0,0 +1,102 @@
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QProcess>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include "logfollower.h"
+
+// 本机校准：在隔离目录里按 batch size × 线程数 的网格逐个短时运行train_menet，
+// 测每秒epoch数和峰值内存，选内存上限内吞吐最高的组合，
+// 按主机名和表型规模档存进MENET/tuning.json，参数弹窗据此给出默认值。
+// 探测逐个串行运行，互不抢核，测得的吞吐才可比
+class AutoTuner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class ProbeState { Pending, Running, Done, OverMemory, Failed, Skipped, Cancelled };
+
+    struct Probe {
+        int batchSize = 0;
+        int threads = 0;
+        ProbeState state = ProbeState::Pending;
+        double epochsPerSec = 0.0;
+        double peakMB = 0.0;
+        int epochs = 0;           // 探测窗口内完成的epoch数
+        double seconds = 0.0;
+        QString note;
+    };
+
+    struct Options {
+        QString menetDir;
+        QString phenotype;
+        QList<int> batchSizes;
+        QList<int> threadCounts;
+        int probeSeconds = 90;     // 每个探测的时长
+        int memoryCapMB = 0;       // 0表示不限制
+        bool runStep1 = false;     // 先在探测目录里跑一次generate_genetic_relatedness.exe
+    };
+
+    // 存进tuning.json的结果
+    struct Profile {
+        int batchSize = 0;
+        int threads = 0;
+        double epochsPerSec = 0.0;
+        double peakMB = 0.0;
+        QString sizeClass;
+        QString measuredAt;
+        bool isValid() const { return batchSize > 0; }
+    };
+
+    explicit AutoTuner(QObject *parent = nullptr);
+    ~AutoTuner();
+
+    bool start(const Options &options, QString *error = nullptr);
+    void cancel();
+    bool isRunning() const { return running; }
+    const QVector<Probe> &probes() const { return probeList; }
+    int bestIndex() const; // 内存上限内吞吐最高的探测，没有时返回-1
+    bool wasCancelled() const; // 中途被停止，结果不会保存
+
+    // 表型规模档：按表型文件的行数（csv）或大小取2的幂向上归档，如 "rows<=2048"
+    static QString sizeClassFor(const QString &menetDir, const QString &phenotype);
+    static QString tuningPath(const QString &menetDir);
+    // 本机、该表型规模档的校准结果；没有时返回无效Profile
+    static Profile lookup(const QString &menetDir, const QString &phenotype);
+    static bool store(const QString &menetDir, const Profile &profile, QString *error = nullptr);
+
+signals:
+    void probeUpdated(int index);
+    void step1Finished(bool ok);
+    void finished();
+
+private slots:
+    void poll();
+
+private:
+    Options opts;
+    QVector<Probe> probeList;
+    QString workDir;
+    QProcess *process = nullptr;
+    QElapsedTimer timer;
+    LogFollower follower;
+    QTimer pollTimer;
+    int current = -1;          // 正在运行的探测，-1表示第一步或空闲
+    bool running = false;
+    bool stopping = false;     // 探测到时或超内存，已发终止信号
+    qint64 firstEpochMs = -1, lastEpochMs = -1;
+    int firstEpoch = -1, lastEpoch = -1;
+
+    void launchStep1();
+    void launchNext();
+    void readEpochs();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus status);
+    void finish();
+};
+
+#endif // AUTOTUNER_H
@@ -0,0 +1,423 @@
+// Demo01_bench：编排核心的微基准。
+// 环境变量：BENCH_MAX_MB   合成日志的最大尺寸（MB，默认64，1024时包含1 GB用例）
+//           BENCH_JSON     结果json的路径（默认当前目录下bench_results.json）
+// 其余命令行参数原样交给QtTest，例如 Demo01_bench lastEpochInLog -iterations 10
+#include <QtTest>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <climits>
+#include "logindex.h"
+#include "metricparser.h"
+#include "pathutils.h"
+#include "phenotypeconfig.h"
+#include "progresschannel.h"
+
+namespace {
+
+const QList<int> kLogSizesMB = {1, 16, 256, 1024};
+const int kConfigPhenotypes = 10000;
+const int kPathCount = 100000;
+
+int maxLogMB()
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue("BENCH_MAX_MB", &ok);
+    return ok && value > 0 ? value : 64;
+}
+
+// 与train_menet的输出格式一致：epoch行之间夹着进度输出，末尾是保存模型的提示
+bool writeSyntheticLog(const QString &path, qint64 megabytes)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    const qint64 target = megabytes * 1024 * 1024;
+    QByteArray block;
+    int epoch = 0;
+    while (file.size() < target) {
+        block.clear();
+        while (block.size() < 1024 * 1024) {
+            for (int batch = 0; batch < 8; ++batch) {
+                block += "batch " + QByteArray::number(batch) + "/8 loss = " + QByteArray::number(0.5 + batch * 0.01, 'f', 4) + "\n";
+            }
+            block += "epoch = " + QByteArray::number(epoch) + ", loss = " + QByteArray::number(0.9 / (epoch + 1), 'f', 6)
+                   + ", train_R2 = " + QByteArray::number(0.6 + (epoch % 100) * 0.001, 'f', 6)
+                   + ", val_R2 = " + QByteArray::number(0.5 + (epoch % 100) * 0.001, 'f', 6) + "\n";
+            ++epoch;
+        }
+        if (file.write(block) != block.size()) return false;
+    }
+    file.write("saving best model to saved/bench_menet.pt\nfinished\n");
+    return true;
+}
+
+// 旧实现：逐行读完整个日志，作为对照
+int forwardScanLastEpoch(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return -1;
+    int lastEpoch = -1;
+    QTextStream in(&f);
+    static const QRegularExpression re("epoch = (\\d+)");
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        const auto match = re.match(line);
+        if (match.hasMatch()) lastEpoch = match.captured(1).toInt();
+    }
+    return lastEpoch;
+}
+
+} // namespace
+
+class BenchCore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void lastEpochInLog_data();
+    void lastEpochInLog();
+    void forwardScanBaseline_data();
+    void forwardScanBaseline();
+    void lastEpochMetrics_data();
+    void lastEpochMetrics();
+    void logIndexBuild_data();
+    void logIndexBuild();
+    void logIndexLookup_data();
+    void logIndexLookup();
+
+    void configLoad();
+    void configSave();
+    void configUpdateSaved();
+
+    void chinesePathDetection();
+
+    void uploadCopy_data();
+    void uploadCopy();
+
+    void progressChannelPublish();
+
+private:
+    QTemporaryDir workDir;
+    QMap<int, QString> logPaths; // MB -> 合成日志
+    QString configPath;
+    QJsonObject configRoot;
+    QStringList paths;
+
+    void addLogRows(int limitMB);
+};
+
+void BenchCore::initTestCase()
+{
+    QVERIFY(workDir.isValid());
+    const int limit = maxLogMB();
+    for (int mb : kLogSizesMB) {
+        if (mb > limit) continue;
+        const QString path = workDir.filePath(QString("step2_%1MB.log").arg(mb));
+        QVERIFY2(writeSyntheticLog(path, mb), qPrintable("cannot write " + path));
+        logPaths.insert(mb, path);
+    }
+
+    // 与MeNet.json同样的结构，kConfigPhenotypes个表型
+    for (int i = 0; i < kConfigPhenotypes; ++i) {
+        QJsonObject pheno;
+        pheno["batch size"] = 128;
+        pheno["p1"] = 0.8;
+        pheno["p2"] = 0.8;
+        pheno["p3"] = 0.8;
+        pheno["p4"] = 0.6;
+        pheno["saved"] = 100;
+        pheno["wd"] = 1e-5;
+        configRoot[QString("trait_%1").arg(i)] = pheno;
+    }
+    configPath = workDir.filePath("MeNet.json");
+    QVERIFY(PhenotypeConfig::save(configPath, configRoot));
+
+    paths.reserve(kPathCount);
+    for (int i = 0; i < kPathCount; ++i) {
+        // 每100条里有1条含中文，其余为常见的英文工程路径
+        paths << (i % 100 == 0 ? QString("D:\\工作\\MMNET_%1\\data\\phen").arg(i)
+                               : QString("C:\\Users\\lab\\Projects\\MMNET_%1\\MENET\\data\\phen\\trait.csv").arg(i));
+    }
+}
+
+void BenchCore::addLogRows(int limitMB)
+{
+    QTest::addColumn<QString>("path");
+    for (auto it = logPaths.constBegin(); it != logPaths.constEnd(); ++it) {
+        if (it.key() > limitMB) continue;
+        QTest::newRow(qPrintable(QString("%1MB").arg(it.key()))) << it.value();
+    }
+}
+
+void BenchCore::lastEpochInLog_data()
+{
+    addLogRows(INT_MAX);
+}
+
+void BenchCore::lastEpochInLog()
+{
+    QFETCH(QString, path);
+    int epoch = -1;
+    QBENCHMARK {
+        epoch = ::lastEpochInLog(path);
+    }
+    QVERIFY(epoch > 0);
+}
+
+void BenchCore::forwardScanBaseline_data()
+{
+    // 整读对照组最多跑到256 MB，否则单个用例要几分钟
+    addLogRows(256);
+}
+
+void BenchCore::forwardScanBaseline()
+{
+    QFETCH(QString, path);
+    int epoch = -1;
+    QBENCHMARK_ONCE {
+        epoch = forwardScanLastEpoch(path);
+    }
+    QCOMPARE(epoch, ::lastEpochInLog(path));
+}
+
+void BenchCore::lastEpochMetrics_data()
+{
+    addLogRows(INT_MAX);
+}
+
+void BenchCore::lastEpochMetrics()
+{
+    QFETCH(QString, path);
+    EpochMetrics metrics;
+    bool ok = false;
+    QBENCHMARK {
+        ok = ::lastEpochMetrics(path, metrics);
+    }
+    QVERIFY(ok);
+    QVERIFY(metrics.values.contains("val_R2"));
+}
+
+void BenchCore::logIndexBuild_data()
+{
+    addLogRows(INT_MAX);
+}
+
+void BenchCore::logIndexBuild()
+{
+    QFETCH(QString, path);
+    QBENCHMARK_ONCE {
+        QString error;
+        QVERIFY2(LogIndex::build(path, &error), qPrintable(error));
+    }
+    LogIndex index;
+    QVERIFY(index.open(path, false));
+    QCOMPARE(index.epochAt(index.epochCount() - 1), ::lastEpochInLog(path));
+}
+
+void BenchCore::logIndexLookup_data()
+{
+    addLogRows(INT_MAX);
+}
+
+void BenchCore::logIndexLookup()
+{
+    // 打开索引、查中间一个epoch的val_R2、seek读出原文：与日志大小无关
+    QFETCH(QString, path);
+    QVERIFY(LogIndex::build(path));
+    const int epoch = ::lastEpochInLog(path) / 2;
+    double value = qQNaN();
+    QString line;
+    QBENCHMARK {
+        LogIndex index;
+        QVERIFY(index.open(path, false));
+        value = index.value("val_R2", epoch);
+        line = index.lineAt(epoch);
+    }
+    EpochMetrics metrics;
+    QVERIFY(parseEpochMetrics(line, metrics));
+    QCOMPARE(metrics.epoch, epoch);
+    QCOMPARE(metrics.values.value("val_R2"), value);
+}
+
+void BenchCore::configLoad()
+{
+    QJsonObject root;
+    QBENCHMARK {
+        root = PhenotypeConfig::load(configPath);
+    }
+    QCOMPARE(root.size(), kConfigPhenotypes);
+}
+
+void BenchCore::configSave()
+{
+    const QString path = workDir.filePath("MeNet_save.json");
+    QBENCHMARK {
+        QVERIFY(PhenotypeConfig::save(path, configRoot));
+    }
+}
+
+void BenchCore::configUpdateSaved()
+{
+    const QString path = workDir.filePath("MeNet_update.json");
+    QVERIFY(PhenotypeConfig::save(path, configRoot));
+    int saved = 0;
+    QBENCHMARK {
+        QVERIFY(PhenotypeConfig::updateSaved(path, "trait_5000", ++saved));
+    }
+}
+
+void BenchCore::chinesePathDetection()
+{
+    int hits = 0;
+    QBENCHMARK {
+        hits = 0;
+        for (const QString &path : std::as_const(paths)) {
+            if (PathUtils::containsChineseCharacters(path)) ++hits;
+        }
+    }
+    QCOMPARE(hits, kPathCount / 100);
+}
+
+void BenchCore::uploadCopy_data()
+{
+    QTest::addColumn<int>("megabytes");
+    for (int mb : {1, 16, 64}) {
+        if (mb > maxLogMB()) continue;
+        QTest::newRow(qPrintable(QString("%1MB").arg(mb))) << mb;
+    }
+}
+
+void BenchCore::uploadCopy()
+{
+    QFETCH(int, megabytes);
+    const QString source = workDir.filePath(QString("upload_%1MB.csv").arg(megabytes));
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        const QByteArray row = "sample_0001,0.123456,1.234567,2.345678\n";
+        QByteArray block;
+        while (block.size() < 1024 * 1024) block += row;
+        for (int i = 0; i < megabytes; ++i) file.write(block);
+    }
+    const QString target = workDir.filePath(QString("phen/upload_%1MB.csv").arg(megabytes));
+    QDir().mkpath(QFileInfo(target).absolutePath());
+    QBENCHMARK {
+        QString error;
+        QVERIFY2(PathUtils::copyReplacing(source, target, &error), qPrintable(error));
+    }
+    QCOMPARE(QFileInfo(target).size(), QFileInfo(source).size());
+}
+
+void BenchCore::progressChannelPublish()
+{
+    // 一万个epoch发布后界面取一帧：衡量工作线程侧的开销和一次取用的代价
+    ProgressChannel channel;
+    channel.begin("trait_0");
+    EpochMetrics metrics;
+    metrics.values.insert("train_R2", 0.6);
+    metrics.values.insert("val_R2", 0.5);
+    QList<EpochMetrics> epochs;
+    QBENCHMARK {
+        for (int epoch = 0; epoch < 10000; ++epoch) {
+            metrics.epoch = epoch;
+            channel.publishEpoch(metrics);
+            channel.setPercent(epoch / 100);
+        }
+        epochs.clear();
+        ProgressSnapshot snapshot;
+        channel.consume(&snapshot, &epochs);
+    }
+    QCOMPARE(epochs.size(), 10000);
+}
+
+// QtTest的csv输出：函数名,标签,指标,每次迭代的值,总值,迭代次数
+static QStringList splitCsvLine(const QString &line)
+{
+    QStringList fields;
+    QString current;
+    bool quoted = false;
+    for (const QChar ch : line) {
+        if (ch == '"') {
+            quoted = !quoted;
+        } else if (ch == ',' && !quoted) {
+            fields << current;
+            current.clear();
+        } else {
+            current += ch;
+        }
+    }
+    fields << current;
+    return fields;
+}
+
+static bool writeJsonReport(const QString &csvPath, const QString &jsonPath)
+{
+    QFile csv(csvPath);
+    if (!csv.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    QJsonArray results;
+    while (!csv.atEnd()) {
+        const QStringList fields = splitCsvLine(QString::fromUtf8(csv.readLine()).trimmed());
+        if (fields.size() < 6) continue;
+        bool valueOk = false;
+        const double value = fields.at(3).toDouble(&valueOk);
+        if (!valueOk) continue;
+        QJsonObject result;
+        result["case"] = fields.at(0);
+        result["tag"] = fields.at(1);
+        result["metric"] = fields.at(2);
+        result["value"] = value;
+        result["total"] = fields.at(4).toDouble();
+        result["iterations"] = fields.at(5).toInt();
+        results.append(result);
+    }
+    QJsonObject report;
+    report["generated"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["qt_version"] = QString::fromLatin1(qVersion());
+    report["build_abi"] = QSysInfo::buildAbi();
+    report["os"] = QSysInfo::prettyProductName();
+    report["host"] = QSysInfo::machineHostName();
+    report["max_log_mb"] = maxLogMB();
+    report["results"] = results;
+    QSaveFile out(jsonPath);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+    return out.commit();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QString jsonPath = qEnvironmentVariable("BENCH_JSON", QDir::current().filePath("bench_results.json"));
+    QTemporaryFile csv(QDir::temp().filePath("Demo01_bench_XXXXXX.csv"));
+    if (!csv.open()) {
+        qCritical() << "[Demo01_bench] Cannot create temporary csv:" << csv.errorString();
+        return 2;
+    }
+    csv.close();
+    // 控制台照常输出文本结果，同时写一份csv供转换成json
+    QStringList args = app.arguments();
+    args << "-o" << csv.fileName() + ",csv" << "-o" << "-,txt";
+    BenchCore bench;
+    const int rc = QTest::qExec(&bench, args);
+    if (writeJsonReport(csv.fileName(), jsonPath)) {
+        qInfo().noquote() << "[Demo01_bench] Results written to" << jsonPath;
+    } else {
+        qWarning().noquote() << "[Demo01_bench] Failed to write" << jsonPath;
+    }
+    return rc;
+}
+
+#include "bench_core.moc"
@@ -0,0 +1,111 @@
+#include "clusterdialog.h"
+#include "clusterdispatcher.h"
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+static QString jobStateText(ClusterDispatcher::JobState state)
+{
+    switch (state) {
+    case ClusterDispatcher::JobState::Pending: return QObject::tr("Pending");
+    case ClusterDispatcher::JobState::Assigned: return QObject::tr("Assigned");
+    case ClusterDispatcher::JobState::Running: return QObject::tr("Running");
+    case ClusterDispatcher::JobState::Done: return QObject::tr("Done");
+    case ClusterDispatcher::JobState::Failed: return QObject::tr("Failed");
+    case ClusterDispatcher::JobState::Cancelled: return QObject::tr("Cancelled");
+    }
+    return QString();
+}
+
+static QTableWidget *makeTable(const QStringList &headers, QWidget *parent)
+{
+    QTableWidget *table = new QTableWidget(parent);
+    table->setColumnCount(headers.size());
+    table->setHorizontalHeaderLabels(headers);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    return table;
+}
+
+ClusterDialog::ClusterDialog(ClusterDispatcher *dispatcher, QWidget *parent) : QDialog(parent), dispatcher(dispatcher)
+{
+    setWindowTitle(tr("Cluster"));
+    resize(900, 650);
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    mainLayout->addWidget(new QLabel(tr("Nodes"), this));
+    nodeTable = makeTable({tr("Address"), tr("Host"), tr("Status"), tr("Slots"), tr("Running"), tr("Load"), tr("Last seen")}, this);
+    mainLayout->addWidget(nodeTable, 1);
+
+    mainLayout->addWidget(new QLabel(tr("Jobs"), this));
+    jobTable = makeTable({tr("Phenotype"), tr("Node"), tr("Status"), tr("Progress"), tr("Attempts"), tr("Message")}, this);
+    mainLayout->addWidget(jobTable, 1);
+
+    mainLayout->addWidget(new QLabel(tr("Remote log"), this));
+    logView = new QPlainTextEdit(this);
+    logView->setReadOnly(true);
+    logView->setMaximumBlockCount(2000);
+    mainLayout->addWidget(logView, 1);
+
+    QPushButton *btnClose = new QPushButton(tr("Close"), this);
+    QHBoxLayout *btnRow = new QHBoxLayout();
+    btnRow->addStretch();
+    btnRow->addWidget(btnClose);
+    mainLayout->addLayout(btnRow);
+    setLayout(mainLayout);
+
+    connect(btnClose, &QPushButton::clicked, this, &QDialog::accept);
+    connect(dispatcher, &ClusterDispatcher::nodesChanged, this, &ClusterDialog::refreshNodes);
+    connect(dispatcher, &ClusterDispatcher::jobUpdated, this, &ClusterDialog::refreshJobs);
+    connect(dispatcher, &ClusterDispatcher::jobLog, this, &ClusterDialog::appendLog);
+    refreshNodes();
+    refreshJobs();
+}
+
+void ClusterDialog::refreshNodes()
+{
+    if (!dispatcher) return;
+    const QVector<ClusterDispatcher::Node> &nodes = dispatcher->nodes();
+    nodeTable->setRowCount(nodes.size());
+    for (int row = 0; row < nodes.size(); ++row) {
+        const ClusterDispatcher::Node &node = nodes[row];
+        const QString status = node.healthy ? tr("Healthy") : node.error.isEmpty() ? tr("Connecting") : tr("Down (%1)").arg(node.error);
+        const QStringList cells = {
+            node.address, node.host, status,
+            node.healthy ? QString::number(node.maxJobs) : QString(),
+            node.healthy ? QString::number(qMax(node.assigned, node.running)) : QString(),
+            node.healthy ? QString::number(node.load, 'f', 2) : QString(),
+            node.lastSeen.isValid() ? node.lastSeen.toString("HH:mm:ss") : QString()
+        };
+        for (int col = 0; col < cells.size(); ++col) nodeTable->setItem(row, col, new QTableWidgetItem(cells[col]));
+    }
+}
+
+void ClusterDialog::refreshJobs()
+{
+    if (!dispatcher) return;
+    const QVector<ClusterDispatcher::Job> &jobs = dispatcher->jobs();
+    const QVector<ClusterDispatcher::Node> &nodes = dispatcher->nodes();
+    jobTable->setRowCount(jobs.size());
+    for (int row = 0; row < jobs.size(); ++row) {
+        const ClusterDispatcher::Job &job = jobs[row];
+        const QString node = job.node >= 0 && job.node < nodes.size() ? nodes[job.node].address : QString();
+        const QStringList cells = {
+            job.spec.phenotype, node, jobStateText(job.state),
+            QString("%1%").arg(job.percent), QString::number(job.attempts), job.message
+        };
+        for (int col = 0; col < cells.size(); ++col) jobTable->setItem(row, col, new QTableWidgetItem(cells[col]));
+    }
+}
+
+void ClusterDialog::appendLog(const QString &phenotype, const QStringList &lines)
+{
+    for (const QString &line : lines) logView->appendPlainText(QString("[%1] %2").arg(phenotype, line));
+}
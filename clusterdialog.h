@@ -0,0 +1,31 @@
+#ifndef CLUSTERDIALOG_H
+#define CLUSTERDIALOG_H
+
+#include <QDialog>
+#include <QPointer>
+
+class ClusterDispatcher;
+class QPlainTextEdit;
+class QTableWidget;
+
+// 集群面板：节点健康状态、任务分配和远端日志
+class ClusterDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ClusterDialog(ClusterDispatcher *dispatcher, QWidget *parent = nullptr);
+
+private slots:
+    void refreshNodes();
+    void refreshJobs();
+    void appendLog(const QString &phenotype, const QStringList &lines);
+
+private:
+    QPointer<ClusterDispatcher> dispatcher;
+    QTableWidget *nodeTable;
+    QTableWidget *jobTable;
+    QPlainTextEdit *logView;
+};
+
+#endif // CLUSTERDIALOG_H
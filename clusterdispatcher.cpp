@@ -0,0 +1,428 @@
+#include "clusterdispatcher.h"
+#include "appconfig.h"
+#include "jsonlinechannel.h"
+#include "logcategories.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QUuid>
+
+static const int kReconnectIntervalMs = 10000;
+
+ClusterDispatcher::ClusterDispatcher(const QString &menetDir, QObject *parent) : QObject(parent), menetDir(menetDir)
+{
+    clock.start();
+    connect(&healthTimer, &QTimer::timeout, this, &ClusterDispatcher::checkHealth);
+    healthTimer.setInterval(kPingIntervalMs);
+}
+
+ClusterDispatcher::~ClusterDispatcher()
+{
+    for (Node &node : nodeList) {
+        if (!node.channel) continue;
+        node.channel->disconnect(this);
+        delete node.channel;
+        node.channel = nullptr;
+    }
+}
+
+QStringList ClusterDispatcher::configuredNodes()
+{
+    if (!AppConfig::boolValue("Cluster", "Enabled", false)) return QStringList();
+    return AppConfig::listValue("Cluster", "Nodes");
+}
+
+void ClusterDispatcher::setNodes(const QStringList &addresses)
+{
+    for (Node &node : nodeList) {
+        if (!node.channel) continue;
+        node.channel->disconnect(this);
+        node.channel->deleteLater();
+    }
+    nodeList.clear();
+    for (const QString &address : addresses) {
+        Node node;
+        node.address = address.trimmed();
+        if (!node.address.isEmpty()) nodeList << node;
+    }
+    for (int i = 0; i < nodeList.size(); ++i) connectNode(i);
+    if (nodeList.isEmpty()) healthTimer.stop();
+    else healthTimer.start();
+    emit nodesChanged();
+}
+
+void ClusterDispatcher::connectNode(int index)
+{
+    Node &node = nodeList[index];
+    if (node.channel) return;
+    node.lastAttemptMs = clock.elapsed();
+
+    QJsonObject hello;
+    hello["type"] = "hello";
+    hello["version"] = JsonLineChannel::kProtocolVersion;
+    // agent监听非本机地址时要求共享密钥
+    const QString token = AppConfig::value("Cluster", "Token");
+    if (!token.isEmpty()) hello["token"] = token;
+    JsonLineChannel *channel = nullptr;
+    if (node.address.startsWith("unix:")) {
+        QLocalSocket *socket = new QLocalSocket();
+        channel = new JsonLineChannel(socket, this);
+        connect(socket, &QLocalSocket::connected, channel, [channel, hello]() { channel->send(hello); });
+        socket->connectToServer(node.address.mid(5));
+    } else {
+        const int colon = node.address.lastIndexOf(':');
+        const QString host = colon > 0 ? node.address.left(colon) : node.address;
+        const quint16 port = colon > 0 ? node.address.mid(colon + 1).toUShort() : 47820;
+        QTcpSocket *socket = new QTcpSocket();
+        channel = new JsonLineChannel(socket, this);
+        connect(socket, &QTcpSocket::connected, channel, [channel, hello]() { channel->send(hello); });
+        socket->connectToHost(host, port);
+    }
+    node.channel = channel;
+    connect(channel, &JsonLineChannel::messageReceived, this, [this, index](const QJsonObject &message) {
+        handleMessage(index, message);
+    });
+    connect(channel, &JsonLineChannel::disconnected, this, [this, index, channel]() {
+        if (nodeList.value(index).channel != channel) return;
+        dropNode(index, "disconnected");
+    });
+}
+
+void ClusterDispatcher::dropNode(int index, const QString &reason)
+{
+    Node &node = nodeList[index];
+    if (node.channel) {
+        JsonLineChannel *channel = node.channel;
+        node.channel = nullptr;
+        channel->disconnect(this);
+        channel->close();
+        channel->deleteLater();
+    }
+    if (node.healthy) qCWarning(lcCluster) << "[ClusterDispatcher] Node" << node.address << "lost:" << reason;
+    node.healthy = false;
+    node.error = reason;
+    node.assigned = 0;
+    node.running = 0;
+
+    // 该节点上未完成的任务重新排队，超过重试次数的判为失败
+    bool requeued = false;
+    for (int i = 0; i < jobList.size(); ++i) {
+        Job &job = jobList[i];
+        if (job.node != index || (job.state != JobState::Assigned && job.state != JobState::Running)) continue;
+        QDir(stagingDir(job)).removeRecursively();
+        job.node = -1;
+        job.percent = 0;
+        if (job.attempts >= kMaxAttempts) {
+            finishJob(i, false, QString("Node %1 lost (%2), giving up after %3 attempts").arg(node.address, reason).arg(job.attempts));
+            continue;
+        }
+        qCInfo(lcCluster) << "[ClusterDispatcher] Requeueing" << job.spec.phenotype << "after losing" << node.address;
+        job.state = JobState::Pending;
+        job.message = QString("Requeued: node %1 lost").arg(node.address);
+        requeued = true;
+        emit jobUpdated(i);
+    }
+    emit nodesChanged();
+    if (requeued) schedule();
+}
+
+void ClusterDispatcher::checkHealth()
+{
+    const qint64 now = clock.elapsed();
+    const QDateTime current = QDateTime::currentDateTime();
+    for (int i = 0; i < nodeList.size(); ++i) {
+        Node &node = nodeList[i];
+        if (!node.channel) {
+            if (now - node.lastAttemptMs >= kReconnectIntervalMs) connectNode(i);
+            continue;
+        }
+        if (node.healthy && node.lastSeen.msecsTo(current) > kNodeTimeoutMs) {
+            dropNode(i, "no heartbeat");
+            continue;
+        }
+        if (!node.healthy && now - node.lastAttemptMs > kNodeTimeoutMs) {
+            // 连接一直没建立起来，放弃这次尝试，下个周期重连
+            dropNode(i, "connect timeout");
+            continue;
+        }
+        QJsonObject ping;
+        ping["type"] = "ping";
+        node.channel->send(ping);
+    }
+}
+
+int ClusterDispatcher::healthyNodeCount() const
+{
+    int count = 0;
+    for (const Node &node : nodeList) if (node.healthy) ++count;
+    return count;
+}
+
+bool ClusterDispatcher::isBusy() const
+{
+    for (const Job &job : jobList) {
+        if (job.state == JobState::Pending || job.state == JobState::Assigned || job.state == JobState::Running) return true;
+    }
+    return false;
+}
+
+int ClusterDispatcher::jobIndexById(const QString &id) const
+{
+    for (int i = 0; i < jobList.size(); ++i) if (jobList[i].id == id) return i;
+    return -1;
+}
+
+QString ClusterDispatcher::stagingDir(const Job &job) const
+{
+    return menetDir + "/jobs/cluster_" + job.id;
+}
+
+void ClusterDispatcher::submit(const QList<JobSpec> &specs)
+{
+    jobList.clear();
+    for (const JobSpec &spec : specs) {
+        Job job;
+        job.id = QUuid::createUuid().toString(QUuid::Id128).left(12);
+        job.spec = spec;
+        jobList << job;
+    }
+    qCInfo(lcCluster) << "[ClusterDispatcher] Submitted" << jobList.size() << "jobs to" << healthyNodeCount() << "healthy nodes";
+    schedule();
+}
+
+void ClusterDispatcher::schedule()
+{
+    for (int i = 0; i < jobList.size(); ++i) {
+        Job &job = jobList[i];
+        if (job.state != JobState::Pending) continue;
+
+        // 选空闲槽位最多的健康节点，槽位相同时选负载低的
+        int best = -1;
+        for (int n = 0; n < nodeList.size(); ++n) {
+            const Node &node = nodeList[n];
+            if (!node.healthy || !node.channel) continue;
+            const int free = node.maxJobs - qMax(node.assigned, node.running);
+            if (free <= 0) continue;
+            if (best < 0) { best = n; continue; }
+            const int bestFree = nodeList[best].maxJobs - qMax(nodeList[best].assigned, nodeList[best].running);
+            if (free > bestFree || (free == bestFree && node.load < nodeList[best].load)) best = n;
+        }
+        if (best < 0) return;
+
+        QByteArray phenData;
+        QFile phen(job.spec.phenFilePath);
+        if (!job.spec.phenFilePath.isEmpty()) {
+            if (!phen.open(QIODevice::ReadOnly)) {
+                finishJob(i, false, QString("Unable to read phenotype file %1").arg(job.spec.phenFilePath));
+                continue;
+            }
+            phenData = phen.readAll();
+        }
+        QJsonObject message;
+        message["type"] = "submit";
+        message["job"] = job.id;
+        message["phenotype"] = job.spec.phenotype;
+        message["repgeno"] = job.spec.repgeno;
+        message["menet"] = job.spec.menet;
+        message["early_stop"] = job.spec.earlyStop;
+        if (!phenData.isEmpty()) {
+            QJsonObject phenFile;
+            phenFile["name"] = QFileInfo(job.spec.phenFilePath).fileName();
+            phenFile["data"] = QString::fromLatin1(phenData.toBase64());
+            message["phen_file"] = phenFile;
+        }
+
+        Node &node = nodeList[best];
+        job.state = JobState::Assigned;
+        job.node = best;
+        job.attempts++;
+        job.percent = 0;
+        job.message = QString("Assigned to %1").arg(node.address);
+        node.assigned++;
+        node.channel->send(message);
+        qCDebug(lcCluster) << "[ClusterDispatcher] Job" << job.id << job.spec.phenotype << "->" << node.address << "attempt" << job.attempts;
+        emit jobUpdated(i);
+    }
+    emit nodesChanged();
+}
+
+void ClusterDispatcher::cancelAll()
+{
+    for (int i = 0; i < jobList.size(); ++i) {
+        Job &job = jobList[i];
+        if (job.state == JobState::Pending) {
+            job.state = JobState::Cancelled;
+            job.message = "Cancelled";
+            emit jobUpdated(i);
+            emit jobFinished(i);
+        } else if ((job.state == JobState::Assigned || job.state == JobState::Running) && job.node >= 0) {
+            // 等agent回报done后再结束，那时已取消的训练会带着失败消息回来
+            QJsonObject message;
+            message["type"] = "cancel";
+            message["job"] = job.id;
+            if (nodeList[job.node].channel) nodeList[job.node].channel->send(message);
+            job.message = "Cancelling...";
+            emit jobUpdated(i);
+        }
+    }
+    if (!isBusy()) emit allFinished();
+}
+
+void ClusterDispatcher::handleMessage(int nodeIndex, const QJsonObject &message)
+{
+    Node &node = nodeList[nodeIndex];
+    node.lastSeen = QDateTime::currentDateTime();
+    const QString type = message.value("type").toString();
+
+    if (type == "hello" || type == "pong") {
+        if (message.value("version").toInt() != JsonLineChannel::kProtocolVersion) {
+            dropNode(nodeIndex, QString("protocol version %1").arg(message.value("version").toInt()));
+            return;
+        }
+        const bool wasHealthy = node.healthy;
+        node.healthy = true;
+        node.error.clear();
+        node.host = message.value("host").toString();
+        node.maxJobs = message.value("slots").toInt(1);
+        node.running = message.value("running").toInt();
+        node.load = message.value("load").toDouble();
+        if (!wasHealthy) qCInfo(lcCluster) << "[ClusterDispatcher] Node" << node.address << "ready:" << node.host << "slots" << node.maxJobs;
+        emit nodesChanged();
+        if (!wasHealthy) schedule();
+        return;
+    }
+    if (type == "error") {
+        // token不对等连接级错误，agent随后会断开
+        dropNode(nodeIndex, message.value("reason").toString());
+        return;
+    }
+
+    const int jobIndex = jobIndexById(message.value("job").toString());
+    if (jobIndex < 0) return;
+    Job &job = jobList[jobIndex];
+    if (job.node != nodeIndex) return; // 已被重新分配的旧任务的迟到消息
+
+    if (type == "accepted") {
+        job.state = JobState::Running;
+        job.startedAt = QDateTime::currentDateTime();
+        job.message = QString("Running on %1").arg(node.host.isEmpty() ? node.address : node.host);
+        emit jobUpdated(jobIndex);
+    } else if (type == "rejected") {
+        const QString reason = message.value("reason").toString();
+        qCInfo(lcCluster) << "[ClusterDispatcher] Node" << node.address << "rejected" << job.spec.phenotype << reason;
+        node.assigned = qMax(0, node.assigned - 1);
+        job.node = -1;
+        if (reason == "busy") {
+            // 节点被别的调度端占满，不计入重试次数
+            job.attempts--;
+            job.state = JobState::Pending;
+            node.running = node.maxJobs;
+        } else if (job.attempts >= kMaxAttempts) {
+            finishJob(jobIndex, false, QString("Rejected by %1: %2").arg(node.address, reason));
+            return;
+        } else {
+            job.state = JobState::Pending;
+        }
+        job.message = QString("Rejected by %1: %2").arg(node.address, reason);
+        emit jobUpdated(jobIndex);
+        schedule();
+    } else if (type == "progress") {
+        job.percent = message.value("percent").toInt();
+        emit jobUpdated(jobIndex);
+    } else if (type == "epoch") {
+        EpochMetrics metrics;
+        metrics.epoch = message.value("epoch").toInt();
+        const QJsonObject values = message.value("values").toObject();
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) metrics.values.insert(it.key(), it.value().toDouble());
+        emit jobEpoch(job.spec.phenotype, metrics);
+    } else if (type == "early_stopped") {
+        job.stoppedEarly = true;
+    } else if (type == "log") {
+        QStringList lines;
+        for (const QJsonValue &value : message.value("lines").toArray()) lines << value.toString();
+        emit jobLog(job.spec.phenotype, lines);
+    } else if (type == "artifact") {
+        handleArtifact(job, message);
+    } else if (type == "done") {
+        node.assigned = qMax(0, node.assigned - 1);
+        node.running = qMax(0, node.running - 1);
+        job.seconds = message.value("seconds").toDouble();
+        job.step1Seconds = message.value("step1_seconds").toDouble();
+        job.step2Seconds = message.value("step2_seconds").toDouble();
+        bool ok = message.value("ok").toBool();
+        QString text = message.value("message").toString();
+        const QString staging = stagingDir(job);
+        if (ok) {
+            // 全部产物到齐后才替换正式文件，半截的模型不会覆盖旧模型
+            const QString model = staging + "/model";
+            const QString target = menetDir + QString("/saved/%1_menet.pt").arg(job.spec.phenotype);
+            QDir().mkpath(menetDir + "/saved");
+            if (!QFile::exists(model)) {
+                ok = false;
+                text = "Model artifact missing";
+            } else {
+                QFile::remove(target);
+                if (!QFile::rename(model, target)) {
+                    ok = false;
+                    text = QString("Unable to move model to %1").arg(target);
+                }
+            }
+            const QString curve = staging + "/pca_curve";
+            if (QFile::exists(curve)) {
+                const QString curveTarget = menetDir + QString("/%1_pca_curve.png").arg(job.spec.phenotype);
+                QFile::remove(curveTarget);
+                QFile::rename(curve, curveTarget);
+            }
+        }
+        if (QFile::exists(staging + "/step2_log")) {
+            job.logPath = staging + "/step2.log";
+            QFile::remove(job.logPath);
+            QFile::rename(staging + "/step2_log", job.logPath);
+        }
+        finishJob(jobIndex, ok, text);
+        schedule();
+    }
+}
+
+void ClusterDispatcher::handleArtifact(Job &job, const QJsonObject &message)
+{
+    static const QStringList known = {"model", "pca_curve", "step2_log"};
+    const QString name = message.value("name").toString();
+    if (!known.contains(name)) return;
+    const QString dir = stagingDir(job);
+    QDir().mkpath(dir);
+    const qint64 offset = qint64(message.value("offset").toDouble());
+    const QString partPath = dir + "/" + name + ".part";
+    QFile part(partPath);
+    const QIODevice::OpenMode mode = offset == 0 ? (QIODevice::WriteOnly | QIODevice::Truncate) : (QIODevice::ReadWrite);
+    if (!part.open(mode) || part.size() != offset) {
+        qCWarning(lcCluster) << "[ClusterDispatcher] Artifact" << name << "of job" << job.id << "out of order at" << offset;
+        return;
+    }
+    part.seek(offset);
+    part.write(QByteArray::fromBase64(message.value("data").toString().toLatin1()));
+    const qint64 size = qint64(message.value("size").toDouble());
+    const bool complete = message.value("last").toBool() && part.size() == size;
+    part.close();
+    if (complete) {
+        QFile::remove(dir + "/" + name);
+        QFile::rename(partPath, dir + "/" + name);
+    }
+}
+
+void ClusterDispatcher::finishJob(int jobIndex, bool ok, const QString &message)
+{
+    Job &job = jobList[jobIndex];
+    job.state = ok ? JobState::Done : JobState::Failed;
+    job.ok = ok;
+    job.node = job.state == JobState::Done ? job.node : -1;
+    job.percent = ok ? 100 : job.percent;
+    job.message = message;
+    qCInfo(lcCluster) << "[ClusterDispatcher] Job" << job.id << job.spec.phenotype << (ok ? "done" : "failed") << message;
+    emit jobUpdated(jobIndex);
+    emit jobFinished(jobIndex);
+    if (!isBusy()) emit allFinished();
+}
@@ -0,0 +1,111 @@
+#ifndef CLUSTERDISPATCHER_H
+#define CLUSTERDISPATCHER_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include "metricparser.h"
+
+class JsonLineChannel;
+
+// 界面端的调度器：连接config.ini [Cluster] Nodes= 中列出的agent，
+// 按空闲槽位分配表型训练任务，监控节点健康，节点掉线时把任务重新排队
+class ClusterDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kMaxAttempts = 3;       // 同一任务最多尝试次数（节点丢失后重试）
+    static constexpr int kPingIntervalMs = 5000;
+    static constexpr int kNodeTimeoutMs = 15000; // 超过这么久没有任何消息视为节点丢失
+
+    struct Node {
+        QString address;          // "host:port" 或 "unix:/path/to/socket"
+        QString host;             // agent上报的主机名
+        int maxJobs = 0;
+        int running = 0;
+        int assigned = 0;         // 本调度器分配到该节点、尚未结束的任务数
+        double load = 0.0;
+        bool healthy = false;
+        QDateTime lastSeen;
+        QString error;
+        JsonLineChannel *channel = nullptr;
+        qint64 lastAttemptMs = -1;
+    };
+
+    enum class JobState { Pending, Assigned, Running, Done, Failed, Cancelled };
+
+    struct JobSpec {
+        QString phenotype;
+        QJsonObject repgeno;      // RepGeno.json中该表型的对象
+        QJsonObject menet;        // MeNet.json中该表型的对象
+        QJsonObject earlyStop;    // {"enabled","patience","min_delta"}
+        QString phenFilePath;     // 本机的表型文件，随任务下发
+    };
+
+    struct Job {
+        QString id;
+        JobSpec spec;
+        JobState state = JobState::Pending;
+        int node = -1;
+        int attempts = 0;
+        int percent = 0;
+        bool ok = false;
+        bool stoppedEarly = false;
+        QString message;
+        double seconds = 0.0;
+        double step1Seconds = 0.0;
+        double step2Seconds = 0.0;
+        QDateTime startedAt;
+        QString logPath;          // 回传的step2.log保存位置
+    };
+
+    explicit ClusterDispatcher(const QString &menetDir, QObject *parent = nullptr);
+    ~ClusterDispatcher();
+
+    // 从config.ini读取 [Cluster] Enabled / Nodes
+    static QStringList configuredNodes();
+
+    void setNodes(const QStringList &addresses);
+    const QVector<Node> &nodes() const { return nodeList; }
+    const QVector<Job> &jobs() const { return jobList; }
+    int healthyNodeCount() const;
+    bool isBusy() const;
+
+    void submit(const QList<JobSpec> &specs);
+    void cancelAll();
+
+signals:
+    void nodesChanged();
+    void jobUpdated(int index);
+    void jobEpoch(const QString &phenotype, const EpochMetrics &metrics);
+    void jobLog(const QString &phenotype, const QStringList &lines);
+    void jobFinished(int index);
+    void allFinished();
+
+private slots:
+    void checkHealth();
+
+private:
+    QString menetDir;
+    QVector<Node> nodeList;
+    QVector<Job> jobList;
+    QTimer healthTimer;
+    QElapsedTimer clock;
+
+    void connectNode(int index);
+    void dropNode(int index, const QString &reason);
+    void handleMessage(int nodeIndex, const QJsonObject &message);
+    void handleArtifact(Job &job, const QJsonObject &message);
+    void finishJob(int jobIndex, bool ok, const QString &message);
+    void schedule();
+    int jobIndexById(const QString &id) const;
+    QString stagingDir(const Job &job) const;
+};
+
+#endif // CLUSTERDISPATCHER_H
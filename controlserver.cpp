@@ -0,0 +1,287 @@
+#include "controlserver.h"
+#include "appconfig.h"
+#include "jsonlinechannel.h"
+#include "logcategories.h"
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUrlQuery>
+
+static const int kMaxHttpHeaderBytes = 16 * 1024;
+static const int kMaxHttpBodyBytes = 1024 * 1024;
+
+ControlServer::ControlServer(const Options &options, QObject *parent) : QObject(parent), opts(options)
+{
+}
+
+ControlServer::~ControlServer()
+{
+    for (JsonLineChannel *channel : channels) channel->disconnect(this);
+    for (auto it = httpClients.begin(); it != httpClients.end(); ++it) it.key()->disconnect(this);
+}
+
+bool ControlServer::configuredOptions(Options *options)
+{
+    if (!AppConfig::boolValue("Control", "Enabled", true)) return false;
+    options->socketName = AppConfig::value("Control", "SocketName", options->socketName);
+    options->httpPort = quint16(qBound(0, AppConfig::intValue("Control", "HttpPort", 0), 65535));
+    options->token = AppConfig::value("Control", "Token");
+    return true;
+}
+
+bool ControlServer::start(QString *error)
+{
+    // 名字已被另一个正在运行的实例占用时不抢；只是残留的socket文件就清掉
+    QLocalSocket probe;
+    probe.connectToServer(opts.socketName);
+    if (probe.waitForConnected(200)) {
+        if (error) *error = QString("Control socket %1 is already served by another instance").arg(opts.socketName);
+        return false;
+    }
+    QLocalServer::removeServer(opts.socketName);
+    localServer = new QLocalServer(this);
+    localServer->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(localServer, &QLocalServer::newConnection, this, &ControlServer::onNewLocalConnection);
+    if (!localServer->listen(opts.socketName)) {
+        if (error) *error = QString("Unable to listen on %1: %2").arg(opts.socketName, localServer->errorString());
+        return false;
+    }
+    qCInfo(lcControl) << "[ControlServer] Listening on" << localServer->fullServerName();
+    // 同一台机器上的网页也能访问127.0.0.1，HTTP不能没有token
+    if (opts.httpPort > 0 && opts.token.isEmpty()) {
+        qCWarning(lcControl) << "[ControlServer] HttpPort is set but [Control] Token is empty, HTTP disabled";
+    } else if (opts.httpPort > 0) {
+        httpServer = new QTcpServer(this);
+        connect(httpServer, &QTcpServer::newConnection, this, &ControlServer::onNewHttpConnection);
+        if (!httpServer->listen(QHostAddress::LocalHost, opts.httpPort)) {
+            if (error) *error = QString("Unable to listen on 127.0.0.1:%1: %2").arg(opts.httpPort).arg(httpServer->errorString());
+            return false;
+        }
+        qCInfo(lcControl) << "[ControlServer] HTTP on 127.0.0.1:" << opts.httpPort;
+    }
+    return true;
+}
+
+void ControlServer::setHandler(const QString &command, Handler handler, bool readOnly)
+{
+    handlers.insert(command, std::move(handler));
+    if (readOnly) readOnlyCommands.insert(command);
+    else readOnlyCommands.remove(command);
+}
+
+QString ControlServer::localServerName() const
+{
+    return localServer ? localServer->fullServerName() : QString();
+}
+
+bool ControlServer::authorized(const QString &token) const
+{
+    return opts.token.isEmpty() || token == opts.token;
+}
+
+QJsonObject ControlServer::dispatch(const QJsonObject &request)
+{
+    const QString command = request.value("cmd").toString();
+    QJsonObject response;
+    if (!handlers.contains(command)) {
+        response["ok"] = false;
+        response["error"] = QString("Unknown command: %1").arg(command);
+        return response;
+    }
+    response = handlers.value(command)(request);
+    response["ok"] = !response.contains("error");
+    return response;
+}
+
+void ControlServer::publish(const QJsonObject &event)
+{
+    if (subscribers.isEmpty() && httpClients.isEmpty()) return;
+    // close()/abort()可能同步触发disconnected并改动列表，所以先取快照
+    const QList<JsonLineChannel*> targets = subscribers;
+    for (JsonLineChannel *channel : targets) {
+        // 对端不读时不无限堆积，断开让它重连
+        if (channel->bytesToWrite() > kMaxSubscriberBacklog) {
+            qCWarning(lcControl) << "[ControlServer] Dropping slow subscriber" << channel->peerName();
+            subscribers.removeAll(channel);
+            channel->close();
+            continue;
+        }
+        channel->send(event);
+    }
+    const QByteArray payload = "event: " + event.value("event").toString().toUtf8() + "\ndata: "
+                             + QJsonDocument(event).toJson(QJsonDocument::Compact) + "\n\n";
+    QList<QTcpSocket*> streams;
+    for (auto it = httpClients.cbegin(); it != httpClients.cend(); ++it) {
+        if (it.value().streaming) streams << it.key();
+    }
+    for (QTcpSocket *socket : streams) {
+        if (socket->bytesToWrite() > kMaxSubscriberBacklog) {
+            socket->abort();
+            continue;
+        }
+        socket->write(payload);
+    }
+}
+
+void ControlServer::onNewLocalConnection()
+{
+    while (QLocalSocket *socket = localServer->nextPendingConnection()) {
+        JsonLineChannel *channel = new JsonLineChannel(socket, this);
+        channels << channel;
+        connect(channel, &JsonLineChannel::messageReceived, this, [this, channel](const QJsonObject &message) {
+            handleLocalMessage(channel, message);
+        });
+        connect(channel, &JsonLineChannel::disconnected, this, [this, channel]() {
+            channels.removeAll(channel);
+            subscribers.removeAll(channel);
+            channel->deleteLater();
+        });
+    }
+}
+
+void ControlServer::handleLocalMessage(JsonLineChannel *channel, const QJsonObject &message)
+{
+    QJsonObject response;
+    const QString command = message.value("cmd").toString();
+    if (!authorized(message.value("token").toString())) {
+        response["ok"] = false;
+        response["error"] = "Invalid token";
+    } else if (command == "subscribe-progress") {
+        if (!subscribers.contains(channel)) subscribers << channel;
+        response["ok"] = true;
+        response["subscribed"] = true;
+    } else if (command == "unsubscribe-progress") {
+        subscribers.removeAll(channel);
+        response["ok"] = true;
+        response["subscribed"] = false;
+    } else {
+        response = dispatch(message);
+    }
+    if (message.contains("id")) response["id"] = message.value("id");
+    channel->send(response);
+}
+
+void ControlServer::onNewHttpConnection()
+{
+    while (QTcpSocket *socket = httpServer->nextPendingConnection()) {
+        httpClients.insert(socket, HttpClient());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleHttpData(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            httpClients.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::handleHttpData(QTcpSocket *socket)
+{
+    auto found = httpClients.find(socket);
+    if (found == httpClients.end()) return;
+    HttpClient &client = found.value();
+    if (client.streaming) {
+        socket->readAll();
+        return;
+    }
+    client.buffer += socket->readAll();
+    const int headerEnd = client.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (client.buffer.size() > kMaxHttpHeaderBytes) sendHttpJson(socket, 431, {{"ok", false}, {"error", "Header too large"}});
+        return;
+    }
+    const QList<QByteArray> lines = client.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        sendHttpJson(socket, 400, {{"ok", false}, {"error", "Malformed request line"}});
+        return;
+    }
+    const QByteArray method = requestLine.at(0).toUpper();
+    const QUrl url(QString::fromUtf8(requestLine.at(1)));
+    QHash<QByteArray, QByteArray> headers;
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines.at(i).indexOf(':');
+        if (colon > 0) headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+    }
+    // 浏览器跨站发起的请求都会带Origin，脚本和curl不带；
+    // POST只收JSON，表单和text/plain这类不触发CORS预检的简单请求进不来
+    if (headers.contains("origin")) {
+        sendHttpJson(socket, 403, {{"ok", false}, {"error", "Cross-origin requests are not allowed"}});
+        return;
+    }
+    const QByteArray contentType = headers.value("content-type").split(';').value(0).trimmed().toLower();
+    if (method == "POST" && contentType != "application/json") {
+        sendHttpJson(socket, 415, {{"ok", false}, {"error", "Content-Type must be application/json"}});
+        return;
+    }
+    const int contentLength = headers.value("content-length", "0").toInt();
+    if (contentLength < 0 || contentLength > kMaxHttpBodyBytes) {
+        sendHttpJson(socket, 413, {{"ok", false}, {"error", "Body too large"}});
+        return;
+    }
+    if (client.buffer.size() < headerEnd + 4 + contentLength) return; // 请求体还没收全
+    const QByteArray body = client.buffer.mid(headerEnd + 4, contentLength);
+    client.buffer.clear();
+
+    QString token = QUrlQuery(url).queryItemValue("token");
+    const QByteArray authorization = headers.value("authorization");
+    if (authorization.startsWith("Bearer ")) token = QString::fromUtf8(authorization.mid(7).trimmed());
+    if (opts.token.isEmpty() || !authorized(token)) {
+        sendHttpJson(socket, 401, {{"ok", false}, {"error", "Invalid token"}});
+        return;
+    }
+
+    const QString path = url.path();
+    if (method == "GET" && (path == "/api/events" || path == "/api/subscribe-progress")) {
+        // Server-Sent Events：连接保持打开，publish()往里写事件
+        client.streaming = true;
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                      "Connection: keep-alive\r\n\r\n: subscribed\n\n");
+        return;
+    }
+    if (!path.startsWith("/api/")) {
+        sendHttpJson(socket, 404, {{"ok", false}, {"error", "Not found"}});
+        return;
+    }
+    if (method != "POST" && method != "GET") {
+        sendHttpJson(socket, 405, {{"ok", false}, {"error", "Use GET or POST"}});
+        return;
+    }
+    // 改变状态的命令（提交、取消、暂停）只能POST，GET不带请求体，只用于查询
+    const QString command = path.mid(5);
+    if (method == "GET" && !readOnlyCommands.contains(command)) {
+        sendHttpJson(socket, 405, {{"ok", false}, {"error", QString("Use POST with a JSON body for %1").arg(command)}});
+        return;
+    }
+    QJsonObject request;
+    if (method == "POST") {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
+        if (!doc.isObject()) {
+            sendHttpJson(socket, 400, {{"ok", false}, {"error", body.trimmed().isEmpty() ? QString("Missing JSON body")
+                                                                                           : parseError.errorString()}});
+            return;
+        }
+        request = doc.object();
+    }
+    request["cmd"] = command;
+    const QJsonObject response = dispatch(request);
+    const bool unknown = !response.value("ok").toBool() && !handlers.contains(request.value("cmd").toString());
+    sendHttpJson(socket, response.value("ok").toBool() ? 200 : unknown ? 404 : 400, response);
+}
+
+void ControlServer::sendHttpJson(QTcpSocket *socket, int status, const QJsonObject &body)
+{
+    static const QHash<int, QByteArray> reasons = {
+        {200, "OK"}, {400, "Bad Request"}, {401, "Unauthorized"}, {403, "Forbidden"}, {404, "Not Found"},
+        {405, "Method Not Allowed"}, {413, "Payload Too Large"}, {415, "Unsupported Media Type"},
+        {431, "Request Header Fields Too Large"}};
+    const QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + reasons.value(status, "Error") + "\r\n";
+    response += "Content-Type: application/json\r\nContent-Length: " + QByteArray::number(payload.size());
+    response += "\r\nConnection: close\r\n\r\n" + payload;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
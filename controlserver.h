@@ -0,0 +1,81 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <functional>
+
+class JsonLineChannel;
+class QLocalServer;
+class QTcpServer;
+class QTcpSocket;
+
+// 本机控制接口，供外部脚本提交任务、查询和订阅进度：
+//  - QLocalServer（Windows命名管道/Unix socket），每行一个JSON：
+//      请求 {"id":1,"cmd":"submit-train","phenotypes":["a","b"]}
+//      应答 {"id":1,"ok":true,...} 或 {"id":1,"ok":false,"error":"..."}
+//    发送 {"cmd":"subscribe-progress"} 后，服务端主动推送 {"event":"progress",...} 等事件
+//  - 可选的HTTP，只监听127.0.0.1：POST /api/<cmd>（请求体为同样的JSON），
+//    GET只能调用只读命令（如/api/list-jobs），GET /api/events 以Server-Sent Events推送事件。
+//    HTTP必须配置token；带Origin头的（浏览器跨站发起的）请求和非application/json的POST一律拒绝
+// 具体命令由setHandler()注册，本类只负责传输、鉴权和事件分发
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Handler = std::function<QJsonObject(const QJsonObject &request)>;
+
+    struct Options {
+        QString socketName = "menet-control";
+        quint16 httpPort = 0;   // 0表示不开HTTP；token为空时也不开
+        QString token;          // 非空时每个请求都要带上（"token"字段或Authorization: Bearer）
+    };
+
+    static constexpr qint64 kMaxSubscriberBacklog = 4 * 1024 * 1024;
+
+    explicit ControlServer(const Options &options, QObject *parent = nullptr);
+    ~ControlServer();
+
+    // config.ini的[Control]节；Enabled=false时返回false
+    static bool configuredOptions(Options *options);
+
+    bool start(QString *error = nullptr);
+    // readOnly的命令不改变任何状态，HTTP下才允许用GET调用
+    void setHandler(const QString &command, Handler handler, bool readOnly = false);
+    // 推送给所有订阅者；event里应包含"event"字段
+    void publish(const QJsonObject &event);
+    QString localServerName() const;
+
+private slots:
+    void onNewLocalConnection();
+    void onNewHttpConnection();
+
+private:
+    struct HttpClient {
+        QByteArray buffer;
+        bool streaming = false; // 已切换为事件流
+    };
+
+    Options opts;
+    QLocalServer *localServer = nullptr;
+    QTcpServer *httpServer = nullptr;
+    QHash<QString, Handler> handlers;
+    QSet<QString> readOnlyCommands;
+    QList<JsonLineChannel*> channels;
+    QList<JsonLineChannel*> subscribers;
+    QHash<QTcpSocket*, HttpClient> httpClients;
+
+    QJsonObject dispatch(const QJsonObject &request);
+    bool authorized(const QString &token) const;
+    void handleLocalMessage(JsonLineChannel *channel, const QJsonObject &message);
+    void handleHttpData(QTcpSocket *socket);
+    void sendHttpJson(QTcpSocket *socket, int status, const QJsonObject &body);
+};
+
+#endif // CONTROLSERVER_H
@@ -0,0 +1,527 @@
+#include "crossvalidator.h"
+#include "admissioncontroller.h"
+#include "trialworkspace.h"
+#include "metricparser.h"
+#include "logtail.h"
+#include "processcontrol.h"
+#include "resourcecontrol.h"
+#include "spreadsheetconverter.h"
+#include "logcategories.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// 表型文件的最后一列是表型值；分隔符按首行判断（逗号或制表符）
+QString lastField(const QString &line, QChar separator)
+{
+    QString value = line.mid(line.lastIndexOf(separator) + 1).trimmed();
+    if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"')) value = value.mid(1, value.size() - 2);
+    return value;
+}
+
+bool writeLines(const QString &path, const QString &header, const QStringList &lines, QString *error)
+{
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    QByteArray data;
+    if (!header.isNull()) data += header.toUtf8() + '\n';
+    for (const QString &line : lines) data += line.toUtf8() + '\n';
+    out.write(data);
+    if (!out.commit()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+void meanAndSd(const QVector<double> &values, double &mean, double &sd)
+{
+    if (values.isEmpty()) return;
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    mean = sum / values.size();
+    double squares = 0.0;
+    for (double v : values) squares += (v - mean) * (v - mean);
+    sd = values.size() > 1 ? qSqrt(squares / (values.size() - 1)) : 0.0;
+}
+
+} // namespace
+
+CrossValidator::CrossValidator(QObject *parent) : QObject(parent)
+{
+    pollTimer.setInterval(1000);
+    connect(&pollTimer, &QTimer::timeout, this, &CrossValidator::poll);
+}
+
+CrossValidator::~CrossValidator()
+{
+    for (int i = 0; i < runtimes.size(); ++i) {
+        Runtime &rt = runtimes[i];
+        if (rt.process && rt.process->state() != QProcess::NotRunning) {
+            ProcessControl::terminateTree(*rt.process, 2000);
+        }
+        releaseTicket(i);
+    }
+}
+
+bool CrossValidator::isMissingValue(const QString &value)
+{
+    const QString v = value.trimmed().toLower();
+    return v.isEmpty() || v == "na" || v == "nan" || v == "." || v == "null";
+}
+
+QVector<int> CrossValidator::assignFolds(const QStringList &values, int folds, quint32 seed)
+{
+    QVector<int> assignment(values.size(), -1);
+    if (folds < 2) return assignment;
+    QRandomGenerator rng(seed);
+    QVector<int> present;
+    QVector<double> numbers(values.size(), 0.0);
+    bool numeric = true;
+    QSet<QString> distinct;
+    for (int i = 0; i < values.size(); ++i) {
+        if (isMissingValue(values.at(i))) continue;
+        present << i;
+        distinct.insert(values.at(i).trimmed());
+        bool ok = false;
+        numbers[i] = values.at(i).trimmed().toDouble(&ok);
+        if (!ok) numeric = false;
+    }
+    if (numeric && distinct.size() > folds * 2) {
+        // 连续值：按值排序，每k个相邻样本为一组，组内随机打乱后分到k个折，各折的分布与整体一致
+        std::stable_sort(present.begin(), present.end(), [&numbers](int a, int b) { return numbers[a] < numbers[b]; });
+        QVector<int> order(folds);
+        for (int start = 0; start < present.size(); start += folds) {
+            for (int f = 0; f < folds; ++f) order[f] = f;
+            std::shuffle(order.begin(), order.end(), rng);
+            for (int j = 0; j < folds && start + j < present.size(); ++j) assignment[present[start + j]] = order[j];
+        }
+        return assignment;
+    }
+    // 分类/二值：每个类别内打乱后轮流分配，计数跨类别连续，各折大小最多差一
+    QMap<QString, QVector<int>> classes;
+    for (int i : present) classes[values.at(i).trimmed()] << i;
+    int next = int(rng.bounded(quint32(folds)));
+    for (auto it = classes.begin(); it != classes.end(); ++it) {
+        std::shuffle(it.value().begin(), it.value().end(), rng);
+        for (int i : it.value()) assignment[i] = next++ % folds;
+    }
+    return assignment;
+}
+
+int CrossValidator::threadsPerFold() const
+{
+    if (opts.threadsPerFold > 0) return opts.threadsPerFold;
+    // 默认按核数平分给同时运行的各折，整机核数用满但不超订
+    const int cores = qMax(1, QThread::idealThreadCount());
+    const int parallel = opts.maxParallel > 0 ? qMin(opts.maxParallel, opts.folds) : opts.folds;
+    return qMax(1, cores / qMax(1, parallel));
+}
+
+int CrossValidator::effectiveParallel() const
+{
+    // 核数上限在这里，内存上限由AdmissionController按每折的估计值把关
+    int parallel = opts.maxParallel > 0 ? opts.maxParallel : opts.folds;
+    const int cores = qMax(1, QThread::idealThreadCount());
+    return qMax(1, qMin(parallel, cores / threadsPerFold()));
+}
+
+int CrossValidator::activeCount() const
+{
+    // 排队等内存的折也占一个并发名额
+    int n = 0;
+    for (int i = 0; i < foldList.size(); ++i) {
+        const FoldState state = foldList.at(i).state;
+        if (state == FoldState::Step1 || state == FoldState::Running || state == FoldState::Scoring || runtimes.at(i).ticket) ++n;
+    }
+    return n;
+}
+
+void CrossValidator::releaseTicket(int index)
+{
+    Runtime &rt = runtimes[index];
+    if (!rt.ticket) return;
+    AdmissionController::instance()->release(rt.ticket);
+    rt.ticket = 0;
+}
+
+void CrossValidator::admitAndLaunch(int index)
+{
+    QPointer<CrossValidator> self(this);
+    const QString label = tr("Cross-validation %1 fold %2").arg(opts.phenotype).arg(foldList.at(index).index);
+    // 交叉验证是批量的后台作业，排在普通训练后面
+    runtimes[index].ticket = AdmissionController::instance()->submit(label, opts.memoryPerFoldMB, [self, index](int ticket) {
+        // 准入回调是延迟执行的，期间可能已取消或本对象已销毁
+        if (!self || index >= self->runtimes.size() || self->runtimes.at(index).ticket != ticket) return;
+        if (self->foldList.at(index).state != FoldState::Pending) {
+            self->releaseTicket(index);
+            return;
+        }
+        self->launch(index, self->opts.runStep1 ? FoldState::Step1 : FoldState::Running);
+    }, AdmissionController::Priority::Background);
+}
+
+bool CrossValidator::start(const Options &options, QString *error)
+{
+    if (running) {
+        if (error) *error = tr("Cross-validation is already running");
+        return false;
+    }
+    if (options.folds < 2) {
+        if (error) *error = tr("Cross-validation needs at least 2 folds");
+        return false;
+    }
+    opts = options;
+    foldList.clear();
+    runtimes.clear();
+
+    // 上传的表格已转成csv；这里再确认一次，.pt格式的表型无法分折
+    const QString phenDir = opts.menetDir + "/data/phen";
+    SpreadsheetConverter::ensureCsvInDirectory(phenDir, opts.phenotype);
+    QFile source(phenDir + "/" + opts.phenotype + ".csv");
+    if (!source.open(QIODevice::ReadOnly)) {
+        if (error) *error = tr("Cross-validation needs %1.csv (or .xls/.xlsx) in data/phen").arg(opts.phenotype);
+        return false;
+    }
+    QStringList lines;
+    for (const QByteArray &raw : source.readAll().split('\n')) {
+        QString line = QString::fromUtf8(raw);
+        if (line.endsWith('\r')) line.chop(1);
+        if (!line.trimmed().isEmpty()) lines << line;
+    }
+    source.close();
+    if (lines.isEmpty()) {
+        if (error) *error = tr("%1.csv is empty").arg(opts.phenotype);
+        return false;
+    }
+    separator = lines.first().contains('\t') && !lines.first().contains(',') ? QChar('\t') : QChar(',');
+    // 首行最后一列不是数字也不是缺失值，就当作表头
+    header.clear();
+    const QString firstValue = lastField(lines.first(), separator);
+    bool firstNumeric = false;
+    firstValue.toDouble(&firstNumeric);
+    if (!firstNumeric && !isMissingValue(firstValue)) header = lines.takeFirst();
+    QStringList values;
+    for (const QString &line : std::as_const(lines)) values << lastField(line, separator);
+    const QVector<int> assignment = assignFolds(values, opts.folds, opts.seed);
+    const int labelled = int(std::count_if(assignment.begin(), assignment.end(), [](int f) { return f >= 0; }));
+    if (labelled < opts.folds) {
+        if (error) *error = tr("%1 has only %2 samples with phenotype values, fewer than %3 folds")
+                                .arg(opts.phenotype).arg(labelled).arg(opts.folds);
+        return false;
+    }
+
+    rootDir = opts.menetDir + QString("/crossval/%1_%2").arg(opts.phenotype, QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+    for (int f = 0; f < opts.folds; ++f) {
+        Fold fold;
+        fold.index = f + 1;
+        fold.dir = rootDir + QString("/fold_%1").arg(fold.index);
+        QString prepareError;
+        if (!TrialWorkspace::prepare(opts.menetDir, fold.dir, &prepareError)
+            || !TrialWorkspace::makePrivateDir(opts.menetDir, fold.dir, "data/phen", &prepareError)
+            || !TrialWorkspace::makePrivateDir(opts.menetDir, fold.dir, "data/pred", &prepareError)) {
+            if (error) *error = prepareError;
+            TrialWorkspace::remove(rootDir);
+            return false;
+        }
+        // 缺失值的样本只进训练集；验证集只含这一折
+        QStringList trainLines, validLines;
+        for (int i = 0; i < lines.size(); ++i) {
+            (assignment.at(i) == f ? validLines : trainLines) << lines.at(i);
+        }
+        fold.trainSamples = trainLines.size();
+        fold.validSamples = validLines.size();
+        // 留出折按表型文件的原格式写成待预测文件，训完后pred.exe对它预测，真实值留着算R²
+        if (!writeLines(fold.dir + "/data/phen/" + opts.phenotype + ".csv", header, trainLines, &prepareError)
+            || !writeLines(fold.dir + "/data/pred/" + opts.phenotype + ".csv", header, validLines, &prepareError)) {
+            if (error) *error = prepareError;
+            TrialWorkspace::remove(rootDir);
+            return false;
+        }
+        foldList << fold;
+        runtimes << Runtime();
+    }
+    qCInfo(lcWorker) << "[CrossValidator] Starting" << opts.folds << "folds for" << opts.phenotype << ", parallel="
+                     << effectiveParallel() << ", threads per fold=" << threadsPerFold() << ", root=" << rootDir;
+    running = true;
+    wallSeconds = 0.0;
+    wallTimer.start();
+    pollTimer.start();
+    poll();
+    return true;
+}
+
+void CrossValidator::cancel()
+{
+    for (int i = 0; i < foldList.size(); ++i) {
+        Fold &f = foldList[i];
+        if (f.state == FoldState::Pending) {
+            f.state = FoldState::Cancelled;
+            emit foldUpdated(i);
+            releaseTicket(i);
+        } else if (f.state == FoldState::Step1 || f.state == FoldState::Running || f.state == FoldState::Scoring) {
+            f.state = FoldState::Cancelled;
+            ProcessControl::terminateTreeAsync(runtimes[i].process);
+            emit foldUpdated(i);
+        }
+    }
+    if (running) QTimer::singleShot(0, this, &CrossValidator::poll);
+}
+
+void CrossValidator::launch(int index, FoldState stage)
+{
+    Fold &f = foldList[index];
+    Runtime &rt = runtimes[index];
+    const QString exeName = stage == FoldState::Step1 ? "generate_genetic_relatedness.exe"
+                          : stage == FoldState::Scoring ? "pred.exe" : "train_menet.exe";
+    const QString output = stage == FoldState::Step1 ? "/step1_output.txt"
+                         : stage == FoldState::Scoring ? "/pred_output.txt" : "/step2_output.txt";
+    rt.process = new QProcess(this);
+    rt.process->setWorkingDirectory(f.dir);
+    rt.process->setProcessChannelMode(QProcess::MergedChannels);
+    rt.process->setStandardOutputFile(f.dir + output);
+    ProcessControl::setThreadEnvironment(*rt.process, threadsPerFold());
+    ResourceControl::instance()->prepareProcess(*rt.process, "crossval");
+    connect(rt.process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, index](int exitCode, QProcess::ExitStatus status) { onProcessFinished(index, exitCode, status); });
+    connect(rt.process, &QProcess::errorOccurred, this, [this, index, exeName](QProcess::ProcessError err) {
+        if (err != QProcess::FailedToStart) return;
+        // 启动失败不会发出finished，在这里收尾
+        Runtime &failed = runtimes[index];
+        if (failed.process) {
+            failed.process->deleteLater();
+            failed.process = nullptr;
+        }
+        releaseTicket(index);
+        foldList[index].state = FoldState::Failed;
+        foldList[index].note = tr("Unable to start %1").arg(exeName);
+        emit foldUpdated(index);
+        QTimer::singleShot(0, this, &CrossValidator::poll);
+    });
+    QStringList args = QStringList() << "--phenotype" << opts.phenotype;
+    if (stage == FoldState::Running) {
+        rt.follower.reset(f.dir + "/step2.log");
+        if (!opts.validArg.isEmpty()) args << opts.validArg << f.dir + "/data/pred/" + opts.phenotype + ".csv";
+    }
+    if (f.state == FoldState::Pending) rt.timer.start(); // 耗时包含第一步和留出预测
+    f.state = stage;
+    qCInfo(lcWorker) << "[CrossValidator] Launching fold" << f.index << exeName << "in" << f.dir;
+    rt.process->start(f.dir + "/" + exeName, args);
+    if (rt.process) AdmissionController::instance()->attachProcess(rt.ticket, rt.process->processId());
+    emit foldUpdated(index);
+}
+
+void CrossValidator::startScoring(int index)
+{
+    Fold &f = foldList[index];
+    // 训练产出saved/menet.pt，pred.exe读saved/<表型>_menet.pt；saved是每折私有的
+    const QString trained = f.dir + "/saved/menet.pt";
+    const QString model = f.dir + QString("/saved/%1_menet.pt").arg(opts.phenotype);
+    if (QFile::exists(trained)) {
+        QFile::remove(model);
+        QFile::rename(trained, model);
+    }
+    if (!QFile::exists(model) || !QFile::exists(f.dir + "/pred.exe")) {
+        releaseTicket(index);
+        f.state = FoldState::Failed;
+        f.note = QFile::exists(model) ? tr("pred.exe not found, held-out R² cannot be computed")
+                                      : tr("train_menet.exe produced no model");
+        return;
+    }
+    QFile::remove(f.dir + QString("/%1_MeNet_pred.csv").arg(opts.phenotype));
+    // 同一张准入票据继续用于预测
+    launch(index, FoldState::Scoring);
+}
+
+void CrossValidator::scoreFold(int index)
+{
+    Fold &f = foldList[index];
+    const auto readLines = [](const QString &path) {
+        QStringList lines;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) return lines;
+        for (const QByteArray &raw : file.readAll().split('\n')) {
+            const QString line = QString::fromUtf8(raw).trimmed();
+            if (!line.isEmpty()) lines << line;
+        }
+        return lines;
+    };
+    QStringList observed = readLines(f.dir + "/data/pred/" + opts.phenotype + ".csv");
+    if (!header.isEmpty() && !observed.isEmpty()) observed.removeFirst();
+    const QStringList predicted = readLines(f.dir + QString("/%1_MeNet_pred.csv").arg(opts.phenotype));
+    f.valR2 = heldOutR2(observed, predicted, separator, &f.scoredSamples);
+    if (qIsNaN(f.valR2)) {
+        f.state = FoldState::Failed;
+        f.note = predicted.isEmpty() ? tr("pred.exe wrote no predictions")
+                                     : tr("predictions could not be matched to the held-out samples");
+        return;
+    }
+    f.state = FoldState::Done;
+}
+
+double CrossValidator::heldOutR2(const QStringList &observedLines, const QStringList &predictionLines, QChar separator,
+                                 int *matched)
+{
+    if (matched) *matched = 0;
+    const auto firstField = [](const QString &line, QChar sep) {
+        QString id = line.section(sep, 0, 0).trimmed();
+        if (id.size() >= 2 && id.startsWith('"') && id.endsWith('"')) id = id.mid(1, id.size() - 2);
+        return id;
+    };
+    // 预测文件自己的分隔符；表头行的最后一列不是数字，自然被跳过
+    QHash<QString, double> byId;
+    QVector<double> inOrder;
+    for (const QString &line : predictionLines) {
+        const QChar sep = line.contains('\t') && !line.contains(',') ? QChar('\t') : QChar(',');
+        bool ok = false;
+        const double value = lastField(line, sep).toDouble(&ok);
+        if (!ok) continue;
+        byId.insert(firstField(line, sep), value);
+        inOrder << value;
+    }
+    QVector<double> obs, pred;
+    QVector<double> obsInOrder;
+    for (const QString &line : observedLines) {
+        bool ok = false;
+        const double value = lastField(line, separator).toDouble(&ok);
+        if (!ok) continue; // 缺失值不参与
+        obsInOrder << value;
+        const auto it = byId.constFind(firstField(line, separator));
+        if (it == byId.constEnd()) continue;
+        obs << value;
+        pred << it.value();
+    }
+    if (obs.isEmpty() && obsInOrder.size() == inOrder.size()) {
+        obs = obsInOrder;
+        pred = inOrder;
+    }
+    if (obs.size() < 2) return qQNaN();
+    double mean = 0.0;
+    for (double v : obs) mean += v;
+    mean /= obs.size();
+    double ssRes = 0.0, ssTot = 0.0;
+    for (int i = 0; i < obs.size(); ++i) {
+        ssRes += (obs[i] - pred[i]) * (obs[i] - pred[i]);
+        ssTot += (obs[i] - mean) * (obs[i] - mean);
+    }
+    if (ssTot <= 0.0) return qQNaN();
+    if (matched) *matched = int(obs.size());
+    return 1.0 - ssRes / ssTot;
+}
+
+void CrossValidator::onProcessFinished(int index, int exitCode, QProcess::ExitStatus status)
+{
+    Fold &f = foldList[index];
+    Runtime &rt = runtimes[index];
+    rt.process->deleteLater();
+    rt.process = nullptr;
+    const bool ok = status == QProcess::NormalExit && exitCode == 0;
+    f.seconds = rt.timer.elapsed() / 1000.0;
+    if (f.state == FoldState::Step1 && ok) {
+        // 第二步沿用同一张准入票据
+        launch(index, FoldState::Running);
+        return;
+    }
+    if (f.state == FoldState::Running) {
+        EpochMetrics metrics;
+        if (parseEpochMetrics(LogTail::lastNonEmptyLine(f.dir + "/step2.log"), metrics)) {
+            if (metrics.values.contains("val_R2")) f.logValR2 = metrics.values.value("val_R2");
+            if (metrics.values.contains("train_R2")) f.trainR2 = metrics.values.value("train_R2");
+            f.lastEpoch = qMax(f.lastEpoch, metrics.epoch);
+        }
+        if (ok) {
+            startScoring(index);
+            if (f.state == FoldState::Scoring) return;
+            emit foldUpdated(index);
+            QTimer::singleShot(0, this, &CrossValidator::poll);
+            return;
+        }
+    }
+    releaseTicket(index);
+    if (f.state == FoldState::Step1) {
+        f.state = FoldState::Failed;
+        f.note = tr("generate_genetic_relatedness.exe failed");
+    } else if (f.state == FoldState::Running) {
+        f.state = FoldState::Failed;
+        f.note = tr("train_menet.exe failed (exit code %1)").arg(exitCode);
+    } else if (f.state == FoldState::Scoring) {
+        if (ok) {
+            scoreFold(index);
+        } else {
+            f.state = FoldState::Failed;
+            f.note = tr("pred.exe failed (exit code %1)").arg(exitCode);
+        }
+    }
+    qCInfo(lcWorker) << "[CrossValidator] Fold" << f.index << (f.state == FoldState::Done ? "finished" : "failed")
+                     << ", held-out R2=" << f.valR2 << "on" << f.scoredSamples << "samples, seconds=" << f.seconds;
+    emit foldUpdated(index);
+    QTimer::singleShot(0, this, &CrossValidator::poll);
+}
+
+void CrossValidator::poll()
+{
+    if (!running) return;
+    for (int i = 0; i < foldList.size(); ++i) {
+        Fold &f = foldList[i];
+        if (f.state != FoldState::Running) continue;
+        Runtime &rt = runtimes[i];
+        for (const QString &line : rt.follower.readNewLines()) {
+            EpochMetrics metrics;
+            if (!parseEpochMetrics(line, metrics)) continue;
+            f.lastEpoch = qMax(f.lastEpoch, metrics.epoch);
+            if (metrics.values.contains("val_R2")) f.logValR2 = metrics.values.value("val_R2");
+            if (metrics.values.contains("train_R2")) f.trainR2 = metrics.values.value("train_R2");
+        }
+        f.seconds = rt.timer.elapsed() / 1000.0;
+        emit foldUpdated(i);
+    }
+    // 在核数和内存预算内补齐并发
+    for (int i = 0; i < foldList.size() && activeCount() < effectiveParallel(); ++i) {
+        if (foldList[i].state == FoldState::Pending && !runtimes[i].ticket) admitAndLaunch(i);
+    }
+    bool anyLeft = false;
+    for (const Fold &f : foldList) {
+        if (f.state == FoldState::Pending || f.state == FoldState::Step1 || f.state == FoldState::Running
+            || f.state == FoldState::Scoring) anyLeft = true;
+    }
+    for (const Runtime &rt : runtimes) {
+        if (rt.process || rt.ticket) anyLeft = true;
+    }
+    if (anyLeft) return;
+    running = false;
+    pollTimer.stop();
+    wallSeconds = wallTimer.elapsed() / 1000.0;
+    if (!opts.keepWorkspaces) TrialWorkspace::remove(rootDir);
+    qCInfo(lcWorker) << "[CrossValidator] Finished" << opts.phenotype << "in" << wallSeconds << "s";
+    emit finished();
+}
+
+CrossValidator::Summary CrossValidator::summary() const
+{
+    Summary result;
+    QVector<double> val, train;
+    for (const Fold &f : foldList) {
+        if (f.state != FoldState::Done) continue;
+        ++result.completed;
+        if (!qIsNaN(f.valR2)) val << f.valR2;
+        if (!qIsNaN(f.trainR2)) train << f.trainR2;
+    }
+    meanAndSd(val, result.meanValR2, result.sdValR2);
+    meanAndSd(train, result.meanTrainR2, result.sdTrainR2);
+    result.seconds = running ? wallTimer.elapsed() / 1000.0 : wallSeconds;
+    return result;
+}
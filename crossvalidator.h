@@ -0,0 +1,119 @@
+#ifndef CROSSVALIDATOR_H
+#define CROSSVALIDATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+#include <QtNumeric>
+#include <QVector>
+#include "logfollower.h"
+
+// k折交叉验证：表型文件分层切成k折，每折一个隔离工作目录（TrialWorkspace），
+// 训练部分写成data/phen/<表型>.csv，留出的一折写成data/pred/<表型>.csv，
+// k个train_menet在核数内并发运行，每折经AdmissionController准入，内存放不下的折排队。
+// 每折训练完用这一折的模型跑pred.exe预测留出样本，与真实值比较算出留出R²，
+// 结束后汇总各折留出R²的均值和标准差
+class CrossValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class FoldState { Pending, Step1, Running, Scoring, Done, Failed, Cancelled };
+
+    struct Fold {
+        int index = 0;              // 从1开始
+        QString dir;
+        FoldState state = FoldState::Pending;
+        int trainSamples = 0;
+        int validSamples = 0;
+        double valR2 = qQNaN();     // 留出样本上的R²（1-残差平方和/总平方和），由pred.exe的预测算出
+        int scoredSamples = 0;      // 参与计算valR2的留出样本数
+        double logValR2 = qQNaN();  // train_menet日志里的val_R2（它在训练折内部划分的验证集），仅供参考
+        double trainR2 = qQNaN();
+        int lastEpoch = -1;
+        double seconds = 0.0;
+        QString note;
+    };
+
+    struct Options {
+        QString menetDir;               // 原MENET目录
+        QString phenotype;
+        int folds = 5;
+        quint32 seed = 1;               // 分折的随机种子，同一种子得到同样的折
+        int maxParallel = 0;            // 0表示k折全部同时运行
+        int threadsPerFold = 0;         // 每折的OMP/MKL线程数，0表示按核数平分
+        double memoryPerFoldMB = 2048;  // 单折的内存估计；每折启动前按这个值向AdmissionController申请
+        bool runStep1 = false;          // 每折先跑generate_genetic_relatedness.exe
+        QString validArg;               // 非空时额外把留出文件以这个参数传给train_menet（需确认它支持），留出R²照样由pred.exe算
+        bool keepWorkspaces = false;    // 结束后保留各折目录（日志、模型）
+    };
+
+    struct Summary {
+        int completed = 0;
+        double meanValR2 = qQNaN();
+        double sdValR2 = qQNaN();       // 样本标准差（n-1），只有一折时为0
+        double meanTrainR2 = qQNaN();
+        double sdTrainR2 = qQNaN();
+        double seconds = 0.0;           // 从开始到最后一折结束的墙钟时间
+    };
+
+    explicit CrossValidator(QObject *parent = nullptr);
+    ~CrossValidator();
+
+    // 分层分折：数值表型按值排序后每k个一组、组内随机分到k折，取值很少的表型（分类/二值）按类别轮流分配。
+    // 返回每个值所在的折（0..k-1），缺失值为-1，只进训练集
+    static QVector<int> assignFolds(const QStringList &values, int folds, quint32 seed);
+    static bool isMissingValue(const QString &value);
+    // 决定系数：observed按样本ID（首列）与predictions（首列ID、最后一个数值列为预测值）对应，
+    // ID对不上而行数相同时按顺序对应。返回NaN表示无法计算
+    static double heldOutR2(const QStringList &observedLines, const QStringList &predictionLines, QChar separator,
+                            int *matched = nullptr);
+
+    bool start(const Options &options, QString *error = nullptr);
+    void cancel();
+    bool isRunning() const { return running; }
+    const Options &options() const { return opts; }
+    const QVector<Fold> &folds() const { return foldList; }
+    Summary summary() const;
+
+signals:
+    void foldUpdated(int index);
+    void finished();
+
+private slots:
+    void poll();
+
+private:
+    struct Runtime {
+        QProcess *process = nullptr;
+        int ticket = 0;             // 内存准入票据，排队或运行中非0
+        QElapsedTimer timer;
+        LogFollower follower;
+    };
+
+    Options opts;
+    QVector<Fold> foldList;
+    QVector<Runtime> runtimes;
+    QTimer pollTimer;
+    QElapsedTimer wallTimer;
+    double wallSeconds = 0.0;
+    QString rootDir;
+    bool running = false;
+
+    int threadsPerFold() const;
+    int effectiveParallel() const;
+    int activeCount() const;
+    void admitAndLaunch(int index);
+    QString header;
+    QChar separator = ',';
+
+    void launch(int index, FoldState stage);
+    void startScoring(int index);
+    void scoreFold(int index);
+    void releaseTicket(int index);
+    void onProcessFinished(int index, int exitCode, QProcess::ExitStatus status);
+};
+
+#endif // CROSSVALIDATOR_H
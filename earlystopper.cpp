@@ -0,0 +1,29 @@
+#include "earlystopper.h"
+#include <QtGlobal>
+
+EarlyStopper::EarlyStopper(const Config &config)
+{
+    reset(config);
+}
+
+void EarlyStopper::reset(const Config &config)
+{
+    cfg = config;
+    bestEpochValue = -1;
+    bestValueSeen = 0.0;
+    lastEpoch = -1;
+    fired = false;
+}
+
+bool EarlyStopper::observe(int epoch, double valR2)
+{
+    if (!cfg.enabled || fired || epoch <= lastEpoch || !qIsFinite(valR2)) return fired;
+    lastEpoch = epoch;
+    if (bestEpochValue < 0 || valR2 > bestValueSeen + cfg.minDelta) {
+        bestEpochValue = epoch;
+        bestValueSeen = valR2;
+        return false;
+    }
+    if (epoch - bestEpochValue >= cfg.patience) fired = true;
+    return fired;
+}
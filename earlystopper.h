@@ -0,0 +1,32 @@
+#ifndef EARLYSTOPPER_H
+#define EARLYSTOPPER_H
+
+// 根据val_R2决定是否提前停止训练：
+// 连续patience个epoch没有比最佳值提高至少minDelta就触发
+class EarlyStopper
+{
+public:
+    struct Config {
+        bool enabled = false;
+        int patience = 20;
+        double minDelta = 0.001;
+    };
+
+    EarlyStopper() = default;
+    explicit EarlyStopper(const Config &config);
+    void reset(const Config &config);
+    // 输入一个epoch的val_R2，返回true表示应该停止
+    bool observe(int epoch, double valR2);
+    bool hasFired() const { return fired; }
+    int bestEpoch() const { return bestEpochValue; }
+    double bestValue() const { return bestValueSeen; }
+
+private:
+    Config cfg;
+    int bestEpochValue = -1;
+    double bestValueSeen = 0.0;
+    int lastEpoch = -1;
+    bool fired = false;
+};
+
+#endif // EARLYSTOPPER_H
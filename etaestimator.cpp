@@ -0,0 +1,135 @@
+#include "etaestimator.h"
+#include <QtGlobal>
+
+EtaEstimator::EtaEstimator(double alpha) : alpha(qBound(0.01, alpha, 1.0))
+{
+    clock.start();
+}
+
+double EtaEstimator::ewma(double previous, double sample, double alpha)
+{
+    return previous < 0.0 ? sample : alpha * sample + (1.0 - alpha) * previous;
+}
+
+void EtaEstimator::setPriors(double step1SecondsPerMB, double epochSecs, double overheadSeconds)
+{
+    // 先验只在还没有实测值时生效
+    if (step1PerMB < 0.0 && step1SecondsPerMB > 0.0) step1PerMB = step1SecondsPerMB;
+    if (epochSeconds < 0.0 && epochSecs > 0.0) epochSeconds = epochSecs;
+    if (step2Overhead < 0.0 && overheadSeconds >= 0.0) step2Overhead = overheadSeconds;
+}
+
+void EtaEstimator::beginJob(const Job &job)
+{
+    current = job;
+    active = true;
+    jobStartMs = clock.elapsed();
+    step2StartMs = job.skipStep1 ? jobStartMs : -1;
+    lastEpochMs = -1;
+    lastEpoch = -1;
+}
+
+void EtaEstimator::step1Finished()
+{
+    if (!active) return;
+    const qint64 now = clock.elapsed();
+    if (!current.skipStep1 && current.datasetMB > 0.0) {
+        const double seconds = (now - jobStartMs) / 1000.0;
+        step1PerMB = ewma(step1PerMB, seconds / current.datasetMB, alpha);
+    }
+    step2StartMs = now;
+}
+
+void EtaEstimator::observeEpoch(int epoch)
+{
+    if (!active || epoch <= lastEpoch) return;
+    const qint64 now = clock.elapsed();
+    if (step2StartMs < 0) step2StartMs = now;
+    if (lastEpoch < 0) {
+        // 第一个epoch之前包含加载数据、建模型的时间，单独记作开销
+        step2Overhead = ewma(step2Overhead, (now - step2StartMs) / 1000.0, alpha);
+    } else {
+        const double perEpoch = (now - lastEpochMs) / 1000.0 / (epoch - lastEpoch);
+        epochSeconds = ewma(epochSeconds, perEpoch, alpha);
+    }
+    lastEpoch = epoch;
+    lastEpochMs = now;
+}
+
+void EtaEstimator::finishJob()
+{
+    active = false;
+}
+
+double EtaEstimator::estimateStep1Seconds(double datasetMB) const
+{
+    if (step1PerMB < 0.0 || datasetMB <= 0.0) return -1.0;
+    return step1PerMB * datasetMB;
+}
+
+double EtaEstimator::estimateStep2Seconds(int totalEpochs) const
+{
+    if (epochSeconds < 0.0) return -1.0;
+    return qMax(0.0, step2Overhead) + epochSeconds * qMax(0, totalEpochs);
+}
+
+double EtaEstimator::estimateJobSeconds(const Job &job) const
+{
+    const double step2 = estimateStep2Seconds(job.totalEpochs);
+    if (step2 < 0.0) return -1.0;
+    if (job.skipStep1) return step2;
+    const double step1 = estimateStep1Seconds(job.datasetMB);
+    return step1 < 0.0 ? -1.0 : step1 + step2;
+}
+
+double EtaEstimator::remainingCurrentSeconds() const
+{
+    if (!active) return 0.0;
+    const qint64 now = clock.elapsed();
+    if (step2StartMs < 0) {
+        // 还在第一步：估计值减去已用时间，超时后至少按0算
+        const double step1 = estimateStep1Seconds(current.datasetMB);
+        const double step2 = estimateStep2Seconds(current.totalEpochs);
+        if (step1 < 0.0 || step2 < 0.0) return -1.0;
+        return qMax(0.0, step1 - (now - jobStartMs) / 1000.0) + step2;
+    }
+    if (epochSeconds < 0.0) return -1.0;
+    if (lastEpoch < 0) {
+        return qMax(0.0, qMax(0.0, step2Overhead) - (now - step2StartMs) / 1000.0) + epochSeconds * current.totalEpochs;
+    }
+    const int remainingEpochs = qMax(0, current.totalEpochs - (lastEpoch + 1));
+    const double sinceLast = (now - lastEpochMs) / 1000.0;
+    return qMax(0.0, remainingEpochs * epochSeconds - sinceLast);
+}
+
+double EtaEstimator::remainingTotalSeconds(const QList<Job> &queue) const
+{
+    double total = remainingCurrentSeconds();
+    if (total < 0.0) return -1.0;
+    for (const Job &job : queue) {
+        const double seconds = estimateJobSeconds(job);
+        if (seconds < 0.0) return -1.0;
+        total += seconds;
+    }
+    return total;
+}
+
+double EtaEstimator::step1Weight() const
+{
+    if (current.skipStep1) return 0.0;
+    const double step1 = estimateStep1Seconds(current.datasetMB);
+    const double step2 = estimateStep2Seconds(current.totalEpochs);
+    if (step1 < 0.0 || step2 < 0.0 || step1 + step2 <= 0.0) return 0.5;
+    // 两端留一点区间，避免某一步在进度条上完全看不到
+    return qBound(0.05, step1 / (step1 + step2), 0.95);
+}
+
+QString EtaEstimator::formatDuration(double seconds)
+{
+    if (seconds < 0.0) return QStringLiteral("--");
+    const qint64 total = qRound64(seconds);
+    const qint64 h = total / 3600, m = (total % 3600) / 60, s = total % 60;
+    if (h > 0) return QString("%1h %2m").arg(h).arg(m, 2, 10, QChar('0'));
+    if (m > 0) return QString("%1m %2s").arg(m).arg(s, 2, 10, QChar('0'));
+    return QString("%1s").arg(s);
+}
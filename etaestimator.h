@@ -0,0 +1,62 @@
+#ifndef ETAESTIMATOR_H
+#define ETAESTIMATOR_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+// 训练队列的剩余时间估计：
+// 第二步按epoch耗时的指数加权平均（EWMA）外推，第一步按数据量（秒/MB）估计；
+// 没有实测值时用运行历史给出的先验
+class EtaEstimator
+{
+public:
+    struct Job {
+        QString phenotype;
+        int totalEpochs = 0;
+        double datasetMB = 0.0;
+        bool skipStep1 = false;
+    };
+
+    explicit EtaEstimator(double alpha = 0.3);
+
+    // 先验：来自运行历史，<=0表示没有
+    void setPriors(double step1SecondsPerMB, double epochSeconds, double step2OverheadSeconds);
+
+    void beginJob(const Job &job);
+    void step1Finished();
+    void observeEpoch(int epoch);
+    void finishJob();
+
+    // 估计值，未知时返回-1
+    double estimateStep1Seconds(double datasetMB) const;
+    double estimateStep2Seconds(int totalEpochs) const;
+    double estimateJobSeconds(const Job &job) const;
+    // 当前表型剩余秒数
+    double remainingCurrentSeconds() const;
+    // 当前表型加上队列中剩余表型的总秒数；有任何一项未知时返回-1
+    double remainingTotalSeconds(const QList<Job> &queue) const;
+    // 第一步在当前表型总耗时中的占比，用来分配进度条区间；未知时返回0.5
+    double step1Weight() const;
+    bool isActive() const { return active; }
+    const Job &currentJob() const { return current; }
+
+    static QString formatDuration(double seconds);
+
+private:
+    double alpha;
+    double step1PerMB = -1.0;    // 秒/MB
+    double epochSeconds = -1.0;  // 每个epoch的秒数
+    double step2Overhead = -1.0; // 第二步启动到第一个epoch之前的开销
+    bool active = false;
+    Job current;
+    QElapsedTimer clock;
+    qint64 jobStartMs = 0;
+    qint64 step2StartMs = -1;
+    qint64 lastEpochMs = -1;
+    int lastEpoch = -1;
+
+    static double ewma(double previous, double sample, double alpha);
+};
+
+#endif // ETAESTIMATOR_H
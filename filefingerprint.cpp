@@ -0,0 +1,189 @@
+#include "filefingerprint.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const qint64 kChunkSize = 1024 * 1024;
+
+FileFingerprint *FileFingerprint::instance()
+{
+    static FileFingerprint *fingerprint = new FileFingerprint();
+    return fingerprint;
+}
+
+void FileFingerprint::setMemoPath(const QString &path)
+{
+    QMutexLocker locker(&mutex);
+    if (memoPath == path) return;
+    memoPath = path;
+    loaded = false;
+}
+
+void FileFingerprint::loadLocked()
+{
+    if (loaded) return;
+    loaded = true;
+    if (memoPath.isEmpty()) return;
+    QFile file(memoPath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        Entry entry;
+        entry.inode = obj.value("inode").toString().toULongLong();
+        entry.mtimeMs = qint64(obj.value("mtime").toDouble());
+        entry.size = qint64(obj.value("size").toDouble(-1));
+        entry.hash = obj.value("hash").toString();
+        if (!entry.hash.isEmpty()) memo.insert(it.key(), entry);
+    }
+}
+
+void FileFingerprint::save()
+{
+    QMutexLocker locker(&mutex);
+    if (!dirty || memoPath.isEmpty()) return;
+    QJsonObject root;
+    for (auto it = memo.constBegin(); it != memo.constEnd(); ++it) {
+        // 已删除的文件不再保留
+        if (!QFileInfo::exists(it.key())) continue;
+        QJsonObject obj;
+        obj["inode"] = QString::number(it.value().inode);
+        obj["mtime"] = double(it.value().mtimeMs);
+        obj["size"] = double(it.value().size);
+        obj["hash"] = it.value().hash;
+        root[it.key()] = obj;
+    }
+    QDir().mkpath(QFileInfo(memoPath).absolutePath());
+    QSaveFile file(memoPath);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (file.commit()) dirty = false;
+}
+
+quint64 FileFingerprint::fileId(const QString &path)
+{
+#if defined(Q_OS_WIN)
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(path).utf16()), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return 0;
+    BY_HANDLE_FILE_INFORMATION info;
+    quint64 id = 0;
+    if (GetFileInformationByHandle(handle, &info)) id = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    CloseHandle(handle);
+    return id;
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) return 0;
+    return quint64(st.st_ino);
+#endif
+}
+
+QString FileFingerprint::hashContents(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QByteArray buffer(kChunkSize, Qt::Uninitialized);
+    for (;;) {
+        const qint64 n = file.read(buffer.data(), kChunkSize);
+        if (n < 0) return QString();
+        if (n == 0) break;
+        hash.addData(QByteArrayView(buffer.constData(), n));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString FileFingerprint::ofFile(const QString &path)
+{
+    const QFileInfo info(path);
+    if (!info.isFile()) return QString();
+    const QString key = info.absoluteFilePath();
+    const quint64 inode = fileId(key);
+    const qint64 mtimeMs = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+    {
+        QMutexLocker locker(&mutex);
+        loadLocked();
+        const auto it = memo.constFind(key);
+        if (it != memo.constEnd() && it->inode == inode && it->mtimeMs == mtimeMs && it->size == size) return it->hash;
+    }
+    // 读内容不持锁，多个线程可以同时算不同文件
+    const QString hash = hashContents(key);
+    if (hash.isEmpty()) return QString();
+    QMutexLocker locker(&mutex);
+    Entry entry;
+    entry.inode = inode;
+    entry.mtimeMs = mtimeMs;
+    entry.size = size;
+    entry.hash = hash;
+    memo.insert(key, entry);
+    dirty = true;
+    return hash;
+}
+
+void FileFingerprint::remember(const QString &path, const QString &hash)
+{
+    const QFileInfo info(path);
+    if (!info.isFile() || hash.isEmpty()) return;
+    Entry entry;
+    entry.inode = fileId(info.absoluteFilePath());
+    entry.mtimeMs = info.lastModified().toMSecsSinceEpoch();
+    entry.size = info.size();
+    entry.hash = hash;
+    QMutexLocker locker(&mutex);
+    loadLocked();
+    memo.insert(info.absoluteFilePath(), entry);
+    dirty = true;
+}
+
+QString FileFingerprint::ofFiles(const QStringList &paths)
+{
+    QStringList sorted = paths;
+    std::sort(sorted.begin(), sorted.end(), [](const QString &a, const QString &b) {
+        return QFileInfo(a).fileName() < QFileInfo(b).fileName();
+    });
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QString &path : sorted) {
+        const QString fileHash = ofFile(path);
+        if (fileHash.isEmpty()) return QString();
+        hash.addData(QFileInfo(path).fileName().toUtf8());
+        hash.addData(QByteArrayView("\0", 1));
+        hash.addData(fileHash.toLatin1());
+        hash.addData(QByteArrayView("\n", 1));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString FileFingerprint::ofDirectory(const QString &path)
+{
+    QDir dir(path);
+    if (!dir.exists()) return QString();
+    QStringList files;
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) files << dir.relativeFilePath(it.next());
+    files.sort();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QString &relative : files) {
+        const QString fileHash = ofFile(dir.filePath(relative));
+        if (fileHash.isEmpty()) return QString();
+        hash.addData(relative.toUtf8());
+        hash.addData(QByteArrayView("\0", 1));
+        hash.addData(fileHash.toLatin1());
+        hash.addData(QByteArrayView("\n", 1));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
@@ -0,0 +1,50 @@
+#ifndef FILEFINGERPRINT_H
+#define FILEFINGERPRINT_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+// 文件内容指纹：按1MB分块读取做SHA-1，结果按 inode+mtime+size 记忆并持久化到
+// MENET/cache/fingerprints.json。文件没变时只需一次stat，不再读内容
+class FileFingerprint
+{
+public:
+    static FileFingerprint *instance();
+
+    // 设置持久化文件；首次查询时加载
+    void setMemoPath(const QString &path);
+    // 单个文件的内容哈希（hex），文件不存在或读取失败返回空
+    QString ofFile(const QString &path);
+    // 多个文件合并成一个指纹，按文件名排序，与传入顺序无关
+    QString ofFiles(const QStringList &paths);
+    // 目录下所有文件（递归）按相对路径合并；目录不存在返回空
+    QString ofDirectory(const QString &path);
+    // 已知内容的文件（如从已登记对象链接出来的副本）直接记下指纹，免得再读一遍
+    void remember(const QString &path, const QString &hash);
+    // 把新算出的指纹写回持久化文件
+    void save();
+
+private:
+    FileFingerprint() = default;
+
+    struct Entry {
+        quint64 inode = 0;
+        qint64 mtimeMs = 0;
+        qint64 size = -1;
+        QString hash;
+    };
+
+    QMutex mutex;
+    QHash<QString, Entry> memo; // 绝对路径 -> 记忆项
+    QString memoPath;
+    bool loaded = false;
+    bool dirty = false;
+
+    void loadLocked();
+    static quint64 fileId(const QString &path);
+    static QString hashContents(const QString &path);
+};
+
+#endif // FILEFINGERPRINT_H
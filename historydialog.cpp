@@ -0,0 +1,257 @@
+#include "historydialog.h"
+#include "runhistory.h"
+#include "logindex.h"
+#include "trainingcurvewidget.h"
+#include <QApplication>
+#include <QComboBox>
+#include <QDateEdit>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <algorithm>
+
+static QString formatSeconds(double seconds)
+{
+    if (seconds >= 3600.0) return QString("%1 h").arg(seconds / 3600.0, 0, 'f', 2);
+    if (seconds >= 60.0) return QString("%1 min").arg(seconds / 60.0, 0, 'f', 2);
+    return QString("%1 s").arg(seconds, 0, 'f', 1);
+}
+
+HistoryDialog::HistoryDialog(QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Run History"));
+    resize(1000, 600);
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    comboPhenotype = new QComboBox(this);
+    comboPhenotype->addItem(tr("All phenotypes"), QString());
+    for (const QString &phenotype : RunHistory::instance()->phenotypes()) {
+        comboPhenotype->addItem(phenotype, phenotype);
+    }
+    comboKind = new QComboBox(this);
+    comboKind->addItem(tr("All jobs"), QString());
+    comboKind->addItem(tr("Training"), QString("train"));
+    comboKind->addItem(tr("Transfer learning"), QString("transfer"));
+    comboKind->addItem(tr("Prediction"), QString("predict"));
+    comboKind->addItem(tr("Cross-validation"), QString("crossval"));
+    // 默认最近30天
+    dateFrom = new QDateEdit(QDate::currentDate().addDays(-30), this);
+    dateFrom->setCalendarPopup(true);
+    dateTo = new QDateEdit(QDate::currentDate(), this);
+    dateTo->setCalendarPopup(true);
+    QHBoxLayout *filterRow = new QHBoxLayout();
+    filterRow->addWidget(new QLabel(tr("Phenotype:"), this));
+    filterRow->addWidget(comboPhenotype);
+    filterRow->addWidget(new QLabel(tr("Job:"), this));
+    filterRow->addWidget(comboKind);
+    filterRow->addWidget(new QLabel(tr("From:"), this));
+    filterRow->addWidget(dateFrom);
+    filterRow->addWidget(new QLabel(tr("To:"), this));
+    filterRow->addWidget(dateTo);
+    filterRow->addStretch();
+    mainLayout->addLayout(filterRow);
+
+    labelSummary = new QLabel(this);
+    labelSummary->setWordWrap(true);
+    mainLayout->addWidget(labelSummary);
+
+    table = new QTableWidget(this);
+    table->setColumnCount(11);
+    table->setHorizontalHeaderLabels({tr("Started"), tr("Job"), tr("Phenotype"), tr("Status"), tr("Total"),
+                                      tr("Step 1"), tr("Step 2"), tr("Epochs/s"), tr("train_R2"), tr("val_R2"),
+                                      tr("Peak memory")});
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(table, 1);
+
+    // 选中运行的曲线对比和按epoch查询
+    comboMetric = new QComboBox(this);
+    comboMetric->setEditable(true);
+    comboMetric->addItems({"val_R2", "train_R2", "loss"});
+    spinEpoch = new QSpinBox(this);
+    spinEpoch->setRange(0, 10000000);
+    QPushButton *btnCompare = new QPushButton(tr("Compare curves"), this);
+    QPushButton *btnLookup = new QPushButton(tr("Look up epoch"), this);
+    QPushButton *btnClose = new QPushButton(tr("Close"), this);
+    QHBoxLayout *btnRow = new QHBoxLayout();
+    btnRow->addWidget(new QLabel(tr("Metric:"), this));
+    btnRow->addWidget(comboMetric);
+    btnRow->addWidget(btnCompare);
+    btnRow->addWidget(new QLabel(tr("Epoch:"), this));
+    btnRow->addWidget(spinEpoch);
+    btnRow->addWidget(btnLookup);
+    btnRow->addStretch();
+    btnRow->addWidget(btnClose);
+    mainLayout->addLayout(btnRow);
+    setLayout(mainLayout);
+
+    connect(comboPhenotype, &QComboBox::currentIndexChanged, this, &HistoryDialog::refresh);
+    connect(comboKind, &QComboBox::currentIndexChanged, this, &HistoryDialog::refresh);
+    connect(dateFrom, &QDateEdit::dateChanged, this, &HistoryDialog::refresh);
+    connect(dateTo, &QDateEdit::dateChanged, this, &HistoryDialog::refresh);
+    connect(btnCompare, &QPushButton::clicked, this, &HistoryDialog::compareSelected);
+    connect(btnLookup, &QPushButton::clicked, this, &HistoryDialog::lookupEpoch);
+    connect(btnClose, &QPushButton::clicked, this, &QDialog::accept);
+    refresh();
+}
+
+void HistoryDialog::refresh()
+{
+    RunHistory *history = RunHistory::instance();
+    if (!history->isOpen()) {
+        labelSummary->setText(tr("Run history database is not available."));
+        table->setRowCount(0);
+        return;
+    }
+    RunHistory::Filter filter;
+    filter.phenotype = comboPhenotype->currentData().toString();
+    filter.kind = comboKind->currentData().toString();
+    filter.from = dateFrom->date().startOfDay();
+    filter.to = dateTo->date().endOfDay();
+
+    // 统计和明细都走索引，数据再多也是即时返回
+    const RunHistory::Stats stats = history->stats(filter);
+    if (stats.count == 0) {
+        labelSummary->setText(tr("No runs in this range."));
+    } else {
+        QString summary = tr("%1 runs (%2 succeeded). Duration: average %3, fastest %4, slowest %5.")
+                              .arg(stats.count).arg(stats.successCount)
+                              .arg(formatSeconds(stats.avgSeconds), formatSeconds(stats.minSeconds), formatSeconds(stats.maxSeconds));
+        if (stats.avgEpochsPerSecond > 0.0) summary += tr(" Average speed: %1 epochs/s.").arg(stats.avgEpochsPerSecond, 0, 'f', 3);
+        if (!qIsNaN(stats.bestValR2)) summary += tr(" Best val_R2: %1.").arg(stats.bestValR2, 0, 'f', 4);
+        labelSummary->setText(summary);
+    }
+
+    const QList<RunHistory::Run> runs = history->query(filter);
+    table->setRowCount(runs.size());
+    auto number = [](double value, int precision) {
+        return qIsNaN(value) ? QString("-") : QString::number(value, 'f', precision);
+    };
+    for (int row = 0; row < runs.size(); ++row) {
+        const RunHistory::Run &run = runs.at(row);
+        const QStringList cells = {
+            run.startedAt.toString("yyyy-MM-dd hh:mm"), run.kind, run.phenotype, run.status,
+            formatSeconds(run.totalSeconds),
+            run.step1Seconds > 0.0 ? formatSeconds(run.step1Seconds) : QString("-"),
+            run.step2Seconds > 0.0 ? formatSeconds(run.step2Seconds) : QString("-"),
+            run.epochsPerSecond > 0.0 ? QString::number(run.epochsPerSecond, 'f', 3) : QString("-"),
+            number(run.trainR2, 4), number(run.valR2, 4),
+            run.peakMemoryMB > 0.0 ? QString("%1 MB").arg(run.peakMemoryMB, 0, 'f', 0) : QString("-")
+        };
+        for (int col = 0; col < cells.size(); ++col) {
+            QTableWidgetItem *item = new QTableWidgetItem(cells.at(col));
+            if (col == 0) {
+                // 存档日志路径和行标签放在第一列，对比和查询时取用
+                item->setData(Qt::UserRole, run.logPath);
+                item->setData(Qt::UserRole + 1, QString("%1 %2").arg(run.phenotype, run.startedAt.toString("MM-dd hh:mm")));
+                QStringList tip;
+                if (!run.message.isEmpty()) tip << run.message;
+                if (!run.logPath.isEmpty()) tip << tr("Log: %1").arg(run.logPath);
+                if (!tip.isEmpty()) item->setToolTip(tip.join('\n'));
+            }
+            table->setItem(row, col, item);
+        }
+    }
+}
+
+QList<int> HistoryDialog::selectedRows() const
+{
+    QList<int> rows;
+    for (const QModelIndex &index : table->selectionModel()->selectedRows()) rows << index.row();
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+QString HistoryDialog::runLabel(int row) const
+{
+    return table->item(row, 0)->data(Qt::UserRole + 1).toString();
+}
+
+void HistoryDialog::compareSelected()
+{
+    const QString metric = comboMetric->currentText().trimmed();
+    const QList<int> rows = selectedRows();
+    if (metric.isEmpty() || rows.isEmpty()) {
+        QMessageBox::information(this, tr("Compare curves"), tr("Select one or more runs and a metric first."));
+        return;
+    }
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Compare runs"));
+    dialog.resize(900, 480);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    TrainingCurveWidget *curves = new TrainingCurveWidget(&dialog);
+    layout->addWidget(curves, 1);
+    curves->setTitle(tr("%1 by epoch").arg(metric));
+    QStringList skipped;
+    // 索引缺失或过期时open()会重建，老日志第一次打开要完整扫描一遍
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    for (int row : rows) {
+        const QString logPath = table->item(row, 0)->data(Qt::UserRole).toString();
+        const QString label = runLabel(row);
+        LogIndex index;
+        if (logPath.isEmpty() || !index.open(logPath) || !index.hasMetric(metric)) {
+            skipped << label;
+            continue;
+        }
+        // 每个运行一条曲线，曲线名是运行的标签
+        const QVector<int> epochs = index.epochs();
+        const QVector<double> values = index.column(metric);
+        EpochMetrics point;
+        for (int i = 0; i < epochs.size(); ++i) {
+            point.epoch = epochs.at(i);
+            point.values.clear();
+            point.values.insert(label, values.at(i));
+            curves->addEpoch(point);
+        }
+    }
+    QApplication::restoreOverrideCursor();
+
+    if (!skipped.isEmpty()) {
+        QLabel *note = new QLabel(tr("No archived log with %1 for: %2").arg(metric, skipped.join(", ")), &dialog);
+        note->setWordWrap(true);
+        layout->addWidget(note);
+    }
+    dialog.exec();
+}
+
+void HistoryDialog::lookupEpoch()
+{
+    const QList<int> rows = selectedRows();
+    if (rows.isEmpty()) {
+        QMessageBox::information(this, tr("Look up epoch"), tr("Select one or more runs first."));
+        return;
+    }
+    const int epoch = spinEpoch->value();
+    QStringList lines;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    for (int row : rows) {
+        const QString logPath = table->item(row, 0)->data(Qt::UserRole).toString();
+        const QString label = runLabel(row);
+        LogIndex index;
+        if (logPath.isEmpty() || !index.open(logPath)) {
+            lines << tr("%1: no archived log").arg(label);
+            continue;
+        }
+        EpochMetrics metrics;
+        if (!index.metricsAt(epoch, metrics)) {
+            lines << tr("%1: epoch %2 not in log (last epoch %3)").arg(label).arg(epoch).arg(index.epochAt(index.epochCount() - 1));
+            continue;
+        }
+        // 指标来自索引，原文按偏移直接seek读出一行
+        QStringList values;
+        for (auto it = metrics.values.constBegin(); it != metrics.values.constEnd(); ++it) {
+            values << QString("%1 = %2").arg(it.key()).arg(it.value(), 0, 'g', 6);
+        }
+        lines << QString("%1: %2\n    %3").arg(label, values.join(", "), index.lineAt(epoch));
+    }
+    QApplication::restoreOverrideCursor();
+    QMessageBox::information(this, tr("Epoch %1").arg(epoch), lines.join("\n\n"));
+}
@@ -0,0 +1,40 @@
+#ifndef HISTORYDIALOG_H
+#define HISTORYDIALOG_H
+
+#include <QDialog>
+
+class QComboBox;
+class QDateEdit;
+class QTableWidget;
+class QLabel;
+class QSpinBox;
+
+// 运行历史面板：按表型、任务类型、日期范围筛选，显示明细和耗时统计；
+// 选中的运行可以按某个指标对比训练曲线，或查看指定epoch的指标和日志原文（都只读存档日志的.idx索引）
+class HistoryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryDialog(QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+    void compareSelected();
+    void lookupEpoch();
+
+private:
+    QComboBox *comboPhenotype;
+    QComboBox *comboKind;
+    QDateEdit *dateFrom;
+    QDateEdit *dateTo;
+    QTableWidget *table;
+    QLabel *labelSummary;
+    QComboBox *comboMetric;
+    QSpinBox *spinEpoch;
+
+    QList<int> selectedRows() const;
+    QString runLabel(int row) const;
+};
+
+#endif // HISTORYDIALOG_H
@@ -0,0 +1,87 @@
+#include "imageloader.h"
+#include "logcategories.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QImage>
+#include <QImageReader>
+#include <QThreadPool>
+
+ImageLoader *ImageLoader::instance()
+{
+    // 首次调用必须在GUI线程，回调依赖本对象所在线程的事件循环
+    static ImageLoader *loader = new ImageLoader();
+    return loader;
+}
+
+ImageLoader::ImageLoader(QObject *parent) : QObject(parent)
+{
+    pixmapCache.setMaxCost(64 * 1024); // 约64MB
+}
+
+QString ImageLoader::cacheKey(const QString &path, const QSize &boundingSize, qreal dpr)
+{
+    QFileInfo info(path);
+    return QString("%1|%2|%3x%4|%5")
+        .arg(info.absoluteFilePath())
+        .arg(info.lastModified().toMSecsSinceEpoch())
+        .arg(boundingSize.width())
+        .arg(boundingSize.height())
+        .arg(dpr);
+}
+
+QPixmap ImageLoader::cached(const QString &path, const QSize &boundingSize, qreal dpr) const
+{
+    QPixmap *pixmap = pixmapCache.object(cacheKey(path, boundingSize, dpr));
+    return pixmap ? *pixmap : QPixmap();
+}
+
+void ImageLoader::prefetch(const QString &path, const QSize &boundingSize, qreal dpr)
+{
+    request(path, boundingSize, dpr, nullptr, Callback());
+}
+
+void ImageLoader::request(const QString &path, const QSize &boundingSize, qreal dpr,
+                          QObject *context, Callback callback)
+{
+    const QString key = cacheKey(path, boundingSize, dpr);
+    if (QPixmap *pixmap = pixmapCache.object(key)) {
+        if (callback) callback(*pixmap);
+        return;
+    }
+    const bool alreadyDecoding = pending.contains(key);
+    if (callback) pending[key].append({QPointer<QObject>(context), callback});
+    else if (!alreadyDecoding) pending.insert(key, QList<Waiter>());
+    if (alreadyDecoding) return;
+
+    QThreadPool::globalInstance()->start([this, key, path, boundingSize, dpr]() {
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        QSize sourceSize = reader.size();
+        QSize targetSize = (QSizeF(boundingSize) * dpr).toSize();
+        // 只缩小不放大；按目标尺寸解码，避免先解码全图再缩放
+        if (sourceSize.isValid() && !targetSize.isEmpty()
+            && (sourceSize.width() > targetSize.width() || sourceSize.height() > targetSize.height())) {
+            reader.setScaledSize(sourceSize.scaled(targetSize, Qt::KeepAspectRatio));
+        }
+        QImage image = reader.read();
+        if (image.isNull()) {
+            qCWarning(lcUi) << "[ImageLoader] Failed to decode" << path << ":" << reader.errorString();
+        }
+        QMetaObject::invokeMethod(this, [this, key, image]() { onDecoded(key, image); }, Qt::QueuedConnection);
+    });
+}
+
+void ImageLoader::onDecoded(const QString &key, const QImage &image)
+{
+    QPixmap pixmap;
+    if (!image.isNull()) {
+        const qreal dpr = key.section('|', -1).toDouble();
+        pixmap = QPixmap::fromImage(image);
+        pixmap.setDevicePixelRatio(dpr > 0 ? dpr : 1.0);
+        pixmapCache.insert(key, new QPixmap(pixmap), qMax<qint64>(1, pixmap.width() * pixmap.height() * 4 / 1024));
+    }
+    const QList<Waiter> waiters = pending.take(key);
+    for (const Waiter &waiter : waiters) {
+        if (waiter.context && waiter.callback) waiter.callback(pixmap);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QPixmap>
+#include <QPointer>
+#include <QSize>
+#include <functional>
+
+// 异步图片加载：后台线程用QImageReader按目标尺寸解码，
+// GUI线程转换成QPixmap并按 路径+mtime+尺寸+DPR 缓存
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Callback = std::function<void(const QPixmap &pixmap)>;
+
+    static ImageLoader *instance();
+
+    // 请求一张缩放到 boundingSize 以内（保持比例，不放大）的图片。
+    // 命中缓存时立即回调；否则解码完成后在GUI线程回调，context销毁则不回调。
+    void request(const QString &path, const QSize &boundingSize, qreal dpr,
+                 QObject *context, Callback callback);
+    // 预取到缓存，不需要回调
+    void prefetch(const QString &path, const QSize &boundingSize, qreal dpr);
+    QPixmap cached(const QString &path, const QSize &boundingSize, qreal dpr) const;
+
+private:
+    explicit ImageLoader(QObject *parent = nullptr);
+    static QString cacheKey(const QString &path, const QSize &boundingSize, qreal dpr);
+    void onDecoded(const QString &key, const QImage &image);
+
+    struct Waiter {
+        QPointer<QObject> context;
+        Callback callback;
+    };
+    QCache<QString, QPixmap> pixmapCache; // cost 以KB计
+    QHash<QString, QList<Waiter>> pending; // 正在解码的key -> 等待者
+};
+
+#endif // IMAGELOADER_H
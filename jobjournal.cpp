@@ -0,0 +1,135 @@
+#include "jobjournal.h"
+#include "logcategories.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+#include <QUuid>
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const QString JobJournal::StageStep1Done = QStringLiteral("step1_done");
+const QString JobJournal::StageStep2Start = QStringLiteral("step2_start");
+const QString JobJournal::StagePromoted = QStringLiteral("promoted");
+const QString JobJournal::StageDone = QStringLiteral("done");
+const QString JobJournal::StageFailed = QStringLiteral("failed");
+
+JobJournal::JobJournal(const QString &path) : path(path)
+{
+}
+
+bool JobJournal::append(const QJsonObject &record)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(lcData) << "[JobJournal] Unable to open journal:" << path << file.errorString();
+        return false;
+    }
+    QJsonObject line = record;
+    line["ts"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    QByteArray data = QJsonDocument(line).toJson(QJsonDocument::Compact);
+    data.append('\n');
+    if (file.write(data) != data.size() || !file.flush()) {
+        qCWarning(lcData) << "[JobJournal] Write failed:" << file.errorString();
+        return false;
+    }
+    // 落盘后才算记录成功，断电也不会丢掉已完成的阶段
+#if defined(Q_OS_WIN)
+    _commit(file.handle());
+#else
+    ::fsync(file.handle());
+#endif
+    file.close();
+    return true;
+}
+
+QString JobJournal::beginBatch(const QString &kind, const QStringList &phenotypes, const QJsonObject &settings)
+{
+    const QString id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    QJsonObject record;
+    record["type"] = "batch";
+    record["batch"] = id;
+    record["kind"] = kind;
+    record["phenotypes"] = QJsonArray::fromStringList(phenotypes);
+    record["settings"] = settings;
+    return append(record) ? id : QString();
+}
+
+bool JobJournal::recordStage(const QString &batchId, const QString &phenotype, const QString &stage)
+{
+    if (batchId.isEmpty()) return false;
+    QJsonObject record;
+    record["type"] = "stage";
+    record["batch"] = batchId;
+    record["phenotype"] = phenotype;
+    record["stage"] = stage;
+    return append(record);
+}
+
+bool JobJournal::endBatch(const QString &batchId, const QString &reason)
+{
+    if (batchId.isEmpty()) return false;
+    QJsonObject record;
+    record["type"] = "end";
+    record["batch"] = batchId;
+    record["reason"] = reason;
+    if (!append(record)) return false;
+    // 没有需要续跑的内容时压缩为空，日志不会无限增长
+    if (unfinishedBatches().isEmpty()) QFile::remove(path);
+    return true;
+}
+
+QList<JobJournal::Batch> JobJournal::unfinishedBatches() const
+{
+    QList<Batch> batches;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return batches;
+    QMap<QString, int> indexById;
+    QSet<QString> ended;
+    while (!file.atEnd()) {
+        const QByteArray raw = file.readLine().trimmed();
+        if (raw.isEmpty()) continue;
+        // 崩溃时最后一行可能只写了一半，解析失败的行直接跳过
+        QJsonParseError parseError;
+        const QJsonObject record = QJsonDocument::fromJson(raw, &parseError).object();
+        if (parseError.error != QJsonParseError::NoError) {
+            qCWarning(lcData) << "[JobJournal] Skipping damaged line:" << raw.left(80);
+            continue;
+        }
+        const QString type = record.value("type").toString();
+        const QString id = record.value("batch").toString();
+        if (type == "batch") {
+            Batch batch;
+            batch.id = id;
+            batch.kind = record.value("kind").toString();
+            for (const QJsonValue &v : record.value("phenotypes").toArray()) batch.phenotypes << v.toString();
+            batch.settings = record.value("settings").toObject();
+            indexById.insert(id, batches.size());
+            batches << batch;
+        } else if (type == "stage" && indexById.contains(id)) {
+            Batch &batch = batches[indexById.value(id)];
+            const QString phenotype = record.value("phenotype").toString();
+            batch.stages[phenotype] = record.value("stage").toString();
+            batch.stageTimes[phenotype] = QDateTime::fromString(record.value("ts").toString(), Qt::ISODateWithMs);
+        } else if (type == "end") {
+            ended.insert(id);
+        }
+    }
+    file.close();
+    QList<Batch> unfinished;
+    for (const Batch &batch : batches) {
+        if (!ended.contains(batch.id)) unfinished << batch;
+    }
+    return unfinished;
+}
+
+QString JobJournal::checkpointPath(const QString &menetDir)
+{
+    return menetDir + "/saved/menet_checkpoint.pt";
+}
@@ -0,0 +1,51 @@
+#ifndef JOBJOURNAL_H
+#define JOBJOURNAL_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// 只追加的作业日志（每行一个JSON，写完立即fsync），记录批量训练/预测的
+// 表型列表、参数快照和每个表型的阶段变化。程序崩溃或重启后据此续跑未完成的批次
+class JobJournal
+{
+public:
+    // 阶段名
+    static const QString StageStep1Done;  // 第一步完成
+    static const QString StageStep2Start; // 第二步开始，之后写出的checkpoint属于本次运行
+    static const QString StagePromoted;   // 模型已重命名为<表型>_menet.pt
+    static const QString StageDone;       // 预测完成
+    static const QString StageFailed;
+
+    struct Batch {
+        QString id;
+        QString kind;                           // "train" 或 "predict"
+        QStringList phenotypes;
+        QJsonObject settings;                   // 表型 -> 参数快照
+        QMap<QString, QString> stages;          // 表型 -> 最后一个阶段
+        QMap<QString, QDateTime> stageTimes;    // 表型 -> 最后一个阶段的时间
+        bool isValid() const { return !id.isEmpty(); }
+    };
+
+    explicit JobJournal(const QString &path);
+
+    // 返回批次id；写入失败返回空串
+    QString beginBatch(const QString &kind, const QStringList &phenotypes, const QJsonObject &settings = QJsonObject());
+    bool recordStage(const QString &batchId, const QString &phenotype, const QString &stage);
+    // 批次结束（完成、取消或放弃续跑）；没有未完成的批次时清空日志文件
+    bool endBatch(const QString &batchId, const QString &reason);
+    // 所有未结束的批次，按开始顺序
+    QList<Batch> unfinishedBatches() const;
+
+    // train_menet写出的checkpoint位置；存在且比第二步开始时间新、并配置了[Resume] CheckpointArg时续训
+    static QString checkpointPath(const QString &menetDir);
+
+private:
+    QString path;
+    bool append(const QJsonObject &record);
+};
+
+#endif // JOBJOURNAL_H
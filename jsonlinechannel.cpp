@@ -0,0 +1,154 @@
+#include "jsonlinechannel.h"
+#include "logcategories.h"
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QTcpSocket>
+
+// 单行上限：产物块base64后约700KB，留足余量；超过视为协议错误
+static const int kMaxLineBytes = 8 * 1024 * 1024;
+// 写缓冲里超过两块时先不补，等bytesWritten
+static const qint64 kWriteHighWater = 2 * JsonLineChannel::kChunkSize;
+
+JsonLineChannel::JsonLineChannel(QIODevice *device, QObject *parent) : QObject(parent), device(device)
+{
+    device->setParent(this);
+    connect(device, &QIODevice::readyRead, this, &JsonLineChannel::onReadyRead);
+    connect(device, &QIODevice::bytesWritten, this, &JsonLineChannel::pump);
+    if (QTcpSocket *tcp = qobject_cast<QTcpSocket*>(device)) {
+        tcp->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(tcp, &QTcpSocket::disconnected, this, &JsonLineChannel::disconnected);
+        connect(tcp, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) { emit disconnected(); });
+    } else if (QLocalSocket *local = qobject_cast<QLocalSocket*>(device)) {
+        connect(local, &QLocalSocket::disconnected, this, &JsonLineChannel::disconnected);
+        connect(local, &QLocalSocket::errorOccurred, this, [this](QLocalSocket::LocalSocketError) { emit disconnected(); });
+    }
+}
+
+JsonLineChannel::~JsonLineChannel()
+{
+    // device是子对象，随本对象析构；先断开信号，避免析构过程中再发disconnected
+    device->disconnect(this);
+}
+
+bool JsonLineChannel::isOpen() const
+{
+    if (QTcpSocket *tcp = qobject_cast<QTcpSocket*>(device)) return tcp->state() == QAbstractSocket::ConnectedState;
+    if (QLocalSocket *local = qobject_cast<QLocalSocket*>(device)) return local->state() == QLocalSocket::ConnectedState;
+    return device->isOpen();
+}
+
+void JsonLineChannel::send(const QJsonObject &message)
+{
+    if (!isOpen()) return;
+    if (queue.isEmpty()) {
+        writeLine(message);
+        return;
+    }
+    // 前面还有文件没发完，排在它后面
+    Outgoing item;
+    item.line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    item.line.append('\n');
+    queuedBytes += item.line.size();
+    queue.enqueue(item);
+}
+
+void JsonLineChannel::writeLine(const QJsonObject &message)
+{
+    QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    device->write(line);
+}
+
+bool JsonLineChannel::sendFile(const QString &jobId, const QString &name, const QString &path)
+{
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) return false;
+    Outgoing item;
+    item.file = file;
+    item.jobId = jobId;
+    item.name = name;
+    item.size = file->size();
+    queuedBytes += item.size;
+    queue.enqueue(item);
+    pump();
+    return true;
+}
+
+void JsonLineChannel::pump()
+{
+    while (!queue.isEmpty() && isOpen() && device->bytesToWrite() < kWriteHighWater) {
+        Outgoing &item = queue.head();
+        if (!item.file) {
+            queuedBytes -= item.line.size();
+            device->write(queue.dequeue().line);
+            continue;
+        }
+        // 空文件也要发一块last=true
+        const QByteArray chunk = item.file->read(kChunkSize);
+        QJsonObject message;
+        message["type"] = "artifact";
+        message["job"] = item.jobId;
+        message["name"] = item.name;
+        message["offset"] = double(item.offset);
+        message["size"] = double(item.size);
+        message["data"] = QString::fromLatin1(chunk.toBase64());
+        item.offset += chunk.size();
+        queuedBytes -= chunk.size();
+        const bool last = chunk.isEmpty() || item.offset >= item.size;
+        message["last"] = last;
+        writeLine(message);
+        if (last) {
+            queuedBytes -= qMax<qint64>(0, item.size - item.offset);
+            queue.dequeue();
+        }
+    }
+}
+
+void JsonLineChannel::close()
+{
+    if (QTcpSocket *tcp = qobject_cast<QTcpSocket*>(device)) tcp->disconnectFromHost();
+    else if (QLocalSocket *local = qobject_cast<QLocalSocket*>(device)) local->disconnectFromServer();
+    else device->close();
+}
+
+QString JsonLineChannel::peerName() const
+{
+    if (QTcpSocket *tcp = qobject_cast<QTcpSocket*>(device)) {
+        return QString("%1:%2").arg(tcp->peerAddress().toString()).arg(tcp->peerPort());
+    }
+    if (QLocalSocket *local = qobject_cast<QLocalSocket*>(device)) return local->fullServerName();
+    return QString();
+}
+
+qint64 JsonLineChannel::bytesToWrite() const
+{
+    return device->bytesToWrite() + queuedBytes;
+}
+
+void JsonLineChannel::onReadyRead()
+{
+    buffer.append(device->readAll());
+    int start = 0;
+    for (;;) {
+        const int newline = buffer.indexOf('\n', start);
+        if (newline < 0) break;
+        const QByteArray line = buffer.mid(start, newline - start).trimmed();
+        start = newline + 1;
+        if (line.isEmpty()) continue;
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+        if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+            qCWarning(lcCluster) << "[JsonLineChannel] Ignoring malformed message from" << peerName() << error.errorString();
+            continue;
+        }
+        emit messageReceived(doc.object());
+    }
+    buffer.remove(0, start);
+    if (buffer.size() > kMaxLineBytes) {
+        qCWarning(lcCluster) << "[JsonLineChannel] Line too long, closing" << peerName();
+        buffer.clear();
+        close();
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef JSONLINECHANNEL_H
+#define JSONLINECHANNEL_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QQueue>
+#include <memory>
+
+class QFile;
+class QIODevice;
+
+// 调度端与agent之间的通信通道：每行一个紧凑JSON。
+// 底层可以是QTcpSocket或QLocalSocket（Unix socket），本类接管其生命周期
+class JsonLineChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kProtocolVersion = 1;
+    static constexpr qint64 kChunkSize = 512 * 1024; // 产物分块大小（编码前）
+
+    explicit JsonLineChannel(QIODevice *device, QObject *parent = nullptr);
+    ~JsonLineChannel();
+
+    bool isOpen() const;
+    void send(const QJsonObject &message);
+    // 把文件按块发出：{"type":"artifact","job","name","offset","size","data"(base64),"last"}。
+    // 文件在调用时打开，之后可以删除；各块在写缓冲排空时（bytesWritten）才读出下一块，
+    // 不阻塞事件循环。与send()的消息共用一个发送队列，保持先后顺序
+    bool sendFile(const QString &jobId, const QString &name, const QString &path);
+    void close();
+    QString peerName() const;
+    qint64 bytesToWrite() const; // 尚未写出的字节数（含队列里未读出的文件），用来发现消费过慢的对端
+
+signals:
+    void messageReceived(const QJsonObject &message);
+    void disconnected();
+
+private slots:
+    void onReadyRead();
+    void pump(); // 写缓冲低于水位时从队列里补
+
+private:
+    struct Outgoing {
+        QByteArray line;                // 普通消息
+        std::shared_ptr<QFile> file;    // 非空时为分块发送的文件
+        QString jobId;
+        QString name;
+        qint64 offset = 0;
+        qint64 size = 0;
+    };
+
+    QIODevice *device;
+    QByteArray buffer;
+    QQueue<Outgoing> queue;
+    qint64 queuedBytes = 0;             // 队列里还没交给device的字节数
+
+    void writeLine(const QJsonObject &message);
+};
+
+#endif // JSONLINECHANNEL_H
@@ -0,0 +1,31 @@
+#include "logcategories.h"
+#include "appconfig.h"
+#include <QStringList>
+
+// 默认级别：debug关闭；progress每个epoch都会输出，info也关闭
+Q_LOGGING_CATEGORY(lcWorker, "menet.worker", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcProgress, "menet.progress", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcConfig, "menet.config", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcUi, "menet.ui", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcCluster, "menet.cluster", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcControl, "menet.control", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcData, "menet.data", QtInfoMsg)
+
+namespace LogCategories {
+
+void applyRules(bool developMode)
+{
+    QStringList rules;
+    if (developMode) {
+        rules << "menet.worker.debug=true" << "menet.config.debug=true" << "menet.ui.debug=true"
+              << "menet.cluster.debug=true" << "menet.control.debug=true" << "menet.data.debug=true";
+    }
+    // config.ini里一行写不下多条规则，用分号分隔；后写的规则覆盖前面的
+    for (const QString &rule : AppConfig::value("Logging", "Rules").split(';', Qt::SkipEmptyParts)) {
+        if (!rule.trimmed().isEmpty()) rules << rule.trimmed();
+    }
+    // QT_LOGGING_RULES环境变量由Qt在这些规则之后应用，可以临时覆盖
+    QLoggingCategory::setFilterRules(rules.join('\n'));
+}
+
+} // namespace LogCategories
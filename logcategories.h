@@ -0,0 +1,24 @@
+#ifndef LOGCATEGORIES_H
+#define LOGCATEGORIES_H
+
+#include <QLoggingCategory>
+
+// 热路径上的日志分类。qCDebug/qCInfo在该级别关闭时只做一次开关判断，参数完全不求值。
+// 运行时开关：config.ini [Logging] Rules（分号分隔，如 "menet.progress.debug=true;menet.worker.info=false"），
+// 或环境变量QT_LOGGING_RULES（优先级最高）。Release构建里debug级别在编译期去掉（CMake选项DEMO01_STRIP_DEBUG_LOGS）
+Q_DECLARE_LOGGING_CATEGORY(lcWorker)   // menet.worker：Worker的步骤和子进程启动/结束
+Q_DECLARE_LOGGING_CATEGORY(lcProgress) // menet.progress：每个epoch/进度刷新，默认只输出警告
+Q_DECLARE_LOGGING_CATEGORY(lcConfig)   // menet.config：config.ini和各json配置的读写
+Q_DECLARE_LOGGING_CATEGORY(lcUi)       // menet.ui：主窗口的流程日志
+Q_DECLARE_LOGGING_CATEGORY(lcCluster)  // menet.cluster：集群调度器、节点agent和它们之间的连接
+Q_DECLARE_LOGGING_CATEGORY(lcControl)  // menet.control：本机控制接口
+Q_DECLARE_LOGGING_CATEGORY(lcData)     // menet.data：模型仓库、运行历史、作业日志、缓存和文件转换
+
+namespace LogCategories {
+
+// 按开发模式和config.ini设置过滤规则；开发模式下除progress外的debug都打开
+void applyRules(bool developMode);
+
+} // namespace LogCategories
+
+#endif // LOGCATEGORIES_H
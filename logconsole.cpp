@@ -0,0 +1,134 @@
+#include "logconsole.h"
+#include "outputcapture.h"
+#include <QCheckBox>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QFont>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QRegularExpression>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QVBoxLayout>
+
+LogConsole::LogConsole(QWidget *parent) : QWidget(parent)
+{
+    setWindowTitle(tr("Process Output"));
+    resize(800, 480);
+
+    textEdit = new QPlainTextEdit(this);
+    textEdit->setReadOnly(true);
+    textEdit->setMaximumBlockCount(kMaxBlocks);
+    textEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    textEdit->setUndoRedoEnabled(false);
+    QFont mono("Consolas");
+    mono.setStyleHint(QFont::Monospace);
+    textEdit->setFont(mono);
+
+    followCheck = new QCheckBox(tr("Follow output"), this);
+    followCheck->setChecked(true);
+    statusLabel = new QLabel(this);
+    QPushButton *clearButton = new QPushButton(tr("Clear"), this);
+    QPushButton *exportButton = new QPushButton(tr("Export full output..."), this);
+    QPushButton *closeButton = new QPushButton(tr("Close"), this);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(followCheck);
+    buttonLayout->addWidget(statusLabel, 1);
+    buttonLayout->addWidget(clearButton);
+    buttonLayout->addWidget(exportButton);
+    buttonLayout->addWidget(closeButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(textEdit);
+    layout->addLayout(buttonLayout);
+
+    connect(clearButton, &QPushButton::clicked, textEdit, &QPlainTextEdit::clear);
+    connect(exportButton, &QPushButton::clicked, this, &LogConsole::exportOutput);
+    connect(closeButton, &QPushButton::clicked, this, &QWidget::close);
+
+    // 最多每100ms往文本框里追加一次
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(100);
+    connect(&flushTimer, &QTimer::timeout, this, &LogConsole::flushPending);
+}
+
+void LogConsole::appendOutput(const QByteArray &data)
+{
+    pending += decoder.decode(data);
+    if (pending.size() > kMaxPendingChars) {
+        // 来不及显示的部分直接丢弃，完整内容在溢出文件/环形缓冲里
+        const qsizetype drop = pending.size() - kMaxPendingChars;
+        pending.remove(0, drop);
+        droppedChars += drop;
+    }
+    if (!flushTimer.isActive()) flushTimer.start();
+}
+
+void LogConsole::beginSection(const QString &title)
+{
+    flushPending();
+    decoder.resetState();
+    pending = QString("\n===== %1  %2 =====\n").arg(QDateTime::currentDateTime().toString("hh:mm:ss"), title);
+    flushPending();
+}
+
+void LogConsole::noteSpillFile(const QString &path)
+{
+    lastSpillPath = path;
+    statusLabel->setText(tr("Full output: %1").arg(QDir::toNativeSeparators(path)));
+}
+
+void LogConsole::flushPending()
+{
+    if (pending.isEmpty()) return;
+    QString text;
+    if (droppedChars > 0) {
+        text = tr("[... %1 characters not shown ...]\n").arg(droppedChars);
+        droppedChars = 0;
+    }
+    text += pending;
+    pending.clear();
+    // 进度条之类的回车覆盖输出按换行处理
+    text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    text.replace(QLatin1Char('\r'), QLatin1Char('\n'));
+
+    QScrollBar *bar = textEdit->verticalScrollBar();
+    const int keepScroll = bar->value();
+    QTextCursor cursor(textEdit->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+    if (followCheck->isChecked()) {
+        bar->setValue(bar->maximum());
+    } else {
+        bar->setValue(keepScroll);
+    }
+}
+
+void LogConsole::exportOutput()
+{
+    const QString outputDir = QDir::currentPath() + "/MENET/logs/output";
+    const QString source = QFileDialog::getOpenFileName(this, tr("Select captured output"),
+                                                        lastSpillPath.isEmpty() ? outputDir : lastSpillPath,
+                                                        tr("Captured output (*.zlog)"));
+    if (source.isEmpty()) return;
+    QString target = source;
+    target.replace(QRegularExpression("\\.zlog$"), ".txt");
+    target = QFileDialog::getSaveFileName(this, tr("Save output as"), target, tr("Text files (*.txt)"));
+    if (target.isEmpty()) return;
+    QFile out(target);
+    QString error;
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = out.errorString();
+    } else if (!OutputCapture::decompressTo(source, &out, &error)) {
+        out.close();
+    }
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), error);
+    }
+}
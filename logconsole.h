@@ -0,0 +1,44 @@
+#ifndef LOGCONSOLE_H
+#define LOGCONSOLE_H
+
+#include <QWidget>
+#include <QStringDecoder>
+#include <QTimer>
+
+class QPlainTextEdit;
+class QCheckBox;
+class QLabel;
+
+// 子进程输出的实时控制台：输出先攒在待追加缓冲里，定时批量写入文本框；
+// 文本框限制最大行数，缓冲也有上限，输出再多界面内存也不会增长
+class LogConsole : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kMaxBlocks = 5000;
+    static constexpr int kMaxPendingChars = 256 * 1024;
+
+    explicit LogConsole(QWidget *parent = nullptr);
+
+public slots:
+    void appendOutput(const QByteArray &data);
+    void beginSection(const QString &title); // 新的子进程开始时插入一行分隔标题
+    void noteSpillFile(const QString &path); // 提示完整输出保存在哪个溢出文件
+
+private slots:
+    void flushPending();
+    void exportOutput();
+
+private:
+    QPlainTextEdit *textEdit = nullptr;
+    QCheckBox *followCheck = nullptr;
+    QLabel *statusLabel = nullptr;
+    QStringDecoder decoder{QStringDecoder::System};
+    QString pending;
+    qint64 droppedChars = 0;
+    QTimer flushTimer;
+    QString lastSpillPath;
+};
+
+#endif // LOGCONSOLE_H
@@ -0,0 +1,54 @@
+#include "logfollower.h"
+#include <QFile>
+
+LogFollower::LogFollower(const QString &path) : logPath(path) {}
+
+void LogFollower::reset(const QString &path)
+{
+    logPath = path;
+    offset = 0;
+    partialLine.clear();
+}
+
+QStringList LogFollower::readNewLines()
+{
+    QStringList lines;
+    QFile f(logPath);
+    if (!f.open(QIODevice::ReadOnly)) return lines;
+    // 日志被删除重建（比如下一个表型）时从头开始
+    if (f.size() < offset) {
+        offset = 0;
+        partialLine.clear();
+    }
+    if (f.size() == offset || !f.seek(offset)) return lines;
+    // 每次最多读4MB，避免一次性把大日志读进内存
+    QByteArray chunk = f.read(qMin<qint64>(f.size() - offset, 4 * 1024 * 1024));
+    offset += chunk.size();
+    partialLine += chunk;
+    int start = 0;
+    int nl;
+    while ((nl = partialLine.indexOf('\n', start)) >= 0) {
+        QByteArray line = partialLine.mid(start, nl - start);
+        if (line.endsWith('\r')) line.chop(1);
+        lines << QString::fromUtf8(line);
+        start = nl + 1;
+    }
+    partialLine.remove(0, start);
+    return lines;
+}
+
+QStringList LogFollower::drainAll()
+{
+    QStringList lines;
+    qint64 before;
+    do {
+        before = offset;
+        lines << readNewLines();
+    } while (offset != before);
+    if (!partialLine.isEmpty()) {
+        if (partialLine.endsWith('\r')) partialLine.chop(1);
+        lines << QString::fromUtf8(partialLine);
+        partialLine.clear();
+    }
+    return lines;
+}
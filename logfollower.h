@@ -0,0 +1,24 @@
+#ifndef LOGFOLLOWER_H
+#define LOGFOLLOWER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+// 增量读取正在写入的日志：记住上次读到的偏移，每次只返回新增的完整行
+class LogFollower
+{
+public:
+    explicit LogFollower(const QString &path = QString());
+    void reset(const QString &path);
+    QStringList readNewLines(); // 每次最多读4MB
+    // 进程结束后的最后一次读取：读到文件末尾为止，没有换行结尾的最后一行也一起返回
+    QStringList drainAll();
+
+private:
+    QString logPath;
+    qint64 offset = 0;
+    QByteArray partialLine; // 尚未以换行结尾的残留
+};
+
+#endif // LOGFOLLOWER_H
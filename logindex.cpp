@@ -0,0 +1,490 @@
+#include "logindex.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QtNumeric>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+// 文件布局（小端）：
+//   0  "MENETIDX"        8字节魔数
+//   8  u32 版本          12 u32 指标数M
+//   16 u32 epoch行数N    20 u32 保留
+//   24 i64 日志大小       32 i64 日志修改时间（毫秒），两者与日志不符即视为过期
+//   40 i64 epoch数组偏移  48 i64 字节偏移数组偏移  56 i64 指标值偏移  64 i64 保留
+//   72 指标名：每个 u16长度 + UTF-8，之后补齐到8字节
+//   i32[N] epoch，补齐到8字节；i64[N] 每个epoch行在日志里的字节偏移；double[M][N] 按列存放
+const char kMagic[8] = {'M', 'E', 'N', 'E', 'T', 'I', 'D', 'X'};
+const quint32 kVersion = 1;
+const qint64 kHeaderSize = 72;
+const qint64 kChunkSize = 4 * 1024 * 1024;
+
+inline bool isIdentStart(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isIdentChar(char c) { return isIdentStart(c) || isDigit(c); }
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+
+// 从p开始匹配 [-+]?(\d+\.?\d*|\.\d+)([eE][-+]?\d+)?（与parseEpochMetrics的正则一致），
+// 返回数字的结束位置；不是数字返回p
+const char *scanNumber(const char *p, const char *end)
+{
+    const char *q = p;
+    if (q < end && (*q == '-' || *q == '+')) ++q;
+    const char *digits = q;
+    while (q < end && isDigit(*q)) ++q;
+    if (q > digits) {
+        if (q < end && *q == '.') {
+            ++q;
+            while (q < end && isDigit(*q)) ++q;
+        }
+    } else if (q + 1 < end && *q == '.' && isDigit(q[1])) {
+        q += 2;
+        while (q < end && isDigit(*q)) ++q;
+    } else {
+        return p;
+    }
+    if (q < end && (*q == 'e' || *q == 'E')) {
+        const char *e = q + 1;
+        if (e < end && (*e == '-' || *e == '+')) ++e;
+        if (e < end && isDigit(*e)) {
+            while (e < end && isDigit(*e)) ++e;
+            q = e;
+        }
+    }
+    return q;
+}
+
+// 只有含"epoch"的行才可能是epoch行。memchr找'e'再比较，大部分进度行一两次memchr就排除了
+bool containsEpoch(const char *p, const char *end)
+{
+    while (end - p >= 5) {
+        const char *hit = static_cast<const char *>(memchr(p, 'e', size_t(end - p - 4)));
+        if (!hit) return false;
+        if (memcmp(hit, "epoch", 5) == 0) return true;
+        p = hit + 1;
+    }
+    return false;
+}
+
+class IndexBuilder
+{
+public:
+    QVector<qint32> epochs;
+    QVector<qint64> offsets;
+    QList<QByteArray> names;
+    QVector<QVector<double>> columns;
+
+    void addLine(const char *begin, const char *end, qint64 offset);
+
+private:
+    struct Pending {
+        const char *name;
+        int length;
+        double value;
+    };
+    QHash<QByteArray, int> columnOf;
+    QVector<Pending> pending; // 当前行的name = value，确认是epoch行后再落到列里
+
+    int column(const char *name, int length);
+};
+
+int IndexBuilder::column(const char *name, int length)
+{
+    const auto it = columnOf.constFind(QByteArray::fromRawData(name, length));
+    if (it != columnOf.constEnd()) return it.value();
+    // 新出现的指标：之前的行都没有这个值
+    const QByteArray owned(name, length);
+    columnOf.insert(owned, names.size());
+    names << owned;
+    columns.append(QVector<double>(epochs.size(), qQNaN()));
+    return names.size() - 1;
+}
+
+void IndexBuilder::addLine(const char *begin, const char *end, qint64 offset)
+{
+    if (!containsEpoch(begin, end)) return;
+    qint64 epoch = -1;
+    pending.clear();
+    const char *p = begin;
+    while (p < end) {
+        if (!isIdentStart(*p)) {
+            ++p;
+            continue;
+        }
+        const char *nameEnd = p;
+        while (nameEnd < end && isIdentChar(*nameEnd)) ++nameEnd;
+        const char *q = nameEnd;
+        while (q < end && isSpace(*q)) ++q;
+        if (q == end || *q != '=') {
+            p = nameEnd;
+            continue;
+        }
+        ++q;
+        while (q < end && isSpace(*q)) ++q;
+        const char *numberEnd = scanNumber(q, end);
+        if (numberEnd == q) {
+            p = nameEnd;
+            continue;
+        }
+        const int length = int(nameEnd - p);
+        if (length == 5 && memcmp(p, "epoch", 5) == 0) {
+            // epoch只认第一个无符号整数
+            if (epoch < 0 && isDigit(*q)) {
+                epoch = 0;
+                for (const char *d = q; d < end && isDigit(*d) && epoch <= INT_MAX; ++d) epoch = epoch * 10 + (*d - '0');
+                if (epoch > INT_MAX) epoch = -1;
+            }
+        } else {
+            bool ok = false;
+            const double value = QByteArray::fromRawData(q, int(numberEnd - q)).toDouble(&ok);
+            if (ok) pending.append({p, length, value});
+        }
+        p = numberEnd;
+    }
+    if (epoch < 0) return;
+    // 从checkpoint续训时新的epoch追加在同一日志后面，同号及之后的旧epoch以新写的为准
+    if (!epochs.isEmpty() && epoch <= epochs.last()) {
+        const int keep = int(std::lower_bound(epochs.begin(), epochs.end(), qint32(epoch)) - epochs.begin());
+        epochs.resize(keep);
+        offsets.resize(keep);
+        for (QVector<double> &values : columns) values.resize(keep);
+    }
+    epochs.append(qint32(epoch));
+    offsets.append(offset);
+    for (QVector<double> &values : columns) values.append(qQNaN());
+    for (const Pending &metric : std::as_const(pending)) {
+        columns[column(metric.name, metric.length)].last() = metric.value;
+    }
+}
+
+// 按块读日志，memchr切行；跨块的半行留到下一块开头
+bool scanLog(QFile &log, IndexBuilder &builder, QString *error)
+{
+    QByteArray buffer;
+    qint64 base = 0; // buffer第0个字节在日志里的偏移
+    for (;;) {
+        const int carry = buffer.size();
+        buffer.resize(carry + int(kChunkSize));
+        const qint64 got = log.read(buffer.data() + carry, kChunkSize);
+        if (got < 0) {
+            if (error) *error = log.errorString();
+            return false;
+        }
+        buffer.resize(carry + int(got));
+        const bool atEnd = got == 0;
+        const char *begin = buffer.constData();
+        const char *end = begin + buffer.size();
+        const char *line = begin;
+        while (line < end) {
+            const char *newline = static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+            if (!newline) {
+                if (!atEnd) break;
+                newline = end; // 最后一行没有换行
+            }
+            builder.addLine(line, newline, base + (line - begin));
+            line = newline < end ? newline + 1 : end;
+        }
+        if (atEnd) return true;
+        const int consumed = int(line - begin);
+        buffer.remove(0, consumed);
+        base += consumed;
+    }
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray &out, T value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void padTo8(QByteArray &out)
+{
+    while (out.size() % 8) out.append('\0');
+}
+
+// 整数数组按小端写出；小端机器上直接写内存
+template <typename T>
+bool writeArray(QSaveFile &out, const QVector<T> &values)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const qint64 bytes = qint64(values.size()) * qint64(sizeof(T));
+    return out.write(reinterpret_cast<const char *>(values.constData()), bytes) == bytes;
+#else
+    QByteArray block;
+    block.reserve(values.size() * int(sizeof(T)));
+    for (T value : values) appendLittleEndian(block, value);
+    return out.write(block) == block.size();
+#endif
+}
+
+bool writeColumn(QSaveFile &out, const QVector<double> &values)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const qint64 bytes = qint64(values.size()) * qint64(sizeof(double));
+    return out.write(reinterpret_cast<const char *>(values.constData()), bytes) == bytes;
+#else
+    QByteArray block;
+    block.reserve(values.size() * int(sizeof(double)));
+    for (double value : values) {
+        quint64 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        appendLittleEndian(block, bits);
+    }
+    return out.write(block) == block.size();
+#endif
+}
+
+} // namespace
+
+LogIndex::~LogIndex()
+{
+    close();
+}
+
+QString LogIndex::indexPathFor(const QString &logPath)
+{
+    return logPath + ".idx";
+}
+
+bool LogIndex::build(const QString &logPath, QString *error)
+{
+    QFile log(logPath);
+    if (!log.open(QIODevice::ReadOnly)) {
+        if (error) *error = log.errorString();
+        return false;
+    }
+    // 大小和修改时间取扫描前的值：扫描期间日志若还在增长，下次打开会发现过期并重建
+    const QFileInfo logInfo(logPath);
+    const qint64 logSize = logInfo.size();
+    const qint64 logMtime = logInfo.lastModified().toMSecsSinceEpoch();
+    IndexBuilder builder;
+    if (!scanLog(log, builder, error)) return false;
+    log.close();
+
+    const int rowCount = builder.epochs.size();
+    QByteArray head;
+    head.append(kMagic, sizeof(kMagic));
+    appendLittleEndian<quint32>(head, kVersion);
+    appendLittleEndian<quint32>(head, quint32(builder.names.size()));
+    appendLittleEndian<quint32>(head, quint32(rowCount));
+    appendLittleEndian<quint32>(head, 0);
+    appendLittleEndian<qint64>(head, logSize);
+    appendLittleEndian<qint64>(head, logMtime);
+    QByteArray namesBlock;
+    for (const QByteArray &name : std::as_const(builder.names)) {
+        appendLittleEndian<quint16>(namesBlock, quint16(name.size()));
+        namesBlock += name;
+    }
+    padTo8(namesBlock);
+    const qint64 epochsAt = kHeaderSize + namesBlock.size();
+    const qint64 offsetsAt = epochsAt + ((qint64(rowCount) * 4 + 7) / 8) * 8;
+    const qint64 valuesAt = offsetsAt + qint64(rowCount) * 8;
+    appendLittleEndian<qint64>(head, epochsAt);
+    appendLittleEndian<qint64>(head, offsetsAt);
+    appendLittleEndian<qint64>(head, valuesAt);
+    appendLittleEndian<qint64>(head, 0);
+    head += namesBlock;
+
+    QSaveFile out(indexPathFor(logPath));
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    bool ok = out.write(head) == head.size() && writeArray(out, builder.epochs);
+    if (ok && rowCount % 2) ok = out.write(QByteArray(4, '\0')) == 4;
+    ok = ok && writeArray(out, builder.offsets);
+    for (const QVector<double> &values : std::as_const(builder.columns)) {
+        if (!ok) break;
+        ok = writeColumn(out, values);
+    }
+    if (!ok || !out.commit()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString LogIndex::archive(const QString &logPath, const QString &archiveDir, const QString &fileName, QString *error)
+{
+    if (!QDir().mkpath(archiveDir)) {
+        if (error) *error = QString("Cannot create %1").arg(archiveDir);
+        return QString();
+    }
+    const QString target = QDir(archiveDir).filePath(fileName);
+    QFile::remove(indexPathFor(target));
+    if (QFile::exists(target)) QFile::remove(target);
+    if (QFile::rename(logPath, target)) return target;
+    // 跨分区时rename失败，退回复制
+    QFile source(logPath);
+    if (!source.copy(target)) {
+        if (error) *error = source.errorString();
+        return QString();
+    }
+    QFile::remove(logPath);
+    return target;
+}
+
+bool LogIndex::open(const QString &logPath, bool rebuildIfStale, QString *error)
+{
+    close();
+    const QFileInfo logInfo(logPath);
+    if (!logInfo.isFile()) {
+        if (error) *error = QString("%1 not found").arg(logPath);
+        return false;
+    }
+    if (mapIndex(logInfo)) return true;
+    if (!rebuildIfStale) {
+        if (error) *error = QString("Index for %1 is missing or out of date").arg(logPath);
+        return false;
+    }
+    if (!build(logPath, error)) return false;
+    if (mapIndex(QFileInfo(logPath))) return true;
+    if (error) *error = QString("Cannot read %1").arg(indexPathFor(logPath));
+    return false;
+}
+
+bool LogIndex::mapIndex(const QFileInfo &logInfo)
+{
+    file.setFileName(indexPathFor(logInfo.filePath()));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const qint64 size = file.size();
+    uchar *mapped = size >= kHeaderSize ? file.map(0, size) : nullptr;
+    if (!mapped) {
+        file.close();
+        return false;
+    }
+    data = mapped;
+    mappedSize = size;
+    auto fail = [this]() {
+        close();
+        return false;
+    };
+    if (memcmp(data, kMagic, sizeof(kMagic)) != 0 || qFromLittleEndian<quint32>(data + 8) != kVersion) return fail();
+    const quint32 metricCount = qFromLittleEndian<quint32>(data + 12);
+    const quint32 rowCount = qFromLittleEndian<quint32>(data + 16);
+    if (qFromLittleEndian<qint64>(data + 24) != logInfo.size()
+        || qFromLittleEndian<qint64>(data + 32) != logInfo.lastModified().toMSecsSinceEpoch()) {
+        return fail();
+    }
+    epochsOffset = qFromLittleEndian<qint64>(data + 40);
+    offsetsOffset = qFromLittleEndian<qint64>(data + 48);
+    valuesOffset = qFromLittleEndian<qint64>(data + 56);
+    if (rowCount > quint32(INT_MAX) || epochsOffset < kHeaderSize || offsetsOffset < epochsOffset + qint64(rowCount) * 4
+        || valuesOffset < offsetsOffset + qint64(rowCount) * 8
+        || valuesOffset + qint64(metricCount) * qint64(rowCount) * 8 > mappedSize) {
+        return fail();
+    }
+    rows = int(rowCount);
+    qint64 pos = kHeaderSize;
+    for (quint32 i = 0; i < metricCount; ++i) {
+        if (pos + 2 > epochsOffset) return fail();
+        const int length = qFromLittleEndian<quint16>(data + pos);
+        pos += 2;
+        if (pos + length > epochsOffset) return fail();
+        const QString name = QString::fromUtf8(reinterpret_cast<const char *>(data + pos), length);
+        pos += length;
+        columnOf.insert(name, names.size());
+        names << name;
+    }
+    sourcePath = logInfo.filePath();
+    return true;
+}
+
+void LogIndex::close()
+{
+    if (data) file.unmap(const_cast<uchar *>(data));
+    data = nullptr;
+    mappedSize = 0;
+    if (file.isOpen()) file.close();
+    rows = 0;
+    names.clear();
+    columnOf.clear();
+    sourcePath.clear();
+}
+
+int LogIndex::epochAt(int row) const
+{
+    if (!data || row < 0 || row >= rows) return -1;
+    return qFromLittleEndian<qint32>(data + epochsOffset + qint64(row) * 4);
+}
+
+int LogIndex::rowOf(int epoch) const
+{
+    int lo = 0;
+    int hi = rows - 1;
+    while (lo <= hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const int value = epochAt(mid);
+        if (value == epoch) return mid;
+        if (value < epoch) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+qint64 LogIndex::offsetOf(int epoch) const
+{
+    const int row = rowOf(epoch);
+    return row < 0 ? -1 : qFromLittleEndian<qint64>(data + offsetsOffset + qint64(row) * 8);
+}
+
+double LogIndex::valueAt(int column, int row) const
+{
+    const quint64 bits = qFromLittleEndian<quint64>(data + valuesOffset + (qint64(column) * rows + row) * 8);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double LogIndex::value(const QString &metric, int epoch) const
+{
+    const int row = rowOf(epoch);
+    const auto it = columnOf.constFind(metric);
+    if (row < 0 || it == columnOf.constEnd()) return qQNaN();
+    return valueAt(it.value(), row);
+}
+
+bool LogIndex::metricsAt(int epoch, EpochMetrics &out) const
+{
+    const int row = rowOf(epoch);
+    if (row < 0) return false;
+    out.epoch = epoch;
+    out.values.clear();
+    for (int column = 0; column < names.size(); ++column) {
+        const double value = valueAt(column, row);
+        if (!qIsNaN(value)) out.values.insert(names.at(column), value);
+    }
+    return true;
+}
+
+QVector<int> LogIndex::epochs() const
+{
+    QVector<int> result(rows);
+    for (int row = 0; row < rows; ++row) result[row] = epochAt(row);
+    return result;
+}
+
+QVector<double> LogIndex::column(const QString &metric) const
+{
+    const auto it = columnOf.constFind(metric);
+    if (it == columnOf.constEnd()) return QVector<double>();
+    QVector<double> result(rows);
+    for (int row = 0; row < rows; ++row) result[row] = valueAt(it.value(), row);
+    return result;
+}
+
+QString LogIndex::lineAt(int epoch) const
+{
+    const qint64 offset = offsetOf(epoch);
+    if (offset < 0) return QString();
+    QFile log(sourcePath);
+    if (!log.open(QIODevice::ReadOnly) || !log.seek(offset)) return QString();
+    QByteArray line = log.readLine();
+    while (line.endsWith('\n') || line.endsWith('\r')) line.chop(1);
+    return QString::fromUtf8(line);
+}
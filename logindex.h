@@ -0,0 +1,71 @@
+#ifndef LOGINDEX_H
+#define LOGINDEX_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "metricparser.h"
+
+class QFileInfo;
+
+// 已结束训练日志的偏移索引（与日志同名的.idx文件）。一次顺序扫描日志：
+// 按块读入，memchr找换行，只对含"epoch"的行做字节级解析，记录每个epoch行的字节偏移，
+// 各指标按列连续存放（列式，每列N个double）。查询、画曲线、跨运行比较只映射索引文件，
+// 需要原文时直接seek到对应行，耗时与日志大小无关。
+// 续训追加到同一日志时epoch会回退，索引以后写的为准，epoch保持递增，按epoch二分查找
+class LogIndex
+{
+public:
+    LogIndex() = default;
+    ~LogIndex();
+    LogIndex(const LogIndex &) = delete;
+    LogIndex &operator=(const LogIndex &) = delete;
+
+    static QString indexPathFor(const QString &logPath);
+    // 扫描日志写出索引，先写临时文件再替换
+    static bool build(const QString &logPath, QString *error = nullptr);
+    // 把日志移到archiveDir/fileName（同一分区内是一次重命名，否则复制后删除原文件），返回新路径，失败返回空串
+    static QString archive(const QString &logPath, const QString &archiveDir, const QString &fileName, QString *error = nullptr);
+
+    // 映射日志的索引。索引缺失、损坏或与日志的大小/修改时间不符时，rebuildIfStale为true则先重建
+    bool open(const QString &logPath, bool rebuildIfStale = true, QString *error = nullptr);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    QString logPath() const { return sourcePath; }
+
+    int epochCount() const { return rows; }
+    QStringList metricNames() const { return names; }
+    bool hasMetric(const QString &metric) const { return columnOf.contains(metric); }
+    int epochAt(int row) const;
+    // epoch所在的行号，二分查找；没有这个epoch返回-1
+    int rowOf(int epoch) const;
+    // epoch行在日志里的字节偏移，没有返回-1
+    qint64 offsetOf(int epoch) const;
+    // 指标在该epoch的值，没有记录时为NaN
+    double value(const QString &metric, int epoch) const;
+    bool metricsAt(int epoch, EpochMetrics &out) const;
+    // 按行顺序的全部epoch和某一列，用于画曲线和比较
+    QVector<int> epochs() const;
+    QVector<double> column(const QString &metric) const;
+    // seek到epoch行读出日志原文
+    QString lineAt(int epoch) const;
+
+private:
+    bool mapIndex(const QFileInfo &logInfo);
+    double valueAt(int column, int row) const;
+
+    QFile file;
+    const uchar *data = nullptr;
+    qint64 mappedSize = 0;
+    QString sourcePath;
+    int rows = 0;
+    QStringList names;
+    QHash<QString, int> columnOf;
+    qint64 epochsOffset = 0;
+    qint64 offsetsOffset = 0;
+    qint64 valuesOffset = 0;
+};
+
+#endif // LOGINDEX_H
@@ -0,0 +1,72 @@
+#include "logtail.h"
+#include <QFile>
+
+bool LogTail::scanBackward(const QString &path, const std::function<bool(const QString &line)> &visit)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    qint64 pos = f.size();
+    QByteArray carry; // 当前块之后、还没遇到行首的那一段
+    bool skipTrailingNewline = true;
+    while (pos > 0) {
+        qint64 readSize = qMin(kBlockSize, pos);
+        pos -= readSize;
+        if (!f.seek(pos)) return false;
+        QByteArray block = f.read(readSize);
+        if (block.size() != readSize) return false;
+        block += carry;
+        carry.clear();
+        int end = block.size();
+        // 文件末尾的换行不算一个空行
+        if (skipTrailingNewline) {
+            skipTrailingNewline = false;
+            if (end > 0 && block.at(end - 1) == '\n') --end;
+        }
+        int nl;
+        while (end > 0 && (nl = block.lastIndexOf('\n', end - 1)) >= 0) {
+            QByteArray line = block.mid(nl + 1, end - nl - 1);
+            if (line.endsWith('\r')) line.chop(1);
+            if (!visit(QString::fromUtf8(line))) return true;
+            end = nl;
+        }
+        carry = block.left(end);
+    }
+    if (!carry.isEmpty() || f.size() > 0) {
+        if (carry.endsWith('\r')) carry.chop(1);
+        visit(QString::fromUtf8(carry));
+    }
+    return true;
+}
+
+QStringList LogTail::lastLines(const QString &path, int count)
+{
+    QStringList lines;
+    if (count <= 0) return lines;
+    scanBackward(path, [&](const QString &line) {
+        lines.prepend(line);
+        return lines.size() < count;
+    });
+    return lines;
+}
+
+QString LogTail::lastNonEmptyLine(const QString &path)
+{
+    QString result;
+    scanBackward(path, [&](const QString &line) {
+        if (line.trimmed().isEmpty()) return true;
+        result = line;
+        return false;
+    });
+    return result;
+}
+
+QString LogTail::lastMatchingLine(const QString &path, const QRegularExpression &re)
+{
+    QString result;
+    scanBackward(path, [&](const QString &line) {
+        if (!re.match(line).hasMatch()) return true;
+        result = line;
+        return false;
+    });
+    return result;
+}
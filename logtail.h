@@ -0,0 +1,27 @@
+#ifndef LOGTAIL_H
+#define LOGTAIL_H
+
+#include <QByteArray>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+// 从文件末尾按固定大小的块向前扫描日志，内存占用与日志大小无关
+class LogTail
+{
+public:
+    static constexpr qint64 kBlockSize = 64 * 1024;
+
+    // 最后count行（按文件中的顺序返回）
+    static QStringList lastLines(const QString &path, int count);
+    // 最后一个非空行；找不到返回空串
+    static QString lastNonEmptyLine(const QString &path);
+    // 最后一个匹配re的行；找不到返回空串
+    static QString lastMatchingLine(const QString &path, const QRegularExpression &re);
+
+    // 从后往前逐行回调（行不含换行符），visit返回false时停止。文件打不开返回false
+    static bool scanBackward(const QString &path, const std::function<bool(const QString &line)> &visit);
+};
+
+#endif // LOGTAIL_H
@@ -1,4 +1,7 @@
 #include "mainwindow.h"
+#include "appconfig.h"
+#include "startupprofiler.h"
+#include "logcategories.h"
 #include <QApplication>
 #include <QFile>
 #include <QTextStream>
@@ -18,6 +21,8 @@ void myMessageHandler(QtMsgType type, const QMessageLogContext &context, const Q
     if (!g_logFile) return;
     QTextStream out(g_logFile);
     QString time = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
+    // 分类日志带上分类名，便于按menet.worker等过滤
+    if (context.category && qstrcmp(context.category, "default") != 0) time += QString(" %1").arg(context.category);
     QString txt;
     switch (type) {
     case QtDebugMsg:    txt = QString("[%1] Debug: %2").arg(time, msg); break;
@@ -32,36 +37,32 @@ void myMessageHandler(QtMsgType type, const QMessageLogContext &context, const Q
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    // 读取配置文件，判断是否开发模式（直接文本读取，彻底规避QSettings问题）
-    QString configPath = QDir::currentPath() + "/config.ini";
-    bool isDevelopMode = true;
-    QFile f(configPath);
-    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        while (!f.atEnd()) {
-            QString line = f.readLine().trimmed();
-            if (line.startsWith("DevelopMode", Qt::CaseInsensitive)) {
-                QString value = line.section('=', 1).trimmed().toLower();
-                isDevelopMode = (value == "true" || value == "1");
-                break;
-            }
-        }
-        f.close();
+    // --profile-startup：统计各初始化阶段和首帧绘制耗时
+    bool profileStartup = false;
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--profile-startup") == 0) profileStartup = true;
     }
+    StartupProfiler::start(profileStartup);
+    QApplication a(argc, argv);
+    StartupProfiler::mark("QApplication");
+    // 读取配置文件，判断是否开发模式（AppConfig直接文本解析并缓存，彻底规避QSettings问题）
+    QString configPath = AppConfig::path();
+    bool isDevelopMode = AppConfig::boolValue("General", "DevelopMode", true);
+    LogCategories::applyRules(isDevelopMode);
     // 只有开发模式下才输出调试信息
     if (isDevelopMode) {
-        qDebug() << "[DEBUG] isDevelopMode (manual parse):" << isDevelopMode;
-        qDebug() << "[DEBUG] CurrentPath:" << QDir::currentPath();
-        qDebug() << "[DEBUG] config.ini path:" << configPath;
+        qCDebug(lcConfig) << "[DEBUG] isDevelopMode (manual parse):" << isDevelopMode;
+        qCDebug(lcConfig) << "[DEBUG] CurrentPath:" << QDir::currentPath();
+        qCDebug(lcConfig) << "[DEBUG] config.ini path:" << configPath;
         QFile f2(configPath);
         if (f2.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qDebug() << "[DEBUG] config.ini content:";
+            qCDebug(lcConfig) << "[DEBUG] config.ini content:";
             while (!f2.atEnd()) {
-                qDebug() << f2.readLine();
+                qCDebug(lcConfig) << f2.readLine();
             }
             f2.close();
         } else {
-            qDebug() << "[DEBUG] config.ini cannot be opened!";
+            qCDebug(lcConfig) << "[DEBUG] config.ini cannot be opened!";
         }
     }
     if (!isDevelopMode) {
@@ -70,8 +71,11 @@ int main(int argc, char *argv[])
         g_logFile->open(QIODevice::Append | QIODevice::Text);
         qInstallMessageHandler(myMessageHandler);
     }
+    StartupProfiler::mark("config and logging");
     MainWindow w(nullptr, isDevelopMode);
+    StartupProfiler::mark("MainWindow constructed");
     w.show();
+    StartupProfiler::mark("show");
     int ret = a.exec();
     if (g_logFile) { g_logFile->close(); delete g_logFile; g_logFile = nullptr; }
     return ret;
@@ -1,11 +1,13 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "mymessagebox.h"
+#include "imageloader.h"
 #include <QProcess>
 #include <QDir>
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QJsonArray>
 #include <QTimer>
 #include <QProgressBar>
 #include <QTextStream>
@@ -19,7 +21,41 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QThread>
+#include <QThreadPool>
 #include "savedsettingdialog.h"
+#include "trainingcurvewidget.h"
+#include "logtail.h"
+#include "processcontrol.h"
+#include "resourcecontrol.h"
+#include "sweepdialog.h"
+#include "tunedialog.h"
+#include "autotuner.h"
+#include "historydialog.h"
+#include "runhistory.h"
+#include "metricparser.h"
+#include "pathutils.h"
+#include "phenotypeconfig.h"
+#include "phenotypeselector.h"
+#include "outputcapture.h"
+#include "logconsole.h"
+#include <memory>
+#include "clusterdispatcher.h"
+#include "clusterdialog.h"
+#include "modelregistry.h"
+#include "modelsdialog.h"
+#include "appconfig.h"
+#include "startupprofiler.h"
+#include "controlserver.h"
+#include "admissioncontroller.h"
+#include "spreadsheetconverter.h"
+#include "logcategories.h"
+#include "logindex.h"
+#include "crossvalidator.h"
+#include <QLabel>
+#include <QMenu>
+#include <QStatusBar>
+#include <QToolButton>
+#include <algorithm>
 #if defined(Q_OS_WIN)
 #include <windows.h>
 #endif
@@ -40,32 +76,81 @@ static double dirSizeMB(const QString &path) {
     return size / (1024.0 * 1024.0);
 }
 
+// 从日志里最后一个epoch行取epoch数和最终R²，写入运行历史
+static void fillRunMetricsFromLog(RunHistory::Run &run, const QString &logPath)
+{
+    EpochMetrics metrics;
+    if (!lastEpochMetrics(logPath, metrics)) return;
+    run.epochs = metrics.epoch + 1;
+    if (metrics.values.contains("train_R2")) run.trainR2 = metrics.values.value("train_R2");
+    if (metrics.values.contains("val_R2")) run.valR2 = metrics.values.value("val_R2");
+}
+
+// 结束的训练日志移进MENET/logs/<表型>/存档，后台扫描一遍写出.idx偏移索引，
+// 历史面板的曲线对比和按epoch查询只读索引。返回存档路径，未存档返回空串。
+// 第二步没有成功结束且留下了checkpoint时，续跑会从checkpoint接着写step2.log，这时不存档
+static QString archiveRunLog(const QString &logPath, const RunHistory::Run &run)
+{
+    if (!AppConfig::boolValue("Logs", "Archive", true) || !QFileInfo(logPath).isFile()) return QString();
+    const QString menetDir = QDir::currentPath() + "/MENET";
+    if (run.status != "success" && run.status != "early_stopped" && !AppConfig::value("Resume", "CheckpointArg").isEmpty()
+        && QFileInfo(logPath) == QFileInfo(menetDir + "/step2.log")
+        && QFile::exists(JobJournal::checkpointPath(menetDir))) {
+        qCInfo(lcUi) << "[MainWindow] Keeping" << logPath << "in place for checkpoint resume";
+        return QString();
+    }
+    const QDateTime started = run.startedAt.isValid() ? run.startedAt : QDateTime::currentDateTime();
+    const QString fileName = QString("%1_%2.log").arg(run.kind, started.toString("yyyyMMdd-hhmmss"));
+    QString error;
+    const QString archived = LogIndex::archive(logPath, QDir::currentPath() + "/MENET/logs/" + run.phenotype, fileName, &error);
+    if (archived.isEmpty()) {
+        qCWarning(lcUi) << "[MainWindow] Unable to archive" << logPath << ":" << error;
+        return QString();
+    }
+    QThreadPool::globalInstance()->start([archived]() {
+        QString buildError;
+        if (!LogIndex::build(archived, &buildError)) {
+            qCWarning(lcUi) << "[MainWindow] Unable to index" << archived << ":" << buildError;
+        }
+    });
+    return archived;
+}
+
+// 写进模型仓库的训练指标
+static QJsonObject runMetricsJson(const RunHistory::Run &run)
+{
+    QJsonObject metrics;
+    if (!qIsNaN(run.trainR2)) metrics["train_R2"] = run.trainR2;
+    if (!qIsNaN(run.valR2)) metrics["val_R2"] = run.valR2;
+    if (run.epochs > 0) metrics["epochs"] = run.epochs;
+    return metrics;
+}
+
+// 历史库里的参数哈希只包含训练参数，早停设置不影响"同一组参数"的判断
+static QString trainingParamHash(QJsonObject params)
+{
+    params.remove("early_stop");
+    params.remove("patience");
+    params.remove("min_delta");
+    return RunHistory::hashParams(params);
+}
+
 MainWindow::MainWindow(QWidget *parent, bool isDevelop)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , predictionCache(QDir::currentPath() + "/MENET")
     , isDevelopMode(isDevelop)
+    , journal(QDir::currentPath() + "/MENET/jobs/journal.jsonl")
 {
-    qDebug() << "[MainWindow] Constructed, this=" << this << ", thread=" << QThread::currentThread();
+    qCDebug(lcUi) << "[MainWindow] Constructed, this=" << this << ", thread=" << QThread::currentThread();
     ui->setupUi(this);
+    StartupProfiler::mark("MainWindow::setupUi");
     setWindowTitle("MENET");
     connect(ui->pushButton_3, &QPushButton::clicked, this, &MainWindow::handleTrainModelClicked);
-    qDebug() << "[MainWindow] connect pushButton_3 -> handleTrainModelClicked";
+    qCDebug(lcUi) << "[MainWindow] connect pushButton_3 -> handleTrainModelClicked";
     
-    // 添加测试按钮 - 直接检查config.ini
-    QString configPath = QDir::currentPath() + "/config.ini";
-    QFile f(configPath);
-    bool isDevMode = false;
-    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        while (!f.atEnd()) {
-            QString line = f.readLine().trimmed();
-            if (line.startsWith("DevelopMode", Qt::CaseInsensitive)) {
-                QString value = line.section('=', 1).trimmed().toLower();
-                isDevMode = (value == "true" || value == "1");
-                break;
-            }
-        }
-        f.close();
-    }
+    // 添加测试按钮 - config.ini已由AppConfig解析过一次，这里直接查
+    bool isDevMode = AppConfig::boolValue("General", "DevelopMode", false);
     
     if (isDevMode) {
         // 创建测试按钮
@@ -79,12 +164,12 @@ MainWindow::MainWindow(QWidget *parent, bool isDevelop)
             QHBoxLayout *hLayout = qobject_cast<QHBoxLayout*>(step1Group->layout());
             if (hLayout) {
                 hLayout->addWidget(testButton);
-                qDebug() << "[MainWindow] Added test image button to Step 1 layout";
+                qCDebug(lcUi) << "[MainWindow] Added test image button to Step 1 layout";
             } else {
-                qDebug() << "[MainWindow] Failed to get Step 1 horizontal layout";
+                qCWarning(lcUi) << "[MainWindow] Failed to get Step 1 horizontal layout";
             }
         } else {
-            qDebug() << "[MainWindow] Failed to find Step 1 group box";
+            qCWarning(lcUi) << "[MainWindow] Failed to find Step 1 group box";
         }
         
         connect(testButton, &QPushButton::clicked, this, &MainWindow::testShowImage);
@@ -97,10 +182,140 @@ MainWindow::MainWindow(QWidget *parent, bool isDevelop)
     ui->pushButton_download_pred->setEnabled(false);
     // 默认隐藏进度条
     ui->progressBar_step2->setVisible(false);
+    // 实时训练曲线放在进度条下方，开始训练后显示
+    curveWidget = new TrainingCurveWidget(ui->groupBox_step2);
+    curveWidget->setVisible(false);
+    if (QVBoxLayout *step2Layout = qobject_cast<QVBoxLayout*>(ui->groupBox_step2->layout())) {
+        step2Layout->addWidget(curveWidget);
+    }
 
-    // 启动时刷新多选框
-    refreshPhenotypeOptions();
-    
+    // Cancel按钮：训练、迁移学习、预测共用同一条终止路径
+    cancelButton = new QPushButton(tr("Cancel"), ui->groupBox_step2);
+    cancelButton->setMinimumSize(120, 40);
+    cancelButton->setStyleSheet("QPushButton{background-color:#e03131;color:white;font-size:16px;border-radius:8px;} QPushButton:hover{background-color:#c92a2a;} QPushButton:disabled{background-color:#cccccc;}");
+    ui->hLayout2->addWidget(cancelButton);
+    connect(cancelButton, &QPushButton::clicked, this, &MainWindow::cancelRunningJobs);
+    setCancelAvailable(false);
+
+    // 超参数搜索：在独立试验目录中并发训练，不占用上面的训练流程
+    sweepButton = new QPushButton(tr("Hyperparameter Sweep"), ui->groupBox_step2);
+    sweepButton->setMinimumSize(180, 40);
+    ui->hLayout2->addWidget(sweepButton);
+    connect(sweepButton, &QPushButton::clicked, this, &MainWindow::openSweepDialog);
+    historyButton = new QPushButton(tr("History"), ui->groupBox_step2);
+    historyButton->setMinimumSize(120, 40);
+    ui->hLayout2->addWidget(historyButton);
+    connect(historyButton, &QPushButton::clicked, this, &MainWindow::openHistoryDialog);
+    modelsButton = new QPushButton(tr("Models"), ui->groupBox_step2);
+    modelsButton->setMinimumSize(120, 40);
+    ui->hLayout2->addWidget(modelsButton);
+    connect(modelsButton, &QPushButton::clicked, this, &MainWindow::openModelsDialog);
+    // 子进程输出的实时控制台，单独的窗口，关闭只是隐藏，内容保留
+    logConsole = new LogConsole(this);
+    logConsole->setWindowFlag(Qt::Window);
+    consoleButton = new QPushButton(tr("Console"), ui->groupBox_step2);
+    consoleButton->setMinimumSize(120, 40);
+    ui->hLayout2->addWidget(consoleButton);
+    connect(consoleButton, &QPushButton::clicked, this, &MainWindow::openLogConsole);
+    tuneButton = new QPushButton(tr("Calibrate"), ui->groupBox_step2);
+    tuneButton->setMinimumSize(120, 40);
+    ui->hLayout2->addWidget(tuneButton);
+    connect(tuneButton, &QPushButton::clicked, this, &MainWindow::openTuneDialog);
+    // 交叉验证开关：折数、并发、传验证集的参数名等在config.ini [CrossValidation]
+    cvCheckBox = new QCheckBox(tr("%1-fold CV").arg(qMax(2, AppConfig::intValue("CrossValidation", "Folds", 5))),
+                               ui->groupBox_step2);
+    cvCheckBox->setToolTip(tr("After each phenotype is trained, run k-fold cross-validation in parallel "
+                              "and report the mean and standard deviation of the held-out R² (scored with pred.exe) in the summary"));
+    cvCheckBox->setChecked(AppConfig::boolValue("CrossValidation", "Enabled", false));
+    ui->hLayout2->addWidget(cvCheckBox);
+
+    // config.ini里配置了集群节点时，训练批次可以分发到各节点的agent上运行
+    const QStringList clusterNodes = ClusterDispatcher::configuredNodes();
+    if (!clusterNodes.isEmpty()) {
+        cluster = new ClusterDispatcher(QDir::currentPath() + "/MENET", this);
+        connect(cluster, &ClusterDispatcher::jobFinished, this, &MainWindow::onClusterJobFinished);
+        connect(cluster, &ClusterDispatcher::allFinished, this, &MainWindow::onClusterAllFinished);
+        connect(cluster, &ClusterDispatcher::jobUpdated, this, [this](int) {
+            if (!clusterRunActive || cluster->jobs().isEmpty()) return;
+            int total = 0;
+            for (const ClusterDispatcher::Job &job : cluster->jobs()) {
+                total += (job.state == ClusterDispatcher::JobState::Done || job.state == ClusterDispatcher::JobState::Failed
+                          || job.state == ClusterDispatcher::JobState::Cancelled) ? 100 : job.percent;
+            }
+            ui->progressBar_step2->setValue(total / cluster->jobs().size());
+        });
+        connect(cluster, &ClusterDispatcher::jobEpoch, this, [this](const QString &phenotype, const EpochMetrics &metrics) {
+            if (!clusterRunActive) return;
+            if (clusterCurvePhenotype.isEmpty()) {
+                clusterCurvePhenotype = phenotype;
+                curveWidget->clear();
+                curveWidget->setTitle(tr("Training curves (%1)").arg(phenotype));
+            }
+            if (phenotype == clusterCurvePhenotype) curveWidget->addEpoch(metrics);
+        });
+        // 连接节点（含DNS解析）放到首帧之后
+        StartupProfiler::afterFirstPaint(this, "cluster connect", [this, clusterNodes]() { cluster->setNodes(clusterNodes); });
+        clusterButton = new QPushButton(tr("Cluster"), ui->groupBox_step2);
+        clusterButton->setMinimumSize(120, 40);
+        ui->hLayout2->addWidget(clusterButton);
+        connect(clusterButton, &QPushButton::clicked, this, &MainWindow::openClusterDialog);
+    }
+
+    // 剩余时间显示在状态栏右侧
+    etaLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(etaLabel);
+    // 排队等内存的作业也显示在状态栏
+    admissionLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(admissionLabel);
+    // 有作业运行或排队时显示作业菜单，可以暂停/继续单个或全部作业
+    jobsButton = new QToolButton(this);
+    jobsButton->setText(tr("Jobs"));
+    jobsButton->setAutoRaise(true);
+    jobsButton->setPopupMode(QToolButton::InstantPopup);
+    QMenu *jobsMenu = new QMenu(jobsButton);
+    connect(jobsMenu, &QMenu::aboutToShow, this, [this, jobsMenu]() { populateJobsMenu(jobsMenu); });
+    jobsButton->setMenu(jobsMenu);
+    jobsButton->setVisible(false);
+    ui->statusbar->addPermanentWidget(jobsButton);
+    // 开启资源控制时显示子进程的CPU/内存/IO压力，看得出作业之间有没有争抢
+    if (ResourceControl::instance()->isEnabled()) {
+        pressureLabel = new QLabel(this);
+        ui->statusbar->addPermanentWidget(pressureLabel);
+        QTimer *pressureTimer = new QTimer(this);
+        connect(pressureTimer, &QTimer::timeout, this, &MainWindow::updatePressureDisplay);
+        pressureTimer->start(2000);
+    }
+    connect(AdmissionController::instance(), &AdmissionController::queueChanged, this, &MainWindow::updateAdmissionDisplay);
+    etaTimer = new QTimer(this);
+    connect(etaTimer, &QTimer::timeout, this, &MainWindow::updateEtaDisplay);
+    // 训练进度按30帧/秒刷新，与epoch快慢无关
+    progressFrameTimer = new QTimer(this);
+    progressFrameTimer->setInterval(33);
+    connect(progressFrameTimer, &QTimer::timeout, this, &MainWindow::consumeProgressFrame);
+
+    StartupProfiler::mark("MainWindow widgets");
+
+    // 非必需的初始化都推到首帧之后：表型目录扫描、作业日志检查、路径提示
+    ui->pushButton_3->setEnabled(false);
+    phenotypeSelector = new PhenotypeSelector(QDir::currentPath() + "/MENET/data/phen", ui->groupBox_step2);
+    // 插入到Run Model按钮上方
+    if (QVBoxLayout *vLayout = qobject_cast<QVBoxLayout*>(ui->groupBox_step2->layout())) {
+        vLayout->insertWidget(0, phenotypeSelector);
+    }
+    connect(phenotypeSelector, &PhenotypeSelector::selectionChanged, this, &MainWindow::onPhenotypeSelected);
+    connect(phenotypeSelector, &PhenotypeSelector::phenotypesChanged, this, [this](int count) {
+        StartupProfiler::mark("phenotype scan");
+        if (selectedPhenotypes.isEmpty()) ui->pushButton_3->setEnabled(count > 0);
+    });
+    StartupProfiler::afterFirstPaint(this, "phenotype scan (queued)", [this]() { refreshPhenotypeOptions(); });
+    // 窗口显示后再询问是否续跑上次未完成的批次
+    StartupProfiler::afterFirstPaint(this, "unfinished job check", [this]() { checkUnfinishedJobs(); });
+    StartupProfiler::afterFirstPaint(this, "path check", [this]() { warnIfChinesePath(); });
+    StartupProfiler::afterFirstPaint(this, "control server", [this]() { setupControlServer(); });
+}
+
+void MainWindow::warnIfChinesePath()
+{
     // 检查当前目录是否包含中文字符
     QString currentPath = QDir::currentPath();
     if (containsChineseCharacters(currentPath)) {
@@ -124,7 +339,7 @@ MainWindow::MainWindow(QWidget *parent, bool isDevelop)
 
 MainWindow::~MainWindow()
 {
-    qDebug() << "[MainWindow] Destructor called, this=" << this << ", thread=" << QThread::currentThread();
+    qCDebug(lcUi) << "[MainWindow] Destructor called, this=" << this << ", thread=" << QThread::currentThread();
     if (progressTimer) {
         progressTimer->stop();
     }
@@ -154,7 +369,7 @@ void MainWindow::on_pushButton_5_clicked()
 void MainWindow::handleTrainModelClicked()
 {
     if (isStep2Running) {
-        qDebug() << "[MainWindow] handleTrainModelClicked: already running, ignore.";
+        qCDebug(lcUi) << "[MainWindow] handleTrainModelClicked: already running, ignore.";
         return;
     }
     if (selectedPhenotypes.isEmpty()) {
@@ -162,6 +377,7 @@ void MainWindow::handleTrainModelClicked()
         return;
     }
     ui->pushButton_3->setEnabled(false);
+    trainSetupActive = true;
     // 初始化队列和参数map
     pendingPhenotypes = selectedPhenotypes;
     phenotypeSettings.clear();
@@ -171,9 +387,11 @@ void MainWindow::handleTrainModelClicked()
 void MainWindow::showNextSettingDialog()
 {
     if (pendingPhenotypes.isEmpty()) {
+        trainSetupActive = false;
         // 优化：如果没有任何表型被设置（全部被取消），不进入训练
         if (phenotypeSettings.isEmpty()) {
             ui->pushButton_3->setEnabled(true);
+            QTimer::singleShot(0, this, &MainWindow::runQueuedControlSubmission);
             return;
         }
         // 全部设置完毕，开始训练
@@ -181,52 +399,30 @@ void MainWindow::showNextSettingDialog()
         return;
     }
     QString phenotype = pendingPhenotypes.takeFirst();
-        // 读取json参数
-        QString esnJson = QDir::currentPath() + "/MENET/configs/RepGeno.json";
-        QString mmnetJson = QDir::currentPath() + "/MENET/configs/MeNet.json";
-        QFile esnFile(esnJson);
-        QFile mmnetFile(mmnetJson);
-        int esnBatch = 128, esnSaved = 100;
-        double esnP = 0.8;
-        int mmnetBatch = 128, mmnetSaved = 100;
-        double mmnetP1 = 0.8, mmnetP2 = 0.8, mmnetP3 = 0.8, mmnetP4 = 0.6, mmnetWd = 1e-5;
-        // 读取RepGeno.json
-        if (esnFile.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(esnFile.readAll());
-            QJsonObject obj = doc.object();
-            if (obj.contains(phenotype) && obj[phenotype].isObject()) {
-                QJsonObject phenoObj = obj[phenotype].toObject();
-                if (phenoObj.contains("batch size")) esnBatch = phenoObj["batch size"].toInt();
-                if (phenoObj.contains("p")) esnP = phenoObj["p"].toDouble();
-                if (phenoObj.contains("saved")) esnSaved = phenoObj["saved"].toInt();
-            }
-            esnFile.close();
-        }
-        // 读取MeNet.json
-        if (mmnetFile.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(mmnetFile.readAll());
-            QJsonObject obj = doc.object();
-            if (obj.contains(phenotype) && obj[phenotype].isObject()) {
-                QJsonObject phenoObj = obj[phenotype].toObject();
-                if (phenoObj.contains("batch size")) mmnetBatch = phenoObj["batch size"].toInt();
-                if (phenoObj.contains("p1")) mmnetP1 = phenoObj["p1"].toDouble();
-                if (phenoObj.contains("p2")) mmnetP2 = phenoObj["p2"].toDouble();
-                if (phenoObj.contains("p3")) mmnetP3 = phenoObj["p3"].toDouble();
-                if (phenoObj.contains("p4")) mmnetP4 = phenoObj["p4"].toDouble();
-                if (phenoObj.contains("saved")) mmnetSaved = phenoObj["saved"].toInt();
-                if (phenoObj.contains("wd")) mmnetWd = phenoObj["wd"].toDouble();
-            }
-            mmnetFile.close();
-        }
+    const PhenotypeSetting current = loadPhenotypeSetting(phenotype);
     // 弹出设置参数的对话框（异步）
     SavedSettingDialog *dlg = new SavedSettingDialog(this);
     dlg->setPhenotype(phenotype);
-    dlg->setEsnValues(esnBatch, esnP, esnSaved);
-    dlg->setMmnetValues(mmnetBatch, mmnetP1, mmnetP2, mmnetP3, mmnetP4, mmnetSaved, mmnetWd);
-    connect(dlg, &QDialog::accepted, this, [this, phenotype, dlg, &esnBatch, &esnP, &esnSaved, &mmnetBatch, &mmnetP1, &mmnetP2, &mmnetP3, &mmnetP4, &mmnetSaved, &mmnetWd]() {
+    dlg->setEsnValues(current.esnBatch, current.esnP, current.esnSaved);
+    // 本机校准过时，弹窗里的MeNet batch size默认取校准值
+    const AutoTuner::Profile tuned = AutoTuner::lookup(QDir::currentPath() + "/MENET", phenotype);
+    dlg->setMmnetValues(tuned.isValid() ? tuned.batchSize : current.mmnetBatch, current.mmnetP1, current.mmnetP2,
+                        current.mmnetP3, current.mmnetP4, current.mmnetSaved, current.mmnetWd);
+    dlg->setThreadValue(current.threads);
+    if (tuned.isValid()) {
+        dlg->setTuningNote(tr("Calibrated on this machine (%1): batch size %2, %3 threads, %4 epochs/s. Saved batch size: %5.")
+                               .arg(tuned.sizeClass).arg(tuned.batchSize).arg(tuned.threads)
+                               .arg(tuned.epochsPerSec, 0, 'f', 3).arg(current.mmnetBatch));
+    }
+    dlg->setEarlyStopValues(current.earlyStop.enabled, current.earlyStop.patience, current.earlyStop.minDelta);
+    // 弹窗是异步的，lambda执行时本函数早已返回，所以在lambda里重新声明取值变量
+    connect(dlg, &QDialog::accepted, this, [this, phenotype, dlg]() {
+        int esnBatch, esnSaved, mmnetBatch, mmnetSaved;
+        double esnP, mmnetP1, mmnetP2, mmnetP3, mmnetP4, mmnetWd;
         dlg->getEsnValues(esnBatch, esnP, esnSaved);
         dlg->getMmnetValues(mmnetBatch, mmnetP1, mmnetP2, mmnetP3, mmnetP4, mmnetSaved, mmnetWd);
         PhenotypeSetting setting;
+        dlg->getEarlyStopValues(setting.earlyStop.enabled, setting.earlyStop.patience, setting.earlyStop.minDelta);
         setting.esnBatch = esnBatch;
         setting.esnP = esnP;
         setting.esnSaved = esnSaved;
@@ -237,6 +433,7 @@ void MainWindow::showNextSettingDialog()
         setting.mmnetP4 = mmnetP4;
         setting.mmnetSaved = mmnetSaved;
         setting.mmnetWd = mmnetWd;
+        setting.threads = dlg->threadValue();
         phenotypeSettings[phenotype] = setting;
         dlg->deleteLater();
         showNextSettingDialog();
@@ -248,24 +445,50 @@ void MainWindow::showNextSettingDialog()
     dlg->open(); // 异步弹窗
 }
 
-void MainWindow::startTrainingForPhenotypes()
+MainWindow::PhenotypeSetting MainWindow::loadPhenotypeSetting(const QString &phenotype)
+{
+    PhenotypeSetting setting;
+    setting.esnBatch = 128;
+    setting.esnP = 0.8;
+    setting.esnSaved = 100;
+    setting.mmnetBatch = 128;
+    setting.mmnetP1 = 0.8;
+    setting.mmnetP2 = 0.8;
+    setting.mmnetP3 = 0.8;
+    setting.mmnetP4 = 0.6;
+    setting.mmnetSaved = 100;
+    setting.mmnetWd = 1e-5;
+    // 读取RepGeno.json
+    const QJsonObject esnObj = PhenotypeConfig::load(QDir::currentPath() + "/MENET/configs/RepGeno.json").value(phenotype).toObject();
+    if (esnObj.contains("batch size")) setting.esnBatch = esnObj["batch size"].toInt();
+    if (esnObj.contains("p")) setting.esnP = esnObj["p"].toDouble();
+    if (esnObj.contains("saved")) setting.esnSaved = esnObj["saved"].toInt();
+    // 读取MeNet.json
+    const QJsonObject mmnetObj = PhenotypeConfig::load(QDir::currentPath() + "/MENET/configs/MeNet.json").value(phenotype).toObject();
+    if (mmnetObj.contains("batch size")) setting.mmnetBatch = mmnetObj["batch size"].toInt();
+    if (mmnetObj.contains("p1")) setting.mmnetP1 = mmnetObj["p1"].toDouble();
+    if (mmnetObj.contains("p2")) setting.mmnetP2 = mmnetObj["p2"].toDouble();
+    if (mmnetObj.contains("p3")) setting.mmnetP3 = mmnetObj["p3"].toDouble();
+    if (mmnetObj.contains("p4")) setting.mmnetP4 = mmnetObj["p4"].toDouble();
+    if (mmnetObj.contains("saved")) setting.mmnetSaved = mmnetObj["saved"].toInt();
+    if (mmnetObj.contains("wd")) setting.mmnetWd = mmnetObj["wd"].toDouble();
+    setting.earlyStop = loadEarlyStopConfig(phenotype);
+    // 本机校准过时，线程数取校准值；没有保存过batch size的表型也用校准值
+    const AutoTuner::Profile tuned = AutoTuner::lookup(QDir::currentPath() + "/MENET", phenotype);
+    if (tuned.isValid()) {
+        setting.threads = tuned.threads;
+        if (!mmnetObj.contains("batch size")) setting.mmnetBatch = tuned.batchSize;
+    }
+    return setting;
+}
+
+void MainWindow::writePhenotypeConfigs()
 {
     // 1. 先整体读取RepGeno.json和MeNet.json
     QString esnJson = QDir::currentPath() + "/MENET/configs/RepGeno.json";
     QString mmnetJson = QDir::currentPath() + "/MENET/configs/MeNet.json";
-    QFile esnFile(esnJson);
-    QFile mmnetFile(mmnetJson);
-    QJsonObject esnObj, mmnetObj;
-        if (esnFile.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(esnFile.readAll());
-        esnObj = doc.object();
-                esnFile.close();
-            }
-        if (mmnetFile.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(mmnetFile.readAll());
-        mmnetObj = doc.object();
-            mmnetFile.close();
-    }
+    QJsonObject esnObj = PhenotypeConfig::load(esnJson);
+    QJsonObject mmnetObj = PhenotypeConfig::load(mmnetJson);
     // 2. 循环所有表型，修改对象
     for (auto it = phenotypeSettings.begin(); it != phenotypeSettings.end(); ++it) {
         const QString &phenotype = it.key();
@@ -288,25 +511,43 @@ void MainWindow::startTrainingForPhenotypes()
         mmnetObj[phenotype] = mmnetPhenoObj;
     }
     // 3. 一次性写回
-    if (esnFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        QJsonDocument newDoc(esnObj);
-        esnFile.write(newDoc.toJson(QJsonDocument::Indented));
-        esnFile.close();
-    }
-            if (mmnetFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        QJsonDocument newDoc(mmnetObj);
-                mmnetFile.write(newDoc.toJson(QJsonDocument::Indented));
-                mmnetFile.close();
-            }
+    QString error;
+    if (!PhenotypeConfig::save(esnJson, esnObj, &error)) qCWarning(lcConfig) << "[writePhenotypeConfigs] save failed:" << esnJson << error;
+    if (!PhenotypeConfig::save(mmnetJson, mmnetObj, &error)) qCWarning(lcConfig) << "[writePhenotypeConfigs] save failed:" << mmnetJson << error;
+    saveEarlyStopConfigs();
+}
+
+void MainWindow::startTrainingForPhenotypes(bool interactive, bool preferCluster)
+{
+    writePhenotypeConfigs();
     // 新增：确保保存模型的目录存在
     QDir().mkpath(QDir::currentPath() + "/MENET/saved");
 
     // 4. 初始化训练队列和结果，开始逐个训练
+    cancelRequested = false;
     trainPhenoQueue.clear();
     trainResultMsgs.clear();
+    resumeSkipStep1.clear();
+    resumeStep2Start.clear();
+    QJsonObject settingsSnapshot;
     for (auto it = phenotypeSettings.begin(); it != phenotypeSettings.end(); ++it) {
         trainPhenoQueue << it.key();
+        settingsSnapshot[it.key()] = settingToJson(it.value());
     }
+    // 记录批次和参数快照，崩溃后可以从这里续跑
+    trainBatchId = journal.beginBatch("train", trainPhenoQueue, settingsSnapshot);
+    if (cluster && cluster->healthyNodeCount() > 0 && !cluster->isBusy()) {
+        const bool useCluster = interactive
+            ? QMessageBox::question(this, tr("Cluster"),
+                  tr("%1 cluster node(s) are available. Run this batch on the cluster?").arg(cluster->healthyNodeCount()),
+                  QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes) == QMessageBox::Yes
+            : preferCluster;
+        if (useCluster) {
+            startClusterTraining();
+            return;
+        }
+    }
+    beginEtaForBatch();
     trainNextPhenotype();
 }
 
@@ -339,30 +580,79 @@ void MainWindow::trainNextPhenotype()
         ui->pushButton_3->setEnabled(true);
         return;
     }
+    if (trainWaitingTicket) return;
+    if (!trainAdmissionTicket) {
+        // 先申请内存准入，放不下时排队，准入后再进来启动
+        const QString next = trainPhenoQueue.first();
+        ui->progressBar_step2->setVisible(true);
+        ui->progressBar_step2->setFormat(tr("Waiting for memory (%1)...").arg(next));
+        setCancelAvailable(true);
+        trainWaitingTicket = AdmissionController::instance()->submit(tr("Training %1").arg(next), estimatePeakMB("train", next),
+                                                                     [this](int ticket) {
+            trainWaitingTicket = 0;
+            if (cancelRequested) {
+                // 准入时已经取消（队列已清空），直接结束批次
+                AdmissionController::instance()->release(ticket);
+                journal.endBatch(trainBatchId, "cancelled");
+                trainBatchId.clear();
+                trainResultMsgs << tr("Cancelled");
+            } else {
+                trainAdmissionTicket = ticket;
+            }
+            trainNextPhenotype();
+        });
+        return;
+    }
     
     const QString phenotype = trainPhenoQueue.takeFirst();
+    currentTrainPhenotype = phenotype;
+    // 续跑：第一步已完成就跳过；第二步中断且留下了本次运行写出的checkpoint，就从checkpoint续训。
+    // train_menet.exe接受哪个续训参数要在config.ini里配置，没配置时第二步从头重新训练
+    const bool skipStep1 = resumeSkipStep1.contains(phenotype);
+    QStringList step2ExtraArgs;
+    const QString resumeArg = AppConfig::value("Resume", "CheckpointArg");
+    const QString checkpoint = JobJournal::checkpointPath(QDir::currentPath() + "/MENET");
+    QFileInfo checkpointInfo(checkpoint);
+    if (!resumeArg.isEmpty() && resumeStep2Start.contains(phenotype) && checkpointInfo.exists()
+        && checkpointInfo.lastModified() >= resumeStep2Start.value(phenotype)) {
+        step2ExtraArgs << resumeArg << checkpoint;
+        qCInfo(lcUi) << "[MainWindow] Resuming" << phenotype << "from checkpoint" << checkpoint;
+    }
+    resumeSkipStep1.remove(phenotype);
+    resumeStep2Start.remove(phenotype);
+    for (const QString &failure : SpreadsheetConverter::ensureCsvInDirectory(QDir::currentPath() + "/MENET/data/phen", phenotype)) {
+        qCWarning(lcUi) << "[MainWindow] Spreadsheet conversion failed:" << failure;
+    }
+    currentRunUsesCheckpoint = !step2ExtraArgs.isEmpty();
     ui->progressBar_step2->setFormat(tr("Training Progress (%1): %p%").arg(phenotype));
     // 训练流程（原for循环剩余部分）
         isStep2Running = true;
         static int callCount = 0;
         ++callCount;
-        qDebug() << "[MainWindow] handleRunModelClicked called, count=" << callCount << ", this=" << this << ", thread=" << QThread::currentThread();
+        qCDebug(lcUi) << "[MainWindow] handleRunModelClicked called, count=" << callCount << ", this=" << this << ", thread=" << QThread::currentThread();
         // 显示进度条并强制刷新
         ui->progressBar_step2->setVisible(true);
-        ui->progressBar_step2->repaint();
+        ui->progressBar_step2->update();
         QApplication::processEvents();
         // 创建空的日志文件
         QFile step1Log(QDir::currentPath() + "/MENET/step1.log");
         QFile step2Log(QDir::currentPath() + "/MENET/step2.log");
         if (step1Log.exists()) step1Log.remove();
-        if (step2Log.exists()) step2Log.remove();
+        // 从checkpoint续训时保留之前的step2.log，曲线和进度接着显示
+        if (step2Log.exists() && step2ExtraArgs.isEmpty()) step2Log.remove();
         if (!step1Log.open(QIODevice::WriteOnly)) {
+        AdmissionController::instance()->release(trainAdmissionTicket);
+        trainAdmissionTicket = 0;
+        journal.recordStage(trainBatchId, phenotype, JobJournal::StageFailed);
         trainResultMsgs << phenotype + tr(": Unable to create step1.log file");
         trainNextPhenotype();
         return;
         }
         step1Log.close();
-        if (!step2Log.open(QIODevice::WriteOnly)) {
+        if (!step2Log.open(step2ExtraArgs.isEmpty() ? QIODevice::WriteOnly : QIODevice::Append)) {
+        AdmissionController::instance()->release(trainAdmissionTicket);
+        trainAdmissionTicket = 0;
+        journal.recordStage(trainBatchId, phenotype, JobJournal::StageFailed);
         trainResultMsgs << phenotype + tr(": Unable to create step2.log file");
         trainNextPhenotype();
         return;
@@ -371,15 +661,15 @@ void MainWindow::trainNextPhenotype()
         // 路径准备
         QString exePath1 = QDir::currentPath() + "/MENET/generate_genetic_relatedness.exe";
         QString exePath2 = QDir::currentPath() + "/MENET/train_menet.exe";
-        qDebug() << "Checking exe files:";
-        qDebug() << "exePath1 exists:" << QFile::exists(exePath1) << ", path:" << exePath1;
-        qDebug() << "exePath2 exists:" << QFile::exists(exePath2) << ", path:" << exePath2;
+        qCDebug(lcUi) << "Checking exe files:";
+        qCDebug(lcUi) << "exePath1 exists:" << QFile::exists(exePath1) << ", path:" << exePath1;
+        qCDebug(lcUi) << "exePath2 exists:" << QFile::exists(exePath2) << ", path:" << exePath2;
         QString log1 = QDir::currentPath() + "/MENET/step1.log";
         QString log2 = QDir::currentPath() + "/MENET/step2.log";
         QString json1 = QDir::currentPath() + "/MENET/configs/RepGeno.json";
         QString json2 = QDir::currentPath() + "/MENET/configs/MeNet.json";
         if (workerThread) { 
-            qDebug() << "[MainWindow] Deleting old workerThread, thread=" << workerThread;
+            qCDebug(lcUi) << "[MainWindow] Deleting old workerThread, thread=" << workerThread;
             workerThread->quit(); 
             workerThread->wait(); 
             delete workerThread; 
@@ -387,53 +677,108 @@ void MainWindow::trainNextPhenotype()
         }
         workerThread = new QThread(this);
         worker = new Worker();
-        qDebug() << "[MainWindow] New Worker created, worker=" << worker << ", workerThread=" << workerThread;
+        qCDebug(lcUi) << "[MainWindow] New Worker created, worker=" << worker << ", workerThread=" << workerThread;
         worker->setParams(exePath1, exePath2, log1, log2, json1, json2, phenotype);
-        worker->setMainWindow(this);
+        worker->setEarlyStopping(phenotypeSettings.value(phenotype).earlyStop);
+        worker->setThreadCount(phenotypeSettings.value(phenotype).threads);
+        worker->setResume(skipStep1, step2ExtraArgs);
         worker->moveToThread(workerThread);
     connect(workerThread, &QThread::started, worker, &Worker::run);
+    // 进度和epoch指标走进度通道，由progressFrameTimer按固定帧率取用
+    progressChannel->begin(phenotype);
+    worker->setProgressChannel(progressChannel);
+    connect(worker, &Worker::earlyStopped, this, &MainWindow::onEarlyStopped, Qt::QueuedConnection);
+    connect(worker, &Worker::step1Completed, this, &MainWindow::onStep1Completed, Qt::QueuedConnection);
+    connect(worker, &Worker::peakMemory, this, [this](double megabytes) {
+        trainPeakMemMB = qMax(trainPeakMemMB, megabytes);
+    }, Qt::QueuedConnection);
+    connect(worker, &Worker::processStarted, logConsole, &LogConsole::beginSection, Qt::QueuedConnection);
+    connect(worker, &Worker::childStarted, this, [this](qint64 pid) {
+        AdmissionController::instance()->attachProcess(trainAdmissionTicket, pid);
+    }, Qt::QueuedConnection);
+    connect(worker, &Worker::outputReceived, logConsole, &LogConsole::appendOutput, Qt::QueuedConnection);
+    connect(worker, &Worker::outputSpilled, logConsole, &LogConsole::noteSpillFile, Qt::QueuedConnection);
     connect(worker, &Worker::finished, this, &MainWindow::step2Finished, Qt::QueuedConnection);
         connect(worker, &Worker::finished, workerThread, &QThread::quit);
         connect(workerThread, &QThread::finished, worker, &QObject::deleteLater);
         ui->progressBar_step2->setValue(0);
+        curveWidget->clear();
+        curveWidget->setTitle(tr("Training curves (%1)").arg(phenotype));
+        curveWidget->setVisible(true);
         step2StartTime = QDateTime::currentDateTime();
+        earlyStopNote.clear();
+        trainPeakMemMB = 0.0;
+        // 按预计耗时划分两步在进度条上的区间
+        eta.beginJob(etaJobFor(phenotype, skipStep1));
+        worker->setStep1Weight(eta.step1Weight());
+        updateEtaDisplay();
+        snapshotSavedFiles();
+        setCancelAvailable(true);
+        progressFrameTimer->start();
         workerThread->start();
         // 等待训练完成（同步）
         while (workerThread->isRunning()) {
             QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
         }
-        // 训练完成后重命名menet.pt
-    QString ptFile = QDir::currentPath() + "/MENET/saved/menet.pt";
-    QString ptTarget = QDir::currentPath() + QString("/MENET/saved/%1_menet.pt").arg(phenotype);
-        if (QFile::exists(ptFile)) {
-            if (QFile::exists(ptTarget)) QFile::remove(ptTarget);
-            QFile::rename(ptFile, ptTarget);
-        }
-    // step2Finished会自动推进下一个
+    // menet.pt的重命名在step2Finished里完成，它会自动推进下一个
 }
 
 void MainWindow::step2Finished(bool success, const QString &msg, double seconds, double exe1Seconds, double exe2Seconds,
                                const QDateTime &step1Start, const QDateTime &step1End, 
                                const QDateTime &step2Start, const QDateTime &step2End) {
-    qDebug() << "[MainWindow] step2Finished called, this=" << this << ", thread=" << QThread::currentThread();
+    qCDebug(lcUi) << "[MainWindow] step2Finished called, this=" << this << ", thread=" << QThread::currentThread();
     isStep2Running = false;
+    AdmissionController::instance()->release(trainAdmissionTicket);
+    trainAdmissionTicket = 0;
+    // 取走最后一帧，保证曲线和进度包含结束前的所有epoch
+    consumeProgressFrame();
+    progressFrameTimer->stop();
+    // 每个表型的训练结果都写进运行历史
+    RunHistory::Run run;
+    run.kind = "train";
+    run.phenotype = currentTrainPhenotype;
+    run.params = settingToJson(phenotypeSettings.value(currentTrainPhenotype));
+    run.paramHash = trainingParamHash(run.params);
+    run.startedAt = step1Start.isValid() ? step1Start : step2Start;
+    run.endedAt = step2End.isValid() ? step2End : step1End;
+    run.step1Seconds = exe1Seconds;
+    run.step2Seconds = exe2Seconds;
+    run.totalSeconds = seconds;
+    const QString step2LogPath = QDir::currentPath() + "/MENET/step2.log";
+    fillRunMetricsFromLog(run, step2LogPath);
+    run.status = cancelRequested ? "cancelled" : !success ? "failed" : earlyStopNote.isEmpty() ? "success" : "early_stopped";
+    run.peakMemoryMB = trainPeakMemMB;
+    run.dataMB = eta.currentJob().datasetMB;
+    run.message = msg;
+    run.logPath = archiveRunLog(step2LogPath, run);
+    RunHistory::instance()->record(run);
+    publishControlEvent("job-finished", {{"kind", "train"}, {"phenotype", run.phenotype}, {"status", run.status},
+                                         {"seconds", run.totalSeconds}});
+    eta.finishJob();
     // ui->pushButton_3->setEnabled(true); // 恢复按钮
     if (success) {
         ui->progressBar_step2->setValue(100);
     }
-    // 解析step2.log最后一行的决定系数
-    QString step2LogPath = QDir::currentPath() + "/MENET/step2.log";
-    QString lastLine;
-    QFile step2Log(step2LogPath);
-    if (step2Log.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&step2Log);
-        while (!in.atEnd()) {
-            QString line = in.readLine();
-            if (!line.trimmed().isEmpty()) lastLine = line;
-        }
-        step2Log.close();
+    if (cancelRequested) {
+        // 用户取消：删掉本次新生成的半成品模型，不再继续后面的表型
+        removePartialArtifacts();
+        journal.endBatch(trainBatchId, "cancelled");
+        trainBatchId.clear();
+        trainResultMsgs << tr("Cancelled");
+        trainPhenoQueue.clear();
+        trainNextPhenotype();
+        return;
+    }
+    // 训练完成后立即重命名menet.pt，避免下一个表型覆盖
+    if (success) {
+        promoteTrainedModel(currentTrainPhenotype, run.params, runMetricsJson(run));
+        // 模型已落到最终位置，checkpoint不再需要，避免被下一个表型误用
+        QFile::remove(JobJournal::checkpointPath(QDir::currentPath() + "/MENET"));
     }
-    qDebug() << "[Debug] step2.log lastLine:" << lastLine;
+    journal.recordStage(trainBatchId, currentTrainPhenotype, success ? JobJournal::StagePromoted : JobJournal::StageFailed);
+    // 解析step2.log最后一行的决定系数（已存档时读存档）
+    QString lastLine = LogTail::lastNonEmptyLine(run.logPath.isEmpty() ? step2LogPath : run.logPath);
+    qCDebug(lcUi) << "[Debug] step2.log lastLine:" << lastLine;
     QString trainR2, valR2;
     QRegularExpression reTrain("train_R2\\s*=\\s*([\\d\\.\\-eE]+)");
     QRegularExpression reVal("val_R2\\s*=\\s*([\\d\\.\\-eE]+)");
@@ -441,7 +786,7 @@ void MainWindow::step2Finished(bool success, const QString &msg, double seconds,
     auto mVal = reVal.match(lastLine);
     if (mTrain.hasMatch()) trainR2 = mTrain.captured(1);
     if (mVal.hasMatch()) valR2 = mVal.captured(1);
-    qDebug() << "[Debug] trainR2:" << trainR2 << ", valR2:" << valR2;
+    qCDebug(lcUi) << "[Debug] trainR2:" << trainR2 << ", valR2:" << valR2;
     QString r2Msg;
     if (!trainR2.isEmpty() && !valR2.isEmpty()) {
         r2Msg = QString("\nR²: Train %1, Validation %2").arg(trainR2).arg(valR2);
@@ -467,14 +812,133 @@ void MainWindow::step2Finished(bool success, const QString &msg, double seconds,
             .arg(formatTime(exe2Seconds));
     }
     // 收集本次训练结果
-    QString summary = (success ? tr("Success") : tr("Failed")) + r2Msg + timeMsg;
+    QString summary = (success ? tr("Success") : tr("Failed")) + r2Msg + earlyStopNote + timeMsg;
     trainResultMsgs << summary;
+    // 提前在后台解码PCA曲线图，汇总弹框打开时直接命中缓存
+    if (success) {
+        QString imagePath = QDir::currentPath() + QString("/MENET/%1_pca_curve.png").arg(currentTrainPhenotype);
+        if (QFile::exists(imagePath)) {
+            ImageLoader::instance()->prefetch(imagePath, QSize(750, 450), devicePixelRatioF());
+        }
+    }
     // 写入日志等原有逻辑...
     // ...（省略原有日志写入代码）...
+    // 交叉验证模式：k折跑完后由onCrossValidationFinished接着训练下一个
+    if (success && cvCheckBox->isChecked() && startCrossValidation(currentTrainPhenotype)) return;
     // 自动训练下一个
     trainNextPhenotype();
 }
 
+bool MainWindow::startCrossValidation(const QString &phenotype)
+{
+    if (!crossValidator) {
+        crossValidator = new CrossValidator(this);
+        connect(crossValidator, &CrossValidator::finished, this, &MainWindow::onCrossValidationFinished);
+        connect(crossValidator, &CrossValidator::foldUpdated, this, &MainWindow::updateCrossValidationProgress);
+    }
+    CrossValidator::Options options;
+    options.menetDir = QDir::currentPath() + "/MENET";
+    options.phenotype = phenotype;
+    options.folds = qMax(2, AppConfig::intValue("CrossValidation", "Folds", 5));
+    options.seed = quint32(AppConfig::intValue("CrossValidation", "Seed", 1));
+    options.maxParallel = AppConfig::intValue("CrossValidation", "MaxParallel", 0);
+    options.threadsPerFold = AppConfig::intValue("CrossValidation", "ThreadsPerFold", 0);
+    options.memoryPerFoldMB = estimatePeakMB("train", phenotype);
+    options.runStep1 = AppConfig::boolValue("CrossValidation", "RunStep1", false);
+    options.validArg = AppConfig::value("CrossValidation", "ValidArg");
+    options.keepWorkspaces = AppConfig::boolValue("CrossValidation", "KeepWorkspaces", false);
+    QString error;
+    if (!crossValidator->start(options, &error)) {
+        qCWarning(lcUi) << "[MainWindow] Cross-validation not started for" << phenotype << ":" << error;
+        if (!trainResultMsgs.isEmpty()) trainResultMsgs.last() += tr("\nCross-validation not run: %1").arg(error);
+        return false;
+    }
+    ui->progressBar_step2->setFormat(tr("Cross-validation (%1): %p%").arg(phenotype));
+    ui->progressBar_step2->setValue(0);
+    curveWidget->clear();
+    curveWidget->setTitle(tr("Cross-validation (%1)").arg(phenotype));
+    return true;
+}
+
+void MainWindow::updateCrossValidationProgress()
+{
+    if (!crossValidator || !crossValidator->isRunning()) return;
+    const int totalEpochs = qMax(1, phenotypeSettings.value(crossValidator->options().phenotype).mmnetSaved);
+    int total = 0;
+    for (const CrossValidator::Fold &fold : crossValidator->folds()) {
+        switch (fold.state) {
+        case CrossValidator::FoldState::Done:
+        case CrossValidator::FoldState::Failed:
+        case CrossValidator::FoldState::Cancelled:
+            total += 100;
+            break;
+        case CrossValidator::FoldState::Running:
+            total += qMin(95, (fold.lastEpoch + 1) * 95 / totalEpochs);
+            break;
+        case CrossValidator::FoldState::Scoring:
+            total += 95;
+            break;
+        default:
+            break;
+        }
+    }
+    ui->progressBar_step2->setValue(total / qMax(1, int(crossValidator->folds().size())));
+}
+
+void MainWindow::onCrossValidationFinished()
+{
+    const CrossValidator::Summary summary = crossValidator->summary();
+    const QVector<CrossValidator::Fold> &folds = crossValidator->folds();
+    QStringList perFold;
+    for (const CrossValidator::Fold &fold : folds) {
+        perFold << (fold.state == CrossValidator::FoldState::Done && !qIsNaN(fold.valR2)
+                        ? QString::number(fold.valR2, 'f', 4) : QString("-"));
+    }
+    QString cvMsg;
+    if (cancelRequested) {
+        cvMsg = tr("\nCross-validation cancelled");
+    } else if (qIsNaN(summary.meanValR2)) {
+        QString note;
+        for (const CrossValidator::Fold &fold : folds) {
+            if (!fold.note.isEmpty()) {
+                note = fold.note;
+                break;
+            }
+        }
+        cvMsg = tr("\nCross-validation (%1 folds): no fold produced a held-out R² (%2)").arg(folds.size()).arg(note);
+    } else {
+        // 验证R²是各折模型在留出样本上的预测算出来的，训练R²取自train_menet的日志
+        cvMsg = tr("\nCross-validation R² (%1 of %2 folds): Held-out %3 ± %4, Train %5 ± %6\nHeld-out per fold: %7\nCross-validation time: %8 s")
+                    .arg(summary.completed).arg(folds.size())
+                    .arg(summary.meanValR2, 0, 'f', 4).arg(summary.sdValR2, 0, 'f', 4)
+                    .arg(summary.meanTrainR2, 0, 'f', 4).arg(summary.sdTrainR2, 0, 'f', 4)
+                    .arg(perFold.join(", ")).arg(summary.seconds, 0, 'f', 1);
+    }
+    qCInfo(lcUi) << "[MainWindow] Cross-validation finished:" << cvMsg.trimmed();
+    if (!trainResultMsgs.isEmpty()) trainResultMsgs.last() += cvMsg;
+
+    RunHistory::Run run;
+    run.kind = "crossval";
+    run.phenotype = crossValidator->options().phenotype;
+    run.params = settingToJson(phenotypeSettings.value(run.phenotype));
+    run.paramHash = trainingParamHash(run.params);
+    run.endedAt = QDateTime::currentDateTime();
+    run.startedAt = run.endedAt.addMSecs(qint64(-summary.seconds * 1000));
+    run.totalSeconds = run.step2Seconds = summary.seconds;
+    run.trainR2 = summary.meanTrainR2;
+    run.valR2 = summary.meanValR2;
+    run.status = cancelRequested ? "cancelled" : summary.completed == 0 ? "failed" : "success";
+    run.message = tr("%1 folds, held-out R² sd %2: %3").arg(folds.size()).arg(summary.sdValR2, 0, 'f', 4).arg(perFold.join(", "));
+    RunHistory::instance()->record(run);
+
+    if (cancelRequested) {
+        journal.endBatch(trainBatchId, "cancelled");
+        trainBatchId.clear();
+        trainPhenoQueue.clear();
+    }
+    trainNextPhenotype();
+}
+
 void MainWindow::showTrainSummary()
 {
     QString msg = tr("All phenotype trainings are completed!\n\n");
@@ -509,8 +973,25 @@ void MainWindow::showTrainSummary()
     }
 
     msgBox.setStandardButtons(QMessageBox::Ok);
-    msgBox.exec();
+    setCancelAvailable(false);
+    etaTimer->stop();
+    etaLabel->clear();
+    journal.endBatch(trainBatchId, "completed");
+    trainBatchId.clear();
+    if (!trainSubmissionId.isEmpty()) {
+        // 远程提交的批次不弹模态框，结果推给订阅者，接着跑排队的提交
+        QJsonObject payload;
+        payload["job"] = trainSubmissionId;
+        payload["kind"] = "train";
+        payload["cancelled"] = cancelRequested;
+        payload["summary"] = msg;
+        trainSubmissionId.clear();
+        publishControlEvent("batch-finished", payload);
+    } else {
+        msgBox.exec();
+    }
     ui->pushButton_3->setEnabled(true);
+    QTimer::singleShot(0, this, &MainWindow::runQueuedControlSubmission);
 }
 
 void MainWindow::on_pushButton_4_clicked()
@@ -520,10 +1001,18 @@ void MainWindow::on_pushButton_4_clicked()
         return;
     }
     // 优化：点击后立即显示"预测中..."并禁用按钮，防止重复点击
+    startPredictionForPhenotypes(selectedPhenotypes);
+}
+
+void MainWindow::startPredictionForPhenotypes(const QStringList &phenotypes)
+{
     ui->pushButton_4->setText(tr("Predicting..."));
     ui->pushButton_4->setEnabled(false);
-    predictPhenoQueue = selectedPhenotypes;
+    predictPhenoQueue = phenotypes;
     predictResultMsgs.clear();
+    cancelRequested = false;
+    setCancelAvailable(true);
+    predictBatchId = journal.beginBatch("predict", predictPhenoQueue);
     predictNextPhenotype();
 }
 
@@ -539,7 +1028,16 @@ void MainWindow::predictNextPhenotype()
         QDir dir(predDir);
         QStringList filters;
     filters << currentPredictPhenotype + ".csv" << currentPredictPhenotype + ".pt" << currentPredictPhenotype + ".xls" << currentPredictPhenotype + ".xlsx";
+        // 表格比同名csv新（比如直接拷进目录）时先转换，有csv就只用csv
+        for (const QString &failure : SpreadsheetConverter::ensureCsvInDirectory(predDir, currentPredictPhenotype)) {
+            qCWarning(lcUi) << "[MainWindow] Spreadsheet conversion failed:" << failure;
+        }
         QStringList found = dir.entryList(filters, QDir::Files);
+        if (found.contains(currentPredictPhenotype + ".csv")) {
+            for (int i = found.size() - 1; i >= 0; --i) {
+                if (SpreadsheetConverter::isSpreadsheet(found.at(i))) found.removeAt(i);
+            }
+        }
         if (found.isEmpty()) {
         predictResultMsgs << currentPredictPhenotype + tr(": No prediction files found");
         QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
@@ -547,6 +1045,8 @@ void MainWindow::predictNextPhenotype()
         }
         // 运行 pred.exe，指定模型和输出
         QString exePath = QDir::currentPath() + "/MENET/pred.exe";
+    // 按仓库里的当前模型重建saved/<pheno>_menet.pt（未变化时只是一次stat）
+    ModelRegistry::instance()->resolve(currentPredictPhenotype);
     QString modelPath = QDir::currentPath() + QString("/MENET/saved/%1_menet.pt").arg(currentPredictPhenotype);
     QString outputPath = QDir::currentPath() + QString("/MENET/%1_MMNet_pred.csv").arg(currentPredictPhenotype);
         if (!QFile::exists(exePath)) {
@@ -559,6 +1059,63 @@ void MainWindow::predictNextPhenotype()
         QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
         return;
     }
+    // 模型、待预测文件、基因数据和pred.exe都没变时直接复用上次的结果
+    QStringList inputFiles;
+    for (const QString &name : found) inputFiles << dir.absoluteFilePath(name);
+    // 第一次算指纹要读完模型、基因数据和pred.exe，放到线程池里，算完回到界面线程继续
+    ui->pushButton_4->setText(tr("Checking inputs..."));
+    QPointer<MainWindow> self(this);
+    const PredictionCache cache = predictionCache;
+    const QString phenotype = currentPredictPhenotype;
+    QThreadPool::globalInstance()->start([self, cache, phenotype, inputFiles, exePath]() {
+        const PredictionCache::Key key = cache.keyFor(phenotype, inputFiles);
+        QMetaObject::invokeMethod(qApp, [self, exePath, key]() {
+            if (self) self->continuePrediction(exePath, key);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::continuePrediction(const QString &exePath, const PredictionCache::Key &key)
+{
+    if (cancelRequested) {
+        predictResultMsgs << currentPredictPhenotype + tr(": Prediction cancelled");
+        QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
+        return;
+    }
+    currentPredictKey = key;
+    if (predictionCache.lookup(currentPredictPhenotype, currentPredictKey)) {
+        RunHistory::Run run;
+        run.kind = "predict";
+        run.phenotype = currentPredictPhenotype;
+        run.startedAt = run.endedAt = QDateTime::currentDateTime();
+        run.status = "cached";
+        RunHistory::instance()->record(run);
+        journal.recordStage(predictBatchId, currentPredictPhenotype, JobJournal::StageDone);
+        predictResultMsgs << currentPredictPhenotype + tr(": Prediction completed (cached, inputs unchanged)");
+        QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
+        return;
+    }
+    // 内存放不下时排队，准入后再启动pred.exe；预测是交互式作业，运行期间后台训练暂停让路
+    ui->pushButton_4->setText(tr("Waiting for memory..."));
+    predictWaitingTicket = AdmissionController::instance()->submit(tr("Prediction %1").arg(currentPredictPhenotype),
+                                                                   estimatePeakMB("predict", currentPredictPhenotype),
+                                                                   [this, exePath](int ticket) {
+        predictWaitingTicket = 0;
+        predictAdmissionTicket = ticket;
+        if (cancelRequested) {
+            AdmissionController::instance()->release(predictAdmissionTicket);
+            predictAdmissionTicket = 0;
+            predictResultMsgs << currentPredictPhenotype + tr(": Prediction cancelled");
+            QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
+            return;
+        }
+        ui->pushButton_4->setText(tr("Predicting..."));
+        launchPredictProcess(exePath);
+    }, AdmissionController::Priority::Interactive);
+}
+
+void MainWindow::launchPredictProcess(const QString &exePath)
+{
     // 异步QProcess
     if (predictProcess) {
         predictProcess->deleteLater();
@@ -575,15 +1132,54 @@ void MainWindow::predictNextPhenotype()
 #endif
         QStringList args;
     args << "--phenotype" << currentPredictPhenotype;
-    connect(predictProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+    predictStartTime = QDateTime::currentDateTime();
+    predictPeakMemMB = 0.0;
+    ResourceControl::instance()->prepareProcess(*predictProcess, "predict");
+    // 进程退出后读不到峰值内存，运行期间定时采样
+    QTimer *memTimer = new QTimer(predictProcess);
+    connect(memTimer, &QTimer::timeout, this, [this]() {
+        if (predictProcess && predictProcess->state() == QProcess::Running) {
+            predictPeakMemMB = qMax(predictPeakMemMB, ProcessControl::peakMemoryMB(predictProcess->processId()));
+        }
+    });
+    memTimer->start(500);
+    // 先连输出捕获，finished时最后一段输出先落盘，再排下一个表型
+    captureProcessOutput(predictProcess, "pred.exe --phenotype " + currentPredictPhenotype,
+                         currentPredictPhenotype + "_pred_" + predictStartTime.toString("yyyyMMdd_hhmmss"));
+    connect(predictProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, memTimer](int exitCode, QProcess::ExitStatus exitStatus) {
+        memTimer->stop();
+        AdmissionController::instance()->release(predictAdmissionTicket);
+        predictAdmissionTicket = 0;
+        RunHistory::Run run;
+        run.kind = "predict";
+        run.phenotype = currentPredictPhenotype;
+        run.startedAt = predictStartTime;
+        run.step2Seconds = run.totalSeconds = predictStartTime.msecsTo(QDateTime::currentDateTime()) / 1000.0;
+        run.peakMemoryMB = predictPeakMemMB;
+        run.dataMB = phenotypeDataMB(currentPredictPhenotype);
+        run.status = cancelRequested ? "cancelled" : (exitStatus != QProcess::NormalExit || exitCode != 0) ? "failed" : "success";
+        RunHistory::instance()->record(run);
+        publishControlEvent("job-finished", {{"kind", "predict"}, {"phenotype", run.phenotype}, {"status", run.status},
+                                             {"seconds", run.totalSeconds}});
+        if (cancelRequested) {
+            // 取消时删掉本次写了一半的预测结果
+            QString partialOutput = QDir::currentPath() + QString("/MENET/%1_MeNet_pred.csv").arg(currentPredictPhenotype);
+            QFileInfo outputInfo(partialOutput);
+            if (outputInfo.exists() && outputInfo.lastModified() >= predictStartTime) QFile::remove(partialOutput);
+            predictResultMsgs << currentPredictPhenotype + tr(": Prediction cancelled");
+            predictPhenoQueue.clear();
+        } else if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+            journal.recordStage(predictBatchId, currentPredictPhenotype, JobJournal::StageFailed);
             predictResultMsgs << currentPredictPhenotype + tr(": pred.exe failed");
         } else {
+            journal.recordStage(predictBatchId, currentPredictPhenotype, JobJournal::StageDone);
+            predictionCache.store(currentPredictPhenotype, currentPredictKey);
             predictResultMsgs << currentPredictPhenotype + tr(": Prediction completed!");
         }
         QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
     });
     predictProcess->start(exePath, args);
+    AdmissionController::instance()->attachProcess(predictAdmissionTicket, predictProcess->processId());
 }
 
 void MainWindow::showPredictSummary()
@@ -592,80 +1188,41 @@ void MainWindow::showPredictSummary()
     for (const QString &line : predictResultMsgs) {
         msg += line + "\n";
         }
+    setCancelAvailable(false);
+    journal.endBatch(predictBatchId, cancelRequested ? "cancelled" : "completed");
+    predictBatchId.clear();
+    if (!predictSubmissionId.isEmpty()) {
+        QJsonObject payload;
+        payload["job"] = predictSubmissionId;
+        payload["kind"] = "predict";
+        payload["cancelled"] = cancelRequested;
+        payload["summary"] = msg;
+        predictSubmissionId.clear();
+        publishControlEvent("batch-finished", payload);
+    } else {
         MyMessageBox msgBox(this);
-    msgBox.setMySize(500, 300);
+        msgBox.setMySize(500, 300);
         msgBox.setIcon(QMessageBox::Information);
-    msgBox.setWindowTitle(tr("Prediction Completed"));
-    msgBox.setText(msg);
+        msgBox.setWindowTitle(tr("Prediction Completed"));
+        msgBox.setText(msg);
         msgBox.setStandardButtons(QMessageBox::Ok);
         msgBox.exec();
+    }
     // 恢复按钮文本和可用状态
     ui->pushButton_4->setText(tr("Start Prediction"));
         ui->pushButton_4->setEnabled(true);
         ui->pushButton_download_pred->setEnabled(true);
+    QTimer::singleShot(0, this, &MainWindow::runQueuedControlSubmission);
 }
 
 void MainWindow::refreshPhenotypeOptions() {
-    qDebug() << "[refreshPhenotypeOptions] called";
-    // 清空旧的
-    QLayout *layout = ui->groupBox_step2->layout();
-    if (!layout) { qDebug() << "[refreshPhenotypeOptions] no layout found"; return; }
-    // 查找并移除旧的checkbox布局
-    QVBoxLayout *vLayout = qobject_cast<QVBoxLayout*>(ui->groupBox_step2->layout());
-    if (vLayout) {
-        for (int i = vLayout->count() - 1; i >= 0; --i) {
-            QLayoutItem *item = vLayout->itemAt(i);
-            QHBoxLayout *oldCheckLayout = qobject_cast<QHBoxLayout*>(item ? item->layout() : nullptr);
-            if (oldCheckLayout) {
-                // 检查是否全是QCheckBox
-                bool allCheck = true;
-                for (int j = 0; j < oldCheckLayout->count(); ++j) {
-                    QWidget *w = oldCheckLayout->itemAt(j) ? oldCheckLayout->itemAt(j)->widget() : nullptr;
-                    if (!w || !qobject_cast<QCheckBox*>(w)) { allCheck = false; break; }
-                }
-                if (allCheck) {
-                    QLayoutItem *removed = vLayout->takeAt(i);
-                    delete removed->layout();
-                    qDebug() << "[refreshPhenotypeOptions] removed old checkLayout at" << i;
-                }
-            }
-        }
-    }
-    phenotypeCheckBoxes.clear();
-    selectedPhenotypes.clear();
-    // 遍历MENET/data/phen目录
-    QString phenDir = QDir::currentPath() + "/MENET/data/phen";
-    QDir dir(phenDir);
-    QStringList filters;
-    filters << "*.csv" << "*.pt" << "*.xls" << "*.xlsx";
-    QFileInfoList fileList = dir.entryInfoList(filters, QDir::Files | QDir::NoDotAndDotDot);
-    qDebug() << "[refreshPhenotypeOptions] found" << fileList.size() << "phenotype files";
-    // 创建新的多选框布局
-    QHBoxLayout *checkLayout = new QHBoxLayout();
-    for (const QFileInfo &info : fileList) {
-        QString baseName = info.completeBaseName();
-        QCheckBox *check = new QCheckBox(baseName, ui->groupBox_step2);
-        phenotypeCheckBoxes.append(check);
-        checkLayout->addWidget(check);
-        connect(check, &QCheckBox::checkStateChanged, this, &MainWindow::onPhenotypeSelected);
-        qDebug() << "[refreshPhenotypeOptions] add QCheckBox for" << baseName;
-    }
-    // 插入到Run Model按钮上方
-    if (vLayout) {
-        vLayout->insertLayout(0, checkLayout);
-        qDebug() << "[refreshPhenotypeOptions] insert checkLayout at top of vLayout";
-    }
-    // 启用/禁用Run Model按钮
-    ui->pushButton_3->setEnabled(!fileList.isEmpty());
+    qCDebug(lcUi) << "[refreshPhenotypeOptions] called";
+    // 选择器在线程池里列目录，只把增删的表型同步到列表
+    phenotypeSelector->rescan();
 }
 
 void MainWindow::onPhenotypeSelected() {
-    selectedPhenotypes.clear();
-    for (QCheckBox *check : phenotypeCheckBoxes) {
-        if (check->isChecked()) {
-            selectedPhenotypes.append(check->text());
-        }
-    }
+    selectedPhenotypes = phenotypeSelector->selectedPhenotypes();
     ui->pushButton_3->setEnabled(!selectedPhenotypes.isEmpty());
 }
 
@@ -710,21 +1267,7 @@ void MainWindow::on_pushButton_download_pred_clicked()
 
 bool MainWindow::updateSavedValue(const QString &jsonPath, const QString &phenotype, int savedValue)
 {
-    QFile file(jsonPath);
-    if (!file.open(QIODevice::ReadOnly)) return false;
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-    if (!doc.isObject()) return false;
-    QJsonObject obj = doc.object();
-    if (!obj.contains(phenotype) || !obj[phenotype].isObject()) return false;
-    QJsonObject phenoObj = obj[phenotype].toObject();
-    phenoObj["saved"] = savedValue;
-    obj[phenotype] = phenoObj;
-    QJsonDocument newDoc(obj);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
-    file.write(newDoc.toJson(QJsonDocument::Indented));
-    file.close();
-    return true;
+    return PhenotypeConfig::updateSaved(jsonPath, phenotype, savedValue);
 }
 
 // 文件上传功能实现
@@ -770,6 +1313,7 @@ void MainWindow::uploadFiles(const QString &targetDir, const QString &fileType)
     // 验证文件格式并复制文件
     QStringList successFiles;
     QStringList failedFiles;
+    QList<QPair<QString, QString>> conversions; // 表格 -> csv，复制完后在线程池里转换
     for (const QString &fileName : fileNames) {
         QFileInfo fileInfo(fileName);
         // 验证文件格式
@@ -793,16 +1337,54 @@ void MainWindow::uploadFiles(const QString &targetDir, const QString &fileType)
                 failedFiles.append(fileInfo.fileName() + tr(" (User canceled overwrite)"));
                 continue;
             }
-            // 删除现有文件
-            QFile::remove(targetFilePath);
         }
-        // 复制文件
-        if (QFile::copy(fileName, targetFilePath)) {
-            successFiles.append(fileInfo.fileName());
-        } else {
+        // 复制文件（先写临时文件再替换已有文件）
+        if (!PathUtils::copyReplacing(fileName, targetFilePath)) {
             failedFiles.append(fileInfo.fileName() + tr(" (Copy failed)"));
+        } else if (targetDir != "MENET/data/gene" && SpreadsheetConverter::isSpreadsheet(targetFilePath)) {
+            // 表型和待预测表格上传时就转成同名csv，Python各步不必每次重新解析表格；
+            // 同名csv是用户自己放的（不是转换生成的）时先问一声
+            const QString csvPath = SpreadsheetConverter::csvPathFor(targetFilePath);
+            const QString csvName = QFileInfo(csvPath).fileName();
+            if (!SpreadsheetConverter::canOverwriteCsv(csvPath)
+                && QMessageBox::question(this, tr("File already exists"),
+                                         tr("%1 already exists and was not converted from a spreadsheet. Replace it with the contents of %2?")
+                                             .arg(csvName, fileInfo.fileName()),
+                                         QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::No) {
+                successFiles.append(fileInfo.fileName() + tr(" (not converted, existing %1 kept)").arg(csvName));
+                continue;
+            }
+            conversions.append({targetFilePath, csvPath});
+        } else {
+            successFiles.append(fileInfo.fileName());
         }
     }
+    if (conversions.isEmpty()) {
+        showUploadResults(fileType, successFiles, failedFiles);
+        return;
+    }
+    // 大表格转换要几秒，放到线程池里，转完再显示结果
+    statusBar()->showMessage(tr("Converting %1 spreadsheet(s) to CSV...").arg(conversions.size()));
+    QPointer<MainWindow> self(this);
+    QThreadPool::globalInstance()->start([self, fileType, successFiles, failedFiles, conversions]() {
+        QStringList converted = successFiles;
+        for (const auto &conversion : conversions) {
+            QString error;
+            const bool ok = SpreadsheetConverter::convertToCsv(conversion.first, conversion.second, &error);
+            const QString name = QFileInfo(conversion.first).fileName();
+            converted.append(name + (ok ? tr(" (converted to %1)").arg(QFileInfo(conversion.second).fileName())
+                                        : tr(" (CSV conversion failed: %1)").arg(error)));
+        }
+        QMetaObject::invokeMethod(qApp, [self, fileType, converted, failedFiles]() {
+            if (!self) return;
+            self->statusBar()->clearMessage();
+            self->showUploadResults(fileType, converted, failedFiles);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::showUploadResults(const QString &fileType, const QStringList &successFiles, const QStringList &failedFiles)
+{
     // 显示结果
     QString resultMsg;
     if (!successFiles.isEmpty()) {
@@ -823,15 +1405,35 @@ void MainWindow::uploadFiles(const QString &targetDir, const QString &fileType)
 }
 
 void MainWindow::updateStep2Progress(int percent) {
-    qDebug() << "[MainWindow] Received progress signal:" << percent << "%";
+    qCDebug(lcProgress) << "[MainWindow] Received progress signal:" << percent << "%";
     ui->progressBar_step2->setValue(percent);
-    ui->progressBar_step2->repaint(); // 强制立即刷新显示
 }
 
 void MainWindow::changeProgress(int value) {
-    qDebug() << "[MainWindow] changeProgress called with value:" << value << ", this=" << this << ", thread=" << QThread::currentThread();
+    if (ui->progressBar_step2->value() == value) return;
+    qCDebug(lcProgress) << "[MainWindow] changeProgress called with value:" << value << ", this=" << this << ", thread=" << QThread::currentThread();
     ui->progressBar_step2->setValue(value);
-    ui->progressBar_step2->repaint(); // 强制立即刷新
+}
+
+void MainWindow::consumeProgressFrame() {
+    ProgressSnapshot snapshot;
+    QList<EpochMetrics> epochs;
+    if (!progressChannel->consume(&snapshot, &epochs)) return;
+    // 一帧内到达的所有epoch一起加进曲线，曲线只在下一次绘制时重画一次
+    for (const EpochMetrics &metrics : epochs) curveWidget->addEpoch(metrics);
+    // epoch按LogFollower的批次成串到达，同一批的接收时间几乎相同；
+    // 每帧只报最后一个epoch，估计器按epoch差值摊分间隔
+    if (!epochs.isEmpty()) eta.observeEpoch(epochs.last().epoch);
+    changeProgress(snapshot.percent);
+    QJsonObject payload;
+    payload["phenotype"] = snapshot.phenotype;
+    payload["stage"] = snapshot.stage;
+    payload["percent"] = snapshot.percent;
+    payload["epoch"] = snapshot.epoch;
+    QJsonObject metrics;
+    for (auto it = snapshot.latest.values.cbegin(); it != snapshot.latest.values.cend(); ++it) metrics[it.key()] = it.value();
+    payload["metrics"] = metrics;
+    publishControlEvent("progress", payload);
 }
 
 void MainWindow::updatePredictStatus(const QString &msg) {
@@ -839,80 +1441,35 @@ void MainWindow::updatePredictStatus(const QString &msg) {
 }
 
 void MainWindow::updateProgressFromLog() {
+    addLogEpochs(progressLogFollower.readNewLines());
     int curEpoch = parseEpochFromLog(currentLogPath);
     if (curEpoch > lastParsedEpoch) {
         lastParsedEpoch = curEpoch;
         int percent = qMin(100, (int)((curEpoch + 1) * 100.0 / currentTotalEpoch));
-        qDebug() << "[MainWindow] Real-time progress from log:" << percent << "% , epoch:" << curEpoch;
+        qCDebug(lcProgress) << "[MainWindow] Real-time progress from log:" << percent << "% , epoch:" << curEpoch;
         ui->progressBar_step2->setValue(percent);
     }
 }
 
+void MainWindow::addLogEpochs(const QStringList &lines) {
+    for (const QString &line : lines) {
+        EpochMetrics metrics;
+        if (!parseEpochMetrics(line, metrics)) continue;
+        curveWidget->addEpoch(metrics);
+        if (metrics.values.contains("val_R2")) transferStopper.observe(metrics.epoch, metrics.values.value("val_R2"));
+    }
+}
+
 bool MainWindow::isValidFileFormat(const QString &fileName) {
-    QFileInfo fileInfo(fileName);
-    QString suffix = fileInfo.suffix().toLower();
-    QStringList validFormats = {"csv", "pt", "xls", "xlsx"};
-    return validFormats.contains(suffix);
+    return PathUtils::isSupportedDataFile(fileName);
 }
 
 int MainWindow::parseEpochFromLog(const QString &logPath) {
-    QFile f(logPath);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return -1;
-    }
-    int lastEpoch = -1;
-    QTextStream in(&f);
-    QRegularExpression re("epoch = (\\d+)[, ]"); // 支持逗号或空格结尾
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        auto match = re.match(line);
-        if (match.hasMatch()) {
-            lastEpoch = match.captured(1).toInt();
-        }
-    }
-    return lastEpoch;
+    return lastEpochInLog(logPath);
 }
 
 bool MainWindow::containsChineseCharacters(const QString &path) {
-    // 检查字符串是否包含中文字符
-    // 中文字符的Unicode范围：0x4E00-0x9FFF (基本汉字)
-    // 以及一些扩展的中文字符范围
-    for (const QChar &ch : path) {
-        ushort unicode = ch.unicode();
-        // 基本汉字范围
-        if (unicode >= 0x4E00 && unicode <= 0x9FFF) {
-            return true;
-        }
-        // 扩展汉字范围A
-        if (unicode >= 0x3400 && unicode <= 0x4DBF) {
-            return true;
-        }
-        // 扩展汉字范围B
-        if (unicode >= 0x20000 && unicode <= 0x2A6DF) {
-            return true;
-        }
-        // 扩展汉字范围C
-        if (unicode >= 0x2A700 && unicode <= 0x2B73F) {
-            return true;
-        }
-        // 扩展汉字范围D
-        if (unicode >= 0x2B740 && unicode <= 0x2B81F) {
-            return true;
-        }
-        // 扩展汉字范围E
-        if (unicode >= 0x2B820 && unicode <= 0x2CEAF) {
-            return true;
-        }
-        // 扩展汉字范围F
-        if (unicode >= 0x2CEB0 && unicode <= 0x2EBEF) {
-            return true;
-        }
-        // 扩展汉字范围G
-        if (unicode >= 0x30000 && unicode <= 0x3134F) {
-            return true;
-        }
-    }
-    return false;
+    return PathUtils::containsChineseCharacters(path);
 }
 
 // Load Model 按钮
@@ -932,6 +1489,24 @@ void MainWindow::on_pushButton_load_model_clicked()
             continue;
         }
         
+        // <pheno>_menet.pt 登记进模型仓库，原来的当前模型保留可回滚；相同内容只存一份
+        if (fileInfo.fileName().endsWith("_menet.pt") && fileInfo.fileName().size() > QString("_menet.pt").size()) {
+            ModelRegistry *registry = ModelRegistry::instance();
+            ModelRegistry::Model meta;
+            meta.phenotype = fileInfo.fileName().chopped(QString("_menet.pt").size());
+            meta.source = "import";
+            meta.originalName = fileInfo.absoluteFilePath();
+            QString error;
+            const QString hash = registry->add(fileName, meta, false, &error);
+            if (hash.isEmpty() || !registry->setCurrent(meta.phenotype, hash, &error)) {
+                failedFiles << fileInfo.fileName() + " (" + error + ")";
+            } else if (registry->model(hash).originalName != meta.originalName) {
+                successFiles << fileInfo.fileName() + tr(" (already in the model registry)");
+            } else {
+                successFiles << fileInfo.fileName();
+            }
+            continue;
+        }
         QString targetFile = targetDir + "/" + fileInfo.fileName();
         if (QFile::exists(targetFile)) QFile::remove(targetFile);
         
@@ -966,7 +1541,7 @@ void MainWindow::on_pushButton_load_model_clicked()
 void MainWindow::on_pushButton_transfer_learning_clicked()
 {
     if (isStep2Running) {
-        qDebug() << "[MainWindow] TransferLearning: already running, ignore.";
+        qCDebug(lcUi) << "[MainWindow] TransferLearning: already running, ignore.";
         return;
     }
     if (selectedPhenotypes.isEmpty()) {
@@ -986,6 +1561,7 @@ void MainWindow::showNextTransferLearningDialog()
     if (pendingPhenotypes.isEmpty()) {
         if (phenotypeSettings.isEmpty()) {
             ui->pushButton_transfer_learning->setEnabled(true);
+            QTimer::singleShot(0, this, &MainWindow::runQueuedControlSubmission);
             return;
         }
         startTransferLearningForPhenotypes();
@@ -1025,9 +1601,14 @@ void MainWindow::showNextTransferLearningDialog()
     // 隐藏ESN参数区
     auto esnGroup = dlg->findChild<QGroupBox*>(QString(), Qt::FindDirectChildrenOnly);
     if (esnGroup) esnGroup->hide();
-    connect(dlg, &QDialog::accepted, this, [this, phenotype, dlg, &mmnetBatch, &mmnetP1, &mmnetP2, &mmnetP3, &mmnetP4, &mmnetSaved, &mmnetWd]() {
+    EarlyStopper::Config earlyStop = loadEarlyStopConfig(phenotype);
+    dlg->setEarlyStopValues(earlyStop.enabled, earlyStop.patience, earlyStop.minDelta);
+    connect(dlg, &QDialog::accepted, this, [this, phenotype, dlg]() {
+        int mmnetBatch, mmnetSaved;
+        double mmnetP1, mmnetP2, mmnetP3, mmnetP4, mmnetWd;
         dlg->getMmnetValues(mmnetBatch, mmnetP1, mmnetP2, mmnetP3, mmnetP4, mmnetSaved, mmnetWd);
         PhenotypeSetting setting;
+        dlg->getEarlyStopValues(setting.earlyStop.enabled, setting.earlyStop.patience, setting.earlyStop.minDelta);
         setting.mmnetBatch = mmnetBatch;
         setting.mmnetP1 = mmnetP1;
         setting.mmnetP2 = mmnetP2;
@@ -1062,10 +1643,13 @@ void MainWindow::startTransferLearningForPhenotypes()
         mmnetObj = doc.object();
         mmnetFile.close();
     }
+    saveEarlyStopConfigs();
+    cancelRequested = false;
+    setCancelAvailable(true);
     ui->progressBar_step2->setVisible(true);
     ui->progressBar_step2->setFormat(tr("Transfer Learning Progress: %p%"));
     ui->progressBar_step2->setValue(0);
-    ui->progressBar_step2->repaint();
+    ui->progressBar_step2->update();
     QApplication::processEvents();
     QStringList queue = phenotypeSettings.keys();
     QList<QString> resultMsgs;
@@ -1074,17 +1658,25 @@ void MainWindow::startTransferLearningForPhenotypes()
     QElapsedTimer totalTimer;
     totalTimer.start();
     for (const QString &phenotype : queue) {
+        if (cancelRequested) {
+            resultMsgs << phenotype + tr(": Cancelled");
+            continue;
+        }
         currentPhenotype++;
         const PhenotypeSetting &setting = phenotypeSettings[phenotype];
         ui->progressBar_step2->setFormat(tr("Transfer Learning Progress (%1): %p%").arg(phenotype));
         ui->progressBar_step2->setValue((currentPhenotype - 1) * 100 / totalPhenotypes);
-        ui->progressBar_step2->repaint();
+        ui->progressBar_step2->update();
         QApplication::processEvents();
         QString modelPath = QDir::currentPath() + QString("/MENET/saved/%1_menet.pt").arg(phenotype);
+        ModelRegistry::instance()->resolve(phenotype);
         if (!QFile::exists(modelPath)) {
             resultMsgs << phenotype + tr(": Unable to find pre-trained model file:") + modelPath;
             continue;
         }
+        // transferLearning.exe可能原地改写这个文件，先从仓库对象上拆成独立副本
+        const QString parentHash = ModelRegistry::instance()->currentHash(phenotype);
+        ModelRegistry::instance()->detach(modelPath);
         QString exePath = QDir::currentPath() + "/MENET/transferLearning.exe";
         QString logPath = QDir::currentPath() + "/MENET/step3.log";
         QString jsonPath = QDir::currentPath() + "/MENET/configs/MeNet.json";
@@ -1092,6 +1684,24 @@ void MainWindow::startTransferLearningForPhenotypes()
             resultMsgs << phenotype + tr(": Unable to find transferLearning.exe");
             continue;
         }
+        // 内存放不下时在这里等其他作业释放；回调可能在取消之后才到，状态放在共享指针里
+        auto admitted = std::make_shared<bool>(false);
+        const int admissionTicket = AdmissionController::instance()->submit(
+            tr("Transfer learning %1").arg(phenotype), estimatePeakMB("transfer", phenotype),
+            [admitted](int) { *admitted = true; });
+        if (AdmissionController::instance()->isWaiting(admissionTicket)) {
+            ui->progressBar_step2->setFormat(tr("Waiting for memory (%1)...").arg(phenotype));
+        }
+        while (!*admitted && !cancelRequested) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+        }
+        ui->progressBar_step2->setFormat(tr("Transfer Learning Progress (%1): %p%").arg(phenotype));
+        if (cancelRequested) {
+            AdmissionController::instance()->release(admissionTicket);
+            finishTransferModel(phenotype, parentHash, QDateTime::currentDateTime(), false, settingToJson(setting), QJsonObject());
+            resultMsgs << phenotype + tr(": Cancelled");
+            continue;
+        }
         QFile step3Log(logPath);
         if (step3Log.exists()) step3Log.remove();
         if (!step3Log.open(QIODevice::WriteOnly)) {
@@ -1103,10 +1713,16 @@ void MainWindow::startTransferLearningForPhenotypes()
         currentLogPath = logPath;
         currentTotalEpoch = setting.mmnetSaved;
         lastParsedEpoch = -1;
+        curveWidget->clear();
+        curveWidget->setTitle(tr("Transfer learning curves (%1)").arg(phenotype));
+        curveWidget->setVisible(true);
+        transferStopper.reset(setting.earlyStop);
+        snapshotSavedFiles();
         startProgressMonitoring(logPath, setting.mmnetSaved);
         QElapsedTimer timer;
         timer.start();
         QProcess proc;
+        ResourceControl::instance()->prepareProcess(proc, "transfer");
         QStringList args;
         args << "--phenotype" << phenotype;
         proc.setWorkingDirectory(QDir::currentPath() + "/MENET");
@@ -1117,25 +1733,66 @@ void MainWindow::startTransferLearningForPhenotypes()
             });
         }
 #endif
+        const QDateTime runStart = QDateTime::currentDateTime();
+        captureProcessOutput(&proc, "transferLearning.exe --phenotype " + phenotype,
+                             phenotype + "_transfer_" + runStart.toString("yyyyMMdd_hhmmss"));
         proc.start(exePath, args);
+        AdmissionController::instance()->attachProcess(admissionTicket, proc.processId());
         // 让主线程处理事件，保证进度条实时刷新
+        bool stoppedEarly = false;
+        double peakMemMB = 0.0;
+        QElapsedTimer memSampleTimer;
+        memSampleTimer.start();
         while (proc.state() != QProcess::NotRunning) {
             QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+            if (memSampleTimer.elapsed() >= 500 && proc.state() == QProcess::Running) {
+                peakMemMB = qMax(peakMemMB, ProcessControl::peakMemoryMB(proc.processId()));
+                memSampleTimer.restart();
+            }
+            if (cancelRequested) {
+                ProcessControl::terminateTree(proc);
+                break;
+            }
+            if (transferStopper.hasFired()) {
+                qCInfo(lcUi) << "[MainWindow] Transfer learning early stop, best epoch:" << transferStopper.bestEpoch();
+                ProcessControl::terminateTree(proc);
+                stoppedEarly = true;
+                break;
+            }
         }
-        if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) {
+        AdmissionController::instance()->release(admissionTicket);
+        RunHistory::Run run;
+        run.kind = "transfer";
+        run.phenotype = phenotype;
+        run.params = settingToJson(setting);
+        run.paramHash = trainingParamHash(run.params);
+        run.startedAt = runStart;
+        run.step2Seconds = run.totalSeconds = timer.elapsed() / 1000.0;
+        run.peakMemoryMB = peakMemMB;
+        run.dataMB = phenotypeDataMB(phenotype);
+        if (cancelRequested) {
+            stopProgressMonitoring();
+            removePartialArtifacts();
+            finishTransferModel(phenotype, parentHash, runStart, false, run.params, QJsonObject());
+            run.status = "cancelled";
+            run.logPath = archiveRunLog(logPath, run);
+            RunHistory::instance()->record(run);
+            resultMsgs << phenotype + tr(": Cancelled");
+            continue;
+        }
+        // 存档会把step3.log移走，先把最后几个epoch读进曲线
+        stopProgressMonitoring();
+        fillRunMetricsFromLog(run, logPath);
+        run.status = stoppedEarly ? "early_stopped"
+                   : (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) ? "failed" : "success";
+        run.logPath = archiveRunLog(logPath, run);
+        RunHistory::instance()->record(run);
+        finishTransferModel(phenotype, parentHash, runStart, run.status != "failed", run.params, runMetricsJson(run));
+        if (!stoppedEarly && (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)) {
             resultMsgs << phenotype + tr(": transferLearning.exe failed");
         } else {
             // 解析step3.log最后一行的决定系数
-            QString lastLine;
-            QFile step3Log(logPath);
-            if (step3Log.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                QTextStream in(&step3Log);
-                while (!in.atEnd()) {
-                    QString line = in.readLine();
-                    if (!line.trimmed().isEmpty()) lastLine = line;
-                }
-                step3Log.close();
-            }
+            QString lastLine = LogTail::lastNonEmptyLine(run.logPath.isEmpty() ? logPath : run.logPath);
             QString trainR2, valR2;
             QRegularExpression reTrain("train_R2\\s*=\\s*([\\d\\.\\-eE]+)");
             QRegularExpression reVal("val_R2\\s*=\\s*([\\d\\.\\-eE]+)");
@@ -1157,12 +1814,15 @@ void MainWindow::startTransferLearningForPhenotypes()
             } else {
                 timeMsg = QString("\nTime taken for this transfer learning: %1 seconds").arg(seconds, 0, 'f', 2);
             }
+            if (stoppedEarly) {
+                r2Msg += tr("\nStopped early: best val_R2 %1 at epoch %2").arg(transferStopper.bestValue()).arg(transferStopper.bestEpoch());
+            }
             resultMsgs << phenotype + tr(": Transfer Learning completed!") + r2Msg + timeMsg;
         }
         // 结束进度监控
         stopProgressMonitoring();
         ui->progressBar_step2->setValue(currentPhenotype * 100 / totalPhenotypes);
-        ui->progressBar_step2->repaint();
+        ui->progressBar_step2->update();
         QApplication::processEvents();
     }
     ui->progressBar_step2->setValue(100);
@@ -1180,6 +1840,7 @@ void MainWindow::startTransferLearningForPhenotypes()
         msg += line + "\n";
     }
     msg += "\n" + totalTimeMsg;
+    setCancelAvailable(false);
     MyMessageBox msgBox(this);
     msgBox.setMySize(500, 300);
     msgBox.setIcon(QMessageBox::Information);
@@ -1188,17 +1849,22 @@ void MainWindow::startTransferLearningForPhenotypes()
     msgBox.setStandardButtons(QMessageBox::Ok);
     msgBox.exec();
     ui->pushButton_transfer_learning->setEnabled(true);
+    QTimer::singleShot(0, this, &MainWindow::runQueuedControlSubmission);
 }
 
 void MainWindow::startProgressMonitoring(const QString &logPath, int totalEpoch) {
     currentLogPath = logPath;
     currentTotalEpoch = totalEpoch;
     lastParsedEpoch = -1;
+    progressLogFollower.reset(logPath);
     if (progressTimer) progressTimer->start(500); // 500ms刷新
 }
 
 void MainWindow::stopProgressMonitoring() {
     if (progressTimer) progressTimer->stop();
+    // 进程已经结束，读到日志末尾（可能超过单次4MB的上限），把最后几个epoch补进曲线
+    addLogEpochs(progressLogFollower.drainAll());
+    updateProgressFromLog();
 }
 
 // 新增：测试显示图片的函数
@@ -1211,8 +1877,8 @@ void MainWindow::testShowImage()
     msgBox.setText(tr("Testing image display functionality.\nBelow should show the PCA curve image:"));
     
     QString imagePath = QDir::currentPath() + "/MENET/culmlength_pca_curve.png";
-    qDebug() << "[MainWindow] Testing image display with path:" << imagePath;
-    qDebug() << "[MainWindow] Image file exists:" << QFileInfo(imagePath).exists();
+    qCDebug(lcUi) << "[MainWindow] Testing image display with path:" << imagePath;
+    qCDebug(lcUi) << "[MainWindow] Image file exists:" << QFileInfo(imagePath).exists();
     
     msgBox.setImage(imagePath);
     
@@ -1220,5 +1886,856 @@ void MainWindow::testShowImage()
     msgBox.exec();
 }
 
+EarlyStopper::Config MainWindow::loadEarlyStopConfig(const QString &phenotype)
+{
+    // 早停规则是GUI侧的配置，单独存放，不写进python读取的MeNet.json
+    EarlyStopper::Config config;
+    QFile file(QDir::currentPath() + "/MENET/configs/EarlyStop.json");
+    if (file.open(QIODevice::ReadOnly)) {
+        QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+        if (obj.contains(phenotype) && obj[phenotype].isObject()) {
+            QJsonObject phenoObj = obj[phenotype].toObject();
+            if (phenoObj.contains("enabled")) config.enabled = phenoObj["enabled"].toBool();
+            if (phenoObj.contains("patience")) config.patience = phenoObj["patience"].toInt();
+            if (phenoObj.contains("min_delta")) config.minDelta = phenoObj["min_delta"].toDouble();
+        }
+        file.close();
+    }
+    return config;
+}
 
+void MainWindow::saveEarlyStopConfigs()
+{
+    QString jsonPath = QDir::currentPath() + "/MENET/configs/EarlyStop.json";
+    QFile file(jsonPath);
+    QJsonObject obj;
+    if (file.open(QIODevice::ReadOnly)) {
+        obj = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+    }
+    for (auto it = phenotypeSettings.begin(); it != phenotypeSettings.end(); ++it) {
+        QJsonObject phenoObj;
+        phenoObj["enabled"] = it.value().earlyStop.enabled;
+        phenoObj["patience"] = it.value().earlyStop.patience;
+        phenoObj["min_delta"] = it.value().earlyStop.minDelta;
+        obj[it.key()] = phenoObj;
+    }
+    QDir().mkpath(QFileInfo(jsonPath).absolutePath());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(obj).toJson(QJsonDocument::Indented));
+        file.close();
+    }
+}
 
+void MainWindow::snapshotSavedFiles()
+{
+    savedFilesBeforeRun.clear();
+    QDir savedDir(QDir::currentPath() + "/MENET/saved");
+    for (const QString &name : savedDir.entryList(QDir::Files | QDir::NoDotAndDotDot)) {
+        savedFilesBeforeRun.insert(name);
+    }
+}
+
+void MainWindow::removePartialArtifacts()
+{
+    // 只删除本次运行中新出现的文件，已有的模型一律保留
+    QDir savedDir(QDir::currentPath() + "/MENET/saved");
+    for (const QString &name : savedDir.entryList(QDir::Files | QDir::NoDotAndDotDot)) {
+        if (savedFilesBeforeRun.contains(name)) continue;
+        qCInfo(lcUi) << "[MainWindow] Removing partial artifact:" << savedDir.absoluteFilePath(name);
+        QFile::remove(savedDir.absoluteFilePath(name));
+    }
+}
+
+void MainWindow::promoteTrainedModel(const QString &phenotype, const QJsonObject &params, const QJsonObject &metrics)
+{
+    QString ptFile = QDir::currentPath() + "/MENET/saved/menet.pt";
+    if (!QFile::exists(ptFile)) return;
+    // 旧模型留在仓库里，可以随时回滚；saved/<pheno>_menet.pt变成新模型的链接
+    ModelRegistry::Model meta;
+    meta.phenotype = phenotype;
+    meta.source = "train";
+    meta.params = params;
+    meta.metrics = metrics;
+    QString error;
+    const QString hash = ModelRegistry::instance()->add(ptFile, meta, true, &error);
+    if (hash.isEmpty() || !ModelRegistry::instance()->setCurrent(phenotype, hash, &error)) {
+        qCWarning(lcUi) << "[MainWindow] Unable to register model for" << phenotype << ":" << error;
+        // 仓库不可用时退回原来的直接改名
+        QString ptTarget = QDir::currentPath() + QString("/MENET/saved/%1_menet.pt").arg(phenotype);
+        if (QFile::exists(ptFile)) {
+            if (QFile::exists(ptTarget)) QFile::remove(ptTarget);
+            QFile::rename(ptFile, ptTarget);
+        }
+    }
+}
+
+void MainWindow::finishTransferModel(const QString &phenotype, const QString &parentHash, const QDateTime &runStart,
+                                     bool success, const QJsonObject &params, const QJsonObject &metrics)
+{
+    ModelRegistry *registry = ModelRegistry::instance();
+    const QString workingPath = registry->workingPath(phenotype);
+    if (success) {
+        // 新模型可能写到saved/menet.pt，也可能原地覆盖了<pheno>_menet.pt
+        QString output;
+        const QString ptFile = QDir::currentPath() + "/MENET/saved/menet.pt";
+        if (QFileInfo::exists(ptFile) && QFileInfo(ptFile).lastModified() >= runStart) output = ptFile;
+        else if (QFileInfo::exists(workingPath) && QFileInfo(workingPath).lastModified() >= runStart) output = workingPath;
+        if (!output.isEmpty()) {
+            ModelRegistry::Model meta;
+            meta.phenotype = phenotype;
+            meta.source = "transfer";
+            meta.parent = parentHash;
+            meta.params = params;
+            meta.metrics = metrics;
+            QString error;
+            const QString hash = registry->add(output, meta, true, &error);
+            if (!hash.isEmpty() && registry->setCurrent(phenotype, hash, &error)) return;
+            qCWarning(lcUi) << "[MainWindow] Unable to register transfer learning model for" << phenotype << ":" << error;
+        }
+    }
+    // 失败或取消：工作文件可能被写了一半，按仓库恢复成父模型
+    if (!parentHash.isEmpty()) registry->setCurrent(phenotype, parentHash);
+}
+
+void MainWindow::setCancelAvailable(bool available)
+{
+    cancelButton->setVisible(available);
+    cancelButton->setEnabled(available);
+}
+
+void MainWindow::cancelRunningJobs()
+{
+    qCInfo(lcUi) << "[MainWindow] cancelRunningJobs called";
+    cancelRequested = true;
+    cancelButton->setEnabled(false);
+    trainPhenoQueue.clear();
+    predictPhenoQueue.clear();
+    // 训练在Worker线程里，由它自己终止子进程；迁移学习循环会在下一次检查时终止
+    if (worker && workerThread && workerThread->isRunning()) {
+        worker->requestCancel();
+    }
+    if (clusterRunActive && cluster) {
+        cluster->cancelAll();
+    }
+    // 交叉验证的各折结束后onCrossValidationFinished收尾
+    if (crossValidator && crossValidator->isRunning()) {
+        crossValidator->cancel();
+    }
+    if (predictProcess && predictProcess->state() != QProcess::NotRunning) {
+        ProcessControl::terminateTree(*predictProcess, 3000);
+    }
+    // 还在排队等内存的作业直接撤回并结束批次；已准入但回调未到的由回调自己检查cancelRequested
+    AdmissionController *admission = AdmissionController::instance();
+    if (trainWaitingTicket && admission->isWaiting(trainWaitingTicket)) {
+        admission->release(trainWaitingTicket);
+        trainWaitingTicket = 0;
+        journal.endBatch(trainBatchId, "cancelled");
+        trainBatchId.clear();
+        trainResultMsgs << tr("Cancelled");
+        trainNextPhenotype();
+    }
+    if (predictWaitingTicket && admission->isWaiting(predictWaitingTicket)) {
+        admission->release(predictWaitingTicket);
+        predictWaitingTicket = 0;
+        predictResultMsgs << currentPredictPhenotype + tr(": Prediction cancelled");
+        QTimer::singleShot(0, this, &MainWindow::predictNextPhenotype);
+    }
+}
+
+void MainWindow::onEarlyStopped(int bestEpoch, double bestValR2)
+{
+    earlyStopNote = tr("\nStopped early: best val_R2 %1 at epoch %2").arg(bestValR2).arg(bestEpoch);
+}
+
+void MainWindow::openSweepDialog()
+{
+    if (selectedPhenotypes.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("Please select one or more phenotype files first!"));
+        return;
+    }
+    SweepDialog *dialog = new SweepDialog(QDir::currentPath() + "/MENET", selectedPhenotypes, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::openTuneDialog()
+{
+    if (selectedPhenotypes.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("Please select one or more phenotype files first!"));
+        return;
+    }
+    TuneDialog *dialog = new TuneDialog(QDir::currentPath() + "/MENET", selectedPhenotypes, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::onStep1Completed()
+{
+    eta.step1Finished();
+    // 从checkpoint续训时保留原来的第二步开始时间，再次中断仍能认出这个checkpoint
+    if (currentRunUsesCheckpoint) return;
+    journal.recordStage(trainBatchId, currentTrainPhenotype, JobJournal::StageStep1Done);
+    journal.recordStage(trainBatchId, currentTrainPhenotype, JobJournal::StageStep2Start);
+}
+
+QJsonObject MainWindow::settingToJson(const PhenotypeSetting &setting)
+{
+    QJsonObject obj;
+    obj["esn_batch"] = setting.esnBatch;
+    obj["esn_p"] = setting.esnP;
+    obj["esn_saved"] = setting.esnSaved;
+    obj["menet_batch"] = setting.mmnetBatch;
+    obj["menet_p1"] = setting.mmnetP1;
+    obj["menet_p2"] = setting.mmnetP2;
+    obj["menet_p3"] = setting.mmnetP3;
+    obj["menet_p4"] = setting.mmnetP4;
+    obj["menet_saved"] = setting.mmnetSaved;
+    obj["menet_wd"] = setting.mmnetWd;
+    obj["early_stop"] = setting.earlyStop.enabled;
+    obj["patience"] = setting.earlyStop.patience;
+    obj["min_delta"] = setting.earlyStop.minDelta;
+    obj["threads"] = setting.threads;
+    return obj;
+}
+
+MainWindow::PhenotypeSetting MainWindow::settingFromJson(const QJsonObject &obj)
+{
+    PhenotypeSetting setting;
+    setting.esnBatch = obj.value("esn_batch").toInt(128);
+    setting.esnP = obj.value("esn_p").toDouble(0.8);
+    setting.esnSaved = obj.value("esn_saved").toInt(100);
+    setting.mmnetBatch = obj.value("menet_batch").toInt(128);
+    setting.mmnetP1 = obj.value("menet_p1").toDouble(0.8);
+    setting.mmnetP2 = obj.value("menet_p2").toDouble(0.8);
+    setting.mmnetP3 = obj.value("menet_p3").toDouble(0.8);
+    setting.mmnetP4 = obj.value("menet_p4").toDouble(0.6);
+    setting.mmnetSaved = obj.value("menet_saved").toInt(100);
+    setting.mmnetWd = obj.value("menet_wd").toDouble(1e-5);
+    setting.earlyStop.enabled = obj.value("early_stop").toBool(false);
+    setting.earlyStop.patience = obj.value("patience").toInt(20);
+    setting.earlyStop.minDelta = obj.value("min_delta").toDouble(0.001);
+    setting.threads = obj.value("threads").toInt(0);
+    return setting;
+}
+
+void MainWindow::checkUnfinishedJobs()
+{
+    for (const JobJournal::Batch &batch : journal.unfinishedBatches()) {
+        int remaining = 0;
+        for (const QString &phenotype : batch.phenotypes) {
+            const QString stage = batch.stages.value(phenotype);
+            if (stage != JobJournal::StagePromoted && stage != JobJournal::StageDone && stage != JobJournal::StageFailed) ++remaining;
+        }
+        const bool isTrain = batch.kind == "train";
+        if (remaining == 0 || (isTrain && isStep2Running) || (!isTrain && predictProcess)) {
+            journal.endBatch(batch.id, remaining == 0 ? "completed" : "abandoned");
+            continue;
+        }
+        const QString question = (isTrain ? tr("An unfinished training batch was found.") : tr("An unfinished prediction batch was found."))
+                               + "\n\n" + tr("Phenotypes: %1").arg(batch.phenotypes.join(", "))
+                               + "\n" + tr("Remaining: %1 of %2").arg(remaining).arg(batch.phenotypes.size())
+                               + "\n\n" + tr("Resume it now? Completed stages will be skipped.");
+        if (QMessageBox::question(this, tr("Resume"), question) != QMessageBox::Yes) {
+            journal.endBatch(batch.id, "abandoned");
+            continue;
+        }
+        if (isTrain) resumeTrainingBatch(batch);
+        else resumePredictBatch(batch);
+    }
+}
+
+void MainWindow::resumeTrainingBatch(const JobJournal::Batch &batch)
+{
+    qCInfo(lcUi) << "[MainWindow] Resuming training batch" << batch.id << batch.stages;
+    phenotypeSettings.clear();
+    for (const QString &phenotype : batch.phenotypes) {
+        phenotypeSettings[phenotype] = settingFromJson(batch.settings.value(phenotype).toObject());
+    }
+    // 参数快照重新写回配置，保证续跑和原批次用同一组参数
+    writePhenotypeConfigs();
+    QDir().mkpath(QDir::currentPath() + "/MENET/saved");
+    trainBatchId = batch.id;
+    cancelRequested = false;
+    trainPhenoQueue.clear();
+    trainResultMsgs.clear();
+    resumeSkipStep1.clear();
+    resumeStep2Start.clear();
+    // 队列按表型顺序逐个训练，已结束的一定排在未结束的前面，汇总消息的顺序保持一致
+    for (auto it = phenotypeSettings.begin(); it != phenotypeSettings.end(); ++it) {
+        const QString &phenotype = it.key();
+        const QString stage = batch.stages.value(phenotype);
+        if (stage == JobJournal::StagePromoted) {
+            trainResultMsgs << tr("Success (completed before restart)");
+        } else if (stage == JobJournal::StageFailed) {
+            trainResultMsgs << tr("Failed (before restart)");
+        } else {
+            trainPhenoQueue << phenotype;
+            if (stage == JobJournal::StageStep1Done || stage == JobJournal::StageStep2Start) resumeSkipStep1.insert(phenotype);
+            if (stage == JobJournal::StageStep2Start) resumeStep2Start.insert(phenotype, batch.stageTimes.value(phenotype));
+        }
+    }
+    ui->pushButton_3->setEnabled(false);
+    beginEtaForBatch();
+    trainNextPhenotype();
+}
+
+void MainWindow::resumePredictBatch(const JobJournal::Batch &batch)
+{
+    qCInfo(lcUi) << "[MainWindow] Resuming prediction batch" << batch.id << batch.stages;
+    predictPhenoQueue.clear();
+    predictResultMsgs.clear();
+    for (const QString &phenotype : batch.phenotypes) {
+        const QString stage = batch.stages.value(phenotype);
+        if (stage == JobJournal::StageDone) predictResultMsgs << phenotype + tr(": Prediction completed before restart");
+        else predictPhenoQueue << phenotype;
+    }
+    predictBatchId = batch.id;
+    cancelRequested = false;
+    ui->pushButton_4->setText(tr("Predicting..."));
+    ui->pushButton_4->setEnabled(false);
+    setCancelAvailable(true);
+    predictNextPhenotype();
+}
+
+void MainWindow::openHistoryDialog()
+{
+    HistoryDialog *dialog = new HistoryDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::openModelsDialog()
+{
+    ModelsDialog *dialog = new ModelsDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::openLogConsole()
+{
+    logConsole->show();
+    logConsole->raise();
+    logConsole->activateWindow();
+}
+
+void MainWindow::captureProcessOutput(QProcess *process, const QString &title, const QString &spillName)
+{
+    // 边产生边取走输出，不让它堆在QProcess里；要在其它finished处理之前连接
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    auto capture = std::make_shared<OutputCapture>(QDir::currentPath() + "/MENET/logs/output/" + spillName + ".zlog");
+    logConsole->beginSection(title);
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, process, capture]() {
+        const QByteArray chunk = process->readAllStandardOutput();
+        capture->append(chunk);
+        logConsole->appendOutput(chunk);
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, process, capture]() {
+        const QByteArray chunk = process->readAllStandardOutput();
+        capture->append(chunk);
+        logConsole->appendOutput(chunk);
+        capture->finish();
+        if (capture->hasSpilled()) {
+            logConsole->noteSpillFile(capture->spillPath());
+            qCInfo(lcUi) << "[MainWindow] Full process output saved to:" << capture->spillPath();
+        }
+    });
+}
+
+void MainWindow::openClusterDialog()
+{
+    ClusterDialog *dialog = new ClusterDialog(cluster, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::startClusterTraining()
+{
+    // writePhenotypeConfigs刚写好的配置里，每个任务只带自己表型的那一段
+    auto readConfig = [](const QString &path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) return QJsonObject();
+        return QJsonDocument::fromJson(file.readAll()).object();
+    };
+    const QJsonObject esnObj = readConfig(QDir::currentPath() + "/MENET/configs/RepGeno.json");
+    const QJsonObject mmnetObj = readConfig(QDir::currentPath() + "/MENET/configs/MeNet.json");
+    const QString phenDir = QDir::currentPath() + "/MENET/data/phen";
+    QList<ClusterDispatcher::JobSpec> specs;
+    for (auto it = phenotypeSettings.begin(); it != phenotypeSettings.end(); ++it) {
+        ClusterDispatcher::JobSpec spec;
+        spec.phenotype = it.key();
+        spec.repgeno = esnObj.value(it.key()).toObject();
+        spec.menet = mmnetObj.value(it.key()).toObject();
+        const EarlyStopper::Config &earlyStop = it.value().earlyStop;
+        spec.earlyStop["enabled"] = earlyStop.enabled;
+        spec.earlyStop["patience"] = earlyStop.patience;
+        spec.earlyStop["min_delta"] = earlyStop.minDelta;
+        const QStringList found = QDir(phenDir).entryList({it.key() + ".csv", it.key() + ".pt", it.key() + ".xls", it.key() + ".xlsx"}, QDir::Files);
+        if (!found.isEmpty()) spec.phenFilePath = phenDir + "/" + found.first();
+        specs << spec;
+    }
+    qCInfo(lcUi) << "[MainWindow] Dispatching" << specs.size() << "phenotypes to" << cluster->healthyNodeCount() << "cluster nodes";
+    clusterRunActive = true;
+    isStep2Running = true;
+    clusterResults.clear();
+    clusterCurvePhenotype.clear();
+    ui->progressBar_step2->setFormat(tr("Cluster training: %p%"));
+    ui->progressBar_step2->setValue(0);
+    ui->progressBar_step2->setVisible(true);
+    curveWidget->clear();
+    curveWidget->setVisible(true);
+    setCancelAvailable(true);
+    cluster->submit(specs);
+}
+
+void MainWindow::onClusterJobFinished(int index)
+{
+    if (!clusterRunActive) return;
+    const ClusterDispatcher::Job &job = cluster->jobs().at(index);
+    const QString &phenotype = job.spec.phenotype;
+    if (phenotype == clusterCurvePhenotype) clusterCurvePhenotype.clear();
+    const bool cancelled = job.state == ClusterDispatcher::JobState::Cancelled || (cancelRequested && !job.ok);
+
+    RunHistory::Run run;
+    run.kind = "train";
+    run.phenotype = phenotype;
+    run.params = settingToJson(phenotypeSettings.value(phenotype));
+    run.paramHash = trainingParamHash(run.params);
+    run.startedAt = job.startedAt;
+    run.endedAt = QDateTime::currentDateTime();
+    run.step1Seconds = job.step1Seconds;
+    run.step2Seconds = job.step2Seconds;
+    run.totalSeconds = job.seconds;
+    if (!job.logPath.isEmpty()) fillRunMetricsFromLog(run, job.logPath);
+    run.status = cancelled ? "cancelled" : !job.ok ? "failed" : job.stoppedEarly ? "early_stopped" : "success";
+    run.message = job.message;
+    if (job.startedAt.isValid()) {
+        if (!job.logPath.isEmpty()) run.logPath = archiveRunLog(job.logPath, run);
+        RunHistory::instance()->record(run);
+    }
+    if (job.ok) {
+        // 回传的模型已放在saved/<pheno>_menet.pt，登记进模型仓库
+        ModelRegistry::Model meta;
+        meta.phenotype = phenotype;
+        meta.source = "cluster";
+        meta.params = run.params;
+        meta.metrics = runMetricsJson(run);
+        const QString hash = ModelRegistry::instance()->add(ModelRegistry::instance()->workingPath(phenotype), meta, true);
+        if (!hash.isEmpty()) ModelRegistry::instance()->setCurrent(phenotype, hash);
+    }
+    journal.recordStage(trainBatchId, phenotype, job.ok ? JobJournal::StagePromoted : JobJournal::StageFailed);
+
+    if (cancelled) {
+        clusterResults[phenotype] = tr("Cancelled");
+        return;
+    }
+    QString summary = job.ok ? tr("Success") : tr("Failed");
+    if (!qIsNaN(run.trainR2) && !qIsNaN(run.valR2)) {
+        summary += QString("\nR²: Train %1, Validation %2").arg(run.trainR2).arg(run.valR2);
+    }
+    if (job.stoppedEarly) summary += tr("\nStopped early");
+    if (job.node >= 0 && job.node < cluster->nodes().size()) {
+        const ClusterDispatcher::Node &node = cluster->nodes().at(job.node);
+        summary += tr("\nNode: %1").arg(node.host.isEmpty() ? node.address : node.host);
+    }
+    if (!job.ok && !job.message.isEmpty()) summary += "\n" + job.message;
+    summary += tr("\nTime taken for this training: %1").arg(EtaEstimator::formatDuration(job.seconds));
+    clusterResults[phenotype] = summary;
+    if (job.ok) {
+        QString imagePath = QDir::currentPath() + QString("/MENET/%1_pca_curve.png").arg(phenotype);
+        if (QFile::exists(imagePath)) {
+            ImageLoader::instance()->prefetch(imagePath, QSize(750, 450), devicePixelRatioF());
+        }
+    }
+}
+
+void MainWindow::onClusterAllFinished()
+{
+    if (!clusterRunActive) return;
+    clusterRunActive = false;
+    isStep2Running = false;
+    // 汇总弹框按phenotypeSettings的键顺序对应结果
+    trainResultMsgs.clear();
+    for (const QString &phenotype : phenotypeSettings.keys()) {
+        trainResultMsgs << clusterResults.value(phenotype, tr("Cancelled"));
+    }
+    clusterResults.clear();
+    if (cancelRequested) {
+        journal.endBatch(trainBatchId, "cancelled");
+        trainBatchId.clear();
+    }
+    showTrainSummary();
+}
+
+void MainWindow::beginEtaForBatch()
+{
+    geneDataMB = dirSizeMB(QDir::currentPath() + "/MENET/data/gene");
+    // 本次会话还没有实测值时，用最近90天的训练历史作为先验
+    RunHistory::Filter filter;
+    filter.kind = "train";
+    filter.from = QDateTime::currentDateTime().addDays(-90);
+    const RunHistory::Stats stats = RunHistory::instance()->stats(filter);
+    eta.setPriors(stats.avgStep1SecondsPerMB,
+                  stats.avgEpochsPerSecond > 0.0 ? 1.0 / stats.avgEpochsPerSecond : -1.0,
+                  0.0);
+    etaTimer->start(1000);
+}
+
+EtaEstimator::Job MainWindow::etaJobFor(const QString &phenotype, bool skipStep1) const
+{
+    EtaEstimator::Job job;
+    job.phenotype = phenotype;
+    // Worker按"saved"+1个epoch计算进度
+    job.totalEpochs = phenotypeSettings.value(phenotype).mmnetSaved + 1;
+    job.skipStep1 = skipStep1;
+    job.datasetMB = phenotypeDataMB(phenotype);
+    return job;
+}
+
+double MainWindow::phenotypeDataMB(const QString &phenotype) const
+{
+    // 训练批次开始时已统计过基因数据；预测和迁移学习时现算
+    double total = geneDataMB > 0.0 ? geneDataMB : dirSizeMB(QDir::currentPath() + "/MENET/data/gene");
+    QDir phenDir(QDir::currentPath() + "/MENET/data/phen");
+    for (const QFileInfo &info : phenDir.entryInfoList(QStringList() << phenotype + ".*", QDir::Files)) {
+        total += info.size() / (1024.0 * 1024.0);
+    }
+    return total;
+}
+
+double MainWindow::estimatePeakMB(const QString &kind, const QString &phenotype) const
+{
+    // 优先用同一表型的历史，没有时用同类作业的
+    RunHistory::Filter filter;
+    filter.kind = kind;
+    filter.phenotype = phenotype;
+    filter.limit = 20;
+    QList<RunHistory::Run> runs = RunHistory::instance()->query(filter);
+    if (runs.isEmpty()) {
+        filter.phenotype.clear();
+        runs = RunHistory::instance()->query(filter);
+    }
+    QList<QPair<double, double>> samples;
+    for (const RunHistory::Run &run : runs) {
+        if (run.peakMemoryMB > 0.0) samples << qMakePair(run.dataMB, run.peakMemoryMB);
+    }
+    const double estimate = AdmissionController::estimatePeakMB(kind, samples, phenotypeDataMB(phenotype));
+    qCDebug(lcUi) << "[MainWindow] Peak memory estimate for" << kind << phenotype << ":" << estimate << "MB from" << samples.size() << "runs";
+    return estimate;
+}
+
+void MainWindow::updateAdmissionDisplay()
+{
+    AdmissionController *admission = AdmissionController::instance();
+    const QList<AdmissionController::Entry> waiting = admission->waitingEntries();
+    const QList<AdmissionController::Entry> running = admission->runningEntries();
+    jobsButton->setVisible(!waiting.isEmpty() || !running.isEmpty());
+    int paused = 0, yielding = 0;
+    QStringList lines;
+    for (const AdmissionController::Entry &entry : running) {
+        if (entry.paused) {
+            ++paused;
+            lines << tr("%1: paused").arg(entry.label);
+        } else if (entry.preempted) {
+            ++yielding;
+            lines << tr("%1: yielding to an interactive job").arg(entry.label);
+        }
+    }
+    const QString reason = admission->waitReason();
+    if (!reason.isEmpty()) lines << reason;
+    for (const AdmissionController::Entry &entry : waiting) {
+        if (entry.paused) {
+            ++paused;
+            lines << tr("%1: paused in queue").arg(entry.label);
+        } else if (!reason.startsWith(entry.label)) {
+            lines << tr("%1 needs ~%2 MB").arg(entry.label).arg(entry.estimateMB, 0, 'f', 0);
+        }
+    }
+    QStringList parts;
+    const int queued = int(waiting.size()) - int(std::count_if(waiting.begin(), waiting.end(),
+                                                               [](const AdmissionController::Entry &e) { return e.paused; }));
+    if (queued > 0) parts << tr("Queued for memory: %1").arg(queued);
+    if (paused > 0) parts << tr("Paused: %1").arg(paused);
+    if (yielding > 0) parts << tr("Yielding to prediction: %1").arg(yielding);
+    admissionLabel->setText(parts.join("  |  "));
+    admissionLabel->setToolTip(lines.join("\n"));
+}
+
+void MainWindow::updatePressureDisplay()
+{
+    ResourceControl *control = ResourceControl::instance();
+    const ResourceControl::Pressure pressure = control->pressure();
+    if (!pressure.valid) {
+        pressureLabel->clear();
+        pressureLabel->setToolTip(control->unavailableReason());
+        return;
+    }
+    const auto percent = [](double value) { return qIsNaN(value) ? QString("-") : QString::number(value, 'f', value < 10.0 ? 1 : 0); };
+    pressureLabel->setText(tr("Pressure CPU %1%  Mem %2%  IO %3%")
+                               .arg(percent(pressure.cpu), percent(pressure.memory), percent(pressure.io)));
+    QStringList lines;
+    if (control->cgroupsAvailable()) {
+        lines << tr("Child jobs (cgroup %1)").arg(pressure.source);
+    } else {
+        lines << tr("Whole machine; child jobs run with nice/ionice (%1)").arg(control->unavailableReason());
+    }
+    lines << tr("Share of the last 10 s in which tasks were stalled waiting for CPU, memory or IO");
+    lines << tr("Memory, all tasks stalled: %1%").arg(percent(pressure.memoryFull));
+    pressureLabel->setToolTip(lines.join("\n"));
+}
+
+void MainWindow::populateJobsMenu(QMenu *menu)
+{
+    menu->clear();
+    AdmissionController *admission = AdmissionController::instance();
+    const QList<AdmissionController::Entry> running = admission->runningEntries();
+    const QList<AdmissionController::Entry> entries = running + admission->waitingEntries();
+    if (entries.isEmpty()) {
+        menu->addAction(tr("No jobs"))->setEnabled(false);
+        return;
+    }
+    menu->addAction(tr("Check a job to pause it"))->setEnabled(false);
+    bool anyPaused = false, anyActive = false;
+    for (int i = 0; i < entries.size(); ++i) {
+        const AdmissionController::Entry &entry = entries.at(i);
+        const QString state = entry.paused ? tr("paused")
+                            : i >= running.size() ? tr("queued")
+                            : entry.preempted ? tr("yielding")
+                            : tr("running");
+        QAction *action = menu->addAction(QString("%1  [%2, %3]").arg(entry.label,
+                                                                      AdmissionController::priorityName(entry.priority), state));
+        action->setCheckable(true);
+        action->setChecked(entry.paused);
+        const int ticket = entry.ticket;
+        connect(action, &QAction::toggled, this, [ticket](bool checked) {
+            AdmissionController::instance()->setPaused(ticket, checked);
+        });
+        if (entry.paused) anyPaused = true;
+        else anyActive = true;
+    }
+    menu->addSeparator();
+    QAction *pauseAll = menu->addAction(tr("Pause all"));
+    pauseAll->setEnabled(anyActive);
+    connect(pauseAll, &QAction::triggered, this, []() { AdmissionController::instance()->setAllPaused(true); });
+    QAction *resumeAll = menu->addAction(tr("Resume all"));
+    resumeAll->setEnabled(anyPaused);
+    connect(resumeAll, &QAction::triggered, this, []() { AdmissionController::instance()->setAllPaused(false); });
+}
+
+void MainWindow::updateEtaDisplay()
+{
+    if (!eta.isActive()) return;
+    QList<EtaEstimator::Job> queue;
+    QStringList lines;
+    for (const QString &phenotype : trainPhenoQueue) {
+        const EtaEstimator::Job job = etaJobFor(phenotype, resumeSkipStep1.contains(phenotype));
+        queue << job;
+        lines << QString("%1: %2").arg(phenotype, EtaEstimator::formatDuration(eta.estimateJobSeconds(job)));
+    }
+    const double current = eta.remainingCurrentSeconds();
+    const double total = eta.remainingTotalSeconds(queue);
+    QString text = tr("%1: %2 left").arg(eta.currentJob().phenotype, EtaEstimator::formatDuration(current));
+    if (!queue.isEmpty()) {
+        text += tr("  |  Batch (%1 more): %2 left").arg(queue.size()).arg(EtaEstimator::formatDuration(total));
+    }
+    if (total >= 0.0) {
+        text += tr(", finishes ~%1").arg(QDateTime::currentDateTime().addSecs(qint64(total)).toString("MM-dd hh:mm"));
+    }
+    etaLabel->setText(text);
+    lines.prepend(QString("%1: %2").arg(eta.currentJob().phenotype, EtaEstimator::formatDuration(current)));
+    etaLabel->setToolTip(lines.join("\n"));
+}
+
+void MainWindow::setupControlServer()
+{
+    ControlServer::Options options;
+    if (!ControlServer::configuredOptions(&options)) return;
+    controlServer = new ControlServer(options, this);
+    controlServer->setHandler("submit-train", [this](const QJsonObject &request) { return submitControlJob("train", request); });
+    controlServer->setHandler("submit-predict", [this](const QJsonObject &request) { return submitControlJob("predict", request); });
+    controlServer->setHandler("list-jobs", [this](const QJsonObject &) { return listJobsJson(); }, true);
+    controlServer->setHandler("cancel", [this](const QJsonObject &request) {
+        QJsonObject response;
+        const QString job = request.value("job").toString();
+        QJsonArray dropped;
+        for (int i = controlQueue.size() - 1; i >= 0; --i) {
+            if (request.value("clear_queue").toBool() || controlQueue.at(i).id == job) {
+                dropped.prepend(controlQueue.at(i).id);
+                controlQueue.removeAt(i);
+            }
+        }
+        // 不指定job时取消正在运行的作业；指定时只有它正在运行才取消
+        const bool cancelRunning = !jobsIdle() && (job.isEmpty() || job == trainSubmissionId || job == predictSubmissionId);
+        if (!job.isEmpty() && dropped.isEmpty() && !cancelRunning) {
+            response["error"] = QString("No such job: %1").arg(job);
+            return response;
+        }
+        if (cancelRunning) cancelRunningJobs();
+        response["cancelled"] = cancelRunning;
+        response["dropped"] = dropped;
+        return response;
+    });
+    // 暂停/继续：带ticket（list-jobs里的admission票号）时只针对该作业，否则全部
+    const auto pauseHandler = [](bool paused) {
+        return [paused](const QJsonObject &request) {
+            QJsonObject response;
+            if (request.contains("ticket")) {
+                if (!AdmissionController::instance()->setPaused(request.value("ticket").toInt(), paused)) {
+                    response["error"] = QString("No such ticket: %1").arg(request.value("ticket").toInt());
+                    return response;
+                }
+            } else {
+                AdmissionController::instance()->setAllPaused(paused);
+            }
+            response["paused"] = paused;
+            return response;
+        };
+    };
+    controlServer->setHandler("pause", pauseHandler(true));
+    controlServer->setHandler("resume", pauseHandler(false));
+    QString error;
+    if (!controlServer->start(&error)) {
+        qCWarning(lcUi) << "[MainWindow] Control server not started:" << error;
+        ui->statusbar->showMessage(tr("Control endpoint unavailable: %1").arg(error), 10000);
+    }
+}
+
+bool MainWindow::jobsIdle() const
+{
+    // 迁移学习和它的参数对话框期间按钮一直禁用，用按钮状态判断
+    return !isStep2Running && !clusterRunActive && !trainSetupActive
+        && trainBatchId.isEmpty() && predictBatchId.isEmpty()
+        && trainSubmissionId.isEmpty() && predictSubmissionId.isEmpty()
+        && !(predictProcess && predictProcess->state() != QProcess::NotRunning)
+        && ui->pushButton_transfer_learning->isEnabled();
+}
+
+QJsonObject MainWindow::submitControlJob(const QString &kind, const QJsonObject &request)
+{
+    QJsonObject response;
+    ControlSubmission submission;
+    submission.kind = kind;
+    for (const QJsonValue &value : request.value("phenotypes").toArray()) submission.phenotypes << value.toString();
+    if (request.contains("phenotype")) submission.phenotypes << request.value("phenotype").toString();
+    submission.phenotypes.removeAll(QString());
+    submission.phenotypes.removeDuplicates();
+    if (submission.phenotypes.isEmpty()) {
+        response["error"] = QString("No phenotypes given");
+        return response;
+    }
+    QStringList unknown;
+    for (const QString &phenotype : submission.phenotypes) {
+        if (!phenotypeSelector->hasPhenotype(phenotype)) unknown << phenotype;
+    }
+    if (!unknown.isEmpty()) {
+        response["error"] = QString("Unknown phenotype(s): %1").arg(unknown.join(", "));
+        return response;
+    }
+    if (kind == "train" && PathUtils::containsChineseCharacters(QDir::currentPath())) {
+        response["error"] = QString("The project directory contains Chinese characters: %1").arg(QDir::currentPath());
+        return response;
+    }
+    submission.params = request.value("params").toObject();
+    submission.preferCluster = request.value("cluster").toBool(false);
+    submission.id = QString("ctl-%1").arg(++controlSerial);
+    controlQueue << submission;
+    // 训练会在主线程里等待Worker，不能在应答前启动，放到下一轮事件循环
+    const bool startsNow = jobsIdle() && controlQueue.size() == 1;
+    QTimer::singleShot(0, this, &MainWindow::runQueuedControlSubmission);
+    qCInfo(lcUi) << "[MainWindow] Control submission" << submission.id << kind << submission.phenotypes;
+    response["job"] = submission.id;
+    response["state"] = startsNow ? "starting" : "queued";
+    response["position"] = controlQueue.size();
+    return response;
+}
+
+void MainWindow::runQueuedControlSubmission()
+{
+    if (controlQueue.isEmpty() || !jobsIdle()) return;
+    startControlSubmission(controlQueue.takeFirst());
+}
+
+void MainWindow::startControlSubmission(const ControlSubmission &submission)
+{
+    qCInfo(lcUi) << "[MainWindow] Starting control submission" << submission.id;
+    publishControlEvent("batch-started", {{"job", submission.id}, {"kind", submission.kind},
+                                          {"phenotypes", QJsonArray::fromStringList(submission.phenotypes)}});
+    if (submission.kind == "predict") {
+        predictSubmissionId = submission.id;
+        startPredictionForPhenotypes(submission.phenotypes);
+        return;
+    }
+    // 参数以配置文件里的当前值为底，params里的同名键覆盖；按表型的覆盖放在params["per_phenotype"][表型]
+    phenotypeSettings.clear();
+    const QJsonObject perPhenotype = submission.params.value("per_phenotype").toObject();
+    for (const QString &phenotype : submission.phenotypes) {
+        QJsonObject merged = settingToJson(loadPhenotypeSetting(phenotype));
+        for (auto it = submission.params.begin(); it != submission.params.end(); ++it) {
+            if (it.key() != "per_phenotype") merged[it.key()] = it.value();
+        }
+        const QJsonObject overrides = perPhenotype.value(phenotype).toObject();
+        for (auto it = overrides.begin(); it != overrides.end(); ++it) merged[it.key()] = it.value();
+        phenotypeSettings[phenotype] = settingFromJson(merged);
+    }
+    trainSubmissionId = submission.id;
+    ui->pushButton_3->setEnabled(false);
+    startTrainingForPhenotypes(false, submission.preferCluster);
+}
+
+QJsonObject MainWindow::listJobsJson() const
+{
+    static const char *const clusterStates[] = {"pending", "assigned", "running", "done", "failed", "cancelled"};
+    QJsonObject training;
+    training["active"] = isStep2Running || clusterRunActive || !trainBatchId.isEmpty();
+    training["job"] = trainSubmissionId;
+    training["batch"] = trainBatchId;
+    training["current"] = isStep2Running && !clusterRunActive ? currentTrainPhenotype : QString();
+    training["queue"] = QJsonArray::fromStringList(trainPhenoQueue);
+    training["cluster"] = clusterRunActive;
+    if (clusterRunActive && cluster) {
+        QJsonArray clusterJobs;
+        for (const ClusterDispatcher::Job &job : cluster->jobs()) {
+            clusterJobs.append(QJsonObject{{"phenotype", job.spec.phenotype}, {"state", clusterStates[int(job.state)]},
+                                           {"percent", job.percent}, {"node", job.node}});
+        }
+        training["cluster_jobs"] = clusterJobs;
+    }
+    QJsonObject prediction;
+    const bool predicting = predictProcess && predictProcess->state() != QProcess::NotRunning;
+    prediction["active"] = predicting || !predictBatchId.isEmpty();
+    prediction["job"] = predictSubmissionId;
+    prediction["batch"] = predictBatchId;
+    prediction["current"] = predicting ? currentPredictPhenotype : QString();
+    prediction["queue"] = QJsonArray::fromStringList(predictPhenoQueue);
+    QJsonArray pending;
+    for (const ControlSubmission &submission : controlQueue) {
+        pending.append(QJsonObject{{"job", submission.id}, {"kind", submission.kind},
+                                   {"phenotypes", QJsonArray::fromStringList(submission.phenotypes)}});
+    }
+    // 已准入和排队等内存的子进程作业，ticket用于pause/resume
+    QJsonArray admission;
+    const auto appendEntries = [&admission](const QList<AdmissionController::Entry> &entries, bool waiting) {
+        for (const AdmissionController::Entry &entry : entries) {
+            admission.append(QJsonObject{{"ticket", entry.ticket}, {"label", entry.label},
+                                         {"priority", AdmissionController::priorityName(entry.priority)},
+                                         {"waiting", waiting}, {"paused", entry.paused}, {"preempted", entry.preempted}});
+        }
+    };
+    appendEntries(AdmissionController::instance()->runningEntries(), false);
+    appendEntries(AdmissionController::instance()->waitingEntries(), true);
+    QJsonObject response;
+    response["idle"] = jobsIdle();
+    response["training"] = training;
+    response["prediction"] = prediction;
+    response["pending"] = pending;
+    response["admission"] = admission;
+    return response;
+}
+
+void MainWindow::publishControlEvent(const QString &event, QJsonObject payload)
+{
+    if (!controlServer) return;
+    payload["event"] = event;
+    payload["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    controlServer->publish(payload);
+}
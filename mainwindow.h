@@ -12,7 +12,18 @@
 #include <QRadioButton>
 #include <QCheckBox>
 #include <QProcess>
+#include <QPointer>
+#include <QPushButton>
+#include <QSet>
+#include <QJsonObject>
+#include <memory>
 #include "savedsettingdialog.h"
+#include "logfollower.h"
+#include "earlystopper.h"
+#include "jobjournal.h"
+#include "etaestimator.h"
+#include "predictioncache.h"
+#include "progresschannel.h"
 
 #define IS_DEVELOP_MODE 1 // 1为开发模式，0为正式模式
 
@@ -23,6 +34,15 @@ class MainWindow;
 QT_END_NAMESPACE
 
 class Worker;
+class TrainingCurveWidget;
+class ClusterDispatcher;
+class CrossValidator;
+class PhenotypeSelector;
+class QMenu;
+class QToolButton;
+class LogConsole;
+class ControlServer;
+class QLabel;
 
 class MainWindow : public QMainWindow
 {
@@ -50,12 +70,27 @@ private slots:
     void updatePredictStatus(const QString &msg);
     void updateProgressFromLog();
     void onPhenotypeSelected();
+    void cancelRunningJobs(); // Cancel按钮：终止训练/迁移学习/预测并清理中间产物
+    void openSweepDialog();   // 打开超参数搜索对话框
+    void openHistoryDialog(); // 打开运行历史面板
+    void openClusterDialog(); // 打开集群节点/任务面板
+    void openModelsDialog();  // 打开模型仓库面板
+    void openLogConsole();    // 显示子进程输出控制台
+    void openTuneDialog();    // 本机batch size/线程数校准
+    void onClusterJobFinished(int index);
+    void onClusterAllFinished();
+    void onCrossValidationFinished();
+    void onEarlyStopped(int bestEpoch, double bestValR2);
+    void onStep1Completed();
+    void checkUnfinishedJobs(); // 启动后检查作业日志里未完成的批次
+    void updateEtaDisplay();    // 刷新状态栏里的剩余时间
+    void consumeProgressFrame(); // 从进度通道取最新进度，按固定帧率调用
     void testShowImage(); // 新增：测试显示图片的函数
 
 private:
     Ui::MainWindow *ui;
     QThread *workerThread = nullptr;
-    Worker *worker = nullptr;
+    QPointer<Worker> worker;
     QDateTime step2StartTime;
     
     // 添加定时器和相关变量用于实时进度更新
@@ -63,22 +98,27 @@ private:
     QString currentLogPath;
     int currentTotalEpoch = 0;
     int lastParsedEpoch = -1;
+    LogFollower progressLogFollower; // 迁移学习日志的增量读取，喂给实时曲线
+    TrainingCurveWidget *curveWidget = nullptr; // 实时训练曲线
     
     void startProgressMonitoring(const QString &logPath, int totalEpoch);
     void stopProgressMonitoring();
+    void addLogEpochs(const QStringList &lines); // 日志新行里的epoch指标加进曲线和早停规则
     int parseEpochFromLog(const QString &logPath);
     
     // 文件上传相关方法
     void uploadFiles(const QString &targetDir, const QString &fileType);
+    void showUploadResults(const QString &fileType, const QStringList &successFiles, const QStringList &failedFiles);
     bool isValidFileFormat(const QString &fileName);
     
     // 检查路径是否包含中文
     bool containsChineseCharacters(const QString &path);
 
     // phenotype多选相关
-    QList<QCheckBox*> phenotypeCheckBoxes;
+    PhenotypeSelector *phenotypeSelector = nullptr;
     QStringList selectedPhenotypes;
-    void refreshPhenotypeOptions();
+    void refreshPhenotypeOptions();          // 重新扫描MENET/data/phen，增量更新表型列表
+    void warnIfChinesePath();                // 首帧之后检查工程路径
 
     // 防止重复运行step2
     bool isStep2Running = false;
@@ -93,28 +133,140 @@ private:
         double esnP = 0.0;
         int mmnetBatch = 0, mmnetSaved = 0;
         double mmnetP1 = 0.0, mmnetP2 = 0.0, mmnetP3 = 0.0, mmnetP4 = 0.0, mmnetWd = 0.0;
+        EarlyStopper::Config earlyStop;
+        int threads = 0; // 第二步的OMP/MKL线程数，0表示不指定
     };
     QMap<QString, PhenotypeSetting> phenotypeSettings; // 每个表型的参数
+    bool trainSetupActive = false; // 参数对话框流程进行中
     void showNextSettingDialog(); // 弹出下一个参数设置对话框
-    void startTrainingForPhenotypes(); // 所有参数设置完毕后统一训练
+    PhenotypeSetting loadPhenotypeSetting(const QString &phenotype); // 从RepGeno.json/MeNet.json读当前参数
+    // 所有参数设置完毕后统一训练；interactive=false时不弹集群询问，按preferCluster决定
+    void startTrainingForPhenotypes(bool interactive = true, bool preferCluster = false);
 
     // --- 新增：多表型训练/预测统一弹框 ---
     QStringList trainPhenoQueue; // 训练表型队列
     QList<QString> trainResultMsgs; // 训练结果信息
+    QString currentTrainPhenotype; // 当前正在训练的表型
     void trainNextPhenotype(); // 训练下一个表型
     void showTrainSummary(); // 训练全部完成后弹框
 
     QStringList predictPhenoQueue; // 预测表型队列
     QList<QString> predictResultMsgs; // 预测结果信息
+    void startPredictionForPhenotypes(const QStringList &phenotypes);
     void predictNextPhenotype(); // 预测下一个表型
     void showPredictSummary(); // 预测全部完成后弹框
 
     // --- 新增：异步预测相关 ---
     QProcess *predictProcess = nullptr;
     QString currentPredictPhenotype;
+    QDateTime predictStartTime;
+    PredictionCache predictionCache;           // 模型和输入都没变时复用上次的预测结果
+    PredictionCache::Key currentPredictKey;
 
     bool isDevelopMode;
 
     void startTransferLearningForPhenotypes(); // Transfer Learning helper
+
+    // --- 早停与取消 ---
+    QPushButton *cancelButton = nullptr;
+    QPushButton *sweepButton = nullptr;
+    QPushButton *historyButton = nullptr;
+    QPushButton *modelsButton = nullptr;
+    QPushButton *consoleButton = nullptr;
+    QPushButton *tuneButton = nullptr;
+    LogConsole *logConsole = nullptr;
+    // 子进程输出接到有界捕获和控制台上，spillName为溢出文件名（不含扩展名）
+    void captureProcessOutput(QProcess *process, const QString &title, const QString &spillName);
+    double trainPeakMemMB = 0.0;   // 当前表型训练子进程的峰值内存，由Worker上报
+    double predictPeakMemMB = 0.0; // 当前预测子进程的峰值内存
+    bool cancelRequested = false;       // 用户点了Cancel，当前队列不再继续
+    EarlyStopper transferStopper;       // 迁移学习的早停（主线程中根据step3.log判断）
+    QString earlyStopNote;              // 当前表型的早停说明，写进训练汇总
+    QSet<QString> savedFilesBeforeRun;  // 运行前MENET/saved下已有的文件，取消时只删新产生的
+    EarlyStopper::Config loadEarlyStopConfig(const QString &phenotype);
+    void saveEarlyStopConfigs();
+    void snapshotSavedFiles();
+    void removePartialArtifacts();
+    // 训练产出的saved/menet.pt登记进模型仓库并设为该表型的当前模型
+    void promoteTrainedModel(const QString &phenotype, const QJsonObject &params, const QJsonObject &metrics);
+    // 迁移学习结束后登记新模型（父模型为parentHash）；失败或取消时恢复父模型
+    void finishTransferModel(const QString &phenotype, const QString &parentHash, const QDateTime &runStart,
+                             bool success, const QJsonObject &params, const QJsonObject &metrics);
+    void setCancelAvailable(bool available);
+
+    // --- 内存准入：子进程启动前按估计峰值内存申请，放不下时排队 ---
+    QLabel *admissionLabel = nullptr;  // 状态栏里显示排队等内存、暂停和让路的作业
+    QToolButton *jobsButton = nullptr; // 状态栏里的作业菜单，手动暂停/继续
+    int trainWaitingTicket = 0;        // 训练在排队等内存
+    int trainAdmissionTicket = 0;      // 当前表型训练已准入
+    int predictWaitingTicket = 0;
+    int predictAdmissionTicket = 0;
+    // 按运行历史里的峰值内存和数据量估计，kind为"train"/"transfer"/"predict"
+    double estimatePeakMB(const QString &kind, const QString &phenotype) const;
+    double phenotypeDataMB(const QString &phenotype) const; // 基因数据加该表型文件的大小
+    void updateAdmissionDisplay();
+    void populateJobsMenu(QMenu *menu);
+    QLabel *pressureLabel = nullptr;   // 开启[Resources]时状态栏里显示作业的PSI压力
+    void updatePressureDisplay();
+    void continuePrediction(const QString &exePath, const PredictionCache::Key &key); // 缓存键算完后查缓存、申请内存
+    void launchPredictProcess(const QString &exePath); // 准入后启动pred.exe
+
+    // --- 作业日志：崩溃或重启后续跑 ---
+    JobJournal journal;                      // MENET/jobs/journal.jsonl
+    QString trainBatchId;                    // 当前训练批次，空表示没有记录
+    QString predictBatchId;                  // 当前预测批次
+    QSet<QString> resumeSkipStep1;           // 续跑时第一步已完成的表型
+    QMap<QString, QDateTime> resumeStep2Start; // 续跑时上次第二步开始的时间，用来判断checkpoint是否属于它
+    bool currentRunUsesCheckpoint = false;   // 当前表型是否从checkpoint续训启动
+    void writePhenotypeConfigs();            // 把phenotypeSettings写进RepGeno.json/MeNet.json
+    static QJsonObject settingToJson(const PhenotypeSetting &setting);
+    static PhenotypeSetting settingFromJson(const QJsonObject &obj);
+    void resumeTrainingBatch(const JobJournal::Batch &batch);
+    void resumePredictBatch(const JobJournal::Batch &batch);
+
+    // --- 训练队列剩余时间估计 ---
+    EtaEstimator eta;
+    QLabel *etaLabel = nullptr;   // 状态栏常驻标签
+    QTimer *etaTimer = nullptr;   // 训练期间每秒刷新
+    QTimer *progressFrameTimer = nullptr;
+    std::shared_ptr<ProgressChannel> progressChannel = std::make_shared<ProgressChannel>();
+    double geneDataMB = 0.0;      // 基因数据目录大小，批次开始时统计一次
+    void beginEtaForBatch();
+    EtaEstimator::Job etaJobFor(const QString &phenotype, bool skipStep1) const;
+
+    // --- 分布式训练：config.ini [Cluster] 配置了节点时可把批次分发给各节点agent ---
+    ClusterDispatcher *cluster = nullptr;
+    QPushButton *clusterButton = nullptr;
+    bool clusterRunActive = false;           // 当前训练批次在集群上运行
+    QMap<QString, QString> clusterResults;   // 表型 -> 汇总文本，批次结束时按表型顺序填进trainResultMsgs
+    QString clusterCurvePhenotype;           // 实时曲线跟随的表型
+    void startClusterTraining();
+
+    // --- 交叉验证：整份数据训练完后，在隔离目录里并发跑k折，R²的均值和标准差写进训练汇总 ---
+    CrossValidator *crossValidator = nullptr;
+    QCheckBox *cvCheckBox = nullptr;          // 勾选后本批次每个表型训练成功后都做交叉验证
+    bool startCrossValidation(const QString &phenotype); // 无法开始时把原因写进汇总并返回false
+    void updateCrossValidationProgress();
+
+    // --- 本机控制接口：外部脚本提交训练/预测、查询队列、订阅进度 ---
+    ControlServer *controlServer = nullptr;
+    struct ControlSubmission {
+        QString id;
+        QString kind;              // "train" 或 "predict"
+        QStringList phenotypes;
+        QJsonObject params;        // 训练参数覆盖，键同settingToJson
+        bool preferCluster = false;
+    };
+    QList<ControlSubmission> controlQueue;  // 有作业在跑时排队，空闲后按提交顺序启动
+    int controlSerial = 0;
+    QString trainSubmissionId;              // 当前训练批次来自哪个远程提交，空表示界面发起
+    QString predictSubmissionId;
+    void setupControlServer();
+    bool jobsIdle() const;                  // 训练、预测、迁移学习和参数对话框都不在进行
+    QJsonObject submitControlJob(const QString &kind, const QJsonObject &request);
+    void startControlSubmission(const ControlSubmission &submission);
+    void runQueuedControlSubmission();
+    QJsonObject listJobsJson() const;
+    void publishControlEvent(const QString &event, QJsonObject payload = QJsonObject());
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,37 @@
+#include "metricparser.h"
+#include "logtail.h"
+#include <QRegularExpression>
+
+bool parseEpochMetrics(const QString &line, EpochMetrics &out)
+{
+    static const QRegularExpression reEpoch("epoch\\s*=\\s*(\\d+)");
+    static const QRegularExpression reMetric("([A-Za-z_][A-Za-z0-9_]*)\\s*=\\s*([-+]?(?:\\d+\\.?\\d*|\\.\\d+)(?:[eE][-+]?\\d+)?)");
+    auto epochMatch = reEpoch.match(line);
+    if (!epochMatch.hasMatch()) return false;
+    out.epoch = epochMatch.captured(1).toInt();
+    out.values.clear();
+    auto it = reMetric.globalMatch(line);
+    while (it.hasNext()) {
+        auto m = it.next();
+        const QString name = m.captured(1);
+        if (name == "epoch") continue;
+        bool ok = false;
+        double value = m.captured(2).toDouble(&ok);
+        if (ok) out.values.insert(name, value);
+    }
+    return true;
+}
+
+int lastEpochInLog(const QString &logPath)
+{
+    static const QRegularExpression reEpoch("epoch = (\\d+)");
+    const QString line = LogTail::lastMatchingLine(logPath, reEpoch);
+    if (line.isEmpty()) return -1;
+    return reEpoch.match(line).captured(1).toInt();
+}
+
+bool lastEpochMetrics(const QString &logPath, EpochMetrics &out)
+{
+    static const QRegularExpression reEpoch("epoch = \\d+");
+    return parseEpochMetrics(LogTail::lastMatchingLine(logPath, reEpoch), out);
+}
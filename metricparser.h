@@ -0,0 +1,24 @@
+#ifndef METRICPARSER_H
+#define METRICPARSER_H
+
+#include <QMap>
+#include <QMetaType>
+#include <QString>
+
+// 一个epoch的日志行解析结果，例如
+// "epoch = 12, loss = 0.53, train_R2 = 0.61, val_R2 = 0.48"
+struct EpochMetrics {
+    int epoch = -1;
+    QMap<QString, double> values; // 指标名 -> 数值（不含epoch本身）
+};
+Q_DECLARE_METATYPE(EpochMetrics)
+
+// 解析一行日志，含 "epoch = N" 时返回true并填充所有 name = number 指标
+bool parseEpochMetrics(const QString &line, EpochMetrics &out);
+
+// 日志里最后一个epoch编号，没有或打不开返回-1。从文件末尾往前找，开销与日志大小无关
+int lastEpochInLog(const QString &logPath);
+// 日志里最后一个epoch行的全部指标（训练结束后的最终R²等）
+bool lastEpochMetrics(const QString &logPath, EpochMetrics &out);
+
+#endif // METRICPARSER_H
@@ -0,0 +1,321 @@
+#include "modelregistry.h"
+#include "filefingerprint.h"
+#include "logcategories.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <algorithm>
+#include <memory>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(Q_OS_LINUX)
+#include <linux/fs.h>
+#endif
+#endif
+
+ModelRegistry *ModelRegistry::instance()
+{
+    static ModelRegistry *registry = new ModelRegistry();
+    return registry;
+}
+
+ModelRegistry::ModelRegistry()
+    : menetDir(QDir::currentPath() + "/MENET")
+    , root(QDir::currentPath() + "/MENET/registry")
+{
+    QDir().mkpath(root + "/objects");
+    FileFingerprint::instance()->setMemoPath(menetDir + "/cache/fingerprints.json");
+    load();
+    // 第一次哈希要读完整个.pt，模型多时在界面线程上会卡住启动
+    auto promise = std::make_shared<std::promise<QStringList>>();
+    adoption = promise->get_future();
+    const QString savedDir = menetDir + "/saved";
+    const QJsonObject current = currentObj;
+    QThreadPool::globalInstance()->start([promise, savedDir, current]() {
+        promise->set_value(scanUnregistered(savedDir, current));
+        QMetaObject::invokeMethod(qApp, []() { ModelRegistry::instance()->finishAdoption(); }, Qt::QueuedConnection);
+    });
+}
+
+void ModelRegistry::load()
+{
+    QFile file(root + "/index.json");
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    modelsObj = index.value("models").toObject();
+    currentObj = index.value("current").toObject();
+}
+
+bool ModelRegistry::save()
+{
+    QJsonObject index;
+    index["version"] = 1;
+    index["models"] = modelsObj;
+    index["current"] = currentObj;
+    QSaveFile file(root + "/index.json");
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
+
+QString ModelRegistry::workingPath(const QString &phenotype) const
+{
+    return menetDir + QString("/saved/%1_menet.pt").arg(phenotype);
+}
+
+QString ModelRegistry::objectPath(const QString &hash) const
+{
+    return root + "/objects/" + hash + ".pt";
+}
+
+QStringList ModelRegistry::scanUnregistered(const QString &savedDir, const QJsonObject &current)
+{
+    // 仓库启用前已有的模型、或手工放进saved的模型，登记为import。
+    // 在线程池里运行，只算哈希（结果记在FileFingerprint里），不碰仓库本身
+    QStringList paths;
+    for (const QFileInfo &info : QDir(savedDir).entryInfoList({"*_menet.pt"}, QDir::Files)) {
+        const QString phenotype = info.fileName().chopped(QString("_menet.pt").size());
+        if (phenotype.isEmpty()) continue;
+        const QString hash = FileFingerprint::instance()->ofFile(info.absoluteFilePath());
+        if (hash.isEmpty() || hash == current.value(phenotype).toString()) continue;
+        paths << info.absoluteFilePath();
+    }
+    return paths;
+}
+
+void ModelRegistry::finishAdoption()
+{
+    if (!adoption.valid()) return;
+    // get()之后future不再valid，下面的add/setCurrent再进来时直接返回
+    const QStringList paths = adoption.get();
+    for (const QString &path : paths) {
+        const QString fileName = QFileInfo(path).fileName();
+        const QString phenotype = fileName.chopped(QString("_menet.pt").size());
+        // 哈希已经记住，文件没变时这里只有一次stat；等待期间可能已被登记或替换
+        const QString hash = FileFingerprint::instance()->ofFile(path);
+        if (hash.isEmpty() || hash == currentHash(phenotype)) continue;
+        Model meta;
+        meta.phenotype = phenotype;
+        meta.source = "import";
+        meta.originalName = fileName;
+        const QString added = add(path, meta, true);
+        if (!added.isEmpty()) setCurrent(phenotype, added);
+    }
+    if (!paths.isEmpty()) qCInfo(lcData) << "[ModelRegistry] Adopted" << paths.size() << "unregistered model(s)";
+}
+
+int ModelRegistry::linkCount(const QString &path)
+{
+#if defined(Q_OS_WIN)
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(path).utf16()), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return 0;
+    BY_HANDLE_FILE_INFORMATION info;
+    int count = 0;
+    if (GetFileInformationByHandle(handle, &info)) count = int(info.nNumberOfLinks);
+    CloseHandle(handle);
+    return count;
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) return 0;
+    return int(st.st_nlink);
+#endif
+}
+
+bool ModelRegistry::cloneFile(const QString &from, const QString &to, bool allowHardLink)
+{
+    QFile::remove(to);
+#if defined(FICLONE)
+    // btrfs/xfs等支持reflink的文件系统上共享数据块，写入时才复制
+    const int src = ::open(QFile::encodeName(from).constData(), O_RDONLY);
+    if (src >= 0) {
+        const int dst = ::open(QFile::encodeName(to).constData(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool cloned = false;
+        if (dst >= 0) {
+            cloned = ::ioctl(dst, FICLONE, src) == 0;
+            ::close(dst);
+        }
+        ::close(src);
+        if (cloned) return true;
+        QFile::remove(to);
+    }
+#endif
+    if (allowHardLink) {
+#if defined(Q_OS_WIN)
+        if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                            reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()), nullptr)) return true;
+#else
+        if (::link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0) return true;
+#endif
+    }
+    return QFile::copy(from, to);
+}
+
+QString ModelRegistry::add(const QString &path, const Model &meta, bool moveSource, QString *error)
+{
+    finishAdoption();
+    const QString hash = FileFingerprint::instance()->ofFile(path);
+    if (hash.isEmpty()) {
+        if (error) *error = QString("Unable to read %1").arg(path);
+        return QString();
+    }
+    const QString object = objectPath(hash);
+    if (QFile::exists(object)) {
+        // 内容已在仓库里，只去重
+        qCDebug(lcData) << "[ModelRegistry] Deduplicated" << path << "->" << hash;
+        if (moveSource) QFile::remove(path);
+    } else {
+        const QString temp = object + ".tmp";
+        QFile::remove(temp);
+        bool stored = false;
+        if (moveSource) stored = QFile::rename(path, temp);
+        // 跨文件系统改名会失败，退回复制；外部导入的文件不做硬链接，避免用户改动原文件时连带仓库
+        if (!stored) stored = cloneFile(path, temp, false);
+        if (!stored || !QFile::rename(temp, object)) {
+            QFile::remove(temp);
+            if (error) *error = QString("Unable to store %1 in the model registry").arg(path);
+            return QString();
+        }
+        if (moveSource) QFile::remove(path);
+        FileFingerprint::instance()->remember(object, hash);
+        qCDebug(lcData) << "[ModelRegistry] Stored" << hash << "for" << meta.phenotype << "(" << meta.source << ")";
+    }
+    if (!modelsObj.contains(hash)) {
+        QJsonObject obj;
+        obj["phenotype"] = meta.phenotype;
+        obj["source"] = meta.source;
+        obj["parent"] = meta.parent;
+        obj["params"] = meta.params;
+        obj["metrics"] = meta.metrics;
+        obj["created"] = (meta.created.isValid() ? meta.created : QDateTime::currentDateTime()).toString(Qt::ISODate);
+        obj["size"] = double(QFileInfo(object).size());
+        obj["original_name"] = meta.originalName;
+        modelsObj[hash] = obj;
+        save();
+    }
+    return hash;
+}
+
+bool ModelRegistry::materialize(const QString &hash, const QString &target, QString *error)
+{
+    QDir().mkpath(QFileInfo(target).absolutePath());
+    const QString temp = target + ".tmp";
+    if (!cloneFile(objectPath(hash), temp, true)) {
+        QFile::remove(temp);
+        if (error) *error = QString("Unable to link %1").arg(target);
+        return false;
+    }
+    QFile::remove(target);
+    if (!QFile::rename(temp, target)) {
+        QFile::remove(temp);
+        if (error) *error = QString("Unable to replace %1").arg(target);
+        return false;
+    }
+    FileFingerprint::instance()->remember(target, hash);
+    FileFingerprint::instance()->save();
+    return true;
+}
+
+bool ModelRegistry::setCurrent(const QString &phenotype, const QString &hash, QString *error)
+{
+    finishAdoption();
+    if (!modelsObj.contains(hash) || !QFile::exists(objectPath(hash))) {
+        if (error) *error = QString("Model %1 is not in the registry").arg(hash);
+        return false;
+    }
+    if (!materialize(hash, workingPath(phenotype), error)) return false;
+    currentObj[phenotype] = hash;
+    qCInfo(lcData) << "[ModelRegistry] Current model of" << phenotype << "is now" << hash;
+    return save();
+}
+
+QString ModelRegistry::currentHash(const QString &phenotype) const
+{
+    return currentObj.value(phenotype).toString();
+}
+
+QString ModelRegistry::resolve(const QString &phenotype)
+{
+    finishAdoption();
+    const QString path = workingPath(phenotype);
+    const QString current = currentHash(phenotype);
+    if (current.isEmpty()) return QFile::exists(path) ? path : QString();
+    // 指纹按inode/mtime/size记忆，未变化时这里只有一次stat
+    const QString actual = FileFingerprint::instance()->ofFile(path);
+    if (actual == current) return path;
+    if (!actual.isEmpty() && !modelsObj.contains(actual)) {
+        // 运行期间手工替换的文件，登记后作为当前模型
+        Model meta;
+        meta.phenotype = phenotype;
+        meta.source = "import";
+        meta.originalName = QFileInfo(path).fileName();
+        const QString added = add(path, meta, true);
+        if (!added.isEmpty() && setCurrent(phenotype, added)) return path;
+        return QString();
+    }
+    return materialize(current, path, nullptr) ? path : QString();
+}
+
+bool ModelRegistry::detach(const QString &path, QString *error)
+{
+    if (linkCount(path) <= 1) return true;
+    const QString temp = path + ".tmp";
+    QFile::remove(temp);
+    if (!QFile::copy(path, temp)) {
+        if (error) *error = QString("Unable to copy %1").arg(path);
+        return false;
+    }
+    QFile::remove(path);
+    if (!QFile::rename(temp, path)) {
+        if (error) *error = QString("Unable to replace %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+ModelRegistry::Model ModelRegistry::model(const QString &hash) const
+{
+    Model m;
+    const QJsonObject obj = modelsObj.value(hash).toObject();
+    if (obj.isEmpty()) return m;
+    m.hash = hash;
+    m.phenotype = obj.value("phenotype").toString();
+    m.source = obj.value("source").toString();
+    m.parent = obj.value("parent").toString();
+    m.params = obj.value("params").toObject();
+    m.metrics = obj.value("metrics").toObject();
+    m.created = QDateTime::fromString(obj.value("created").toString(), Qt::ISODate);
+    m.size = qint64(obj.value("size").toDouble());
+    m.originalName = obj.value("original_name").toString();
+    return m;
+}
+
+QList<ModelRegistry::Model> ModelRegistry::models(const QString &phenotype) const
+{
+    QList<Model> result;
+    for (auto it = modelsObj.constBegin(); it != modelsObj.constEnd(); ++it) {
+        if (it.value().toObject().value("phenotype").toString() == phenotype) result << model(it.key());
+    }
+    std::sort(result.begin(), result.end(), [](const Model &a, const Model &b) { return a.created > b.created; });
+    return result;
+}
+
+QStringList ModelRegistry::phenotypes() const
+{
+    QStringList result;
+    for (auto it = modelsObj.constBegin(); it != modelsObj.constEnd(); ++it) {
+        const QString phenotype = it.value().toObject().value("phenotype").toString();
+        if (!phenotype.isEmpty() && !result.contains(phenotype)) result << phenotype;
+    }
+    result.sort();
+    return result;
+}
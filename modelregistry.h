@@ -0,0 +1,68 @@
+#ifndef MODELREGISTRY_H
+#define MODELREGISTRY_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <future>
+
+// 模型仓库：.pt按内容哈希存放在 MENET/registry/objects/<hash>.pt，相同内容只存一份；
+// index.json记录每个模型的表型、参数、训练指标、迁移学习的父模型，以及每个表型的"当前"模型。
+// saved/<pheno>_menet.pt 只是当前模型的reflink/硬链接，回滚只改指针并重建链接
+class ModelRegistry
+{
+public:
+    struct Model {
+        QString hash;
+        QString phenotype;
+        QString source;           // "train" / "transfer" / "import" / "cluster"
+        QString parent;           // 迁移学习的起点模型
+        QJsonObject params;
+        QJsonObject metrics;      // train_R2 / val_R2 / epochs
+        QDateTime created;
+        qint64 size = 0;
+        QString originalName;
+    };
+
+    static ModelRegistry *instance();
+
+    // 启动时在线程池里给saved下未登记的模型算哈希，算完回到界面线程登记。
+    // add/setCurrent/resolve会先等它结束，只读的查询不等，登记前看不到这些模型
+
+    // 登记模型文件，返回内容哈希。moveSource为true时源文件移入仓库（同一文件系统内只是改名），
+    // 否则复制一份（可能时用reflink）。内容已存在时只去重，不重复存储
+    QString add(const QString &path, const Model &meta, bool moveSource, QString *error = nullptr);
+    // 切换表型的当前模型并重建 saved/<pheno>_menet.pt
+    bool setCurrent(const QString &phenotype, const QString &hash, QString *error = nullptr);
+    QString currentHash(const QString &phenotype) const;
+    // 预测和迁移学习使用前调用：保证 saved/<pheno>_menet.pt 是当前模型，返回其路径
+    QString resolve(const QString &phenotype);
+    // 硬链接的工作文件在被原地写入前拆成独立副本，避免改坏仓库里的对象
+    bool detach(const QString &path, QString *error = nullptr);
+
+    Model model(const QString &hash) const;
+    QList<Model> models(const QString &phenotype) const; // 新的在前
+    QStringList phenotypes() const;
+    QString workingPath(const QString &phenotype) const;
+    QString objectPath(const QString &hash) const;
+
+private:
+    ModelRegistry();
+    void load();
+    bool save();
+    static QStringList scanUnregistered(const QString &savedDir, const QJsonObject &current);
+    void finishAdoption();
+    bool materialize(const QString &hash, const QString &target, QString *error);
+    static bool cloneFile(const QString &from, const QString &to, bool allowHardLink);
+    static int linkCount(const QString &path);
+
+    QString menetDir;
+    QString root;
+    QJsonObject modelsObj;   // hash -> 元数据
+    QJsonObject currentObj;  // 表型 -> hash
+    std::future<QStringList> adoption; // 待登记的saved/*_menet.pt
+};
+
+#endif // MODELREGISTRY_H
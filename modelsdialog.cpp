@@ -0,0 +1,101 @@
+#include "modelsdialog.h"
+#include "modelregistry.h"
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+ModelsDialog::ModelsDialog(QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Models"));
+    resize(950, 500);
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    comboPhenotype = new QComboBox(this);
+    for (const QString &phenotype : ModelRegistry::instance()->phenotypes()) comboPhenotype->addItem(phenotype);
+    QHBoxLayout *filterRow = new QHBoxLayout();
+    filterRow->addWidget(new QLabel(tr("Phenotype:"), this));
+    filterRow->addWidget(comboPhenotype);
+    filterRow->addStretch();
+    mainLayout->addLayout(filterRow);
+
+    table = new QTableWidget(this);
+    table->setColumnCount(8);
+    table->setHorizontalHeaderLabels({tr("Current"), tr("Created"), tr("Source"), tr("train_R2"), tr("val_R2"),
+                                      tr("Parent"), tr("Size"), tr("Hash")});
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(table, 1);
+
+    labelInfo = new QLabel(this);
+    labelInfo->setWordWrap(true);
+    mainLayout->addWidget(labelInfo);
+
+    QPushButton *btnSetCurrent = new QPushButton(tr("Set as current"), this);
+    QPushButton *btnClose = new QPushButton(tr("Close"), this);
+    QHBoxLayout *btnRow = new QHBoxLayout();
+    btnRow->addStretch();
+    btnRow->addWidget(btnSetCurrent);
+    btnRow->addWidget(btnClose);
+    mainLayout->addLayout(btnRow);
+    setLayout(mainLayout);
+
+    connect(comboPhenotype, &QComboBox::currentIndexChanged, this, &ModelsDialog::refresh);
+    connect(btnSetCurrent, &QPushButton::clicked, this, &ModelsDialog::setSelectedAsCurrent);
+    connect(table, &QTableWidget::cellDoubleClicked, this, &ModelsDialog::setSelectedAsCurrent);
+    connect(btnClose, &QPushButton::clicked, this, &QDialog::accept);
+    refresh();
+}
+
+void ModelsDialog::refresh()
+{
+    ModelRegistry *registry = ModelRegistry::instance();
+    const QString phenotype = comboPhenotype->currentText();
+    const QString current = registry->currentHash(phenotype);
+    const QList<ModelRegistry::Model> models = registry->models(phenotype);
+    table->setRowCount(models.size());
+    auto metric = [](const QJsonObject &metrics, const QString &key) {
+        return metrics.contains(key) ? QString::number(metrics.value(key).toDouble(), 'f', 4) : QString();
+    };
+    for (int row = 0; row < models.size(); ++row) {
+        const ModelRegistry::Model &m = models[row];
+        const QStringList cells = {
+            m.hash == current ? QStringLiteral("✔") : QString(),
+            m.created.toString("yyyy-MM-dd HH:mm:ss"),
+            m.source,
+            metric(m.metrics, "train_R2"),
+            metric(m.metrics, "val_R2"),
+            m.parent.left(10),
+            QString("%1 MB").arg(m.size / (1024.0 * 1024.0), 0, 'f', 1),
+            m.hash
+        };
+        for (int col = 0; col < cells.size(); ++col) {
+            QTableWidgetItem *item = new QTableWidgetItem(cells[col]);
+            item->setData(Qt::UserRole, m.hash);
+            table->setItem(row, col, item);
+        }
+    }
+    labelInfo->setText(current.isEmpty() ? tr("No current model for this phenotype.")
+                                         : tr("Current model: %1").arg(current));
+}
+
+void ModelsDialog::setSelectedAsCurrent()
+{
+    const int row = table->currentRow();
+    if (row < 0 || !table->item(row, 0)) return;
+    const QString hash = table->item(row, 0)->data(Qt::UserRole).toString();
+    QString error;
+    if (!ModelRegistry::instance()->setCurrent(comboPhenotype->currentText(), hash, &error)) {
+        QMessageBox::warning(this, tr("Error"), error);
+        return;
+    }
+    refresh();
+}
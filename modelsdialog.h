@@ -0,0 +1,28 @@
+#ifndef MODELSDIALOG_H
+#define MODELSDIALOG_H
+
+#include <QDialog>
+
+class QComboBox;
+class QLabel;
+class QTableWidget;
+
+// 模型仓库面板：查看每个表型的历史模型，把任一版本设为当前模型（回滚只改指针）
+class ModelsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ModelsDialog(QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+    void setSelectedAsCurrent();
+
+private:
+    QComboBox *comboPhenotype;
+    QTableWidget *table;
+    QLabel *labelInfo;
+};
+
+#endif // MODELSDIALOG_H
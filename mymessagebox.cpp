@@ -1,4 +1,5 @@
 #include "mymessagebox.h"
+#include "imageloader.h"
 #include <QPixmap>
 #include <QFileInfo>
 #include <QGridLayout>
@@ -150,49 +151,43 @@ void MyMessageBox::setImage(const QString &imagePath)
         return;
     }
 
-    QPixmap originalPixmap(imagePath);
-    if (originalPixmap.isNull()) {
-        qDebug() << "[MyMessageBox] Error: failed to load image";
-        imageLabel->setText(tr("Failed to load image: %1").arg(imagePath));
-        imageLabel->show();
-        return;
-    }
-
-    qDebug() << "[MyMessageBox] Original image size:" << originalPixmap.size();
-    
-    QScreen *screen = QGuiApplication::primaryScreen();
-    QRect screenGeometry = screen->availableGeometry();
-    
     // 设置固定的目标大小（基于主窗口大小 800x600）
     int targetWidth = 850;  // 主窗口宽度 + 50
     int targetHeight = 650; // 主窗口高度 + 50
-    
-    QPixmap pixmap = originalPixmap;
-    // 如果原图比目标尺寸大，就缩放到目标尺寸
-    if (originalPixmap.width() > targetWidth || originalPixmap.height() > targetHeight) {
-        pixmap = originalPixmap.scaled(targetWidth - 100, targetHeight - 200, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        qDebug() << "[MyMessageBox] Scaled image size:" << pixmap.size();
-    } else {
-        // 如果原图比较小，保持原始大小
-        pixmap = originalPixmap;
-    }
 
-    imageLabel->setPixmap(pixmap);
-    imageLabel->setMinimumSize(pixmap.size());
+    // 先显示占位，解码和缩放放到后台线程，避免打开对话框时卡顿
+    imageLabel->setPixmap(QPixmap());
+    imageLabel->setText(tr("Loading image..."));
     imageLabel->show();
-    qDebug() << "[MyMessageBox] Image set successfully";
-    
-    // 调整对话框大小以适应图片
-    int dialogWidth = qMax(targetWidth, pixmap.width() + 100);  // 确保至少有目标宽度
-    int dialogHeight = qMax(targetHeight, pixmap.height() + 200); // 确保至少有目标高度
-    
-    // 设置对话框的最小尺寸
-    setMinimumSize(dialogWidth, dialogHeight);
-    
-    // 设置初始尺寸
-    resize(dialogWidth, dialogHeight);
-    
-    qDebug() << "[MyMessageBox] Initial dialog size:" << size();
+    // 提前按目标尺寸布局，图片到达后不会再明显跳动
+    setMinimumSize(targetWidth, targetHeight);
+    resize(targetWidth, targetHeight);
+    QSize boundingSize(targetWidth - 100, targetHeight - 200);
+    ImageLoader::instance()->request(imagePath, boundingSize, devicePixelRatioF(), this,
+                                     [this, imagePath, targetWidth, targetHeight](const QPixmap &pixmap) {
+        if (pixmap.isNull()) {
+            qDebug() << "[MyMessageBox] Error: failed to load image";
+            imageLabel->setText(tr("Failed to load image: %1").arg(imagePath));
+            return;
+        }
+        QSize logicalSize = pixmap.deviceIndependentSize().toSize();
+        qDebug() << "[MyMessageBox] Scaled image size:" << logicalSize;
+        imageLabel->setPixmap(pixmap);
+        imageLabel->setMinimumSize(logicalSize);
+        qDebug() << "[MyMessageBox] Image set successfully";
+
+        // 调整对话框大小以适应图片
+        int dialogWidth = qMax(targetWidth, logicalSize.width() + 100);  // 确保至少有目标宽度
+        int dialogHeight = qMax(targetHeight, logicalSize.height() + 200); // 确保至少有目标高度
+
+        // 设置对话框的最小尺寸
+        setMinimumSize(dialogWidth, dialogHeight);
+
+        // 设置初始尺寸
+        resize(dialogWidth, dialogHeight);
+
+        qDebug() << "[MyMessageBox] Initial dialog size:" << size();
+    });
 }
 
 void MyMessageBox::resizeEvent(QResizeEvent *event)
@@ -0,0 +1,325 @@
+#include "nodeagent.h"
+#include "jsonlinechannel.h"
+#include "trialworkspace.h"
+#include "worker.h"
+#include "logcategories.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+NodeAgent::NodeAgent(const Options &options, QObject *parent) : QObject(parent), opts(options)
+{
+    opts.maxJobs = qMax(1, opts.maxJobs);
+    connect(&logTimer, &QTimer::timeout, this, &NodeAgent::pollLogs);
+    logTimer.setInterval(1000);
+}
+
+NodeAgent::~NodeAgent()
+{
+    for (Job *job : jobs) {
+        if (job->worker) job->worker->requestCancel();
+        if (job->thread) {
+            job->thread->quit();
+            job->thread->wait();
+        }
+        TrialWorkspace::remove(job->dir);
+        delete job;
+    }
+    jobs.clear();
+}
+
+bool NodeAgent::start(QString *error)
+{
+    if (!QFile::exists(opts.menetDir + "/train_menet.exe")) {
+        if (error) *error = QString("train_menet.exe not found in %1").arg(opts.menetDir);
+        return false;
+    }
+    if (opts.port > 0 && opts.token.isEmpty() && !QHostAddress(opts.bindAddress).isLoopback()) {
+        // 能连上端口的主机都能提交任务、往MENET里写文件，不带token只允许本机
+        if (error) *error = QString("Listening on %1 requires a token (--token or [Cluster] Token)").arg(opts.bindAddress);
+        return false;
+    }
+    if (opts.port > 0) {
+        tcpServer = new QTcpServer(this);
+        connect(tcpServer, &QTcpServer::newConnection, this, &NodeAgent::onNewTcpConnection);
+        if (!tcpServer->listen(QHostAddress(opts.bindAddress), opts.port)) {
+            if (error) *error = QString("Unable to listen on %1:%2: %3").arg(opts.bindAddress).arg(opts.port).arg(tcpServer->errorString());
+            return false;
+        }
+        qCInfo(lcCluster) << "[NodeAgent] Listening on" << opts.bindAddress << opts.port;
+    }
+    if (!opts.socketPath.isEmpty()) {
+        QLocalServer::removeServer(opts.socketPath);
+        localServer = new QLocalServer(this);
+        connect(localServer, &QLocalServer::newConnection, this, &NodeAgent::onNewLocalConnection);
+        if (!localServer->listen(opts.socketPath)) {
+            if (error) *error = QString("Unable to listen on %1: %2").arg(opts.socketPath, localServer->errorString());
+            return false;
+        }
+        qCInfo(lcCluster) << "[NodeAgent] Listening on" << localServer->fullServerName();
+    }
+    if (!tcpServer && !localServer) {
+        if (error) *error = "Neither a TCP port nor a socket path was given";
+        return false;
+    }
+    logTimer.start();
+    return true;
+}
+
+void NodeAgent::onNewTcpConnection()
+{
+    while (QTcpSocket *socket = tcpServer->nextPendingConnection()) addChannel(socket);
+}
+
+void NodeAgent::onNewLocalConnection()
+{
+    while (QLocalSocket *socket = localServer->nextPendingConnection()) addChannel(socket);
+}
+
+void NodeAgent::addChannel(QIODevice *device)
+{
+    JsonLineChannel *channel = new JsonLineChannel(device, this);
+    channels << channel;
+    qCInfo(lcCluster) << "[NodeAgent] Dispatcher connected:" << channel->peerName();
+    connect(channel, &JsonLineChannel::messageReceived, this, [this, channel](const QJsonObject &message) {
+        handleMessage(channel, message);
+    });
+    connect(channel, &JsonLineChannel::disconnected, this, [this, channel]() {
+        if (!channels.removeOne(channel)) return;
+        authenticated.remove(channel);
+        qCInfo(lcCluster) << "[NodeAgent] Dispatcher disconnected:" << channel->peerName();
+        // 调度端断开后会把任务重新分配，本地的就不必再跑了
+        for (Job *job : jobs) {
+            if (job->owner != channel) continue;
+            job->owner = nullptr;
+            if (job->worker) job->worker->requestCancel();
+        }
+        channel->deleteLater();
+    });
+}
+
+QJsonObject NodeAgent::statusMessage(const QString &type) const
+{
+    QJsonObject message;
+    message["type"] = type;
+    message["version"] = JsonLineChannel::kProtocolVersion;
+    message["host"] = QSysInfo::machineHostName();
+    message["slots"] = opts.maxJobs;
+    message["running"] = int(jobs.size());
+    message["cores"] = QThread::idealThreadCount();
+#if defined(Q_OS_LINUX)
+    QFile loadavg("/proc/loadavg");
+    if (loadavg.open(QIODevice::ReadOnly)) message["load"] = QString::fromLatin1(loadavg.readAll()).section(' ', 0, 0).toDouble();
+#endif
+    return message;
+}
+
+void NodeAgent::handleMessage(JsonLineChannel *channel, const QJsonObject &message)
+{
+    const QString type = message.value("type").toString();
+    if (type == "hello") {
+        if (!opts.token.isEmpty() && message.value("token").toString() != opts.token) {
+            qCWarning(lcCluster) << "[NodeAgent] Rejected dispatcher with invalid token:" << channel->peerName();
+            channel->send(QJsonObject{{"type", "error"}, {"reason", "invalid token"}});
+            channel->close();
+            return;
+        }
+        authenticated.insert(channel);
+        channel->send(statusMessage("hello"));
+    } else if (!authenticated.contains(channel)) {
+        // 没有先通过hello认证的连接，任何消息都不处理
+        qCWarning(lcCluster) << "[NodeAgent] Ignoring" << type << "from unauthenticated" << channel->peerName();
+        channel->send(QJsonObject{{"type", "error"}, {"reason", "not authenticated"}});
+        channel->close();
+    } else if (type == "ping") {
+        channel->send(statusMessage("pong"));
+    } else if (type == "submit") {
+        submit(channel, message);
+    } else if (type == "cancel") {
+        Job *job = jobs.value(message.value("job").toString());
+        if (job && job->worker) job->worker->requestCancel();
+    } else {
+        qCWarning(lcCluster) << "[NodeAgent] Unknown message type:" << type;
+    }
+}
+
+void NodeAgent::submit(JsonLineChannel *channel, const QJsonObject &message)
+{
+    const QString jobId = message.value("job").toString();
+    const QString phenotype = message.value("phenotype").toString();
+    auto reject = [&](const QString &reason) {
+        QJsonObject reply;
+        reply["type"] = "rejected";
+        reply["job"] = jobId;
+        reply["reason"] = reason;
+        channel->send(reply);
+        qCInfo(lcCluster) << "[NodeAgent] Rejected job" << jobId << reason;
+    };
+    if (jobId.isEmpty() || phenotype.isEmpty()) return reject("missing job id or phenotype");
+    if (jobs.contains(jobId)) return reject("duplicate job id");
+    if (jobs.size() >= opts.maxJobs) return reject("busy");
+
+    Job *job = new Job;
+    job->id = jobId;
+    job->phenotype = phenotype;
+    job->owner = channel;
+    job->dir = opts.menetDir + "/jobs/agent_" + QString(jobId).replace(QRegularExpression("[^A-Za-z0-9_-]"), "_");
+    TrialWorkspace::remove(job->dir);
+    QString error;
+    if (!TrialWorkspace::prepare(opts.menetDir, job->dir, &error)) {
+        delete job;
+        return reject(error);
+    }
+    TrialWorkspace::updatePhenotypeConfig(job->dir, "RepGeno.json", phenotype, message.value("repgeno").toObject());
+    TrialWorkspace::updatePhenotypeConfig(job->dir, "MeNet.json", phenotype, message.value("menet").toObject());
+    // 表型文件随任务下发，写进任务自己的data/phen：不覆盖本机的数据，同名表型的并发任务也互不干扰
+    const QJsonObject phenFile = message.value("phen_file").toObject();
+    const QString phenName = QFileInfo(phenFile.value("name").toString()).fileName();
+    if (!phenName.isEmpty()) {
+        const QByteArray content = QByteArray::fromBase64(phenFile.value("data").toString().toLatin1());
+        QFile target(job->dir + "/data/phen/" + phenName);
+        if (!TrialWorkspace::makePrivateDir(opts.menetDir, job->dir, "data/phen", &error)
+            || !target.open(QIODevice::WriteOnly | QIODevice::Truncate) || target.write(content) != content.size()) {
+            TrialWorkspace::remove(job->dir);
+            delete job;
+            return reject(error.isEmpty() ? QString("unable to write phenotype file") : error);
+        }
+        target.close();
+    }
+    const QString log1 = job->dir + "/step1.log";
+    const QString log2 = job->dir + "/step2.log";
+    for (const QString &log : {log1, log2}) {
+        QFile f(log);
+        if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) f.close();
+    }
+    job->step1Log.reset(log1);
+    job->step2Log.reset(log2);
+
+    // 与界面上的本地训练用同一个Worker
+    EarlyStopper::Config earlyStop;
+    const QJsonObject es = message.value("early_stop").toObject();
+    earlyStop.enabled = es.value("enabled").toBool(false);
+    earlyStop.patience = es.value("patience").toInt(earlyStop.patience);
+    earlyStop.minDelta = es.value("min_delta").toDouble(earlyStop.minDelta);
+    job->thread = new QThread(this);
+    Worker *worker = new Worker();
+    job->worker = worker;
+    worker->setParams(job->dir + "/generate_genetic_relatedness.exe", job->dir + "/train_menet.exe", log1, log2,
+                      job->dir + "/configs/RepGeno.json", job->dir + "/configs/MeNet.json", phenotype);
+    worker->setEarlyStopping(earlyStop);
+    worker->moveToThread(job->thread);
+    connect(job->thread, &QThread::started, worker, &Worker::run);
+    connect(worker, &Worker::progressChanged, this, [this, jobId](int percent) {
+        Job *j = jobs.value(jobId);
+        if (!j || !j->owner) return;
+        QJsonObject m;
+        m["type"] = "progress";
+        m["job"] = jobId;
+        m["percent"] = percent;
+        j->owner->send(m);
+    }, Qt::QueuedConnection);
+    connect(worker, &Worker::epochMetrics, this, [this, jobId](const EpochMetrics &metrics) {
+        Job *j = jobs.value(jobId);
+        if (!j || !j->owner) return;
+        QJsonObject values;
+        for (auto it = metrics.values.constBegin(); it != metrics.values.constEnd(); ++it) values[it.key()] = it.value();
+        QJsonObject m;
+        m["type"] = "epoch";
+        m["job"] = jobId;
+        m["epoch"] = metrics.epoch;
+        m["values"] = values;
+        j->owner->send(m);
+    }, Qt::QueuedConnection);
+    connect(worker, &Worker::earlyStopped, this, [this, jobId](int bestEpoch, double bestValR2) {
+        Job *j = jobs.value(jobId);
+        if (!j || !j->owner) return;
+        QJsonObject m;
+        m["type"] = "early_stopped";
+        m["job"] = jobId;
+        m["best_epoch"] = bestEpoch;
+        m["best_val_r2"] = bestValR2;
+        j->owner->send(m);
+    }, Qt::QueuedConnection);
+    connect(worker, &Worker::finished, this,
+            [this, jobId](bool success, const QString &msg, double seconds, double step1Seconds, double step2Seconds) {
+        onJobFinished(jobId, success, msg, seconds, step1Seconds, step2Seconds);
+    }, Qt::QueuedConnection);
+    connect(worker, &Worker::finished, job->thread, &QThread::quit);
+    connect(job->thread, &QThread::finished, worker, &QObject::deleteLater);
+    jobs.insert(jobId, job);
+
+    QJsonObject reply;
+    reply["type"] = "accepted";
+    reply["job"] = jobId;
+    channel->send(reply);
+    qCInfo(lcCluster) << "[NodeAgent] Accepted job" << jobId << "phenotype" << phenotype << "in" << job->dir;
+    job->thread->start();
+}
+
+void NodeAgent::sendLogLines(Job *job)
+{
+    QStringList lines = job->step1Log.readNewLines();
+    lines << job->step2Log.readNewLines();
+    if (lines.isEmpty() || !job->owner) return;
+    // 单条消息最多200行，刷屏的日志分批发送
+    for (int i = 0; i < lines.size(); i += 200) {
+        QJsonObject m;
+        m["type"] = "log";
+        m["job"] = job->id;
+        m["lines"] = QJsonArray::fromStringList(lines.mid(i, 200));
+        job->owner->send(m);
+    }
+}
+
+void NodeAgent::pollLogs()
+{
+    for (Job *job : jobs) sendLogLines(job);
+}
+
+void NodeAgent::onJobFinished(const QString &jobId, bool success, const QString &msg,
+                              double seconds, double step1Seconds, double step2Seconds)
+{
+    Job *job = jobs.value(jobId);
+    if (!job) return;
+    qCInfo(lcCluster) << "[NodeAgent] Job" << jobId << "finished, success=" << success << msg;
+    sendLogLines(job);
+    if (job->owner) {
+        // 先回传产物，再发done；调度端收到done时文件已经齐了
+        if (success) {
+            job->owner->sendFile(jobId, "model", job->dir + "/saved/menet.pt");
+            const QString curve = job->dir + QString("/%1_pca_curve.png").arg(job->phenotype);
+            if (QFile::exists(curve)) job->owner->sendFile(jobId, "pca_curve", curve);
+        }
+        job->owner->sendFile(jobId, "step2_log", job->dir + "/step2.log");
+        QJsonObject m;
+        m["type"] = "done";
+        m["job"] = jobId;
+        m["ok"] = success;
+        m["message"] = msg;
+        m["seconds"] = seconds;
+        m["step1_seconds"] = step1Seconds;
+        m["step2_seconds"] = step2Seconds;
+        job->owner->send(m);
+    }
+    releaseJob(job);
+}
+
+void NodeAgent::releaseJob(Job *job)
+{
+    jobs.remove(job->id);
+    if (job->thread) {
+        job->thread->wait();
+        job->thread->deleteLater();
+    }
+    TrialWorkspace::remove(job->dir);
+    delete job;
+}
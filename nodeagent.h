@@ -0,0 +1,76 @@
+#ifndef NODEAGENT_H
+#define NODEAGENT_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include "logfollower.h"
+
+class JsonLineChannel;
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+class QThread;
+class Worker;
+
+// 计算节点上的agent：监听TCP端口或Unix socket，接收调度端发来的表型训练任务，
+// 在 MENET/jobs/agent_<id> 的隔离目录里用Worker跑两步，回传进度、日志和模型
+class NodeAgent : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString menetDir;
+        QString bindAddress = "127.0.0.1";
+        quint16 port = 47820;       // 0表示不监听TCP
+        QString socketPath;         // 非空时同时监听Unix socket
+        int maxJobs = 1;            // 同时运行的任务数
+        QString token;              // 调度端hello里要带的共享密钥；监听非本机地址时必须设置
+    };
+
+    explicit NodeAgent(const Options &options, QObject *parent = nullptr);
+    ~NodeAgent();
+
+    bool start(QString *error = nullptr);
+
+private slots:
+    void onNewTcpConnection();
+    void onNewLocalConnection();
+    void pollLogs();
+
+private:
+    struct Job {
+        QString id;
+        QString phenotype;
+        QString dir;
+        JsonLineChannel *owner = nullptr;
+        QThread *thread = nullptr;
+        QPointer<Worker> worker;
+        LogFollower step1Log;
+        LogFollower step2Log;
+    };
+
+    Options opts;
+    QTcpServer *tcpServer = nullptr;
+    QLocalServer *localServer = nullptr;
+    QList<JsonLineChannel*> channels;
+    QSet<JsonLineChannel*> authenticated; // hello里token正确的连接，其余消息一律拒绝
+    QMap<QString, Job*> jobs;
+    QTimer logTimer;
+
+    void addChannel(QIODevice *device);
+    void handleMessage(JsonLineChannel *channel, const QJsonObject &message);
+    void submit(JsonLineChannel *channel, const QJsonObject &message);
+    void onJobFinished(const QString &jobId, bool success, const QString &msg,
+                       double seconds, double step1Seconds, double step2Seconds);
+    void sendLogLines(Job *job);
+    void releaseJob(Job *job);
+    QJsonObject statusMessage(const QString &type) const;
+};
+
+#endif // NODEAGENT_H
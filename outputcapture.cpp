@@ -0,0 +1,141 @@
+#include "outputcapture.h"
+#include "logcategories.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QObject>
+#include <QtEndian>
+
+OutputCapture::OutputCapture(const QString &spillPath, int ringBytes)
+    : path(spillPath)
+{
+    ring.resize(qMax(1024, ringBytes));
+}
+
+OutputCapture::~OutputCapture()
+{
+    finish();
+}
+
+void OutputCapture::append(const QByteArray &data)
+{
+    if (data.isEmpty()) return;
+    total += data.size();
+    const int capacity = ring.size();
+    const char *src = data.constData();
+    int len = data.size();
+    if (len >= capacity) {
+        // 一次比整个缓冲还大：缓冲里的全部和这块的前面部分直接溢出
+        evict(size);
+        spill(src, len - capacity);
+        src += len - capacity;
+        len = capacity;
+    } else if (size + len > capacity) {
+        evict(size + len - capacity);
+    }
+    int pos = (start + size) % capacity;
+    const int first = qMin(len, capacity - pos);
+    memcpy(ring.data() + pos, src, first);
+    if (first < len) memcpy(ring.data(), src + first, len - first);
+    size += len;
+}
+
+void OutputCapture::evict(int count)
+{
+    if (count <= 0) return;
+    const int capacity = ring.size();
+    const int first = qMin(count, capacity - start);
+    spill(ring.constData() + start, first);
+    if (first < count) spill(ring.constData(), count - first);
+    start = (start + count) % capacity;
+    size -= count;
+}
+
+void OutputCapture::spill(const char *data, int count)
+{
+    if (count <= 0) return;
+    spilled = true;
+    spillBuffer.append(data, count);
+    while (spillBuffer.size() >= kSpillChunkBytes) {
+        writeFrame(spillBuffer.left(kSpillChunkBytes));
+        spillBuffer.remove(0, kSpillChunkBytes);
+    }
+}
+
+void OutputCapture::writeFrame(const QByteArray &chunk)
+{
+    if (spillFailed) return;
+    if (!spillFile.isOpen()) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        spillFile.setFileName(path);
+        if (!spillFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCWarning(lcData) << "[OutputCapture] Cannot open spill file:" << path << spillFile.errorString();
+            spillFailed = true;
+            return;
+        }
+        qCInfo(lcData) << "[OutputCapture] Output exceeds" << ring.size() << "bytes, spilling to" << path;
+    }
+    const QByteArray compressed = qCompress(chunk, 6);
+    uchar header[4];
+    qToBigEndian<quint32>(quint32(compressed.size()), header);
+    spillFile.write(reinterpret_cast<const char *>(header), 4);
+    spillFile.write(compressed);
+}
+
+void OutputCapture::finish()
+{
+    if (finished) return;
+    finished = true;
+    if (!spilled) return;
+    // 环形缓冲保持不动，recent()之后仍然可用
+    spillBuffer.append(recent());
+    for (int offset = 0; offset < spillBuffer.size(); offset += kSpillChunkBytes) {
+        writeFrame(spillBuffer.mid(offset, kSpillChunkBytes));
+    }
+    spillBuffer.clear();
+    spillFile.close();
+}
+
+QByteArray OutputCapture::recent() const
+{
+    const int capacity = ring.size();
+    const int first = qMin(size, capacity - start);
+    QByteArray out = ring.mid(start, first);
+    if (first < size) out.append(ring.constData(), size - first);
+    return out;
+}
+
+QStringList OutputCapture::lastLines(int count) const
+{
+    QStringList lines = QString::fromLocal8Bit(recent()).split('\n');
+    while (!lines.isEmpty() && lines.last().trimmed().isEmpty()) lines.removeLast();
+    if (lines.size() > count) lines = lines.mid(lines.size() - count);
+    for (QString &line : lines) {
+        if (line.endsWith('\r')) line.chop(1);
+    }
+    return lines;
+}
+
+bool OutputCapture::decompressTo(const QString &spillPath, QIODevice *out, QString *error)
+{
+    QFile file(spillPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    while (!file.atEnd()) {
+        const QByteArray header = file.read(4);
+        if (header.size() != 4) {
+            if (error) *error = QObject::tr("Truncated frame header");
+            return false;
+        }
+        const quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(header.constData()));
+        const QByteArray frame = file.read(length);
+        const QByteArray chunk = qUncompress(frame);
+        if (frame.size() != int(length) || chunk.isEmpty()) {
+            if (error) *error = QObject::tr("Corrupt frame at offset %1").arg(file.pos() - frame.size() - 4);
+            return false;
+        }
+        out->write(chunk);
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef OUTPUTCAPTURE_H
+#define OUTPUTCAPTURE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+
+// 子进程输出的有界捕获：内存里只保留最近ringBytes字节的环形缓冲，
+// 被挤出的旧内容按块压缩后追加到磁盘上的溢出文件，内存占用与输出总量无关。
+// 溢出文件格式：每块为4字节大端长度 + qCompress数据，用decompressTo()还原
+class OutputCapture
+{
+public:
+    static constexpr int kDefaultRingBytes = 4 * 1024 * 1024;
+    static constexpr int kSpillChunkBytes = 256 * 1024;
+
+    explicit OutputCapture(const QString &spillPath, int ringBytes = kDefaultRingBytes);
+    ~OutputCapture();
+
+    void append(const QByteArray &data);
+    // 发生过溢出时把环形缓冲里剩余的内容也写入溢出文件，使其成为完整输出；没溢出则不产生文件
+    void finish();
+
+    QByteArray recent() const;             // 环形缓冲里的内容（按时间顺序）
+    QStringList lastLines(int count) const;
+    qint64 totalBytes() const { return total; }
+    bool hasSpilled() const { return spilled; }
+    QString spillPath() const { return path; }
+
+    // 把溢出文件解压写到out，返回是否成功
+    static bool decompressTo(const QString &spillPath, QIODevice *out, QString *error = nullptr);
+
+private:
+    QString path;
+    QByteArray ring;
+    int start = 0;
+    int size = 0;
+    qint64 total = 0;
+    bool spilled = false;
+    bool finished = false;
+    bool spillFailed = false; // 溢出文件打不开时只保留环形缓冲
+    QByteArray spillBuffer; // 凑满一块再压缩
+    QFile spillFile;
+
+    void evict(int count);
+    void spill(const char *data, int count);
+    void writeFrame(const QByteArray &chunk);
+};
+
+#endif // OUTPUTCAPTURE_H
@@ -0,0 +1,77 @@
+#include "pathutils.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace PathUtils {
+
+static bool isChineseCodePoint(char32_t code)
+{
+    return (code >= 0x4E00 && code <= 0x9FFF)      // 基本汉字
+        || (code >= 0x3400 && code <= 0x4DBF)      // 扩展A
+        || (code >= 0x20000 && code <= 0x2A6DF)    // 扩展B
+        || (code >= 0x2A700 && code <= 0x2B73F)    // 扩展C
+        || (code >= 0x2B740 && code <= 0x2B81F)    // 扩展D
+        || (code >= 0x2B820 && code <= 0x2CEAF)    // 扩展E
+        || (code >= 0x2CEB0 && code <= 0x2EBEF)    // 扩展F
+        || (code >= 0x30000 && code <= 0x3134F);   // 扩展G
+}
+
+bool containsChineseCharacters(const QString &path)
+{
+    const QChar *data = path.constData();
+    const qsizetype size = path.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        const QChar ch = data[i];
+        if (ch.unicode() < 0x3400) continue; // ASCII和常见西文字符直接跳过
+        char32_t code = ch.unicode();
+        // 扩展区汉字在UTF-16里是代理对，要合成码点再判断
+        if (ch.isHighSurrogate() && i + 1 < size && data[i + 1].isLowSurrogate()) {
+            code = QChar::surrogateToUcs4(ch, data[i + 1]);
+            ++i;
+        }
+        if (isChineseCodePoint(code)) return true;
+    }
+    return false;
+}
+
+bool isSupportedDataFile(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "csv" || suffix == "pt" || suffix == "xls" || suffix == "xlsx";
+}
+
+bool copyReplacing(const QString &source, const QString &target, QString *error)
+{
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly)) {
+        if (error) *error = in.errorString();
+        return false;
+    }
+    QSaveFile out(target);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    QByteArray buffer;
+    while (!in.atEnd()) {
+        buffer = in.read(1024 * 1024);
+        if (buffer.isEmpty() && in.error() != QFileDevice::NoError) {
+            if (error) *error = in.errorString();
+            out.cancelWriting();
+            return false;
+        }
+        if (out.write(buffer) != buffer.size()) {
+            if (error) *error = out.errorString();
+            out.cancelWriting();
+            return false;
+        }
+    }
+    if (!out.commit()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+} // namespace PathUtils
@@ -0,0 +1,18 @@
+#ifndef PATHUTILS_H
+#define PATHUTILS_H
+
+#include <QString>
+
+// 与界面无关的路径/文件小工具，界面和基准测试共用
+namespace PathUtils {
+
+// 路径里是否含有中文字符（含扩展区B-G，按码点判断）
+bool containsChineseCharacters(const QString &path);
+// 上传支持的数据文件格式：csv/pt/xls/xlsx
+bool isSupportedDataFile(const QString &fileName);
+// 复制到target，已存在时替换。先写同目录临时文件再改名，中途失败不会留下半个文件
+bool copyReplacing(const QString &source, const QString &target, QString *error = nullptr);
+
+} // namespace PathUtils
+
+#endif // PATHUTILS_H
@@ -0,0 +1,48 @@
+#include "phenotypeconfig.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QSaveFile>
+
+QJsonObject PhenotypeConfig::load(const QString &jsonPath, QString *error)
+{
+    QFile file(jsonPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return QJsonObject();
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        if (error) *error = parseError.error != QJsonParseError::NoError ? parseError.errorString() : QString("not a JSON object");
+        return QJsonObject();
+    }
+    return doc.object();
+}
+
+bool PhenotypeConfig::save(const QString &jsonPath, const QJsonObject &root, QString *error)
+{
+    QSaveFile file(jsonPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool PhenotypeConfig::updateSaved(const QString &jsonPath, const QString &phenotype, int savedValue)
+{
+    QString error;
+    QJsonObject root = load(jsonPath, &error);
+    if (!error.isEmpty()) return false;
+    if (!root.value(phenotype).isObject()) return false;
+    QJsonObject phenoObj = root.value(phenotype).toObject();
+    phenoObj["saved"] = savedValue;
+    root[phenotype] = phenoObj;
+    return save(jsonPath, root);
+}
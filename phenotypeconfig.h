@@ -0,0 +1,19 @@
+#ifndef PHENOTYPECONFIG_H
+#define PHENOTYPECONFIG_H
+
+#include <QJsonObject>
+#include <QString>
+
+// MENET/configs下按表型分节的json配置（RepGeno.json、MeNet.json）的读写
+class PhenotypeConfig
+{
+public:
+    // 读取整个文件；文件不存在或不是json对象时返回空对象，error给出原因
+    static QJsonObject load(const QString &jsonPath, QString *error = nullptr);
+    // 整体写回，先写临时文件再替换
+    static bool save(const QString &jsonPath, const QJsonObject &root, QString *error = nullptr);
+    // 只改一个表型的saved字段；表型不存在时返回false
+    static bool updateSaved(const QString &jsonPath, const QString &phenotype, int savedValue);
+};
+
+#endif // PHENOTYPECONFIG_H
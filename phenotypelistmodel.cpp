@@ -0,0 +1,156 @@
+#include "phenotypelistmodel.h"
+#include <QCollator>
+#include <algorithm>
+
+PhenotypeListModel::PhenotypeListModel(QObject *parent) : QAbstractListModel(parent)
+{
+}
+
+bool PhenotypeListModel::lessThan(const QString &a, const QString &b)
+{
+    static const QCollator collator = []() {
+        QCollator c;
+        c.setNumericMode(true);
+        c.setCaseSensitivity(Qt::CaseInsensitive);
+        return c;
+    }();
+    const int result = collator.compare(a, b);
+    return result != 0 ? result < 0 : a < b;
+}
+
+int PhenotypeListModel::lowerBound(const QString &name) const
+{
+    auto it = std::lower_bound(items.cbegin(), items.cend(), name,
+                               [](const Item &item, const QString &value) { return lessThan(item.name, value); });
+    return int(it - items.cbegin());
+}
+
+int PhenotypeListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : items.size();
+}
+
+QVariant PhenotypeListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= items.size()) return QVariant();
+    const Item &item = items.at(index.row());
+    if (role == Qt::DisplayRole || role == Qt::ToolTipRole) return item.name;
+    if (role == Qt::CheckStateRole) return item.checked ? Qt::Checked : Qt::Unchecked;
+    return QVariant();
+}
+
+bool PhenotypeListModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::CheckStateRole || index.row() >= items.size()) return false;
+    const bool checked = value.toInt() == Qt::Checked;
+    Item &item = items[index.row()];
+    if (item.checked == checked) return true;
+    item.checked = checked;
+    checkedTotal += checked ? 1 : -1;
+    emit dataChanged(index, index, {Qt::CheckStateRole});
+    emit checkedChanged();
+    return true;
+}
+
+Qt::ItemFlags PhenotypeListModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable;
+}
+
+int PhenotypeListModel::applyNames(const QStringList &names)
+{
+    const QSet<QString> incoming(names.cbegin(), names.cend());
+    int changed = 0;
+    bool checkedRemoved = false;
+
+    // 删除：从后往前把连续的待删行合成一次removeRows
+    int row = items.size() - 1;
+    while (row >= 0) {
+        if (incoming.contains(items.at(row).name)) { --row; continue; }
+        const int last = row;
+        while (row >= 0 && !incoming.contains(items.at(row).name)) --row;
+        const int first = row + 1;
+        beginRemoveRows(QModelIndex(), first, last);
+        for (int i = first; i <= last; ++i) {
+            if (items.at(i).checked) {
+                --checkedTotal;
+                checkedRemoved = true;
+            }
+            nameSet.remove(items.at(i).name);
+        }
+        items.remove(first, last - first + 1);
+        endRemoveRows();
+        changed += last - first + 1;
+    }
+
+    // 新增
+    QStringList added;
+    for (const QString &name : incoming) {
+        if (!nameSet.contains(name)) added << name;
+    }
+    if (!added.isEmpty()) {
+        std::sort(added.begin(), added.end(), lessThan);
+        if (items.isEmpty() || added.size() > items.size()) {
+            // 首次加载或大批量新增时归并后整体重置，比逐行插入便宜
+            QVector<Item> merged;
+            merged.reserve(items.size() + added.size());
+            int a = 0;
+            for (const Item &item : items) {
+                while (a < added.size() && lessThan(added.at(a), item.name)) merged.append({added.at(a++), false});
+                merged.append(item);
+            }
+            while (a < added.size()) merged.append({added.at(a++), false});
+            beginResetModel();
+            items = merged;
+            endResetModel();
+        } else {
+            for (const QString &name : added) {
+                const int pos = lowerBound(name);
+                beginInsertRows(QModelIndex(), pos, pos);
+                items.insert(pos, Item{name, false});
+                endInsertRows();
+            }
+        }
+        for (const QString &name : added) nameSet.insert(name);
+        changed += added.size();
+    }
+    if (checkedRemoved) emit checkedChanged();
+    return changed;
+}
+
+void PhenotypeListModel::setChecked(const QList<int> &rows, bool checked)
+{
+    QList<int> sorted = rows;
+    std::sort(sorted.begin(), sorted.end());
+    int changedRows = 0;
+    int rangeStart = -1, rangeEnd = -1;
+    auto flush = [&]() {
+        if (rangeStart >= 0) emit dataChanged(index(rangeStart), index(rangeEnd), {Qt::CheckStateRole});
+        rangeStart = rangeEnd = -1;
+    };
+    for (int row : sorted) {
+        if (row < 0 || row >= items.size() || items.at(row).checked == checked) continue;
+        items[row].checked = checked;
+        checkedTotal += checked ? 1 : -1;
+        ++changedRows;
+        // 相邻的行合并成一次dataChanged
+        if (rangeStart >= 0 && row == rangeEnd + 1) {
+            rangeEnd = row;
+        } else {
+            flush();
+            rangeStart = rangeEnd = row;
+        }
+    }
+    flush();
+    if (changedRows > 0) emit checkedChanged();
+}
+
+QStringList PhenotypeListModel::checkedNames() const
+{
+    QStringList names;
+    for (const Item &item : items) {
+        if (item.checked) names << item.name;
+    }
+    return names;
+}
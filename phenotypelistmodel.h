@@ -0,0 +1,46 @@
+#ifndef PHENOTYPELISTMODEL_H
+#define PHENOTYPELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// 表型列表模型：每个表型一行，可勾选，按名称自然排序（trait2排在trait10前）。
+// applyNames()与现有列表做差异，只对增删的行发信号，视图不会整体重建
+class PhenotypeListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit PhenotypeListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    // names为目录里的全部表型名（可重复、无序）；返回增删的行数
+    int applyNames(const QStringList &names);
+    void setChecked(const QList<int> &rows, bool checked);
+    QStringList checkedNames() const;
+    int checkedCount() const { return checkedTotal; }
+    bool contains(const QString &name) const { return nameSet.contains(name); }
+
+signals:
+    void checkedChanged();
+
+private:
+    struct Item {
+        QString name;
+        bool checked = false;
+    };
+    QVector<Item> items;
+    QSet<QString> nameSet;
+    int checkedTotal = 0;
+
+    int lowerBound(const QString &name) const;
+    static bool lessThan(const QString &a, const QString &b);
+};
+
+#endif // PHENOTYPELISTMODEL_H
@@ -0,0 +1,190 @@
+#include "phenotypeselector.h"
+#include "phenotypelistmodel.h"
+#include "logcategories.h"
+#include <QApplication>
+#include <QCheckBox>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QPointer>
+#include <QPushButton>
+#include <QRegularExpression>
+#include <QSortFilterProxyModel>
+#include <QThreadPool>
+#include <QVBoxLayout>
+#include <QElapsedTimer>
+
+PhenotypeSelector::PhenotypeSelector(const QString &directory, QWidget *parent)
+    : QWidget(parent), directory(directory)
+{
+    model = new PhenotypeListModel(this);
+    proxy = new QSortFilterProxyModel(this);
+    proxy->setSourceModel(model);
+    proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+    searchEdit = new QLineEdit(this);
+    searchEdit->setPlaceholderText(tr("Search phenotypes"));
+    searchEdit->setClearButtonEnabled(true);
+    regexCheck = new QCheckBox(tr("Regex"), this);
+    QPushButton *selectButton = new QPushButton(tr("Select matching"), this);
+    QPushButton *clearButton = new QPushButton(tr("Clear matching"), this);
+    countLabel = new QLabel(this);
+
+    QHBoxLayout *searchLayout = new QHBoxLayout();
+    searchLayout->addWidget(searchEdit, 1);
+    searchLayout->addWidget(regexCheck);
+    searchLayout->addWidget(selectButton);
+    searchLayout->addWidget(clearButton);
+    searchLayout->addWidget(countLabel);
+
+    // 行高统一时视图不必逐行测量，几千行也只绘制可见部分
+    view = new QListView(this);
+    view->setModel(proxy);
+    view->setUniformItemSizes(true);
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    view->setMinimumHeight(120);
+    view->setMaximumHeight(200);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(searchLayout);
+    layout->addWidget(view);
+
+    connect(searchEdit, &QLineEdit::textChanged, this, &PhenotypeSelector::updateFilter);
+    connect(regexCheck, &QCheckBox::toggled, this, &PhenotypeSelector::updateFilter);
+    connect(selectButton, &QPushButton::clicked, this, &PhenotypeSelector::selectMatching);
+    connect(clearButton, &QPushButton::clicked, this, &PhenotypeSelector::clearMatching);
+    connect(model, &PhenotypeListModel::checkedChanged, this, [this]() {
+        updateCountLabel();
+        emit selectionChanged(model->checkedNames());
+    });
+    connect(proxy, &QAbstractItemModel::rowsInserted, this, &PhenotypeSelector::updateCountLabel);
+    connect(proxy, &QAbstractItemModel::rowsRemoved, this, &PhenotypeSelector::updateCountLabel);
+    connect(proxy, &QAbstractItemModel::modelReset, this, &PhenotypeSelector::updateCountLabel);
+
+    watcher = new QFileSystemWatcher(this);
+    rescanTimer.setSingleShot(true);
+    rescanTimer.setInterval(200);
+    connect(&rescanTimer, &QTimer::timeout, this, &PhenotypeSelector::startScan);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, [this]() { rescanTimer.start(); });
+    updateCountLabel();
+}
+
+QStringList PhenotypeSelector::selectedPhenotypes() const
+{
+    return model->checkedNames();
+}
+
+int PhenotypeSelector::phenotypeCount() const
+{
+    return model->rowCount();
+}
+
+bool PhenotypeSelector::hasPhenotype(const QString &name) const
+{
+    return model->contains(name);
+}
+
+void PhenotypeSelector::rescan()
+{
+    if (!watcher->directories().contains(directory) && QFileInfo(directory).isDir()) {
+        watcher->addPath(directory);
+    }
+    rescanTimer.stop();
+    startScan();
+}
+
+void PhenotypeSelector::startScan()
+{
+    // 同一时间只跑一次扫描，期间的变化在结束后再补扫一次
+    if (scanRunning) {
+        rescanPending = true;
+        return;
+    }
+    scanRunning = true;
+    rescanPending = false;
+    QPointer<PhenotypeSelector> self(this);
+    const QString phenDir = directory;
+    // 目录在网络盘上时列目录可能很慢；只取文件名，不做stat
+    QThreadPool::globalInstance()->start([self, phenDir]() {
+        QStringList filters;
+        filters << "*.csv" << "*.pt" << "*.xls" << "*.xlsx";
+        QStringList baseNames;
+        for (const QString &fileName : QDir(phenDir).entryList(filters, QDir::Files | QDir::NoDotAndDotDot)) {
+            baseNames << QFileInfo(fileName).completeBaseName();
+        }
+        QMetaObject::invokeMethod(qApp, [self, baseNames]() {
+            if (self) self->onScanFinished(baseNames);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void PhenotypeSelector::onScanFinished(const QStringList &names)
+{
+    scanRunning = false;
+    QElapsedTimer timer;
+    timer.start();
+    const int changed = model->applyNames(names);
+    if (changed > 0) {
+        qCDebug(lcUi) << "[PhenotypeSelector]" << changed << "phenotype(s) changed," << model->rowCount()
+                      << "total, applied in" << timer.elapsed() << "ms";
+    }
+    emit phenotypesChanged(model->rowCount());
+    // 目录是扫描期间才创建的，补上监听
+    if (!watcher->directories().contains(directory) && QFileInfo(directory).isDir()) {
+        watcher->addPath(directory);
+    }
+    if (rescanPending) startScan();
+}
+
+void PhenotypeSelector::updateFilter()
+{
+    const QString text = searchEdit->text();
+    if (regexCheck->isChecked()) {
+        QRegularExpression re(text, QRegularExpression::CaseInsensitiveOption);
+        if (!re.isValid()) {
+            // 正则没写完时保持上一次的过滤结果，输入框标红提示
+            searchEdit->setStyleSheet("QLineEdit { color: #c0392b; }");
+            searchEdit->setToolTip(re.errorString());
+            return;
+        }
+        proxy->setFilterRegularExpression(re);
+    } else {
+        proxy->setFilterFixedString(text);
+    }
+    searchEdit->setStyleSheet(QString());
+    searchEdit->setToolTip(QString());
+    updateCountLabel();
+}
+
+void PhenotypeSelector::selectMatching()
+{
+    setMatchingChecked(true);
+}
+
+void PhenotypeSelector::clearMatching()
+{
+    setMatchingChecked(false);
+}
+
+void PhenotypeSelector::setMatchingChecked(bool checked)
+{
+    QList<int> rows;
+    rows.reserve(proxy->rowCount());
+    for (int row = 0; row < proxy->rowCount(); ++row) {
+        rows << proxy->mapToSource(proxy->index(row, 0)).row();
+    }
+    model->setChecked(rows, checked);
+}
+
+void PhenotypeSelector::updateCountLabel()
+{
+    countLabel->setText(tr("%1 selected / %2 shown / %3 total")
+                            .arg(model->checkedCount())
+                            .arg(proxy->rowCount())
+                            .arg(model->rowCount()));
+}
@@ -0,0 +1,59 @@
+#ifndef PHENOTYPESELECTOR_H
+#define PHENOTYPESELECTOR_H
+
+#include <QWidget>
+#include <QStringList>
+#include <QTimer>
+
+class PhenotypeListModel;
+class QSortFilterProxyModel;
+class QLineEdit;
+class QCheckBox;
+class QListView;
+class QLabel;
+class QFileSystemWatcher;
+
+// 表型选择器：搜索框 + 只绘制可见行的列表视图。
+// 监听表型目录，目录变化后在线程池里只列文件名，与模型做差异后增量更新
+class PhenotypeSelector : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PhenotypeSelector(const QString &directory, QWidget *parent = nullptr);
+
+    QStringList selectedPhenotypes() const;
+    int phenotypeCount() const;
+    bool hasPhenotype(const QString &name) const;
+    // 立即重新扫描（上传文件后、目录刚创建时调用），同时补上目录监听
+    void rescan();
+
+signals:
+    void selectionChanged(const QStringList &selected);
+    void phenotypesChanged(int count);
+
+private slots:
+    void updateFilter();
+    void selectMatching();
+    void clearMatching();
+    void updateCountLabel();
+
+private:
+    QString directory;
+    PhenotypeListModel *model = nullptr;
+    QSortFilterProxyModel *proxy = nullptr;
+    QLineEdit *searchEdit = nullptr;
+    QCheckBox *regexCheck = nullptr;
+    QListView *view = nullptr;
+    QLabel *countLabel = nullptr;
+    QFileSystemWatcher *watcher = nullptr;
+    QTimer rescanTimer;   // 合并短时间内的多次目录变化
+    bool scanRunning = false;
+    bool rescanPending = false;
+
+    void startScan();
+    void onScanFinished(const QStringList &names);
+    void setMatchingChecked(bool checked);
+};
+
+#endif // PHENOTYPESELECTOR_H
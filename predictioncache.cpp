@@ -0,0 +1,98 @@
+#include "predictioncache.h"
+#include "filefingerprint.h"
+#include "logcategories.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+PredictionCache::PredictionCache(const QString &menetDir)
+    : menetDir(menetDir)
+    , manifestPath(menetDir + "/cache/prediction_cache.json")
+{
+    FileFingerprint::instance()->setMemoPath(menetDir + "/cache/fingerprints.json");
+}
+
+QString PredictionCache::outputPath(const QString &phenotype) const
+{
+    return menetDir + QString("/%1_MeNet_pred.csv").arg(phenotype);
+}
+
+PredictionCache::Key PredictionCache::keyFor(const QString &phenotype, const QStringList &inputFiles) const
+{
+    FileFingerprint *fingerprint = FileFingerprint::instance();
+    Key key;
+    key.model = fingerprint->ofFile(menetDir + QString("/saved/%1_menet.pt").arg(phenotype));
+    key.input = fingerprint->ofFiles(inputFiles);
+    key.gene = fingerprint->ofDirectory(menetDir + "/data/gene");
+    key.exe = fingerprint->ofFile(menetDir + "/pred.exe");
+    fingerprint->save();
+    return key;
+}
+
+QJsonObject PredictionCache::loadManifest() const
+{
+    QFile file(manifestPath);
+    if (!file.open(QIODevice::ReadOnly)) return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void PredictionCache::saveManifest(const QJsonObject &manifest) const
+{
+    QDir().mkpath(QFileInfo(manifestPath).absolutePath());
+    QSaveFile file(manifestPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcData) << "[PredictionCache] Unable to write" << manifestPath;
+        return;
+    }
+    file.write(QJsonDocument(manifest).toJson(QJsonDocument::Indented));
+    file.commit();
+}
+
+bool PredictionCache::lookup(const QString &phenotype, const Key &key, QString *output) const
+{
+    if (!key.isValid()) return false;
+    const QJsonObject entry = loadManifest().value(phenotype).toObject();
+    if (entry.isEmpty()) return false;
+    Key cached;
+    cached.model = entry.value("model").toString();
+    cached.input = entry.value("input").toString();
+    cached.gene = entry.value("gene").toString();
+    cached.exe = entry.value("exe").toString();
+    if (!(cached == key)) return false;
+    // 输出文件被删除或手工改过就不算命中
+    const QString path = outputPath(phenotype);
+    const QString outputHash = FileFingerprint::instance()->ofFile(path);
+    if (outputHash.isEmpty() || outputHash != entry.value("output").toString()) return false;
+    if (output) *output = path;
+    qCDebug(lcData) << "[PredictionCache] Hit for" << phenotype;
+    return true;
+}
+
+void PredictionCache::store(const QString &phenotype, const Key &key)
+{
+    if (!key.isValid()) return;
+    const QString outputHash = FileFingerprint::instance()->ofFile(outputPath(phenotype));
+    if (outputHash.isEmpty()) return;
+    QJsonObject entry;
+    entry["model"] = key.model;
+    entry["input"] = key.input;
+    entry["gene"] = key.gene;
+    entry["exe"] = key.exe;
+    entry["output"] = outputHash;
+    entry["created"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    QJsonObject manifest = loadManifest();
+    manifest[phenotype] = entry;
+    saveManifest(manifest);
+    FileFingerprint::instance()->save();
+}
+
+void PredictionCache::invalidate(const QString &phenotype)
+{
+    QJsonObject manifest = loadManifest();
+    if (!manifest.contains(phenotype)) return;
+    manifest.remove(phenotype);
+    saveManifest(manifest);
+}
@@ -0,0 +1,45 @@
+#ifndef PREDICTIONCACHE_H
+#define PREDICTIONCACHE_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+// 预测结果缓存：记录每个表型上次预测时模型、待预测文件、基因数据和pred.exe的指纹，
+// 全部一致且输出文件未被改动时直接复用 MENET/<pheno>_MeNet_pred.csv。
+// 清单保存在 MENET/cache/prediction_cache.json
+class PredictionCache
+{
+public:
+    struct Key {
+        QString model;
+        QString input;
+        QString gene;
+        QString exe;
+        bool isValid() const { return !model.isEmpty() && !input.isEmpty() && !exe.isEmpty(); }
+        bool operator==(const Key &other) const {
+            return model == other.model && input == other.input && gene == other.gene && exe == other.exe;
+        }
+    };
+
+    explicit PredictionCache(const QString &menetDir);
+
+    // 计算指纹；inputFiles为 data/pred 下该表型的文件
+    Key keyFor(const QString &phenotype, const QStringList &inputFiles) const;
+    // 命中时返回true，outputPath为可直接使用的预测结果
+    bool lookup(const QString &phenotype, const Key &key, QString *outputPath = nullptr) const;
+    // 预测成功后登记输出文件
+    void store(const QString &phenotype, const Key &key);
+    void invalidate(const QString &phenotype);
+
+    QString outputPath(const QString &phenotype) const;
+
+private:
+    QString menetDir;
+    QString manifestPath;
+
+    QJsonObject loadManifest() const;
+    void saveManifest(const QJsonObject &manifest) const;
+};
+
+#endif // PREDICTIONCACHE_H
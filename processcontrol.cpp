@@ -0,0 +1,228 @@
+#include "processcontrol.h"
+#include "logcategories.h"
+#include <QPointer>
+#include <QTimer>
+#if defined(Q_OS_WIN)
+#include <QStringList>
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#else
+#include <QDir>
+#include <QFile>
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace ProcessControl {
+
+void prepareProcessGroup(QProcess &process)
+{
+#if !defined(Q_OS_WIN)
+    process.setChildProcessModifier([]() {
+        ::setpgid(0, 0);
+    });
+#else
+    Q_UNUSED(process);
+#endif
+}
+
+void setThreadEnvironment(QProcess &process, int threads)
+{
+    QProcessEnvironment env = process.processEnvironment();
+    if (env.isEmpty()) env = QProcessEnvironment::systemEnvironment();
+    const QString value = QString::number(threads);
+    env.insert("OMP_NUM_THREADS", value);
+    env.insert("MKL_NUM_THREADS", value);
+    env.insert("OPENBLAS_NUM_THREADS", value);
+    process.setProcessEnvironment(env);
+}
+
+// SIGTERM/SIGKILL整个进程组；Windows下用taskkill /T结束整棵进程树
+static void sendSignal(qint64 pid, bool force)
+{
+#if defined(Q_OS_WIN)
+    QStringList args = QStringList() << "/PID" << QString::number(pid) << "/T";
+    if (force) args << "/F";
+    QProcess::startDetached("taskkill", args);
+#else
+    int sig = force ? SIGKILL : SIGTERM;
+    if (::kill(-static_cast<pid_t>(pid), sig) != 0) ::kill(static_cast<pid_t>(pid), sig);
+    // 被暂停的进程收不到SIGTERM，要先让它继续运行
+    if (::kill(-static_cast<pid_t>(pid), SIGCONT) != 0) ::kill(static_cast<pid_t>(pid), SIGCONT);
+#endif
+}
+
+#if defined(Q_OS_WIN)
+// pid及其所有子孙进程；Windows没有进程组，按父进程号从快照里展开
+static QList<DWORD> processTree(qint64 pid)
+{
+    QList<DWORD> tree;
+    tree << static_cast<DWORD>(pid);
+    HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return tree;
+    QList<QPair<DWORD, DWORD>> parents;
+    PROCESSENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    for (BOOL ok = ::Process32First(snapshot, &entry); ok; ok = ::Process32Next(snapshot, &entry)) {
+        parents << qMakePair(entry.th32ProcessID, entry.th32ParentProcessID);
+    }
+    ::CloseHandle(snapshot);
+    for (int i = 0; i < tree.size(); ++i) {
+        for (const QPair<DWORD, DWORD> &p : parents) {
+            if (p.second == tree.at(i) && p.first != tree.at(i) && !tree.contains(p.first)) tree << p.first;
+        }
+    }
+    return tree;
+}
+
+// NtSuspendProcess/NtResumeProcess是ntdll的未公开导出，按名字取
+static bool callNtProcessFunction(qint64 pid, const char *name)
+{
+    using NtProcessFunction = LONG(NTAPI *)(HANDLE);
+    static HMODULE ntdll = ::GetModuleHandleW(L"ntdll.dll");
+    const auto function = ntdll ? reinterpret_cast<NtProcessFunction>(::GetProcAddress(ntdll, name)) : nullptr;
+    if (!function) return false;
+    bool ok = true;
+    for (DWORD id : processTree(pid)) {
+        HANDLE handle = ::OpenProcess(PROCESS_SUSPEND_RESUME, FALSE, id);
+        if (!handle) {
+            ok = false;
+            continue;
+        }
+        if (function(handle) < 0) ok = false;
+        ::CloseHandle(handle);
+    }
+    return ok;
+}
+#else
+static bool signalGroup(qint64 pid, int sig)
+{
+    if (::kill(-static_cast<pid_t>(pid), sig) == 0) return true;
+    return ::kill(static_cast<pid_t>(pid), sig) == 0;
+}
+#endif
+
+bool suspendTree(qint64 pid)
+{
+    if (pid <= 0) return false;
+    qCDebug(lcWorker) << "[ProcessControl] Suspending process tree, pid=" << pid;
+#if defined(Q_OS_WIN)
+    return callNtProcessFunction(pid, "NtSuspendProcess");
+#else
+    return signalGroup(pid, SIGSTOP);
+#endif
+}
+
+bool resumeTree(qint64 pid)
+{
+    if (pid <= 0) return false;
+    qCDebug(lcWorker) << "[ProcessControl] Resuming process tree, pid=" << pid;
+#if defined(Q_OS_WIN)
+    return callNtProcessFunction(pid, "NtResumeProcess");
+#else
+    return signalGroup(pid, SIGCONT);
+#endif
+}
+
+bool setTreeLowPriority(qint64 pid, bool low)
+{
+    if (pid <= 0) return false;
+#if defined(Q_OS_WIN)
+    bool ok = true;
+    for (DWORD id : processTree(pid)) {
+        HANDLE handle = ::OpenProcess(PROCESS_SET_INFORMATION, FALSE, id);
+        if (!handle || !::SetPriorityClass(handle, low ? IDLE_PRIORITY_CLASS : NORMAL_PRIORITY_CLASS)) ok = false;
+        if (handle) ::CloseHandle(handle);
+    }
+    return ok;
+#else
+    const int niceness = low ? 19 : 0;
+    if (::setpriority(PRIO_PGRP, static_cast<id_t>(pid), niceness) == 0) return true;
+    return ::setpriority(PRIO_PROCESS, static_cast<id_t>(pid), niceness) == 0;
+#endif
+}
+
+void terminateTree(QProcess &process, int graceMs)
+{
+    if (process.state() == QProcess::NotRunning) return;
+    const qint64 pid = process.processId();
+    qCDebug(lcWorker) << "[ProcessControl] Terminating process tree, pid=" << pid;
+    sendSignal(pid, false);
+    if (process.waitForFinished(graceMs)) return;
+    qCDebug(lcWorker) << "[ProcessControl] Grace period expired, sending SIGKILL, pid=" << pid;
+    sendSignal(pid, true);
+    process.waitForFinished(-1);
+}
+
+void terminateTreeAsync(QProcess *process, int graceMs)
+{
+    if (!process || process->state() == QProcess::NotRunning) return;
+    const qint64 pid = process->processId();
+    qCDebug(lcWorker) << "[ProcessControl] Terminating process tree (async), pid=" << pid;
+    sendSignal(pid, false);
+    QPointer<QProcess> guard(process);
+    QTimer::singleShot(graceMs, process, [guard, pid]() {
+        if (guard && guard->state() != QProcess::NotRunning && guard->processId() == pid) {
+            qCDebug(lcWorker) << "[ProcessControl] Grace period expired, killing pid=" << pid;
+            sendSignal(pid, true);
+        }
+    });
+}
+
+double peakMemoryMB(qint64 pid)
+{
+    if (pid <= 0) return 0.0;
+#if defined(Q_OS_WIN)
+    HANDLE handle = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+    if (!handle) return 0.0;
+    PROCESS_MEMORY_COUNTERS counters;
+    double mb = 0.0;
+    if (::K32GetProcessMemoryInfo(handle, &counters, sizeof(counters))) {
+        mb = counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    ::CloseHandle(handle);
+    return mb;
+#else
+    // 打包的exe启动器会再拉起一个子进程，真正的内存占用在组内其他进程上
+    double totalKB = 0.0;
+    const QStringList entries = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool isPid = false;
+        const qint64 candidate = entry.toLongLong(&isPid);
+        if (!isPid) continue;
+        if (candidate != pid && ::getpgid(static_cast<pid_t>(candidate)) != static_cast<pid_t>(pid)) continue;
+        QFile status("/proc/" + entry + "/status");
+        if (!status.open(QIODevice::ReadOnly)) continue;
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) {
+                totalKB += line.mid(6).trimmed().split(' ').value(0).toDouble();
+                break;
+            }
+        }
+    }
+    return totalKB / 1024.0;
+#endif
+}
+
+double availableMemoryMB()
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (!::GlobalMemoryStatusEx(&status)) return -1.0;
+    return status.ullAvailPhys / (1024.0 * 1024.0);
+#else
+    QFile meminfo("/proc/meminfo");
+    if (!meminfo.open(QIODevice::ReadOnly)) return -1.0;
+    for (const QByteArray &line : meminfo.readAll().split('\n')) {
+        if (line.startsWith("MemAvailable:")) {
+            return line.mid(13).trimmed().split(' ').value(0).toDouble() / 1024.0;
+        }
+    }
+    return -1.0;
+#endif
+}
+
+}
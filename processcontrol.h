@@ -0,0 +1,40 @@
+#ifndef PROCESSCONTROL_H
+#define PROCESSCONTROL_H
+
+#include <QProcess>
+
+// 子进程树的启动/终止辅助
+namespace ProcessControl {
+
+// 在start()之前调用：Linux下让子进程成为新进程组的组长，便于整组发信号
+void prepareProcessGroup(QProcess &process);
+
+// 在start()之前调用：设置OMP/MKL/OpenBLAS的线程数。在已设置的环境（没设置时为系统环境）上修改
+void setThreadEnvironment(QProcess &process, int threads);
+
+// 优雅终止整个进程树：先SIGTERM（Windows下taskkill /T），
+// graceMs内没退出再SIGKILL（taskkill /F /T）。必须在process所在线程调用
+void terminateTree(QProcess &process, int graceMs = 5000);
+
+// 非阻塞版本：立即发SIGTERM，graceMs后进程还在就SIGKILL。用于GUI线程里管理的异步QProcess
+void terminateTreeAsync(QProcess *process, int graceMs = 5000);
+
+// 暂停/继续整个进程树，不丢失进度：Linux下对进程组发SIGSTOP/SIGCONT，
+// Windows下对树里每个进程调用NtSuspendProcess/NtResumeProcess
+bool suspendTree(qint64 pid);
+bool resumeTree(qint64 pid);
+
+// 调低/恢复整个进程树的CPU调度优先级（Linux下nice 19，Windows下IDLE_PRIORITY_CLASS）。
+// Linux下普通用户调低后无法调回，恢复会失败并返回false
+bool setTreeLowPriority(qint64 pid, bool low);
+
+// 进程树到目前为止的峰值内存（MB）。Linux下累加同一进程组各进程的VmHWM，
+// Windows下取该进程的PeakWorkingSetSize；进程已退出或无法读取时返回0
+double peakMemoryMB(qint64 pid);
+
+// 系统当前可用内存（MB）：Linux下为/proc/meminfo的MemAvailable，Windows下为可用物理内存；读不到时返回-1
+double availableMemoryMB();
+
+}
+
+#endif // PROCESSCONTROL_H
@@ -0,0 +1,51 @@
+#include "progresschannel.h"
+#include <QMutexLocker>
+
+void ProgressChannel::begin(const QString &phenotype)
+{
+    QMutexLocker locker(&mutex);
+    state = ProgressSnapshot();
+    state.phenotype = phenotype;
+    pendingEpochs.clear();
+    sequence.fetch_add(1, std::memory_order_release);
+}
+
+void ProgressChannel::setStage(const QString &stage)
+{
+    QMutexLocker locker(&mutex);
+    if (state.stage == stage) return;
+    state.stage = stage;
+    sequence.fetch_add(1, std::memory_order_release);
+}
+
+void ProgressChannel::setPercent(int percent)
+{
+    QMutexLocker locker(&mutex);
+    if (state.percent == percent) return;
+    state.percent = percent;
+    sequence.fetch_add(1, std::memory_order_release);
+}
+
+void ProgressChannel::publishEpoch(const EpochMetrics &metrics)
+{
+    QMutexLocker locker(&mutex);
+    state.epoch = metrics.epoch;
+    state.latest = metrics;
+    // 界面长时间不读（比如弹着模态框）时丢最旧的，内存有上限
+    if (pendingEpochs.size() >= kMaxPendingEpochs) pendingEpochs.removeFirst();
+    pendingEpochs.append(metrics);
+    sequence.fetch_add(1, std::memory_order_release);
+}
+
+bool ProgressChannel::consume(ProgressSnapshot *snapshot, QList<EpochMetrics> *epochs)
+{
+    if (sequence.load(std::memory_order_acquire) == consumedSequence) return false;
+    QMutexLocker locker(&mutex);
+    consumedSequence = sequence.load(std::memory_order_relaxed);
+    if (snapshot) *snapshot = state;
+    if (epochs) {
+        epochs->append(pendingEpochs);
+    }
+    pendingEpochs.clear();
+    return true;
+}
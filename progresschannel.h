@@ -0,0 +1,44 @@
+#ifndef PROGRESSCHANNEL_H
+#define PROGRESSCHANNEL_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include "metricparser.h"
+
+// 训练进度的一份完整快照
+struct ProgressSnapshot {
+    QString phenotype;
+    QString stage;       // "step1" / "step2"
+    int percent = 0;     // 整体进度0-100
+    int epoch = -1;      // 最近一个epoch
+    EpochMetrics latest; // 最近一个epoch的指标
+};
+
+// 工作线程到界面的进度通道：工作线程随时发布，界面用一个定时器按固定帧率读取。
+// 快照整体在锁内替换，读到的永远是一致的一份；序号是原子的，没有新内容时读取方不加锁。
+// epoch指标另外排队（有上限），帧率再低曲线也不会漏点。只允许一个读取方
+class ProgressChannel
+{
+public:
+    static constexpr int kMaxPendingEpochs = 10000;
+
+    // 工作线程调用
+    void begin(const QString &phenotype);
+    void setStage(const QString &stage);
+    void setPercent(int percent);
+    void publishEpoch(const EpochMetrics &metrics);
+
+    // 界面线程调用：自上次读取后有变化时返回true，并取走排队的epoch指标
+    bool consume(ProgressSnapshot *snapshot, QList<EpochMetrics> *epochs);
+
+private:
+    mutable QMutex mutex;
+    ProgressSnapshot state;
+    QList<EpochMetrics> pendingEpochs;
+    std::atomic<quint64> sequence{0};
+    quint64 consumedSequence = 0; // 只在读取方线程访问
+};
+
+#endif // PROGRESSCHANNEL_H
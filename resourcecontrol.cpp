@@ -0,0 +1,268 @@
+#include "resourcecontrol.h"
+#include "appconfig.h"
+#include "processcontrol.h"
+#include "logcategories.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char *const kGuiGroup = "menet-gui";
+const char *const kJobsGroup = "menet-jobs";
+
+bool writeControlFile(const QString &path, const QByteArray &value, QString *error = nullptr)
+{
+    QFile file(path);
+    // cgroup的控制文件不能用QSaveFile换成临时文件，直接写一次
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered) || file.write(value) != value.size()) {
+        if (error) *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+QByteArray readControlFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll().trimmed();
+}
+
+double memTotalMB()
+{
+    QFile meminfo("/proc/meminfo");
+    if (!meminfo.open(QIODevice::ReadOnly)) return 0.0;
+    for (const QByteArray &line : meminfo.readAll().split('\n')) {
+        if (line.startsWith("MemTotal:")) return line.mid(9).trimmed().split(' ').value(0).toDouble() / 1024.0;
+    }
+    return 0.0;
+}
+
+// "some avg10=1.23 avg60=... total=..."这样的行里取avg10
+double parseAvg10(const QByteArray &line)
+{
+    const int start = line.indexOf("avg10=");
+    if (start < 0) return qQNaN();
+    const int end = line.indexOf(' ', start);
+    bool ok = false;
+    const double value = line.mid(start + 6, end < 0 ? -1 : end - start - 6).toDouble(&ok);
+    return ok ? value : qQNaN();
+}
+
+} // namespace
+
+ResourceControl *ResourceControl::instance()
+{
+    static ResourceControl *control = new ResourceControl();
+    return control;
+}
+
+ResourceControl::ResourceControl()
+{
+    opts = configuredOptions();
+}
+
+ResourceControl::Options ResourceControl::configuredOptions()
+{
+    Options options;
+    options.enabled = AppConfig::boolValue("Resources", "Enabled", false);
+    options.memoryMaxMB = qMax(0.0, AppConfig::value("Resources", "MemoryMaxMB", "0").toDouble());
+    options.memoryMaxPercent = qBound(0, AppConfig::intValue("Resources", "MemoryMaxPercent", 90), 100);
+    options.cpuWeight = qBound(1, AppConfig::intValue("Resources", "CpuWeight", 50), 10000);
+    options.cpuMaxCores = qMax(0.0, AppConfig::value("Resources", "CpuMaxCores", "0").toDouble());
+    options.ioWeight = qBound(1, AppConfig::intValue("Resources", "IoWeight", 50), 10000);
+    options.nice = qBound(0, AppConfig::intValue("Resources", "Nice", 10), 19);
+    options.ioniceClass = qBound(0, AppConfig::intValue("Resources", "IoniceClass", 2), 3);
+    options.ioniceLevel = qBound(0, AppConfig::intValue("Resources", "IoniceLevel", 7), 7);
+    return options;
+}
+
+ResourceControl::Pressure ResourceControl::readPressure(const QString &dir)
+{
+    Pressure result;
+    result.source = dir;
+    const auto read = [&dir](const char *name, double *some, double *full) {
+        QFile file(dir + "/" + name);
+        if (!file.open(QIODevice::ReadOnly)) return false;
+        for (const QByteArray &line : file.readAll().split('\n')) {
+            if (line.startsWith("some ")) *some = parseAvg10(line);
+            else if (full && line.startsWith("full ")) *full = parseAvg10(line);
+        }
+        return true;
+    };
+    const bool cpu = read("cpu.pressure", &result.cpu, nullptr);
+    const bool memory = read("memory.pressure", &result.memory, &result.memoryFull);
+    const bool io = read("io.pressure", &result.io, nullptr);
+    result.valid = cpu || memory || io;
+    return result;
+}
+
+void ResourceControl::ensureSetup()
+{
+    if (setupDone) return;
+    setupDone = true;
+#if defined(Q_OS_LINUX)
+    // cgroup v2下/proc/self/cgroup只有一行"0::<路径>"
+    QString relative;
+    for (const QByteArray &line : readControlFile("/proc/self/cgroup").split('\n')) {
+        if (line.startsWith("0::")) relative = QString::fromUtf8(line.mid(3)).trimmed();
+    }
+    const QString mount = "/sys/fs/cgroup";
+    if (relative.isEmpty() || !QFile::exists(mount + "/cgroup.controllers")) {
+        reason = QCoreApplication::translate("ResourceControl", "cgroup v2 is not mounted");
+        return;
+    }
+    QString base = mount + (relative == "/" ? QString() : relative);
+    if (QFileInfo(base).fileName() == kGuiGroup) base = QFileInfo(base).path();
+    const QStringList available = QString::fromUtf8(readControlFile(base + "/cgroup.controllers")).split(' ', Qt::SkipEmptyParts);
+    QStringList controllers;
+    for (const char *name : {"cpu", "memory", "io"}) {
+        if (available.contains(name)) controllers << name;
+    }
+    if (controllers.isEmpty() || !QFileInfo(base + "/cgroup.subtree_control").isWritable()) {
+        reason = QCoreApplication::translate("ResourceControl", "cgroup %1 is not delegated to this user").arg(base);
+        return;
+    }
+    // 有进程的组不能再给子组开控制器：界面自己先挪到叶子组里（根组不受此限制）
+    QString error;
+    const QByteArray selfPid = QByteArray::number(QCoreApplication::applicationPid());
+    const QString guiGroup = base + "/" + kGuiGroup;
+    const bool moveSelf = relative != "/";
+    if (moveSelf && (!QDir().mkpath(guiGroup) || !writeControlFile(guiGroup + "/cgroup.procs", selfPid, &error))) {
+        reason = error.isEmpty() ? QCoreApplication::translate("ResourceControl", "cannot create %1").arg(guiGroup) : error;
+        return;
+    }
+    const auto enableControllers = [&controllers, &error](const QString &dir) {
+        for (const QString &name : controllers) {
+            if (!writeControlFile(dir + "/cgroup.subtree_control", "+" + name.toUtf8(), &error)) return false;
+        }
+        return true;
+    };
+    const QString jobs = base + "/" + kJobsGroup;
+    if (!enableControllers(base) || !QDir().mkpath(jobs) || !enableControllers(jobs)) {
+        // 组里还有别的进程（比如从终端会话直接启动）：把界面放回原处
+        if (moveSelf) {
+            writeControlFile(base + "/cgroup.procs", selfPid);
+            QDir().rmdir(guiGroup);
+        }
+        reason = error.isEmpty() ? QCoreApplication::translate("ResourceControl", "cannot create %1").arg(jobs) : error;
+        return;
+    }
+    // 上次退出时没删掉的空子组
+    for (const QString &stale : QDir(jobs).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) QDir(jobs).rmdir(stale);
+    jobsRoot = jobs;
+    qCInfo(lcWorker) << "[ResourceControl] cgroup v2 jobs root:" << jobsRoot << ", controllers:" << controllers;
+#else
+    reason = QCoreApplication::translate("ResourceControl", "cgroups are only available on Linux");
+#endif
+}
+
+QString ResourceControl::createGroup(const QString &kind, QString *error)
+{
+    const QString dir = jobsRoot + QString("/%1-%2-%3").arg(kind).arg(QCoreApplication::applicationPid()).arg(++serial);
+    if (!QDir().mkdir(dir)) {
+        if (error) *error = QCoreApplication::translate("ResourceControl", "cannot create %1").arg(dir);
+        return QString();
+    }
+    // 某个控制器没有委派时对应文件不存在，只写存在的
+    const auto set = [&dir](const char *name, const QByteArray &value) {
+        const QString path = dir + "/" + name;
+        QString writeError;
+        if (QFile::exists(path) && !writeControlFile(path, value, &writeError)) {
+            qCWarning(lcWorker) << "[ResourceControl] Failed to set" << writeError;
+        }
+    };
+    double memoryMB = opts.memoryMaxMB;
+    if (memoryMB <= 0.0 && opts.memoryMaxPercent > 0) memoryMB = memTotalMB() * opts.memoryMaxPercent / 100.0;
+    if (memoryMB > 0.0) {
+        set("memory.max", QByteArray::number(qint64(memoryMB * 1024.0 * 1024.0)));
+        // 超限时整个作业一起被杀，不留下半个进程树
+        set("memory.oom.group", "1");
+    }
+    set("cpu.weight", QByteArray::number(opts.cpuWeight));
+    if (opts.cpuMaxCores > 0.0) {
+        const qint64 period = 100000;
+        set("cpu.max", QByteArray::number(qint64(opts.cpuMaxCores * period)) + ' ' + QByteArray::number(period));
+    }
+    set("io.weight", "default " + QByteArray::number(opts.ioWeight));
+    return dir;
+}
+
+void ResourceControl::prepareProcess(QProcess &process, const QString &kind)
+{
+    if (!opts.enabled) {
+        ProcessControl::prepareProcessGroup(process);
+        return;
+    }
+#if defined(Q_OS_LINUX)
+    QString group;
+    {
+        QMutexLocker locker(&mutex);
+        ensureSetup();
+        QString error;
+        if (!jobsRoot.isEmpty()) group = createGroup(kind, &error);
+        if (!error.isEmpty()) qCWarning(lcWorker) << "[ResourceControl]" << error << ", falling back to nice/ionice";
+    }
+    const QByteArray procs = group.isEmpty() ? QByteArray() : QFile::encodeName(group + "/cgroup.procs");
+    // 回退值总是带上：组建好了也可能在fork之后写不进去（组被删、权限变了）
+    const int niceness = opts.nice;
+    const int ioprio = opts.ioniceClass > 0 ? (opts.ioniceClass << 13) | opts.ioniceLevel : 0;
+    // 与prepareProcessGroup一样在fork之后、exec之前执行，只用异步信号安全的系统调用。
+    // 在exec之前进组，作业再拉起的子进程也都在组里；进不了组时就地退回nice/ionice
+    process.setChildProcessModifier([procs, niceness, ioprio]() {
+        ::setpgid(0, 0);
+        bool joined = false;
+        if (!procs.isEmpty()) {
+            const int fd = ::open(procs.constData(), O_WRONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                joined = ::write(fd, "0", 1) == 1;
+                ::close(fd);
+            }
+        }
+        if (joined) return;
+        if (niceness != 0) ::setpriority(PRIO_PROCESS, 0, niceness);
+        if (ioprio != 0) ::syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS */, 0, ioprio);
+    });
+    if (!group.isEmpty()) {
+        // 进程对象销毁时子进程已经退出，组空了才能删
+        QObject::connect(&process, &QObject::destroyed, [group]() { QDir().rmdir(group); });
+    }
+#else
+    Q_UNUSED(kind);
+    ProcessControl::prepareProcessGroup(process);
+#endif
+}
+
+bool ResourceControl::cgroupsAvailable()
+{
+    QMutexLocker locker(&mutex);
+    ensureSetup();
+    return !jobsRoot.isEmpty();
+}
+
+QString ResourceControl::unavailableReason()
+{
+    QMutexLocker locker(&mutex);
+    ensureSetup();
+    return reason;
+}
+
+ResourceControl::Pressure ResourceControl::pressure()
+{
+    QString dir;
+    {
+        QMutexLocker locker(&mutex);
+        ensureSetup();
+        dir = jobsRoot.isEmpty() ? QString("/proc/pressure") : jobsRoot;
+    }
+    return readPressure(dir);
+}
@@ -0,0 +1,67 @@
+#ifndef RESOURCECONTROL_H
+#define RESOURCECONTROL_H
+
+#include <QMutex>
+#include <QProcess>
+#include <QString>
+#include <QtNumeric>
+
+// 子进程的资源限制（config.ini的[Resources]节，默认关闭）。Linux下用cgroup v2：
+// 界面进程所在的组需要是委派给当前用户的（如systemd-run --user --scope -p Delegate=yes启动），
+// 界面自己移到其中的menet-gui叶子组，每个子进程在exec之前进入menet-jobs下自己的子组，
+// 写memory.max（超出只杀这个作业，不拖垮界面）、cpu.weight/cpu.max和io.weight。
+// cgroup不可用时退回nice/ionice。作业父组的PSI（压力）读回来给状态栏显示
+class ResourceControl
+{
+public:
+    struct Options {
+        bool enabled = false;
+        double memoryMaxMB = 0.0;   // 每个作业的memory.max，0表示按memoryMaxPercent
+        int memoryMaxPercent = 90;  // 占物理内存的百分比，0表示不限
+        int cpuWeight = 50;         // cpu.weight（1-10000），界面所在组为默认的100
+        double cpuMaxCores = 0.0;   // cpu.max折算成核数，0表示不限
+        int ioWeight = 50;          // io.weight（1-10000）
+        int nice = 10;              // 以下为cgroup不可用时的回退
+        int ioniceClass = 2;        // 1实时 2尽力而为 3空闲
+        int ioniceLevel = 7;        // 0-7，越大越低
+    };
+
+    // 过去10秒内有任务因CPU/内存/IO而等待的时间占比（%），读不到为NaN
+    struct Pressure {
+        bool valid = false;
+        double cpu = qQNaN();
+        double memory = qQNaN();
+        double memoryFull = qQNaN(); // 所有任务同时在等内存
+        double io = qQNaN();
+        QString source;              // 读取的目录
+    };
+
+    static ResourceControl *instance();
+    static Options configuredOptions();
+    // 读dir下的cpu.pressure/memory.pressure/io.pressure（/proc/pressure的格式相同）
+    static Pressure readPressure(const QString &dir);
+
+    bool isEnabled() const { return opts.enabled; }
+    // 代替ProcessControl::prepareProcessGroup在start()之前调用，kind用于子组命名（train/predict/...）。
+    // 关闭时与prepareProcessGroup相同；子组在process销毁时删除。可以在任意线程调用
+    void prepareProcess(QProcess &process, const QString &kind);
+    // cgroup是否可用，不可用的原因（已回退到nice/ionice）
+    bool cgroupsAvailable();
+    QString unavailableReason();
+    // cgroup可用时为所有作业的父组，否则为整机
+    Pressure pressure();
+
+private:
+    ResourceControl();
+    void ensureSetup();   // 第一次用时建组，调用时持有mutex
+    QString createGroup(const QString &kind, QString *error);
+
+    Options opts;
+    QMutex mutex;
+    bool setupDone = false;
+    QString jobsRoot;     // 空表示cgroup不可用
+    QString reason;
+    int serial = 0;
+};
+
+#endif // RESOURCECONTROL_H
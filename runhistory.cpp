@@ -0,0 +1,223 @@
+#include "runhistory.h"
+#include "logcategories.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QJsonDocument>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+static const int kSchemaVersion = 3;
+
+RunHistory *RunHistory::instance()
+{
+    // 首次调用必须在GUI线程，QSqlDatabase连接只能在创建它的线程里使用
+    static RunHistory *history = new RunHistory();
+    return history;
+}
+
+RunHistory::RunHistory() : connectionName(QStringLiteral("run_history"))
+{
+    const QString menetDir = QDir::currentPath() + "/MENET";
+    QDir().mkpath(menetDir);
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(menetDir + "/history.db");
+    if (!db.open()) {
+        qCWarning(lcData) << "[RunHistory] Unable to open history.db:" << db.lastError().text();
+        return;
+    }
+    opened = ensureSchema();
+}
+
+RunHistory::~RunHistory()
+{
+    {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        if (db.isOpen()) db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+bool RunHistory::ensureSchema()
+{
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    QSqlQuery q(db);
+    // WAL：写记录时不阻塞历史面板的查询
+    q.exec("PRAGMA journal_mode=WAL");
+    q.exec("PRAGMA synchronous=NORMAL");
+    q.exec("PRAGMA user_version");
+    const int version = q.next() ? q.value(0).toInt() : 0;
+    if (version >= kSchemaVersion) return true;
+    QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS runs ("
+        " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " kind TEXT NOT NULL,"
+        " phenotype TEXT NOT NULL,"
+        " params TEXT,"
+        " param_hash TEXT,"
+        " started_at INTEGER NOT NULL,"   // 秒级时间戳，便于按时间范围走索引
+        " ended_at INTEGER,"
+        " step1_seconds REAL,"
+        " step2_seconds REAL,"
+        " total_seconds REAL,"
+        " epochs INTEGER,"
+        " epochs_per_sec REAL,"
+        " train_r2 REAL,"
+        " val_r2 REAL,"
+        " status TEXT,"
+        " peak_mem_mb REAL,"
+        " message TEXT,"
+        " data_mb REAL,"
+        " log_path TEXT)",
+        "CREATE INDEX IF NOT EXISTS idx_runs_phenotype ON runs(phenotype, kind, started_at)",
+        "CREATE INDEX IF NOT EXISTS idx_runs_started ON runs(started_at)",
+        "CREATE INDEX IF NOT EXISTS idx_runs_param_hash ON runs(param_hash, started_at)",
+    };
+    // 版本1的库缺少data_mb列，版本2以前缺少log_path列
+    if (version == 1) statements << "ALTER TABLE runs ADD COLUMN data_mb REAL";
+    if (version >= 1 && version < 3) statements << "ALTER TABLE runs ADD COLUMN log_path TEXT";
+    statements << QString("PRAGMA user_version=%1").arg(kSchemaVersion);
+    db.transaction();
+    for (const QString &sql : statements) {
+        if (!q.exec(sql)) {
+            qCWarning(lcData) << "[RunHistory] Schema statement failed:" << q.lastError().text() << sql;
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+QString RunHistory::hashParams(const QJsonObject &params)
+{
+    // QJsonObject按键有序，Compact序列化结果稳定
+    const QByteArray json = QJsonDocument(params).toJson(QJsonDocument::Compact);
+    return QString::fromLatin1(QCryptographicHash::hash(json, QCryptographicHash::Sha1).toHex().left(16));
+}
+
+static QVariant nullableReal(double value)
+{
+    return qIsNaN(value) ? QVariant() : QVariant(value);
+}
+
+qint64 RunHistory::record(const Run &run)
+{
+    if (!opened) return 0;
+    QSqlQuery q(QSqlDatabase::database(connectionName));
+    q.prepare("INSERT INTO runs (kind, phenotype, params, param_hash, started_at, ended_at, step1_seconds,"
+              " step2_seconds, total_seconds, epochs, epochs_per_sec, train_r2, val_r2, status, peak_mem_mb, message, data_mb,"
+              " log_path) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    const QDateTime ended = run.endedAt.isValid() ? run.endedAt : QDateTime::currentDateTime();
+    const QDateTime started = run.startedAt.isValid() ? run.startedAt : ended.addMSecs(qint64(-run.totalSeconds * 1000));
+    double epochsPerSecond = run.epochsPerSecond;
+    if (epochsPerSecond <= 0.0 && run.epochs > 0 && run.step2Seconds > 0.0) epochsPerSecond = run.epochs / run.step2Seconds;
+    q.addBindValue(run.kind);
+    q.addBindValue(run.phenotype);
+    q.addBindValue(QString::fromUtf8(QJsonDocument(run.params).toJson(QJsonDocument::Compact)));
+    q.addBindValue(run.paramHash.isEmpty() ? hashParams(run.params) : run.paramHash);
+    q.addBindValue(started.toSecsSinceEpoch());
+    q.addBindValue(ended.toSecsSinceEpoch());
+    q.addBindValue(run.step1Seconds);
+    q.addBindValue(run.step2Seconds);
+    q.addBindValue(run.totalSeconds);
+    q.addBindValue(run.epochs);
+    q.addBindValue(epochsPerSecond);
+    q.addBindValue(nullableReal(run.trainR2));
+    q.addBindValue(nullableReal(run.valR2));
+    q.addBindValue(run.status);
+    q.addBindValue(run.peakMemoryMB);
+    q.addBindValue(run.message);
+    q.addBindValue(run.dataMB);
+    q.addBindValue(run.logPath);
+    if (!q.exec()) {
+        qCWarning(lcData) << "[RunHistory] Insert failed:" << q.lastError().text();
+        return 0;
+    }
+    return q.lastInsertId().toLongLong();
+}
+
+// 把过滤条件拼成WHERE子句，值一律走绑定参数
+static QString whereClause(const RunHistory::Filter &filter, QVariantList &binds)
+{
+    QStringList conditions;
+    if (!filter.phenotype.isEmpty()) { conditions << "phenotype = ?"; binds << filter.phenotype; }
+    if (!filter.kind.isEmpty()) { conditions << "kind = ?"; binds << filter.kind; }
+    if (filter.from.isValid()) { conditions << "started_at >= ?"; binds << filter.from.toSecsSinceEpoch(); }
+    if (filter.to.isValid()) { conditions << "started_at <= ?"; binds << filter.to.toSecsSinceEpoch(); }
+    if (!filter.paramHash.isEmpty()) { conditions << "param_hash = ?"; binds << filter.paramHash; }
+    return conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND ");
+}
+
+QList<RunHistory::Run> RunHistory::query(const Filter &filter) const
+{
+    QList<Run> runs;
+    if (!opened) return runs;
+    QVariantList binds;
+    QSqlQuery q(QSqlDatabase::database(connectionName));
+    q.setForwardOnly(true);
+    q.prepare("SELECT id, kind, phenotype, params, param_hash, started_at, ended_at, step1_seconds, step2_seconds,"
+              " total_seconds, epochs, epochs_per_sec, train_r2, val_r2, status, peak_mem_mb, message, data_mb, log_path FROM runs"
+              + whereClause(filter, binds) + QString(" ORDER BY started_at DESC LIMIT %1").arg(qMax(1, filter.limit)));
+    for (const QVariant &v : binds) q.addBindValue(v);
+    if (!q.exec()) {
+        qCWarning(lcData) << "[RunHistory] Query failed:" << q.lastError().text();
+        return runs;
+    }
+    while (q.next()) {
+        Run run;
+        run.id = q.value(0).toLongLong();
+        run.kind = q.value(1).toString();
+        run.phenotype = q.value(2).toString();
+        run.params = QJsonDocument::fromJson(q.value(3).toString().toUtf8()).object();
+        run.paramHash = q.value(4).toString();
+        run.startedAt = QDateTime::fromSecsSinceEpoch(q.value(5).toLongLong());
+        run.endedAt = QDateTime::fromSecsSinceEpoch(q.value(6).toLongLong());
+        run.step1Seconds = q.value(7).toDouble();
+        run.step2Seconds = q.value(8).toDouble();
+        run.totalSeconds = q.value(9).toDouble();
+        run.epochs = q.value(10).toInt();
+        run.epochsPerSecond = q.value(11).toDouble();
+        run.trainR2 = q.value(12).isNull() ? qQNaN() : q.value(12).toDouble();
+        run.valR2 = q.value(13).isNull() ? qQNaN() : q.value(13).toDouble();
+        run.status = q.value(14).toString();
+        run.peakMemoryMB = q.value(15).toDouble();
+        run.message = q.value(16).toString();
+        run.dataMB = q.value(17).toDouble();
+        run.logPath = q.value(18).toString();
+        runs << run;
+    }
+    return runs;
+}
+
+RunHistory::Stats RunHistory::stats(const Filter &filter) const
+{
+    Stats result;
+    if (!opened) return result;
+    QVariantList binds;
+    QSqlQuery q(QSqlDatabase::database(connectionName));
+    q.prepare("SELECT COUNT(*), SUM(status IN ('success','early_stopped')), AVG(total_seconds), MIN(total_seconds),"
+              " MAX(total_seconds), AVG(NULLIF(epochs_per_sec, 0)), MAX(val_r2),"
+              " AVG(CASE WHEN data_mb > 0 AND step1_seconds > 0 THEN step1_seconds / data_mb END) FROM runs" + whereClause(filter, binds));
+    for (const QVariant &v : binds) q.addBindValue(v);
+    if (!q.exec() || !q.next()) return result;
+    result.count = q.value(0).toInt();
+    result.successCount = q.value(1).toInt();
+    result.avgSeconds = q.value(2).toDouble();
+    result.minSeconds = q.value(3).toDouble();
+    result.maxSeconds = q.value(4).toDouble();
+    result.avgEpochsPerSecond = q.value(5).toDouble();
+    result.bestValR2 = q.value(6).isNull() ? qQNaN() : q.value(6).toDouble();
+    result.avgStep1SecondsPerMB = q.value(7).toDouble();
+    return result;
+}
+
+QStringList RunHistory::phenotypes() const
+{
+    QStringList list;
+    if (!opened) return list;
+    QSqlQuery q(QSqlDatabase::database(connectionName));
+    if (!q.exec("SELECT DISTINCT phenotype FROM runs ORDER BY phenotype")) return list;
+    while (q.next()) list << q.value(0).toString();
+    return list;
+}
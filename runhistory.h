@@ -0,0 +1,79 @@
+#ifndef RUNHISTORY_H
+#define RUNHISTORY_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QtNumeric>
+
+// 本地运行历史库（SQLite，MENET/history.db）：每次训练、迁移学习、预测一条记录，
+// 按表型、开始时间、参数哈希建索引，供历史面板和耗时估计查询
+class RunHistory
+{
+public:
+    struct Run {
+        qint64 id = 0;
+        QString kind;               // "train" / "transfer" / "predict" / "crossval"
+        QString phenotype;
+        QJsonObject params;
+        QString paramHash;          // 为空时由record()根据params计算
+        QDateTime startedAt;
+        QDateTime endedAt;
+        double step1Seconds = 0.0;  // 训练的第一步；其他任务为0
+        double step2Seconds = 0.0;  // 训练的第二步、迁移学习或预测本身
+        double totalSeconds = 0.0;
+        int epochs = 0;
+        double epochsPerSecond = 0.0;
+        double trainR2 = qQNaN();
+        double valR2 = qQNaN();
+        QString status;             // "success" / "early_stopped" / "failed" / "cancelled"
+        double peakMemoryMB = 0.0;
+        double dataMB = 0.0;        // 输入数据量，用于按数据量估计第一步耗时
+        QString message;
+        QString logPath;            // MENET/logs下存档的训练日志（旁边有.idx索引），没有存档为空
+    };
+
+    struct Filter {
+        QString phenotype;          // 为空表示全部
+        QString kind;
+        QDateTime from;             // 无效表示不限
+        QDateTime to;
+        QString paramHash;
+        int limit = 500;
+    };
+
+    struct Stats {
+        int count = 0;
+        int successCount = 0;
+        double avgSeconds = 0.0;
+        double minSeconds = 0.0;
+        double maxSeconds = 0.0;
+        double avgEpochsPerSecond = 0.0;
+        double avgStep1SecondsPerMB = 0.0;
+        double bestValR2 = qQNaN();
+    };
+
+    // 同一进程内共享一个连接
+    static RunHistory *instance();
+
+    bool isOpen() const { return opened; }
+    qint64 record(const Run &run);
+    QList<Run> query(const Filter &filter) const;
+    Stats stats(const Filter &filter) const;
+    QStringList phenotypes() const;
+
+    // 参数对象按键排序后哈希，键顺序不同的同一组参数得到同一个值
+    static QString hashParams(const QJsonObject &params);
+
+private:
+    RunHistory();
+    ~RunHistory();
+    bool ensureSchema();
+
+    QString connectionName;
+    bool opened = false;
+};
+
+#endif // RUNHISTORY_H
@@ -8,6 +8,7 @@
 #include <QGroupBox>
 #include <QFormLayout>
 #include <QAbstractSpinBox>
+#include <QCheckBox>
 SavedSettingDialog::SavedSettingDialog(QWidget *parent) : QDialog(parent) {
     setWindowTitle(tr("Set Model Parameters"));
     labelTitle = new QLabel(this);
@@ -59,6 +60,25 @@ SavedSettingDialog::SavedSettingDialog(QWidget *parent) : QDialog(parent) {
     spinMmnetWd->setDecimals(8);
     spinMmnetWd->setButtonSymbols(QAbstractSpinBox::NoButtons);
     spinMmnetWd->setKeyboardTracking(true);
+    spinThreads = new QSpinBox(this);
+    spinThreads->setRange(0, 1024);
+    spinThreads->setSpecialValueText(tr("Auto"));
+    spinThreads->setButtonSymbols(QAbstractSpinBox::NoButtons);
+    spinThreads->setKeyboardTracking(true);
+    labelTuning = new QLabel(this);
+    labelTuning->setWordWrap(true);
+    labelTuning->setVisible(false);
+    // Early stopping
+    checkEarlyStop = new QCheckBox(tr("Stop when val_R2 stops improving"), this);
+    spinPatience = new QSpinBox(this);
+    spinPatience->setRange(1, 10000);
+    spinPatience->setButtonSymbols(QAbstractSpinBox::NoButtons);
+    spinPatience->setKeyboardTracking(true);
+    spinMinDelta = new MyDoubleSpinBox(this);
+    spinMinDelta->setRange(0, 1);
+    spinMinDelta->setDecimals(6);
+    spinMinDelta->setButtonSymbols(QAbstractSpinBox::NoButtons);
+    spinMinDelta->setKeyboardTracking(true);
     // 布局
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
     mainLayout->addWidget(labelTitle);
@@ -80,8 +100,21 @@ SavedSettingDialog::SavedSettingDialog(QWidget *parent) : QDialog(parent) {
     mmnetLayout->addRow(tr("p4:"), spinMmnetP4);
     mmnetLayout->addRow(tr("Saved (Epochs):"), spinMmnetSaved);
     mmnetLayout->addRow(tr("Weight Decay (wd):"), spinMmnetWd);
+    mmnetLayout->addRow(tr("Threads:"), spinThreads);
+    mmnetLayout->addRow(labelTuning);
     mmnetGroup->setLayout(mmnetLayout);
     mainLayout->addWidget(mmnetGroup);
+    // Early stopping部分
+    QGroupBox *earlyStopGroup = new QGroupBox(tr("Early Stopping"), this);
+    QFormLayout *earlyStopLayout = new QFormLayout();
+    earlyStopLayout->addRow(checkEarlyStop);
+    earlyStopLayout->addRow(tr("Patience (Epochs):"), spinPatience);
+    earlyStopLayout->addRow(tr("Min Delta (val_R2):"), spinMinDelta);
+    earlyStopGroup->setLayout(earlyStopLayout);
+    mainLayout->addWidget(earlyStopGroup);
+    connect(checkEarlyStop, &QCheckBox::toggled, spinPatience, &QWidget::setEnabled);
+    connect(checkEarlyStop, &QCheckBox::toggled, spinMinDelta, &QWidget::setEnabled);
+    setEarlyStopValues(false, 20, 0.001);
     // 按钮
     btnOk = new QPushButton(tr("OK"), this);
     btnCancel = new QPushButton(tr("Cancel"), this);
@@ -124,4 +157,26 @@ void SavedSettingDialog::getMmnetValues(int &batchSize, double &p1, double &p2,
     p4 = spinMmnetP4->value();
     saved = spinMmnetSaved->value();
     wd = spinMmnetWd->value();
-} 
\ No newline at end of file
+}
+void SavedSettingDialog::setEarlyStopValues(bool enabled, int patience, double minDelta) {
+    checkEarlyStop->setChecked(enabled);
+    spinPatience->setValue(patience);
+    spinMinDelta->setValue(minDelta);
+    spinPatience->setEnabled(enabled);
+    spinMinDelta->setEnabled(enabled);
+}
+void SavedSettingDialog::getEarlyStopValues(bool &enabled, int &patience, double &minDelta) const {
+    enabled = checkEarlyStop->isChecked();
+    patience = spinPatience->value();
+    minDelta = spinMinDelta->value();
+}
+void SavedSettingDialog::setThreadValue(int threads) {
+    spinThreads->setValue(threads);
+}
+int SavedSettingDialog::threadValue() const {
+    return spinThreads->value();
+}
+void SavedSettingDialog::setTuningNote(const QString &note) {
+    labelTuning->setText(note);
+    labelTuning->setVisible(!note.isEmpty());
+}
@@ -7,6 +7,7 @@
 class QSpinBox;
 class QLabel;
 class QPushButton;
+class QCheckBox;
 
 class MyDoubleSpinBox : public QDoubleSpinBox {
     Q_OBJECT
@@ -30,6 +31,11 @@ public:
     void setMmnetValues(int batchSize, double p1, double p2, double p3, double p4, int saved, double wd);
     void getEsnValues(int &batchSize, double &p, int &saved) const;
     void getMmnetValues(int &batchSize, double &p1, double &p2, double &p3, double &p4, int &saved, double &wd) const;
+    void setEarlyStopValues(bool enabled, int patience, double minDelta);
+    void getEarlyStopValues(bool &enabled, int &patience, double &minDelta) const;
+    void setThreadValue(int threads); // 0表示由子进程自己决定
+    int threadValue() const;
+    void setTuningNote(const QString &note); // 本机校准结果的说明，空则隐藏
 private:
     QLabel *labelTitle;
     // ESN
@@ -44,6 +50,12 @@ private:
     MyDoubleSpinBox *spinMmnetP4;
     QSpinBox *spinMmnetSaved;
     MyDoubleSpinBox *spinMmnetWd;
+    QSpinBox *spinThreads;
+    QLabel *labelTuning;
+    // Early stopping
+    QCheckBox *checkEarlyStop;
+    QSpinBox *spinPatience;
+    MyDoubleSpinBox *spinMinDelta;
     QPushButton *btnOk;
     QPushButton *btnCancel;
 };
@@ -0,0 +1,1176 @@
+#include "spreadsheetconverter.h"
+#include "logcategories.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QLocale>
+#include <QMap>
+#include <QPair>
+#include <QSaveFile>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace SpreadsheetConverter {
+
+namespace {
+
+using Sink = std::function<bool(const char *data, qsizetype size)>;
+
+quint16 le16(const char *p) { return qFromLittleEndian<quint16>(p); }
+quint32 le32(const char *p) { return qFromLittleEndian<quint32>(p); }
+
+// 整数按整数写，避免1000000变成1e+06，样本ID才能和基因数据对上
+QString formatNumber(double value)
+{
+    if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 1e15) {
+        return QString::number(qint64(value));
+    }
+    return QString::number(value, 'g', QLocale::FloatingPointShortest);
+}
+
+// ---------------- csv输出 ----------------
+
+class CsvWriter
+{
+public:
+    explicit CsvWriter(const QString &target) : out(target) {}
+
+    bool open(QString *error)
+    {
+        if (out.open(QIODevice::WriteOnly)) return true;
+        if (error) *error = out.errorString();
+        return false;
+    }
+
+    // 空行跳过；行尾的空单元格去掉后再按表头补齐列数
+    void writeRow(QStringList cells)
+    {
+        while (!cells.isEmpty() && cells.last().isEmpty()) cells.removeLast();
+        if (cells.isEmpty()) return;
+        if (rows == 0) columns = cells.size();
+        while (cells.size() < columns) cells << QString();
+        QString line;
+        for (int i = 0; i < cells.size(); ++i) {
+            if (i > 0) line += QLatin1Char(',');
+            line += quoted(cells.at(i));
+        }
+        line += QLatin1Char('\n');
+        buffer += line.toUtf8();
+        ++rows;
+        if (buffer.size() >= 1024 * 1024) flush();
+    }
+
+    bool commit(QString *error)
+    {
+        flush();
+        if (failed || !out.commit()) {
+            if (error) *error = out.errorString();
+            out.cancelWriting();
+            return false;
+        }
+        return true;
+    }
+
+    void cancel() { out.cancelWriting(); }
+    int rowCount() const { return rows; }
+
+private:
+    QSaveFile out;
+    QByteArray buffer;
+    int rows = 0;
+    int columns = 0;
+    bool failed = false;
+
+    static QString quoted(const QString &cell)
+    {
+        if (!cell.contains(QLatin1Char(',')) && !cell.contains(QLatin1Char('"'))
+            && !cell.contains(QLatin1Char('\n')) && !cell.contains(QLatin1Char('\r'))) {
+            return cell;
+        }
+        QString escaped = cell;
+        escaped.replace(QLatin1String("\""), QLatin1String("\"\""));
+        return QLatin1Char('"') + escaped + QLatin1Char('"');
+    }
+
+    void flush()
+    {
+        if (!buffer.isEmpty() && out.write(buffer) != buffer.size()) failed = true;
+        buffer.clear();
+    }
+};
+
+// ---------------- deflate解码 ----------------
+
+// 原始deflate流（RFC 1951）的解码，按规范哈夫曼码逐位解码（同zlib自带的puff.c）。
+// 输出每攒够256KB交给sink一次，只保留最近32KB作为回溯窗口
+class Inflater
+{
+public:
+    Inflater(QIODevice *in, qint64 compressedSize, const Sink &sink) : in(in), remaining(compressedSize), sink(sink) {}
+
+    bool run(QString *error)
+    {
+        int last = 0;
+        do {
+            last = bits(1);
+            const int type = bits(2);
+            bool ok = false;
+            if (type == 0) ok = stored();
+            else if (type == 1) ok = codes(fixedTables().first, fixedTables().second);
+            else if (type == 2) ok = dynamic();
+            if (!ok || eof || sinkFailed) {
+                if (error) *error = sinkFailed ? QString("Malformed sheet data") : QString("Corrupt compressed data");
+                return false;
+            }
+        } while (!last);
+        if (!flush()) {
+            if (error) *error = QString("Malformed sheet data");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Huffman {
+        quint16 count[16];
+        quint16 symbol[288];
+    };
+
+    static constexpr int Window = 32 * 1024;
+    static constexpr int FlushSize = 256 * 1024;
+
+    QIODevice *in;
+    qint64 remaining;
+    Sink sink;
+    QByteArray inBuf;
+    int inPos = 0;
+    quint32 bitBuf = 0;
+    int bitCnt = 0;
+    bool eof = false;        // 压缩数据提前结束
+    bool sinkFailed = false;
+    QByteArray out;          // 前delivered字节已交给sink，只作回溯窗口
+    qsizetype delivered = 0;
+
+    int nextByte()
+    {
+        if (inPos >= inBuf.size()) {
+            inBuf = remaining > 0 ? in->read(qMin<qint64>(remaining, 64 * 1024)) : QByteArray();
+            if (inBuf.isEmpty()) {
+                eof = true;
+                return 0;
+            }
+            remaining -= inBuf.size();
+            inPos = 0;
+        }
+        return quint8(inBuf.at(inPos++));
+    }
+
+    int bits(int need)
+    {
+        quint32 value = bitBuf;
+        while (bitCnt < need) {
+            value |= quint32(nextByte()) << bitCnt;
+            bitCnt += 8;
+        }
+        bitBuf = value >> need;
+        bitCnt -= need;
+        return int(value & ((1u << need) - 1));
+    }
+
+    bool flush()
+    {
+        if (out.size() > delivered && !sink(out.constData() + delivered, out.size() - delivered)) {
+            sinkFailed = true;
+            return false;
+        }
+        if (out.size() > Window) out.remove(0, out.size() - Window);
+        delivered = out.size();
+        return true;
+    }
+
+    int decode(const Huffman &h)
+    {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= bits(1);
+            const int count = h.count[len];
+            if (code - count < first) return h.symbol[index + (code - first)];
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    // 返回0表示完整的码表，>0表示不完整，<0表示超额
+    static int construct(Huffman &h, const quint16 *length, int n)
+    {
+        std::memset(h.count, 0, sizeof(h.count));
+        for (int symbol = 0; symbol < n; ++symbol) h.count[length[symbol]]++;
+        if (h.count[0] == n) return 0;
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left <<= 1;
+            left -= h.count[len];
+            if (left < 0) return left;
+        }
+        quint16 offs[16];
+        offs[1] = 0;
+        for (int len = 1; len < 15; ++len) offs[len + 1] = offs[len] + h.count[len];
+        for (int symbol = 0; symbol < n; ++symbol) {
+            if (length[symbol] != 0) h.symbol[offs[length[symbol]]++] = quint16(symbol);
+        }
+        return left;
+    }
+
+    static const QPair<Huffman, Huffman> &fixedTables()
+    {
+        static const QPair<Huffman, Huffman> tables = []() {
+            QPair<Huffman, Huffman> t;
+            quint16 lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; ++symbol) lengths[symbol] = 8;
+            for (; symbol < 256; ++symbol) lengths[symbol] = 9;
+            for (; symbol < 280; ++symbol) lengths[symbol] = 7;
+            for (; symbol < 288; ++symbol) lengths[symbol] = 8;
+            construct(t.first, lengths, 288);
+            for (symbol = 0; symbol < 30; ++symbol) lengths[symbol] = 5;
+            construct(t.second, lengths, 30);
+            return t;
+        }();
+        return tables;
+    }
+
+    bool stored()
+    {
+        // 丢掉当前字节剩下的位，按字节对齐
+        bitBuf = 0;
+        bitCnt = 0;
+        int len = nextByte();
+        len |= nextByte() << 8;
+        int nlen = nextByte();
+        nlen |= nextByte() << 8;
+        if (eof || len != (~nlen & 0xffff)) return false;
+        while (len-- > 0) out.append(char(nextByte()));
+        return !eof && flush();
+    }
+
+    bool codes(const Huffman &lencode, const Huffman &distcode)
+    {
+        static const quint16 lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                               35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const quint16 lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const quint16 distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                             257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                             8193, 12289, 16385, 24577};
+        static const quint16 distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                              7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        for (;;) {
+            int symbol = decode(lencode);
+            if (eof || symbol < 0) return false;
+            if (symbol < 256) {
+                out.append(char(symbol));
+            } else if (symbol == 256) {
+                return true;
+            } else {
+                symbol -= 257;
+                if (symbol >= 29) return false;
+                const int len = lengthBase[symbol] + bits(lengthExtra[symbol]);
+                const int distSymbol = decode(distcode);
+                if (distSymbol < 0 || distSymbol >= 30) return false;
+                const int dist = distBase[distSymbol] + bits(distExtra[distSymbol]);
+                if (dist > out.size()) return false;
+                // 源和目标可能重叠，逐字节复制
+                const qsizetype from = out.size() - dist;
+                for (int i = 0; i < len; ++i) out.append(out.at(from + i));
+            }
+            if (out.size() - delivered >= FlushSize && !flush()) return false;
+        }
+    }
+
+    bool dynamic()
+    {
+        static const quint8 order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        quint16 lengths[320];
+        const int nlen = bits(5) + 257;
+        const int ndist = bits(5) + 1;
+        const int ncode = bits(4) + 4;
+        if (nlen > 286 || ndist > 30) return false;
+        int index = 0;
+        for (; index < ncode; ++index) lengths[order[index]] = quint16(bits(3));
+        for (; index < 19; ++index) lengths[order[index]] = 0;
+        Huffman lencode, distcode;
+        if (construct(lencode, lengths, 19) != 0) return false;
+        index = 0;
+        while (index < nlen + ndist) {
+            const int symbol = decode(lencode);
+            if (eof || symbol < 0) return false;
+            if (symbol < 16) {
+                lengths[index++] = quint16(symbol);
+                continue;
+            }
+            quint16 len = 0;
+            int repeat = 0;
+            if (symbol == 16) {
+                if (index == 0) return false;
+                len = lengths[index - 1];
+                repeat = 3 + bits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + bits(3);
+            } else {
+                repeat = 11 + bits(7);
+            }
+            if (index + repeat > nlen + ndist) return false;
+            while (repeat-- > 0) lengths[index++] = len;
+        }
+        if (lengths[256] == 0) return false;
+        int err = construct(lencode, lengths, nlen);
+        if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1)) return false;
+        err = construct(distcode, lengths + nlen, ndist);
+        if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1)) return false;
+        return codes(lencode, distcode);
+    }
+};
+
+// ---------------- zip ----------------
+
+class ZipArchive
+{
+public:
+    bool open(const QString &path, QString *error)
+    {
+        file.setFileName(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            if (error) *error = file.errorString();
+            return false;
+        }
+        // 中央目录结尾记录在文件最后22字节加最多64KB注释之内
+        const qint64 size = file.size();
+        const qint64 tailSize = qMin<qint64>(size, 22 + 65535);
+        file.seek(size - tailSize);
+        const QByteArray tail = file.read(tailSize);
+        qsizetype eocd = -1;
+        for (qsizetype i = tail.size() - 22; i >= 0; --i) {
+            if (le32(tail.constData() + i) == 0x06054b50) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd < 0) {
+            if (error) *error = QString("Not a valid .xlsx file (zip directory not found)");
+            return false;
+        }
+        const quint32 cdSize = le32(tail.constData() + eocd + 12);
+        const quint32 cdOffset = le32(tail.constData() + eocd + 16);
+        if (cdOffset == 0xFFFFFFFFu || qint64(cdOffset) + cdSize > size) {
+            if (error) *error = QString("Unsupported .xlsx file (zip64 or truncated)");
+            return false;
+        }
+        file.seek(cdOffset);
+        const QByteArray cd = file.read(cdSize);
+        qsizetype pos = 0;
+        while (pos + 46 <= cd.size() && le32(cd.constData() + pos) == 0x02014b50) {
+            const char *p = cd.constData() + pos;
+            Entry entry;
+            entry.flags = le16(p + 8);
+            entry.method = le16(p + 10);
+            entry.compressedSize = le32(p + 20);
+            entry.localOffset = le32(p + 42);
+            const int nameLen = le16(p + 28);
+            const int extraLen = le16(p + 30);
+            const int commentLen = le16(p + 32);
+            if (pos + 46 + nameLen > cd.size()) break;
+            entries.insert(QString::fromUtf8(p + 46, nameLen), entry);
+            pos += 46 + nameLen + extraLen + commentLen;
+        }
+        return true;
+    }
+
+    bool contains(const QString &name) const { return entries.contains(name); }
+
+    // 解压一个成员，数据分块交给sink
+    bool read(const QString &name, const Sink &sink, QString *error)
+    {
+        if (!entries.contains(name)) {
+            if (error) *error = QString("%1 not found in workbook").arg(name);
+            return false;
+        }
+        const Entry entry = entries.value(name);
+        if (entry.flags & 1) {
+            if (error) *error = QString("Encrypted workbooks are not supported");
+            return false;
+        }
+        char header[30];
+        if (!file.seek(entry.localOffset) || file.read(header, 30) != 30 || le32(header) != 0x04034b50) {
+            if (error) *error = QString("Corrupt .xlsx file (bad local header for %1)").arg(name);
+            return false;
+        }
+        file.seek(qint64(entry.localOffset) + 30 + le16(header + 26) + le16(header + 28));
+        if (entry.method == 8) {
+            Inflater inflater(&file, entry.compressedSize, sink);
+            return inflater.run(error);
+        }
+        if (entry.method != 0) {
+            if (error) *error = QString("Unsupported compression method %1").arg(entry.method);
+            return false;
+        }
+        qint64 left = entry.compressedSize;
+        while (left > 0) {
+            const QByteArray chunk = file.read(qMin<qint64>(left, 256 * 1024));
+            if (chunk.isEmpty()) {
+                if (error) *error = QString("Corrupt .xlsx file (truncated %1)").arg(name);
+                return false;
+            }
+            if (!sink(chunk.constData(), chunk.size())) {
+                if (error) *error = QString("Malformed sheet data");
+                return false;
+            }
+            left -= chunk.size();
+        }
+        return true;
+    }
+
+    QByteArray readAll(const QString &name, QString *error)
+    {
+        QByteArray data;
+        if (!read(name, [&data](const char *chunk, qsizetype size) { data.append(chunk, size); return true; }, error)) {
+            return QByteArray();
+        }
+        return data;
+    }
+
+private:
+    struct Entry {
+        quint16 flags = 0;
+        quint16 method = 0;
+        quint32 compressedSize = 0;
+        quint32 localOffset = 0;
+    };
+    QFile file;
+    QHash<QString, Entry> entries;
+};
+
+// ---------------- xlsx ----------------
+
+// 增量喂给QXmlStreamReader：数据不够时readNext报PrematureEndOfDocumentError，补上数据后接着解析
+class IncrementalXml
+{
+public:
+    virtual ~IncrementalXml() = default;
+
+    bool feed(const char *data, qsizetype size)
+    {
+        reader.addData(QByteArray(data, size));
+        for (;;) {
+            const QXmlStreamReader::TokenType token = reader.readNext();
+            if (token == QXmlStreamReader::Invalid) {
+                return reader.error() == QXmlStreamReader::PrematureEndOfDocumentError;
+            }
+            if (token == QXmlStreamReader::EndDocument) return true;
+            handle(token);
+        }
+    }
+
+    bool finished() const { return reader.tokenType() == QXmlStreamReader::EndDocument; }
+    QString errorString() const { return reader.errorString(); }
+
+protected:
+    QXmlStreamReader reader;
+    virtual void handle(QXmlStreamReader::TokenType token) = 0;
+};
+
+class SharedStringsParser : public IncrementalXml
+{
+public:
+    QStringList strings;
+
+protected:
+    void handle(QXmlStreamReader::TokenType token) override
+    {
+        const auto name = reader.name();
+        if (token == QXmlStreamReader::StartElement) {
+            if (name == QLatin1String("si")) {
+                current.clear();
+                inItem = true;
+            } else if (name == QLatin1String("rPh")) {
+                ++phoneticDepth; // 日文注音，不属于单元格文本
+            } else if (name == QLatin1String("t")) {
+                inText = inItem && phoneticDepth == 0;
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            if (name == QLatin1String("t")) {
+                inText = false;
+            } else if (name == QLatin1String("rPh")) {
+                --phoneticDepth;
+            } else if (name == QLatin1String("si")) {
+                strings << current;
+                inItem = false;
+            }
+        } else if (token == QXmlStreamReader::Characters && inText) {
+            current += reader.text();
+        }
+    }
+
+private:
+    QString current;
+    bool inItem = false;
+    bool inText = false;
+    int phoneticDepth = 0;
+};
+
+class SheetParser : public IncrementalXml
+{
+public:
+    SheetParser(const QStringList &shared, CsvWriter &csv) : shared(shared), csv(csv) {}
+
+protected:
+    void handle(QXmlStreamReader::TokenType token) override
+    {
+        const auto name = reader.name();
+        if (token == QXmlStreamReader::StartElement) {
+            if (name == QLatin1String("row")) {
+                cells.clear();
+                nextColumn = 0;
+            } else if (name == QLatin1String("c")) {
+                const int ref = columnFromRef(reader.attributes().value(QLatin1String("r")).toString());
+                column = ref >= 0 ? ref : nextColumn;
+                type = reader.attributes().value(QLatin1String("t")).toString();
+                value.clear();
+                inlineText.clear();
+                inCell = true;
+            } else if (inCell && name == QLatin1String("v")) {
+                inValue = true;
+            } else if (inCell && name == QLatin1String("t")) {
+                inInline = true;
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            if (name == QLatin1String("v")) {
+                inValue = false;
+            } else if (name == QLatin1String("t")) {
+                inInline = false;
+            } else if (name == QLatin1String("c")) {
+                inCell = false;
+                // 超出Excel列数上限的引用视为损坏，丢弃
+                if (column >= 16384) return;
+                while (cells.size() <= column) cells << QString();
+                cells[column] = cellText();
+                nextColumn = column + 1;
+            } else if (name == QLatin1String("row")) {
+                csv.writeRow(cells);
+            }
+        } else if (token == QXmlStreamReader::Characters) {
+            if (inValue) value += reader.text();
+            else if (inInline) inlineText += reader.text();
+        }
+    }
+
+private:
+    const QStringList &shared;
+    CsvWriter &csv;
+    QStringList cells;
+    int nextColumn = 0;
+    int column = 0;
+    QString type, value, inlineText;
+    bool inCell = false, inValue = false, inInline = false;
+
+    QString cellText() const
+    {
+        if (type == QLatin1String("s")) {
+            bool ok = false;
+            const int index = value.toInt(&ok);
+            return ok ? shared.value(index) : QString();
+        }
+        if (type == QLatin1String("inlineStr")) return inlineText;
+        if (type == QLatin1String("b")) return value == QLatin1String("1") ? QString("TRUE") : QString("FALSE");
+        return value;
+    }
+
+    // "BC12" -> 54；没有列字母时返回-1
+    static int columnFromRef(const QString &ref)
+    {
+        int column = 0;
+        int letters = 0;
+        for (const QChar ch : ref) {
+            const char16_t c = ch.unicode();
+            if (c >= 'A' && c <= 'Z') column = column * 26 + (c - 'A' + 1);
+            else if (c >= 'a' && c <= 'z') column = column * 26 + (c - 'a' + 1);
+            else break;
+            if (++letters > 3) return -1;
+        }
+        return letters > 0 ? column - 1 : -1;
+    }
+};
+
+// 第一个工作表和共享字符串表在zip里的路径，按workbook.xml和它的关系文件解析
+void locateParts(ZipArchive &zip, QString *sheetPath, QString *sharedPath)
+{
+    *sheetPath = QString("xl/worksheets/sheet1.xml");
+    *sharedPath = QString("xl/sharedStrings.xml");
+    QString error;
+    QString firstSheetId;
+    QXmlStreamReader workbook(zip.readAll("xl/workbook.xml", &error));
+    while (!workbook.atEnd() && firstSheetId.isEmpty()) {
+        if (workbook.readNext() == QXmlStreamReader::StartElement && workbook.name() == QLatin1String("sheet")) {
+            for (const QXmlStreamAttribute &attr : workbook.attributes()) {
+                if (attr.name() == QLatin1String("id")) firstSheetId = attr.value().toString();
+            }
+        }
+    }
+    QXmlStreamReader rels(zip.readAll("xl/_rels/workbook.xml.rels", &error));
+    while (!rels.atEnd()) {
+        if (rels.readNext() != QXmlStreamReader::StartElement || rels.name() != QLatin1String("Relationship")) continue;
+        const QXmlStreamAttributes attrs = rels.attributes();
+        QString target = attrs.value(QLatin1String("Target")).toString();
+        target = target.startsWith(QLatin1Char('/')) ? target.mid(1) : QDir::cleanPath("xl/" + target);
+        if (!firstSheetId.isEmpty() && attrs.value(QLatin1String("Id")) == firstSheetId) *sheetPath = target;
+        if (attrs.value(QLatin1String("Type")).endsWith(QLatin1String("/sharedStrings"))) *sharedPath = target;
+    }
+}
+
+bool convertXlsx(const QString &source, CsvWriter &csv, QString *error)
+{
+    ZipArchive zip;
+    if (!zip.open(source, error)) return false;
+    QString sheetPath, sharedPath;
+    locateParts(zip, &sheetPath, &sharedPath);
+    SharedStringsParser shared;
+    if (zip.contains(sharedPath)) {
+        if (!zip.read(sharedPath, [&shared](const char *data, qsizetype size) { return shared.feed(data, size); }, error)) {
+            if (error && !shared.errorString().isEmpty()) *error += ": " + shared.errorString();
+            return false;
+        }
+    }
+    SheetParser sheet(shared.strings, csv);
+    if (!zip.read(sheetPath, [&sheet](const char *data, qsizetype size) { return sheet.feed(data, size); }, error)) {
+        if (error && !sheet.errorString().isEmpty()) *error += ": " + sheet.errorString();
+        return false;
+    }
+    if (!sheet.finished()) {
+        if (error) *error = QString("Worksheet XML ended unexpectedly");
+        return false;
+    }
+    return true;
+}
+
+// ---------------- xls ----------------
+
+// OLE2复合文档，只实现按名字读取根目录下的流
+class CompoundFile
+{
+public:
+    bool open(const QString &path, QString *error)
+    {
+        file.setFileName(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            if (error) *error = file.errorString();
+            return false;
+        }
+        const QByteArray header = file.read(512);
+        static const char signature[8] = {char(0xD0), char(0xCF), 0x11, char(0xE0), char(0xA1), char(0xB1), 0x1A, char(0xE1)};
+        if (header.size() < 512 || std::memcmp(header.constData(), signature, 8) != 0) {
+            if (error) *error = QString("Not a valid .xls file");
+            return false;
+        }
+        const char *h = header.constData();
+        const int sectorShift = le16(h + 30);
+        if (sectorShift != 9 && sectorShift != 12) {
+            if (error) *error = QString("Unsupported .xls sector size");
+            return false;
+        }
+        sectorSize = 1u << sectorShift;
+        miniSectorSize = 1u << le16(h + 32);
+        const quint32 fatCount = le32(h + 44);
+        const quint32 firstDir = le32(h + 48);
+        miniCutoff = le32(h + 56);
+        const quint32 firstMiniFat = le32(h + 60);
+        const quint32 miniFatCount = le32(h + 64);
+        quint32 difat = le32(h + 68);
+        const quint32 difatCount = le32(h + 72);
+
+        QVector<quint32> fatSectors;
+        for (int i = 0; i < 109 && quint32(fatSectors.size()) < fatCount; ++i) {
+            const quint32 sector = le32(h + 76 + 4 * i);
+            if (sector < MaxRegular) fatSectors << sector;
+        }
+        QByteArray buffer(int(sectorSize), '\0');
+        for (quint32 k = 0; k < difatCount && difat < MaxRegular; ++k) {
+            if (!readSector(difat, buffer.data())) break;
+            const quint32 perSector = sectorSize / 4 - 1;
+            for (quint32 i = 0; i < perSector && quint32(fatSectors.size()) < fatCount; ++i) {
+                const quint32 sector = le32(buffer.constData() + 4 * i);
+                if (sector < MaxRegular) fatSectors << sector;
+            }
+            difat = le32(buffer.constData() + sectorSize - 4);
+        }
+        for (quint32 sector : fatSectors) {
+            if (!readSector(sector, buffer.data())) {
+                if (error) *error = QString("Corrupt .xls file (FAT)");
+                return false;
+            }
+            for (quint32 i = 0; i < sectorSize / 4; ++i) fat << le32(buffer.constData() + 4 * i);
+        }
+
+        QByteArray dirData;
+        if (!readChain(fat, firstDir, &dirData)) {
+            if (error) *error = QString("Corrupt .xls file (directory)");
+            return false;
+        }
+        for (qsizetype pos = 0; pos + 128 <= dirData.size(); pos += 128) {
+            const char *p = dirData.constData() + pos;
+            DirEntry entry;
+            const int nameChars = qBound(0, int(le16(p + 64)) / 2 - 1, 31);
+            for (int i = 0; i < nameChars; ++i) entry.name += QChar(le16(p + 2 * i));
+            entry.type = quint8(p[66]);
+            entry.start = le32(p + 116);
+            entry.size = le32(p + 120);
+            dir << entry;
+        }
+        if (miniFatCount > 0) {
+            QByteArray miniFatData;
+            readChain(fat, firstMiniFat, &miniFatData);
+            for (qsizetype pos = 0; pos + 4 <= miniFatData.size(); pos += 4) miniFat << le32(miniFatData.constData() + pos);
+        }
+        return true;
+    }
+
+    bool hasStream(const QString &name) const { return findStream(name) >= 0; }
+
+    bool readStream(const QString &name, QByteArray *data, QString *error)
+    {
+        const int index = findStream(name);
+        if (index < 0) {
+            if (error) *error = QString("No %1 stream in .xls file").arg(name);
+            return false;
+        }
+        const DirEntry &entry = dir.at(index);
+        bool ok = false;
+        if (entry.size < miniCutoff && !dir.isEmpty()) {
+            // 小于阈值的流存在迷你流里，迷你流本身挂在根目录项上
+            QByteArray miniStream;
+            if (readChain(fat, dir.first().start, &miniStream)) {
+                ok = readMiniChain(miniStream, entry.start, data);
+            }
+        } else {
+            ok = readChain(fat, entry.start, data);
+        }
+        if (!ok || data->size() < qsizetype(entry.size)) {
+            if (error) *error = QString("Corrupt .xls file (%1 stream)").arg(name);
+            return false;
+        }
+        data->truncate(entry.size);
+        return true;
+    }
+
+private:
+    static constexpr quint32 MaxRegular = 0xFFFFFFFA;
+
+    struct DirEntry {
+        QString name;
+        quint8 type = 0;   // 1 存储，2 流，5 根
+        quint32 start = 0;
+        quint32 size = 0;
+    };
+
+    QFile file;
+    quint32 sectorSize = 512;
+    quint32 miniSectorSize = 64;
+    quint32 miniCutoff = 4096;
+    QVector<quint32> fat, miniFat;
+    QVector<DirEntry> dir;
+
+    int findStream(const QString &name) const
+    {
+        for (int i = 0; i < dir.size(); ++i) {
+            if (dir.at(i).type == 2 && dir.at(i).name.compare(name, Qt::CaseInsensitive) == 0) return i;
+        }
+        return -1;
+    }
+
+    bool readSector(quint32 sector, char *buffer)
+    {
+        if (!file.seek(qint64(sector + 1) * sectorSize)) return false;
+        const qint64 got = file.read(buffer, sectorSize);
+        if (got <= 0) return false;
+        // 有些写入程序不补齐最后一个扇区
+        if (got < sectorSize) std::memset(buffer + got, 0, sectorSize - got);
+        return true;
+    }
+
+    bool readChain(const QVector<quint32> &table, quint32 start, QByteArray *data)
+    {
+        QByteArray buffer(int(sectorSize), '\0');
+        int guard = 0;
+        for (quint32 sector = start; sector < MaxRegular; sector = table.at(sector)) {
+            if (sector >= quint32(table.size()) || ++guard > table.size() || !readSector(sector, buffer.data())) return false;
+            data->append(buffer);
+        }
+        return true;
+    }
+
+    bool readMiniChain(const QByteArray &miniStream, quint32 start, QByteArray *data) const
+    {
+        int guard = 0;
+        for (quint32 sector = start; sector < MaxRegular; sector = miniFat.at(sector)) {
+            const qint64 offset = qint64(sector) * miniSectorSize;
+            if (sector >= quint32(miniFat.size()) || ++guard > miniFat.size() || offset + miniSectorSize > miniStream.size()) {
+                return false;
+            }
+            data->append(miniStream.constData() + offset, miniSectorSize);
+        }
+        return true;
+    }
+};
+
+// SST记录的字符串可能跨CONTINUE记录；字符数组在记录边界处断开时，新记录开头多一个标志字节
+class SstReader
+{
+public:
+    explicit SstReader(const QList<QByteArray> &segments) : segments(segments) {}
+
+    QStringList readAll(quint32 count)
+    {
+        QStringList strings;
+        skip(8); // 总引用数和唯一字符串数
+        for (quint32 i = 0; i < count && ok; ++i) {
+            const int chars = u16();
+            const quint8 flags = byte();
+            const int runs = (flags & 0x08) ? u16() : 0;
+            const quint32 extSize = (flags & 0x04) ? u32() : 0;
+            const QString text = readChars(chars, flags & 0x01);
+            skip(qint64(runs) * 4 + extSize);
+            if (ok) strings << text;
+        }
+        return strings;
+    }
+
+private:
+    const QList<QByteArray> &segments;
+    int segment = 0;
+    int pos = 0;
+    bool ok = true;
+
+    quint8 byte()
+    {
+        while (segment < segments.size() && pos >= segments.at(segment).size()) {
+            ++segment;
+            pos = 0;
+        }
+        if (segment >= segments.size()) {
+            ok = false;
+            return 0;
+        }
+        return quint8(segments.at(segment).at(pos++));
+    }
+    quint16 u16() { const quint16 lo = byte(); return quint16(lo | (byte() << 8)); }
+    quint32 u32() { const quint32 lo = u16(); return lo | (quint32(u16()) << 16); }
+    void skip(qint64 count) { while (count-- > 0 && ok) byte(); }
+
+    QString readChars(int count, bool wide)
+    {
+        QString text;
+        text.reserve(count);
+        while (count > 0 && ok) {
+            if (segment >= segments.size()) {
+                ok = false;
+                break;
+            }
+            if (pos >= segments.at(segment).size()) {
+                if (++segment >= segments.size()) {
+                    ok = false;
+                    break;
+                }
+                pos = 0;
+                wide = quint8(segments.at(segment).at(pos++)) & 0x01;
+                continue;
+            }
+            const QByteArray &data = segments.at(segment);
+            if (wide) {
+                if (pos + 2 > data.size()) {
+                    ok = false;
+                    break;
+                }
+                text += QChar(le16(data.constData() + pos));
+                pos += 2;
+            } else {
+                text += QChar(quint8(data.at(pos++)));
+            }
+            --count;
+        }
+        return text;
+    }
+};
+
+// BIFF8的XLUnicodeString：字符数、标志、字符（压缩时每字符一个字节）
+QString readXLUnicodeString(const char *p, int size)
+{
+    if (size < 3) return QString();
+    const int count = le16(p);
+    const bool wide = quint8(p[2]) & 0x01;
+    const char *chars = p + 3;
+    const int available = size - 3;
+    if (!wide) return QString::fromLatin1(chars, qMin(count, available));
+    const int n = qMin(count, available / 2);
+    QString text;
+    text.reserve(n);
+    for (int i = 0; i < n; ++i) text += QChar(le16(chars + 2 * i));
+    return text;
+}
+
+double readDouble(const char *p)
+{
+    const quint64 bits = qFromLittleEndian<quint64>(p);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double decodeRk(quint32 rk)
+{
+    double value;
+    if (rk & 0x02) {
+        value = double(qint32(rk) >> 2);
+    } else {
+        const quint64 bits = quint64(rk & 0xFFFFFFFCu) << 32;
+        std::memcpy(&value, &bits, sizeof(value));
+    }
+    return (rk & 0x01) ? value / 100.0 : value;
+}
+
+struct BiffRecord {
+    quint16 type = 0;
+    const char *data = nullptr;
+    int size = 0;
+};
+
+// 从offset读一条记录并前移；越界时返回false
+bool nextRecord(const QByteArray &stream, qsizetype &offset, BiffRecord *record)
+{
+    if (offset + 4 > stream.size()) return false;
+    record->type = le16(stream.constData() + offset);
+    record->size = le16(stream.constData() + offset + 2);
+    if (offset + 4 + record->size > stream.size()) return false;
+    record->data = stream.constData() + offset + 4;
+    offset += 4 + record->size;
+    return true;
+}
+
+bool convertXls(const QString &source, CsvWriter &csv, QString *error)
+{
+    CompoundFile cfb;
+    if (!cfb.open(source, error)) return false;
+    QByteArray stream;
+    if (!cfb.readStream("Workbook", &stream, error)) {
+        if (cfb.hasStream("Book") && error) *error = QString("Excel 5.0/95 workbooks are not supported; please re-save as .xlsx");
+        return false;
+    }
+    // 全局记录：第一个工作表的位置和共享字符串表
+    qsizetype offset = 0;
+    BiffRecord record;
+    if (!nextRecord(stream, offset, &record) || record.type != 0x0809 || record.size < 2 || le16(record.data) != 0x0600) {
+        if (error) *error = QString("Only Excel 97-2003 (BIFF8) .xls files are supported");
+        return false;
+    }
+    qint64 sheetOffset = -1;
+    QStringList shared;
+    while (nextRecord(stream, offset, &record) && record.type != 0x000A) {
+        if (record.type == 0x0085 && record.size >= 6 && sheetOffset < 0 && quint8(record.data[5]) == 0) {
+            sheetOffset = le32(record.data);
+        } else if (record.type == 0x00FC && record.size >= 8) {
+            QList<QByteArray> segments;
+            segments << QByteArray(record.data, record.size);
+            const quint32 unique = le32(record.data + 4);
+            qsizetype next = offset;
+            BiffRecord cont;
+            while (nextRecord(stream, next, &cont) && cont.type == 0x003C) {
+                segments << QByteArray(cont.data, cont.size);
+                offset = next;
+            }
+            shared = SstReader(segments).readAll(unique);
+        }
+    }
+    if (sheetOffset < 0 || sheetOffset >= stream.size()) {
+        if (error) *error = QString("No worksheet found in .xls file");
+        return false;
+    }
+    // 单元格记录不保证按行列顺序，先收集再按行输出
+    QMap<int, QMap<int, QString>> grid;
+    offset = sheetOffset;
+    int depth = 0;
+    int formulaRow = -1, formulaColumn = -1;
+    while (nextRecord(stream, offset, &record)) {
+        const char *p = record.data;
+        if (record.type == 0x0809) {
+            ++depth;
+            continue;
+        }
+        if (record.type == 0x000A) {
+            if (--depth <= 0) break;
+            continue;
+        }
+        if (depth > 1) continue; // 嵌入的图表等子流
+        switch (record.type) {
+        case 0x0203: // NUMBER
+            if (record.size >= 14) grid[le16(p)][le16(p + 2)] = formatNumber(readDouble(p + 6));
+            break;
+        case 0x027E: // RK
+            if (record.size >= 10) grid[le16(p)][le16(p + 2)] = formatNumber(decodeRk(le32(p + 6)));
+            break;
+        case 0x00BD: { // MULRK
+            if (record.size < 6) break;
+            const int row = le16(p);
+            const int first = le16(p + 2);
+            const int count = (record.size - 6) / 6;
+            for (int i = 0; i < count; ++i) grid[row][first + i] = formatNumber(decodeRk(le32(p + 4 + 6 * i + 2)));
+            break;
+        }
+        case 0x00FD: // LABELSST
+            if (record.size >= 10) grid[le16(p)][le16(p + 2)] = shared.value(int(le32(p + 6)));
+            break;
+        case 0x0204: // LABEL
+        case 0x00D6: // RSTRING
+            if (record.size >= 9) grid[le16(p)][le16(p + 2)] = readXLUnicodeString(p + 6, record.size - 6);
+            break;
+        case 0x0205: // BOOLERR
+            if (record.size >= 8 && quint8(p[7]) == 0) grid[le16(p)][le16(p + 2)] = p[6] ? QString("TRUE") : QString("FALSE");
+            break;
+        case 0x0006: { // FORMULA，取缓存的结果
+            if (record.size < 14) break;
+            const int row = le16(p), column = le16(p + 2);
+            if (le16(p + 12) != 0xFFFF) {
+                grid[row][column] = formatNumber(readDouble(p + 6));
+            } else if (quint8(p[6]) == 0) {
+                formulaRow = row; // 字符串结果在随后的STRING记录里
+                formulaColumn = column;
+            } else if (quint8(p[6]) == 1) {
+                grid[row][column] = p[8] ? QString("TRUE") : QString("FALSE");
+            }
+            break;
+        }
+        case 0x0207: // STRING
+            if (formulaRow >= 0) grid[formulaRow][formulaColumn] = readXLUnicodeString(p, record.size);
+            formulaRow = formulaColumn = -1;
+            break;
+        default:
+            break;
+        }
+    }
+    for (auto row = grid.cbegin(); row != grid.cend(); ++row) {
+        QStringList cells;
+        for (auto cell = row.value().cbegin(); cell != row.value().cend(); ++cell) {
+            while (cells.size() < cell.key()) cells << QString();
+            cells << cell.value();
+        }
+        csv.writeRow(cells);
+    }
+    return true;
+}
+
+// ---------------- 转换标记 ----------------
+
+// 同目录下的隐藏文件记录转换出的csv的大小和修改时间，对得上才说明csv是转换器生成、没被改过的
+QString markerPathFor(const QString &csvPath)
+{
+    const QFileInfo info(csvPath);
+    return info.absolutePath() + "/." + info.fileName() + ".converted";
+}
+
+QByteArray csvStamp(const QFileInfo &csv)
+{
+    return QByteArray::number(csv.size()) + ' ' + QByteArray::number(csv.lastModified().toMSecsSinceEpoch());
+}
+
+void writeMarker(const QString &csvPath)
+{
+    QSaveFile marker(markerPathFor(csvPath));
+    if (!marker.open(QIODevice::WriteOnly) || marker.write(csvStamp(QFileInfo(csvPath)) + '\n') < 0 || !marker.commit()) {
+        qCWarning(lcData) << "[SpreadsheetConverter] Unable to write" << marker.fileName() << ":" << marker.errorString();
+    }
+}
+
+bool isConverted(const QFileInfo &csv)
+{
+    QFile marker(markerPathFor(csv.absoluteFilePath()));
+    return marker.open(QIODevice::ReadOnly) && marker.readAll().trimmed() == csvStamp(csv);
+}
+
+} // namespace
+
+bool isSpreadsheet(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "xls" || suffix == "xlsx";
+}
+
+QString csvPathFor(const QString &spreadsheetPath)
+{
+    const QFileInfo info(spreadsheetPath);
+    return info.absolutePath() + "/" + info.completeBaseName() + ".csv";
+}
+
+bool convertToCsv(const QString &source, const QString &target, QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+    CsvWriter csv(target);
+    if (!csv.open(error)) return false;
+    const QString suffix = QFileInfo(source).suffix().toLower();
+    bool ok = false;
+    if (suffix == "xlsx") {
+        ok = convertXlsx(source, csv, error);
+    } else if (suffix == "xls") {
+        ok = convertXls(source, csv, error);
+    } else if (error) {
+        *error = QString("Not a spreadsheet: %1").arg(source);
+    }
+    if (!ok) {
+        csv.cancel();
+        return false;
+    }
+    if (!csv.commit(error)) return false;
+    writeMarker(target);
+    qCDebug(lcData) << "[SpreadsheetConverter] Converted" << source << "to" << target << "," << csv.rowCount()
+                    << "rows in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool canOverwriteCsv(const QString &csvPath)
+{
+    const QFileInfo csv(csvPath);
+    return !csv.exists() || isConverted(csv);
+}
+
+bool ensureCsv(const QString &spreadsheetPath, QString *error)
+{
+    const QFileInfo sheet(spreadsheetPath);
+    const QFileInfo csv(csvPathFor(spreadsheetPath));
+    if (csv.exists() && csv.lastModified() >= sheet.lastModified()) return true;
+    // 用户自己放的或改过的csv不覆盖，交给调用方报告冲突
+    if (!canOverwriteCsv(csv.absoluteFilePath())) {
+        if (error) *error = QString("%1 is newer than %2, but %2 was not generated from it; remove %2 to use the spreadsheet")
+                                .arg(sheet.fileName(), csv.fileName());
+        return false;
+    }
+    return convertToCsv(spreadsheetPath, csv.absoluteFilePath(), error);
+}
+
+QStringList ensureCsvInDirectory(const QString &dir, const QString &baseName)
+{
+    const QString prefix = baseName.isEmpty() ? QString("*") : baseName;
+    QStringList failures;
+    for (const QFileInfo &info : QDir(dir).entryInfoList({prefix + ".xls", prefix + ".xlsx"}, QDir::Files)) {
+        QString error;
+        if (!ensureCsv(info.absoluteFilePath(), &error)) failures << info.fileName() + ": " + error;
+    }
+    return failures;
+}
+
+} // namespace SpreadsheetConverter
@@ -0,0 +1,29 @@
+#ifndef SPREADSHEETCONVERTER_H
+#define SPREADSHEETCONVERTER_H
+
+#include <QString>
+#include <QStringList>
+
+// 上传的xls/xlsx在本地转成同名csv，Python各步直接读csv，不必每次运行都重新解析表格。
+// xlsx：边解压zip边用QXmlStreamReader按事件解析工作表，内存只随单行大小增长；
+// xls：读OLE2复合文档里的Workbook流，解析BIFF8记录。都只转换第一个工作表
+namespace SpreadsheetConverter {
+
+// 后缀是xls或xlsx
+bool isSpreadsheet(const QString &fileName);
+// 与表格同目录、同名的csv路径
+QString csvPathFor(const QString &spreadsheetPath);
+// 转换为UTF-8的csv（逗号分隔，必要时加引号），先写临时文件再替换target。
+// 同目录下的.<csv文件名>.converted标记这个csv是转换生成的
+bool convertToCsv(const QString &source, const QString &target, QString *error = nullptr);
+// csv不存在，或者是转换生成且之后没被改过，可以直接覆盖
+bool canOverwriteCsv(const QString &csvPath);
+// csv不存在或比表格旧时重新转换；已是最新时只做一次stat。
+// 比表格旧的csv不是转换生成的（或生成后被改过）时不覆盖，返回false并在error里说明冲突
+bool ensureCsv(const QString &spreadsheetPath, QString *error = nullptr);
+// 把dir里所有比同名csv新的表格转换一遍，返回失败和冲突的文件及原因
+QStringList ensureCsvInDirectory(const QString &dir, const QString &baseName = QString());
+
+} // namespace SpreadsheetConverter
+
+#endif // SPREADSHEETCONVERTER_H
@@ -0,0 +1,147 @@
+#include "startupprofiler.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+#include <QDebug>
+
+namespace {
+
+struct Phase {
+    QString name;
+    qint64 atMs;
+    qint64 durationMs;
+};
+
+struct Task {
+    QString name;
+    std::function<void()> run;
+};
+
+QElapsedTimer clock;
+bool enabled = false;
+qint64 lastMarkMs = 0;
+qint64 firstPaintMs = -1;
+QList<Phase> phases;
+QList<Task> pendingTasks;
+bool painted = false;
+bool draining = false;
+bool reported = false;
+
+void report()
+{
+    if (!enabled || reported) return;
+    reported = true;
+    QJsonArray phaseArray;
+    qInfo().noquote() << "[StartupProfiler] Startup phases:";
+    for (const Phase &phase : phases) {
+        qInfo().noquote() << QString("  %1 %2 ms (at %3 ms)").arg(phase.name, -32).arg(phase.durationMs, 6).arg(phase.atMs, 6);
+        QJsonObject obj;
+        obj["phase"] = phase.name;
+        obj["at_ms"] = double(phase.atMs);
+        obj["ms"] = double(phase.durationMs);
+        phaseArray.append(obj);
+    }
+    qInfo().noquote() << QString("[StartupProfiler] First paint after %1 ms, idle after %2 ms").arg(firstPaintMs).arg(clock.elapsed());
+    QJsonObject record;
+    record["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    record["first_paint_ms"] = double(firstPaintMs);
+    record["idle_ms"] = double(clock.elapsed());
+    record["phases"] = phaseArray;
+    const QString dir = QDir::currentPath() + "/MENET/logs";
+    QDir().mkpath(dir);
+    QFile file(dir + "/startup_profile.jsonl");
+    if (file.open(QIODevice::Append | QIODevice::Text)) {
+        file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n");
+    }
+}
+
+// 每次事件循环只跑一个延后任务，中间可以处理输入和重绘
+void drainNext()
+{
+    if (pendingTasks.isEmpty()) {
+        draining = false;
+        report();
+        return;
+    }
+    const Task task = pendingTasks.takeFirst();
+    task.run();
+    StartupProfiler::mark(task.name);
+    QTimer::singleShot(0, qApp, &drainNext);
+}
+
+void startDraining()
+{
+    if (draining) return;
+    draining = true;
+    QTimer::singleShot(0, qApp, &drainNext);
+}
+
+class FirstPaintFilter : public QObject
+{
+public:
+    using QObject::QObject;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint && !painted) {
+            painted = true;
+            watched->removeEventFilter(this);
+            deleteLater();
+            // 排到本轮绘制同步之后，记录的是这一帧画完的时间
+            QTimer::singleShot(0, qApp, []() {
+                firstPaintMs = clock.elapsed();
+                StartupProfiler::mark("first paint");
+                startDraining();
+            });
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+} // namespace
+
+void StartupProfiler::start(bool on)
+{
+    enabled = on;
+    clock.start();
+    lastMarkMs = 0;
+}
+
+bool StartupProfiler::isEnabled()
+{
+    return enabled;
+}
+
+void StartupProfiler::mark(const QString &phase)
+{
+    if (!enabled || reported) return;
+    const qint64 now = clock.elapsed();
+    phases.append({phase, now, now - lastMarkMs});
+    lastMarkMs = now;
+}
+
+void StartupProfiler::afterFirstPaint(QWidget *window, const QString &name, std::function<void()> task)
+{
+    QPointer<QWidget> guard(window);
+    pendingTasks.append({name, [guard, task]() { if (guard) task(); }});
+    if (painted) {
+        startDraining();
+        return;
+    }
+    static QPointer<FirstPaintFilter> filter;
+    if (!filter) {
+        filter = new FirstPaintFilter(window);
+        window->installEventFilter(filter);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+#include <functional>
+
+class QWidget;
+
+// 启动耗时统计：--profile-startup 时记录各初始化阶段和首帧绘制的时间，
+// 延后任务全部完成后输出到日志并追加到 MENET/logs/startup_profile.jsonl。
+// afterFirstPaint 不论是否开启统计都生效，用来把非必需的初始化推到首帧之后
+class StartupProfiler
+{
+public:
+    // main()最开始调用，计时从这里开始
+    static void start(bool enabled);
+    static bool isEnabled();
+    // 记录一个阶段结束，耗时为距上一个标记的时间
+    static void mark(const QString &phase);
+    // 窗口第一次绘制完成后，在事件循环里依次执行登记的任务
+    static void afterFirstPaint(QWidget *window, const QString &name, std::function<void()> task);
+};
+
+#endif // STARTUPPROFILER_H
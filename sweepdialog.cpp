@@ -0,0 +1,274 @@
+#include "sweepdialog.h"
+#include "appconfig.h"
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDateTime>
+#include <QFile>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QThread>
+#include <QVBoxLayout>
+
+static const QStringList kMenetKeys = {"batch size", "p1", "p2", "p3", "p4", "saved", "wd"};
+
+SweepDialog::SweepDialog(const QString &menetDir, const QStringList &phenotypes, QWidget *parent)
+    : QDialog(parent), menetDir(menetDir), runner(new SweepRunner(this))
+{
+    setWindowTitle(tr("Hyperparameter Sweep"));
+    resize(900, 700);
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    comboPhenotype = new QComboBox(this);
+    comboPhenotype->addItems(phenotypes);
+    QFormLayout *topLayout = new QFormLayout();
+    topLayout->addRow(tr("Phenotype:"), comboPhenotype);
+    mainLayout->addLayout(topLayout);
+
+    // 参数取值：逗号分隔的列表，或 start:end:step 区间
+    QGroupBox *paramGroup = new QGroupBox(tr("Values (list \"64,128\" or range \"0.5:0.9:0.1\")"), this);
+    QFormLayout *paramLayout = new QFormLayout();
+    for (const QString &key : kMenetKeys) {
+        QLineEdit *edit = new QLineEdit(this);
+        paramEdits.insert("MeNet:" + key, edit);
+        paramLayout->addRow(tr("MeNet %1:").arg(key), edit);
+    }
+    QLineEdit *repGenoP = new QLineEdit(this);
+    repGenoP->setToolTip(tr("Several values re-run generate_genetic_relatedness.exe in every trial"));
+    paramEdits.insert("RepGeno:p", repGenoP);
+    paramLayout->addRow(tr("RepGeno p:"), repGenoP);
+    paramGroup->setLayout(paramLayout);
+    mainLayout->addWidget(paramGroup);
+
+    // 搜索方式与资源预算
+    QGroupBox *runGroup = new QGroupBox(tr("Search and Resources"), this);
+    QFormLayout *runLayout = new QFormLayout();
+    comboMode = new QComboBox(this);
+    comboMode->addItem(tr("Grid search"));
+    comboMode->addItem(tr("Random search"));
+    spinRandomTrials = new QSpinBox(this);
+    spinRandomTrials->setRange(1, 10000);
+    spinRandomTrials->setValue(20);
+    spinParallel = new QSpinBox(this);
+    spinParallel->setRange(1, 256);
+    spinParallel->setValue(qMax(1, QThread::idealThreadCount() / 4));
+    spinThreads = new QSpinBox(this);
+    spinThreads->setRange(1, 256);
+    spinThreads->setValue(qMax(1, QThread::idealThreadCount() / spinParallel->value()));
+    spinMemoryBudget = new QSpinBox(this);
+    spinMemoryBudget->setRange(0, 4 * 1024 * 1024);
+    spinMemoryBudget->setSuffix(" MB");
+    spinMemoryBudget->setSpecialValueText(tr("Unlimited"));
+    spinMemoryPerTrial = new QSpinBox(this);
+    spinMemoryPerTrial->setRange(1, 4 * 1024 * 1024);
+    spinMemoryPerTrial->setValue(2048);
+    spinMemoryPerTrial->setSuffix(" MB");
+    checkHalving = new QCheckBox(tr("Stop poor trials early (successive halving)"), this);
+    spinMinRung = new QSpinBox(this);
+    spinMinRung->setRange(1, 100000);
+    spinMinRung->setValue(10);
+    spinEta = new QSpinBox(this);
+    spinEta->setRange(2, 10);
+    spinEta->setValue(3);
+    runLayout->addRow(tr("Mode:"), comboMode);
+    runLayout->addRow(tr("Random trials:"), spinRandomTrials);
+    runLayout->addRow(tr("Max parallel trials:"), spinParallel);
+    runLayout->addRow(tr("Threads per trial:"), spinThreads);
+    runLayout->addRow(tr("Memory budget:"), spinMemoryBudget);
+    runLayout->addRow(tr("Memory per trial:"), spinMemoryPerTrial);
+    runLayout->addRow(checkHalving);
+    runLayout->addRow(tr("First check at epoch:"), spinMinRung);
+    runLayout->addRow(tr("Keep top 1/eta, eta:"), spinEta);
+    runGroup->setLayout(runLayout);
+    mainLayout->addWidget(runGroup);
+
+    table = new QTableWidget(this);
+    table->setColumnCount(8);
+    table->setHorizontalHeaderLabels({tr("Rank"), tr("Trial"), tr("Parameters"), tr("val_R2"), tr("train_R2"),
+                                      tr("Epoch"), tr("Wall time"), tr("Status")});
+    table->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(table, 1);
+
+    labelStatus = new QLabel(this);
+    mainLayout->addWidget(labelStatus);
+
+    btnStart = new QPushButton(tr("Start"), this);
+    btnStop = new QPushButton(tr("Stop"), this);
+    btnApply = new QPushButton(tr("Apply Best to MeNet.json"), this);
+    btnStop->setEnabled(false);
+    btnApply->setEnabled(false);
+    QHBoxLayout *btnRow = new QHBoxLayout();
+    btnRow->addStretch();
+    btnRow->addWidget(btnStart);
+    btnRow->addWidget(btnStop);
+    btnRow->addWidget(btnApply);
+    mainLayout->addLayout(btnRow);
+    setLayout(mainLayout);
+
+    connect(comboPhenotype, &QComboBox::currentTextChanged, this, &SweepDialog::loadCurrentValues);
+    connect(btnStart, &QPushButton::clicked, this, &SweepDialog::startSweep);
+    connect(btnStop, &QPushButton::clicked, this, &SweepDialog::stopSweep);
+    connect(btnApply, &QPushButton::clicked, this, &SweepDialog::applyBest);
+    connect(runner, &SweepRunner::trialUpdated, this, &SweepDialog::refreshTable);
+    connect(runner, &SweepRunner::finished, this, &SweepDialog::onSweepFinished);
+    loadCurrentValues();
+}
+
+void SweepDialog::loadCurrentValues()
+{
+    // 默认值与参数弹窗一致，再用当前json里的值覆盖
+    QMap<QString, double> values = {{"MeNet:batch size", 128}, {"MeNet:p1", 0.8}, {"MeNet:p2", 0.8},
+                                    {"MeNet:p3", 0.8}, {"MeNet:p4", 0.6}, {"MeNet:saved", 100},
+                                    {"MeNet:wd", 1e-5}, {"RepGeno:p", 0.8}};
+    const QString phenotype = comboPhenotype->currentText();
+    for (const QString &configName : {QString("MeNet"), QString("RepGeno")}) {
+        QFile file(menetDir + "/configs/" + configName + ".json");
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        QJsonObject phenoObj = QJsonDocument::fromJson(file.readAll()).object().value(phenotype).toObject();
+        file.close();
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            if (!it.key().startsWith(configName + ":")) continue;
+            QString name = SweepRunner::paramName(it.key());
+            if (phenoObj.contains(name)) it.value() = phenoObj[name].toDouble();
+        }
+    }
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        if (QLineEdit *edit = paramEdits.value(it.key())) edit->setText(QString::number(it.value(), 'g', 8));
+    }
+}
+
+void SweepDialog::startSweep()
+{
+    SweepRunner::SearchSpace space;
+    for (auto it = paramEdits.constBegin(); it != paramEdits.constEnd(); ++it) {
+        bool ok = false;
+        QList<double> values = SweepRunner::parseValues(it.value()->text(), &ok);
+        if (!ok) {
+            QMessageBox::warning(this, tr("Error"), tr("Invalid values for %1").arg(it.key()));
+            return;
+        }
+        space.insert(it.key(), values);
+    }
+    QList<SweepRunner::ParamSet> trials = comboMode->currentIndex() == 0
+        ? SweepRunner::gridTrials(space)
+        : SweepRunner::randomTrials(space, spinRandomTrials->value(), quint32(QDateTime::currentMSecsSinceEpoch()));
+    if (trials.size() > 1000) {
+        QMessageBox::warning(this, tr("Error"), tr("The grid has %1 trials; please narrow it or use random search.").arg(trials.size()));
+        return;
+    }
+    SweepRunner::Options options;
+    options.menetDir = menetDir;
+    options.phenotype = comboPhenotype->currentText();
+    options.maxParallel = spinParallel->value();
+    options.threadsPerTrial = spinThreads->value();
+    options.memoryBudgetMB = spinMemoryBudget->value();
+    options.memoryPerTrialMB = spinMemoryPerTrial->value();
+    options.successiveHalving = checkHalving->isChecked();
+    options.minRungEpoch = spinMinRung->value();
+    options.eta = spinEta->value();
+    options.keepWorkspaces = AppConfig::boolValue("Sweep", "KeepWorkspaces", false);
+    QString error;
+    if (!runner->start(options, trials, &error)) {
+        QMessageBox::warning(this, tr("Error"), error);
+        return;
+    }
+    btnStart->setEnabled(false);
+    btnStop->setEnabled(true);
+    btnApply->setEnabled(false);
+    comboPhenotype->setEnabled(false);
+    labelStatus->setText(tr("Running %1 trials...").arg(trials.size()));
+    refreshTable();
+}
+
+void SweepDialog::stopSweep()
+{
+    runner->cancel();
+    btnStop->setEnabled(false);
+}
+
+void SweepDialog::applyBest()
+{
+    QList<int> order = runner->ranking();
+    if (order.isEmpty() || runner->trials().at(order.first()).state != SweepRunner::TrialState::Done) {
+        QMessageBox::warning(this, tr("Error"), tr("No completed trial to apply."));
+        return;
+    }
+    // 选中行优先，否则取排名第一
+    int index = order.first();
+    int row = table->currentRow();
+    if (row >= 0 && row < order.size() && runner->trials().at(order.at(row)).state == SweepRunner::TrialState::Done) {
+        index = order.at(row);
+    }
+    QString error;
+    if (!runner->applyToConfigs(index, &error)) {
+        QMessageBox::warning(this, tr("Error"), error);
+        return;
+    }
+    labelStatus->setText(tr("Trial %1 parameters written to MeNet.json").arg(runner->trials().at(index).id));
+}
+
+void SweepDialog::refreshTable()
+{
+    const QVector<SweepRunner::Trial> &trials = runner->trials();
+    const QList<int> order = runner->ranking();
+    table->setRowCount(order.size());
+    auto stateText = [this](SweepRunner::TrialState s) {
+        switch (s) {
+        case SweepRunner::TrialState::Pending: return tr("Pending");
+        case SweepRunner::TrialState::Step1: return tr("Step 1");
+        case SweepRunner::TrialState::Running: return tr("Running");
+        case SweepRunner::TrialState::Done: return tr("Done");
+        case SweepRunner::TrialState::Failed: return tr("Failed");
+        case SweepRunner::TrialState::Pruned: return tr("Pruned");
+        case SweepRunner::TrialState::Cancelled: return tr("Cancelled");
+        }
+        return QString();
+    };
+    for (int row = 0; row < order.size(); ++row) {
+        const SweepRunner::Trial &t = trials.at(order.at(row));
+        QStringList params;
+        for (auto it = t.params.constBegin(); it != t.params.constEnd(); ++it) {
+            params << QString("%1=%2").arg(it.key().section(':', 1)).arg(it.value(), 0, 'g', 6);
+        }
+        QString status = stateText(t.state);
+        if (!t.note.isEmpty()) status += " - " + t.note;
+        const QStringList cells = {QString::number(row + 1), QString::number(t.id), params.join(", "),
+                                   qIsNaN(t.valR2) ? QString("-") : QString::number(t.valR2, 'f', 4),
+                                   qIsNaN(t.trainR2) ? QString("-") : QString::number(t.trainR2, 'f', 4),
+                                   t.lastEpoch < 0 ? QString("-") : QString::number(t.lastEpoch),
+                                   QString("%1 s").arg(t.seconds, 0, 'f', 1), status};
+        for (int col = 0; col < cells.size(); ++col) {
+            QTableWidgetItem *item = table->item(row, col);
+            if (!item) {
+                item = new QTableWidgetItem();
+                table->setItem(row, col, item);
+            }
+            item->setText(cells.at(col));
+        }
+    }
+}
+
+void SweepDialog::onSweepFinished()
+{
+    refreshTable();
+    btnStart->setEnabled(true);
+    btnStop->setEnabled(false);
+    comboPhenotype->setEnabled(true);
+    QList<int> order = runner->ranking();
+    bool hasDone = !order.isEmpty() && runner->trials().at(order.first()).state == SweepRunner::TrialState::Done;
+    btnApply->setEnabled(hasDone);
+    labelStatus->setText(hasDone ? tr("Sweep finished. Best trial: %1").arg(runner->trials().at(order.first()).id)
+                                 : tr("Sweep finished without a completed trial."));
+}
@@ -0,0 +1,53 @@
+#ifndef SWEEPDIALOG_H
+#define SWEEPDIALOG_H
+
+#include <QDialog>
+#include <QMap>
+#include "sweeprunner.h"
+
+class QComboBox;
+class QLineEdit;
+class QSpinBox;
+class QCheckBox;
+class QPushButton;
+class QTableWidget;
+class QLabel;
+
+// 超参数搜索对话框：填写取值列表/区间，运行并查看排名，一键写回MeNet.json
+class SweepDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SweepDialog(const QString &menetDir, const QStringList &phenotypes, QWidget *parent = nullptr);
+
+private slots:
+    void loadCurrentValues();
+    void startSweep();
+    void stopSweep();
+    void applyBest();
+    void refreshTable();
+    void onSweepFinished();
+
+private:
+    QString menetDir;
+    SweepRunner *runner;
+    QComboBox *comboPhenotype;
+    QMap<QString, QLineEdit*> paramEdits; // "MeNet:p1" -> 取值输入框
+    QComboBox *comboMode;
+    QSpinBox *spinRandomTrials;
+    QSpinBox *spinParallel;
+    QSpinBox *spinThreads;
+    QSpinBox *spinMemoryBudget;
+    QSpinBox *spinMemoryPerTrial;
+    QCheckBox *checkHalving;
+    QSpinBox *spinMinRung;
+    QSpinBox *spinEta;
+    QPushButton *btnStart;
+    QPushButton *btnStop;
+    QPushButton *btnApply;
+    QTableWidget *table;
+    QLabel *labelStatus;
+};
+
+#endif // SWEEPDIALOG_H
@@ -0,0 +1,410 @@
+#include "sweeprunner.h"
+#include "trialworkspace.h"
+#include "metricparser.h"
+#include "logtail.h"
+#include "processcontrol.h"
+#include "resourcecontrol.h"
+#include "logcategories.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QThread>
+#include <algorithm>
+
+SweepRunner::SweepRunner(QObject *parent) : QObject(parent)
+{
+    pollTimer.setInterval(1000);
+    connect(&pollTimer, &QTimer::timeout, this, &SweepRunner::poll);
+}
+
+SweepRunner::~SweepRunner()
+{
+    // 对话框关闭时不留下孤儿进程
+    for (Runtime &rt : runtimes) {
+        if (rt.process && rt.process->state() != QProcess::NotRunning) {
+            ProcessControl::terminateTree(*rt.process, 2000);
+        }
+    }
+}
+
+QList<double> SweepRunner::parseValues(const QString &text, bool *ok)
+{
+    QList<double> values;
+    bool good = true;
+    QString trimmed = text.trimmed();
+    if (trimmed.contains(':')) {
+        // 区间写法 start:end:step
+        QStringList parts = trimmed.split(':');
+        double start = 0, end = 0, step = 0;
+        bool ok1 = false, ok2 = false, ok3 = false;
+        if (parts.size() == 3) {
+            start = parts[0].trimmed().toDouble(&ok1);
+            end = parts[1].trimmed().toDouble(&ok2);
+            step = parts[2].trimmed().toDouble(&ok3);
+        }
+        if (!ok1 || !ok2 || !ok3 || step <= 0 || end < start) {
+            good = false;
+        } else {
+            for (int i = 0; i < 1000; ++i) {
+                double v = start + i * step;
+                if (v > end + step * 1e-9) break;
+                values << v;
+            }
+        }
+    } else {
+        for (const QString &part : trimmed.split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts)) {
+            bool partOk = false;
+            double v = part.toDouble(&partOk);
+            if (!partOk) { good = false; break; }
+            if (!values.contains(v)) values << v;
+        }
+    }
+    if (values.isEmpty()) good = false;
+    if (ok) *ok = good;
+    return good ? values : QList<double>();
+}
+
+QList<SweepRunner::ParamSet> SweepRunner::gridTrials(const SearchSpace &space)
+{
+    QList<ParamSet> result;
+    result << ParamSet();
+    for (auto it = space.constBegin(); it != space.constEnd(); ++it) {
+        QList<ParamSet> expanded;
+        for (const ParamSet &partial : result) {
+            for (double v : it.value()) {
+                ParamSet next = partial;
+                next.insert(it.key(), v);
+                expanded << next;
+            }
+        }
+        result = expanded;
+    }
+    return result;
+}
+
+QList<SweepRunner::ParamSet> SweepRunner::randomTrials(const SearchSpace &space, int count, quint32 seed)
+{
+    QList<ParamSet> result;
+    QRandomGenerator rng(seed);
+    for (int i = 0; i < count; ++i) {
+        ParamSet params;
+        for (auto it = space.constBegin(); it != space.constEnd(); ++it) {
+            const QList<double> &values = it.value();
+            if (values.isEmpty()) continue;
+            params.insert(it.key(), values.at(rng.bounded(int(values.size()))));
+        }
+        if (!result.contains(params)) result << params;
+    }
+    return result;
+}
+
+bool SweepRunner::isIntegerParam(const QString &key)
+{
+    const QString name = paramName(key);
+    return name == "batch size" || name == "saved";
+}
+
+QString SweepRunner::paramName(const QString &key)
+{
+    return key.section(':', 1);
+}
+
+int SweepRunner::effectiveParallel() const
+{
+    int parallel = qMax(1, opts.maxParallel);
+    int cores = qMax(1, QThread::idealThreadCount());
+    parallel = qMin(parallel, qMax(1, cores / qMax(1, opts.threadsPerTrial)));
+    if (opts.memoryBudgetMB > 0 && opts.memoryPerTrialMB > 0) {
+        parallel = qMin(parallel, qMax(1, opts.memoryBudgetMB / opts.memoryPerTrialMB));
+    }
+    return parallel;
+}
+
+int SweepRunner::activeCount() const
+{
+    int n = 0;
+    for (const Trial &t : trialList) {
+        if (t.state == TrialState::Step1 || t.state == TrialState::Running) ++n;
+    }
+    return n;
+}
+
+bool SweepRunner::start(const Options &options, const QList<ParamSet> &trialParams, QString *error)
+{
+    if (running) {
+        if (error) *error = tr("A sweep is already running");
+        return false;
+    }
+    if (trialParams.isEmpty()) {
+        if (error) *error = tr("No trials to run");
+        return false;
+    }
+    opts = options;
+    trialList.clear();
+    runtimes.clear();
+    rungResults.clear();
+    // 只有RepGeno参数取了多个值时每个试验才需要重新跑第一步
+    QMap<QString, QList<double>> seen;
+    for (const ParamSet &params : trialParams) {
+        for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+            if (!seen[it.key()].contains(it.value())) seen[it.key()] << it.value();
+        }
+    }
+    needsStep1 = false;
+    for (auto it = seen.constBegin(); it != seen.constEnd(); ++it) {
+        if (it.key().startsWith("RepGeno:") && it.value().size() > 1) needsStep1 = true;
+    }
+
+    sweepRoot = opts.menetDir + QString("/sweeps/%1_%2").arg(opts.phenotype, QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+    // 试验目录在launch时才建，等待中的试验不占磁盘，也不在界面线程里一次建完
+    for (int i = 0; i < trialParams.size(); ++i) {
+        Trial trial;
+        trial.id = i + 1;
+        trial.params = trialParams.at(i);
+        trial.dir = sweepRoot + QString("/trial_%1").arg(trial.id, 3, 10, QChar('0'));
+        trialList << trial;
+        runtimes << Runtime();
+    }
+    qCInfo(lcWorker) << "[SweepRunner] Starting sweep with" << trialList.size() << "trials, parallel=" << effectiveParallel()
+                     << ", needsStep1=" << needsStep1 << ", root=" << sweepRoot;
+    running = true;
+    pollTimer.start();
+    poll();
+    return true;
+}
+
+void SweepRunner::cancel()
+{
+    for (int i = 0; i < trialList.size(); ++i) {
+        Trial &t = trialList[i];
+        if (t.state == TrialState::Pending) {
+            t.state = TrialState::Cancelled;
+            emit trialUpdated(i);
+        } else if (t.state == TrialState::Step1 || t.state == TrialState::Running) {
+            t.state = TrialState::Cancelled;
+            ProcessControl::terminateTreeAsync(runtimes[i].process);
+            emit trialUpdated(i);
+        }
+    }
+}
+
+bool SweepRunner::prepareTrial(Trial &t, QString *error) const
+{
+    if (!TrialWorkspace::prepare(opts.menetDir, t.dir, error)) return false;
+    QJsonObject menetValues, repGenoValues;
+    for (auto it = t.params.constBegin(); it != t.params.constEnd(); ++it) {
+        QJsonObject &target = it.key().startsWith("RepGeno:") ? repGenoValues : menetValues;
+        if (isIntegerParam(it.key())) target[paramName(it.key())] = qRound(it.value());
+        else target[paramName(it.key())] = it.value();
+    }
+    if (!menetValues.isEmpty()) TrialWorkspace::updatePhenotypeConfig(t.dir, "MeNet.json", opts.phenotype, menetValues);
+    if (!repGenoValues.isEmpty()) TrialWorkspace::updatePhenotypeConfig(t.dir, "RepGeno.json", opts.phenotype, repGenoValues);
+    return true;
+}
+
+void SweepRunner::launch(int index, bool step1)
+{
+    Trial &t = trialList[index];
+    Runtime &rt = runtimes[index];
+    if (t.state == TrialState::Pending) {
+        QString prepareError;
+        if (!prepareTrial(t, &prepareError)) {
+            qCWarning(lcWorker) << "[SweepRunner] Trial" << t.id << "workspace failed:" << prepareError;
+            TrialWorkspace::remove(t.dir);
+            t.state = TrialState::Failed;
+            t.note = prepareError;
+            emit trialUpdated(index);
+            return;
+        }
+    }
+    const QString exeName = step1 ? "generate_genetic_relatedness.exe" : "train_menet.exe";
+    rt.process = new QProcess(this);
+    rt.process->setWorkingDirectory(t.dir);
+    rt.process->setProcessChannelMode(QProcess::MergedChannels);
+    rt.process->setStandardOutputFile(t.dir + (step1 ? "/step1_output.txt" : "/step2_output.txt"));
+    ProcessControl::setThreadEnvironment(*rt.process, qMax(1, opts.threadsPerTrial));
+    ResourceControl::instance()->prepareProcess(*rt.process, "sweep");
+    connect(rt.process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, index](int exitCode, QProcess::ExitStatus status) { onProcessFinished(index, exitCode, status); });
+    connect(rt.process, &QProcess::errorOccurred, this, [this, index](QProcess::ProcessError err) {
+        if (err != QProcess::FailedToStart) return;
+        // 启动失败不会发出finished，在这里收尾
+        Runtime &failed = runtimes[index];
+        if (failed.process) {
+            failed.process->deleteLater();
+            failed.process = nullptr;
+        }
+        trialList[index].state = TrialState::Failed;
+        trialList[index].note = tr("Unable to start process");
+        if (!opts.keepWorkspaces) TrialWorkspace::remove(trialList[index].dir);
+        emit trialUpdated(index);
+        QTimer::singleShot(0, this, &SweepRunner::poll);
+    });
+    if (!step1) rt.follower.reset(t.dir + "/step2.log");
+    if (t.state == TrialState::Pending) rt.timer.start(); // 耗时包含第一步
+    t.state = step1 ? TrialState::Step1 : TrialState::Running;
+    qCDebug(lcWorker) << "[SweepRunner] Launching trial" << t.id << exeName << "in" << t.dir;
+    rt.process->start(t.dir + "/" + exeName, QStringList() << "--phenotype" << opts.phenotype);
+    emit trialUpdated(index);
+}
+
+void SweepRunner::onProcessFinished(int index, int exitCode, QProcess::ExitStatus status)
+{
+    Trial &t = trialList[index];
+    Runtime &rt = runtimes[index];
+    rt.process->deleteLater();
+    rt.process = nullptr;
+    const bool ok = status == QProcess::NormalExit && exitCode == 0;
+    if (t.state == TrialState::Step1) {
+        if (ok) {
+            launch(index, false);
+            return;
+        }
+        t.state = TrialState::Failed;
+        t.note = tr("generate_genetic_relatedness.exe failed");
+    } else if (t.state == TrialState::Running) {
+        t.seconds = rt.timer.elapsed() / 1000.0;
+        // 最终指标和step2Finished一样取日志最后一个非空行
+        EpochMetrics metrics;
+        if (parseEpochMetrics(LogTail::lastNonEmptyLine(t.dir + "/step2.log"), metrics)) {
+            if (metrics.values.contains("val_R2")) t.valR2 = metrics.values.value("val_R2");
+            if (metrics.values.contains("train_R2")) t.trainR2 = metrics.values.value("train_R2");
+            t.lastEpoch = qMax(t.lastEpoch, metrics.epoch);
+        }
+        t.state = ok ? TrialState::Done : TrialState::Failed;
+        if (!ok) t.note = tr("train_menet.exe failed (exit code %1)").arg(exitCode);
+    } else {
+        // 已被淘汰或取消，只记录耗时
+        t.seconds = rt.timer.elapsed() / 1000.0;
+    }
+    // 指标已经取完，和交叉验证一样默认不留试验目录里的模型和日志
+    if (!opts.keepWorkspaces) TrialWorkspace::remove(t.dir);
+    emit trialUpdated(index);
+    QTimer::singleShot(0, this, &SweepRunner::poll);
+}
+
+int SweepRunner::rungEpoch(int rung) const
+{
+    int epoch = qMax(1, opts.minRungEpoch);
+    for (int i = 0; i < rung; ++i) epoch *= qMax(2, opts.eta);
+    return epoch;
+}
+
+void SweepRunner::checkRungs(int index)
+{
+    if (!opts.successiveHalving) return;
+    Trial &t = trialList[index];
+    Runtime &rt = runtimes[index];
+    while (t.state == TrialState::Running && t.lastEpoch >= rungEpoch(rt.nextRung)) {
+        const int rung = rt.nextRung++;
+        auto it = rt.valByEpoch.lowerBound(rungEpoch(rung));
+        if (it == rt.valByEpoch.end()) continue;
+        const double value = it.value();
+        QList<double> &results = rungResults[rung];
+        results << value;
+        // 异步halving：只有排进该检查点前1/eta才继续
+        const int eta = qMax(2, opts.eta);
+        const int keep = qMax(1, int(results.size()) / eta);
+        const int better = int(std::count_if(results.begin(), results.end(), [value](double v) { return v > value; }));
+        if (results.size() >= eta && better >= keep) {
+            t.state = TrialState::Pruned;
+            t.note = tr("Pruned at epoch %1 (val_R2 %2)").arg(rungEpoch(rung)).arg(value);
+            qCDebug(lcWorker) << "[SweepRunner] Trial" << t.id << t.note;
+            ProcessControl::terminateTreeAsync(rt.process);
+        }
+    }
+}
+
+void SweepRunner::poll()
+{
+    if (!running) return;
+    for (int i = 0; i < trialList.size(); ++i) {
+        Trial &t = trialList[i];
+        if (t.state != TrialState::Running) continue;
+        Runtime &rt = runtimes[i];
+        bool changed = false;
+        for (const QString &line : rt.follower.readNewLines()) {
+            EpochMetrics metrics;
+            if (!parseEpochMetrics(line, metrics)) continue;
+            t.lastEpoch = qMax(t.lastEpoch, metrics.epoch);
+            if (metrics.values.contains("val_R2")) {
+                t.valR2 = metrics.values.value("val_R2");
+                rt.valByEpoch.insert(metrics.epoch, t.valR2);
+            }
+            if (metrics.values.contains("train_R2")) t.trainR2 = metrics.values.value("train_R2");
+            changed = true;
+        }
+        t.seconds = rt.timer.elapsed() / 1000.0;
+        if (changed) checkRungs(i);
+        emit trialUpdated(i);
+    }
+    // 在核数和内存预算内补齐并发
+    for (int i = 0; i < trialList.size() && activeCount() < effectiveParallel(); ++i) {
+        if (trialList[i].state == TrialState::Pending) launch(i, needsStep1);
+    }
+    bool anyLeft = false;
+    for (const Trial &t : trialList) {
+        if (t.state == TrialState::Pending || t.state == TrialState::Step1 || t.state == TrialState::Running) anyLeft = true;
+    }
+    bool anyProcess = false;
+    for (const Runtime &rt : runtimes) {
+        if (rt.process) anyProcess = true;
+    }
+    if (!anyLeft && !anyProcess) {
+        running = false;
+        pollTimer.stop();
+        // 各试验目录都删掉后只剩空的根目录，rmdir不会动保留下来的内容
+        if (!opts.keepWorkspaces) QDir().rmdir(sweepRoot);
+        qCInfo(lcWorker) << "[SweepRunner] Sweep finished";
+        emit finished();
+    }
+}
+
+QList<int> SweepRunner::ranking() const
+{
+    auto stateOrder = [](TrialState s) {
+        switch (s) {
+        case TrialState::Done: return 0;
+        case TrialState::Running: return 1;
+        case TrialState::Step1: return 2;
+        case TrialState::Pruned: return 3;
+        case TrialState::Pending: return 4;
+        default: return 5;
+        }
+    };
+    QList<int> order;
+    for (int i = 0; i < trialList.size(); ++i) order << i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const Trial &ta = trialList[a];
+        const Trial &tb = trialList[b];
+        if (stateOrder(ta.state) != stateOrder(tb.state)) return stateOrder(ta.state) < stateOrder(tb.state);
+        const bool aNan = qIsNaN(ta.valR2), bNan = qIsNaN(tb.valR2);
+        if (aNan != bNan) return bNan;
+        return !aNan && ta.valR2 > tb.valR2;
+    });
+    return order;
+}
+
+bool SweepRunner::applyToConfigs(int trialIndex, QString *error) const
+{
+    if (trialIndex < 0 || trialIndex >= trialList.size()) {
+        if (error) *error = tr("Invalid trial");
+        return false;
+    }
+    const Trial &t = trialList[trialIndex];
+    QJsonObject menetValues, repGenoValues;
+    for (auto it = t.params.constBegin(); it != t.params.constEnd(); ++it) {
+        QJsonObject &target = it.key().startsWith("RepGeno:") ? repGenoValues : menetValues;
+        if (isIntegerParam(it.key())) target[paramName(it.key())] = qRound(it.value());
+        else target[paramName(it.key())] = it.value();
+    }
+    // TrialWorkspace按 <dir>/configs/<name> 定位，原MENET目录同样适用
+    bool ok = true;
+    if (!menetValues.isEmpty()) ok = TrialWorkspace::updatePhenotypeConfig(opts.menetDir, "MeNet.json", opts.phenotype, menetValues) && ok;
+    if (!repGenoValues.isEmpty()) ok = TrialWorkspace::updatePhenotypeConfig(opts.menetDir, "RepGeno.json", opts.phenotype, repGenoValues) && ok;
+    if (!ok && error) *error = tr("Unable to write configs in %1/configs").arg(opts.menetDir);
+    return ok;
+}
@@ -0,0 +1,106 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+#include <QtNumeric>
+#include <QVector>
+#include "logfollower.h"
+
+// 超参数搜索：网格/随机生成试验，在隔离目录中并发运行train_menet，
+// 可选异步successive halving（ASHA）提前淘汰差的试验
+class SweepRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 参数键形如 "MeNet:p1"、"RepGeno:p"
+    using ParamSet = QMap<QString, double>;
+    using SearchSpace = QMap<QString, QList<double>>;
+
+    enum class TrialState { Pending, Step1, Running, Done, Failed, Pruned, Cancelled };
+
+    struct Trial {
+        int id = 0;
+        ParamSet params;
+        QString dir;
+        TrialState state = TrialState::Pending;
+        double valR2 = qQNaN();   // 最近一次解析到的val_R2
+        double trainR2 = qQNaN();
+        int lastEpoch = -1;
+        double seconds = 0.0;
+        QString note;
+    };
+
+    struct Options {
+        QString menetDir;               // 原MENET目录
+        QString phenotype;
+        int maxParallel = 2;            // 同时运行的试验数上限
+        int threadsPerTrial = 1;        // 每个试验的OMP/MKL线程数
+        int memoryBudgetMB = 0;         // 0表示不限制
+        int memoryPerTrialMB = 2048;    // 单个试验的内存估计
+        bool successiveHalving = false;
+        int minRungEpoch = 10;          // 第一个淘汰检查点
+        int eta = 3;                    // 每个检查点只保留前1/eta
+        bool keepWorkspaces = false;    // 结束后保留sweeps下各试验目录（日志、模型）
+    };
+
+    explicit SweepRunner(QObject *parent = nullptr);
+    ~SweepRunner();
+
+    // 解析 "64,128,256" 列表或 "0.5:0.9:0.1" 区间
+    static QList<double> parseValues(const QString &text, bool *ok = nullptr);
+    static QList<ParamSet> gridTrials(const SearchSpace &space);
+    static QList<ParamSet> randomTrials(const SearchSpace &space, int count, quint32 seed);
+    static bool isIntegerParam(const QString &key);
+    static QString paramName(const QString &key); // "MeNet:p1" -> "p1"
+
+    bool start(const Options &options, const QList<ParamSet> &trialParams, QString *error = nullptr);
+    void cancel();
+    bool isRunning() const { return running; }
+    const QVector<Trial> &trials() const { return trialList; }
+    // 按val_R2从高到低排序的试验下标，完成的排在被淘汰的前面
+    QList<int> ranking() const;
+    // 把某个试验的参数写回MENET/configs下的MeNet.json（和RepGeno.json）
+    bool applyToConfigs(int trialIndex, QString *error = nullptr) const;
+
+signals:
+    void trialUpdated(int index);
+    void finished();
+
+private slots:
+    void poll();
+
+private:
+    struct Runtime {
+        QProcess *process = nullptr;
+        QElapsedTimer timer;
+        LogFollower follower;
+        QMap<int, double> valByEpoch; // 供淘汰检查点查询
+        int nextRung = 0;
+    };
+
+    Options opts;
+    QVector<Trial> trialList;
+    QVector<Runtime> runtimes;
+    QMap<int, QList<double>> rungResults; // 检查点下标 -> 到达该点的试验val_R2
+    QTimer pollTimer;
+    QString sweepRoot;
+    bool running = false;
+    bool needsStep1 = false;
+
+    int effectiveParallel() const;
+    int activeCount() const;
+    bool prepareTrial(Trial &t, QString *error) const;
+    void launch(int index, bool step1);
+    void onProcessFinished(int index, int exitCode, QProcess::ExitStatus status);
+    void checkRungs(int index);
+    int rungEpoch(int rung) const;
+};
+
+#endif // SWEEPRUNNER_H
@@ -0,0 +1,156 @@
+#include "trainingcurvewidget.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <QtMath>
+
+TrainingCurveWidget::TrainingCurveWidget(QWidget *parent) : QWidget(parent)
+{
+    setMinimumHeight(180);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TrainingCurveWidget::setTitle(const QString &title)
+{
+    titleText = title;
+    update();
+}
+
+void TrainingCurveWidget::clear()
+{
+    series.clear();
+    maxEpoch = 0;
+    update();
+}
+
+bool TrainingCurveWidget::isLossMetric(const QString &name)
+{
+    return name.contains("loss", Qt::CaseInsensitive);
+}
+
+void TrainingCurveWidget::Series::add(int epoch, double value)
+{
+    latest = value;
+    if (!buckets.isEmpty()) {
+        Bucket &b = buckets.last();
+        if (epoch - b.firstEpoch < bucketSpan) {
+            b.lastEpoch = epoch;
+            b.min = qMin(b.min, value);
+            b.max = qMax(b.max, value);
+            b.last = value;
+            return;
+        }
+    }
+    if (buckets.size() == kCapacity) {
+        // 相邻两桶合并，保留每段的最小/最大值
+        int n = 0;
+        for (int i = 0; i + 1 < buckets.size(); i += 2) {
+            Bucket merged = buckets[i];
+            const Bucket &next = buckets[i + 1];
+            merged.lastEpoch = next.lastEpoch;
+            merged.min = qMin(merged.min, next.min);
+            merged.max = qMax(merged.max, next.max);
+            merged.last = next.last;
+            buckets[n++] = merged;
+        }
+        buckets.resize(n);
+        bucketSpan *= 2;
+    }
+    if (buckets.capacity() < kCapacity) buckets.reserve(kCapacity);
+    buckets.append({epoch, epoch, value, value, value});
+}
+
+void TrainingCurveWidget::addEpoch(const EpochMetrics &metrics)
+{
+    if (metrics.epoch < 0) return;
+    for (auto it = metrics.values.constBegin(); it != metrics.values.constEnd(); ++it) {
+        if (!qIsFinite(it.value())) continue;
+        series[it.key()].add(metrics.epoch, it.value());
+    }
+    maxEpoch = qMax(maxEpoch, metrics.epoch);
+    update(); // 合并到下一次绘制，不强制立即重绘
+}
+
+void TrainingCurveWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor("#ffffff"));
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    const QRectF plot = QRectF(rect()).adjusted(48, 28, -48, -22);
+    painter.setPen(QColor("#cccccc"));
+    painter.drawRect(plot);
+    painter.setPen(QColor("#333333"));
+    painter.drawText(QRectF(rect()).adjusted(8, 4, -8, 0), Qt::AlignTop | Qt::AlignLeft,
+                     titleText.isEmpty() ? tr("Training curves") : titleText);
+    if (series.isEmpty()) {
+        painter.setPen(QColor("#999999"));
+        painter.drawText(plot, Qt::AlignCenter, tr("Waiting for epochs..."));
+        return;
+    }
+
+    // 左轴：R²等指标；右轴：loss类指标，各自按数据范围自适应
+    double leftMin = qInf(), leftMax = -qInf(), rightMin = qInf(), rightMax = -qInf();
+    for (auto it = series.constBegin(); it != series.constEnd(); ++it) {
+        const bool loss = isLossMetric(it.key());
+        for (const Bucket &b : it.value().buckets) {
+            double &lo = loss ? rightMin : leftMin;
+            double &hi = loss ? rightMax : leftMax;
+            lo = qMin(lo, b.min);
+            hi = qMax(hi, b.max);
+        }
+    }
+    auto padRange = [](double &lo, double &hi) {
+        if (!qIsFinite(lo) || !qIsFinite(hi)) { lo = 0.0; hi = 1.0; return; }
+        if (hi - lo < 1e-9) { lo -= 0.5; hi += 0.5; return; }
+        double pad = (hi - lo) * 0.05;
+        lo -= pad;
+        hi += pad;
+    };
+    padRange(leftMin, leftMax);
+    padRange(rightMin, rightMax);
+    const double epochSpan = qMax(1, maxEpoch);
+    auto mapX = [&](double epoch) { return plot.left() + plot.width() * epoch / epochSpan; };
+    auto mapY = [&](double v, bool loss) {
+        double lo = loss ? rightMin : leftMin;
+        double hi = loss ? rightMax : leftMax;
+        return plot.bottom() - plot.height() * (v - lo) / (hi - lo);
+    };
+
+    // 坐标轴刻度
+    painter.setPen(QColor("#666666"));
+    QFont small = font();
+    small.setPointSizeF(qMax(6.0, small.pointSizeF() - 1));
+    painter.setFont(small);
+    painter.drawText(QRectF(0, plot.top() - 8, plot.left() - 4, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(leftMax, 'g', 3));
+    painter.drawText(QRectF(0, plot.bottom() - 8, plot.left() - 4, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(leftMin, 'g', 3));
+    painter.drawText(QRectF(plot.right() + 4, plot.top() - 8, 44, 16), Qt::AlignLeft | Qt::AlignVCenter, QString::number(rightMax, 'g', 3));
+    painter.drawText(QRectF(plot.right() + 4, plot.bottom() - 8, 44, 16), Qt::AlignLeft | Qt::AlignVCenter, QString::number(rightMin, 'g', 3));
+    painter.drawText(QRectF(plot.left(), plot.bottom() + 2, plot.width(), 18), Qt::AlignRight | Qt::AlignTop, tr("epoch %1").arg(maxEpoch));
+
+    static const QColor palette[] = {QColor("#4f8cff"), QColor("#e8590c"), QColor("#2b8a3e"),
+                                     QColor("#ae3ec9"), QColor("#f59f00"), QColor("#1098ad")};
+    int colorIndex = 0;
+    qreal legendX = plot.left() + 150;
+    for (auto it = series.constBegin(); it != series.constEnd(); ++it, ++colorIndex) {
+        const QColor color = palette[colorIndex % 6];
+        const bool loss = isLossMetric(it.key());
+        const Series &s = it.value();
+        QPolygonF line;
+        line.reserve(s.buckets.size());
+        QColor bandColor = color;
+        bandColor.setAlpha(70);
+        painter.setPen(QPen(bandColor, 1));
+        for (const Bucket &b : s.buckets) {
+            double x = mapX((b.firstEpoch + b.lastEpoch) / 2.0);
+            if (b.max > b.min) painter.drawLine(QPointF(x, mapY(b.min, loss)), QPointF(x, mapY(b.max, loss)));
+            line << QPointF(x, mapY(b.last, loss));
+        }
+        painter.setPen(QPen(color, 1.5));
+        painter.drawPolyline(line);
+        // 图例：名称 + 最新值
+        QString legend = QString("%1 %2").arg(it.key()).arg(s.latest, 0, 'g', 4);
+        painter.drawText(QPointF(legendX, plot.top() - 10), legend);
+        legendX += painter.fontMetrics().horizontalAdvance(legend) + 16;
+    }
+}
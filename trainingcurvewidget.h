@@ -0,0 +1,49 @@
+#ifndef TRAININGCURVEWIDGET_H
+#define TRAININGCURVEWIDGET_H
+
+#include <QWidget>
+#include <QMap>
+#include <QVector>
+#include "metricparser.h"
+
+// 实时训练曲线：每个指标一条曲线，按epoch增量追加
+class TrainingCurveWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TrainingCurveWidget(QWidget *parent = nullptr);
+    void setTitle(const QString &title);
+
+public slots:
+    void addEpoch(const EpochMetrics &metrics);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    // 固定容量的min/max抽样序列：桶满时相邻两桶合并、桶宽翻倍，
+    // 点数永远不超过kCapacity，上万epoch的重绘开销也是常数
+    struct Bucket {
+        int firstEpoch;
+        int lastEpoch;
+        double min;
+        double max;
+        double last;
+    };
+    struct Series {
+        QVector<Bucket> buckets;
+        int bucketSpan = 1; // 每个桶覆盖的epoch数
+        double latest = 0.0;
+        void add(int epoch, double value);
+    };
+    static constexpr int kCapacity = 512;
+
+    QString titleText;
+    QMap<QString, Series> series;
+    int maxEpoch = 0;
+    static bool isLossMetric(const QString &name);
+};
+
+#endif // TRAININGCURVEWIDGET_H
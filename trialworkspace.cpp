@@ -0,0 +1,141 @@
+#include "trialworkspace.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QDebug>
+
+static bool linkEntry(const QFileInfo &source, const QString &target)
+{
+#if defined(Q_OS_WIN)
+    // Windows下QFile::link生成的是.lnk快捷方式，目录用junction，文件直接复制
+    if (source.isDir()) {
+        return QProcess::execute("cmd", QStringList() << "/c" << "mklink" << "/J"
+                                 << QDir::toNativeSeparators(target)
+                                 << QDir::toNativeSeparators(source.absoluteFilePath())) == 0;
+    }
+    return QFile::copy(source.absoluteFilePath(), target);
+#else
+    return QFile::link(source.absoluteFilePath(), target);
+#endif
+}
+
+bool TrialWorkspace::prepare(const QString &menetDir, const QString &trialDir, QString *error)
+{
+    QDir source(menetDir);
+    if (!source.exists()) {
+        if (error) *error = QString("MENET directory not found: %1").arg(menetDir);
+        return false;
+    }
+    if (!QDir().mkpath(trialDir + "/configs") || !QDir().mkpath(trialDir + "/saved")) {
+        if (error) *error = QString("Unable to create trial directory: %1").arg(trialDir);
+        return false;
+    }
+    // 配置整份复制
+    QDir configs(menetDir + "/configs");
+    for (const QFileInfo &info : configs.entryInfoList(QDir::Files | QDir::NoDotAndDotDot)) {
+        QString target = trialDir + "/configs/" + info.fileName();
+        QFile::remove(target);
+        if (!QFile::copy(info.absoluteFilePath(), target)) {
+            if (error) *error = QString("Unable to copy config: %1").arg(info.fileName());
+            return false;
+        }
+    }
+    // 其余内容共享；日志、模型输出和其他试验目录不共享
+    static const QStringList privateEntries = {"configs", "saved", "sweeps", "tuning", "jobs", "logs", "cache", "registry",
+                                                "crossval"};
+    for (const QFileInfo &info : source.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+        if (privateEntries.contains(info.fileName())) continue;
+        if (info.suffix().toLower() == "log") continue;
+        if (info.fileName().endsWith("_pca_curve.png") || info.fileName().endsWith("_pred.csv")) continue;
+        QString target = trialDir + "/" + info.fileName();
+        if (QFileInfo::exists(target)) continue;
+        if (!linkEntry(info, target)) {
+            if (error) *error = QString("Unable to link %1 into trial directory").arg(info.fileName());
+            return false;
+        }
+    }
+    return true;
+}
+
+// 删除链接本身（Windows的junction用rmdir）
+static void unlinkEntry(const QFileInfo &info)
+{
+#if defined(Q_OS_WIN)
+    if (info.isJunction()) {
+        QDir().rmdir(info.absoluteFilePath());
+        return;
+    }
+#endif
+    QFile::remove(info.absoluteFilePath());
+}
+
+bool TrialWorkspace::makePrivateDir(const QString &menetDir, const QString &trialDir, const QString &relativeDir,
+                                    QString *error)
+{
+    const QStringList parts = relativeDir.split('/', Qt::SkipEmptyParts);
+    QString sourcePath = menetDir;
+    QString targetPath = trialDir;
+    for (int i = 0; i < parts.size(); ++i) {
+        sourcePath += "/" + parts.at(i);
+        targetPath += "/" + parts.at(i);
+        const QFileInfo target(targetPath);
+        if (target.isSymLink() || target.isJunction()) unlinkEntry(target);
+        if (!QDir().mkpath(targetPath)) {
+            if (error) *error = QString("Unable to create %1").arg(targetPath);
+            return false;
+        }
+        if (i + 1 == parts.size()) break;
+        // 中间一层：除了下一层要私有的目录，其余条目照旧链接到原目录
+        for (const QFileInfo &info : QDir(sourcePath).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+            if (info.fileName() == parts.at(i + 1)) continue;
+            const QString entryTarget = targetPath + "/" + info.fileName();
+            if (QFileInfo::exists(entryTarget)) continue;
+            if (!linkEntry(info, entryTarget)) {
+                if (error) *error = QString("Unable to link %1 into trial directory").arg(info.fileName());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TrialWorkspace::updatePhenotypeConfig(const QString &trialDir, const QString &configName,
+                                           const QString &phenotype, const QJsonObject &values)
+{
+    QFile file(trialDir + "/configs/" + configName);
+    QJsonObject obj;
+    if (file.open(QIODevice::ReadOnly)) {
+        obj = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+    }
+    QJsonObject phenoObj = obj.value(phenotype).toObject();
+    for (auto it = values.begin(); it != values.end(); ++it) {
+        phenoObj[it.key()] = it.value();
+    }
+    obj[phenotype] = phenoObj;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Indented));
+    file.close();
+    return true;
+}
+
+// 递归删掉目录里的所有链接，私有子目录（makePrivateDir）里的链接也一样
+static void unlinkShared(const QString &path)
+{
+    for (const QFileInfo &info : QDir(path).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System)) {
+        if (info.isSymLink() || info.isJunction()) {
+            unlinkEntry(info);
+        } else if (info.isDir()) {
+            unlinkShared(info.absoluteFilePath());
+        }
+    }
+}
+
+void TrialWorkspace::remove(const QString &trialDir)
+{
+    // 先删链接本身，避免removeRecursively顺着链接删掉共享数据
+    unlinkShared(trialDir);
+    QDir(trialDir).removeRecursively();
+}
@@ -0,0 +1,23 @@
+#ifndef TRIALWORKSPACE_H
+#define TRIALWORKSPACE_H
+
+#include <QString>
+#include <QJsonObject>
+
+// 为并发试验准备隔离的MENET工作目录：
+// configs/ 整份复制（各试验独立修改），saved/ 新建，其余数据目录和exe以链接方式共享
+class TrialWorkspace
+{
+public:
+    // menetDir: 原MENET目录；trialDir: 新的试验目录（不存在会创建）
+    static bool prepare(const QString &menetDir, const QString &trialDir, QString *error = nullptr);
+    // 修改试验目录下 configs/<configName> 中某个表型的参数
+    // 把共享的relativeDir（如"data/phen"）换成试验自己的空目录，上级目录里的其他内容继续链接共享
+    static bool makePrivateDir(const QString &menetDir, const QString &trialDir, const QString &relativeDir,
+                               QString *error = nullptr);
+    static bool updatePhenotypeConfig(const QString &trialDir, const QString &configName,
+                                      const QString &phenotype, const QJsonObject &values);
+    static void remove(const QString &trialDir);
+};
+
+#endif // TRIALWORKSPACE_H
@@ -0,0 +1,201 @@
+#include "tunedialog.h"
+#include "sweeprunner.h"
+#include <QCheckBox>
+#include <QComboBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QThread>
+#include <QtMath>
+#include <QVBoxLayout>
+
+// 默认线程数网格：1、2、4…直到核数，再加上核数本身
+static QString defaultThreadGrid()
+{
+    const int cores = qMax(1, QThread::idealThreadCount());
+    QStringList values;
+    for (int t = 1; t < cores; t *= 2) values << QString::number(t);
+    values << QString::number(cores);
+    return values.join(",");
+}
+
+TuneDialog::TuneDialog(const QString &menetDir, const QStringList &phenotypes, QWidget *parent)
+    : QDialog(parent), menetDir(menetDir), tuner(new AutoTuner(this))
+{
+    setWindowTitle(tr("Calibrate for This Machine"));
+    resize(760, 620);
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    comboPhenotype = new QComboBox(this);
+    comboPhenotype->addItems(phenotypes);
+    labelCurrent = new QLabel(this);
+    QFormLayout *topLayout = new QFormLayout();
+    topLayout->addRow(tr("Phenotype:"), comboPhenotype);
+    topLayout->addRow(tr("Current default:"), labelCurrent);
+    mainLayout->addLayout(topLayout);
+
+    QGroupBox *gridGroup = new QGroupBox(tr("Probe Grid"), this);
+    QFormLayout *gridLayout = new QFormLayout();
+    editBatchSizes = new QLineEdit("32,64,128,256,512", this);
+    editThreads = new QLineEdit(defaultThreadGrid(), this);
+    spinProbeSeconds = new QSpinBox(this);
+    spinProbeSeconds->setRange(10, 3600);
+    spinProbeSeconds->setValue(90);
+    spinProbeSeconds->setSuffix(" s");
+    spinMemoryCap = new QSpinBox(this);
+    spinMemoryCap->setRange(0, 4 * 1024 * 1024);
+    spinMemoryCap->setSuffix(" MB");
+    spinMemoryCap->setSpecialValueText(tr("Unlimited"));
+    checkStep1 = new QCheckBox(tr("Run generate_genetic_relatedness.exe once first"), this);
+    checkStep1->setToolTip(tr("Needed when this phenotype has not been trained on this machine yet"));
+    gridLayout->addRow(tr("Batch sizes:"), editBatchSizes);
+    gridLayout->addRow(tr("Thread counts:"), editThreads);
+    gridLayout->addRow(tr("Time per probe:"), spinProbeSeconds);
+    gridLayout->addRow(tr("Memory cap:"), spinMemoryCap);
+    gridLayout->addRow(checkStep1);
+    gridGroup->setLayout(gridLayout);
+    mainLayout->addWidget(gridGroup);
+
+    table = new QTableWidget(this);
+    table->setColumnCount(6);
+    table->setHorizontalHeaderLabels({tr("Batch size"), tr("Threads"), tr("Epochs/s"), tr("Peak memory"),
+                                      tr("Epochs"), tr("Status")});
+    table->horizontalHeader()->setSectionResizeMode(5, QHeaderView::Stretch);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    mainLayout->addWidget(table, 1);
+
+    labelStatus = new QLabel(this);
+    mainLayout->addWidget(labelStatus);
+
+    btnStart = new QPushButton(tr("Start"), this);
+    btnStop = new QPushButton(tr("Stop"), this);
+    btnStop->setEnabled(false);
+    QHBoxLayout *btnRow = new QHBoxLayout();
+    btnRow->addStretch();
+    btnRow->addWidget(btnStart);
+    btnRow->addWidget(btnStop);
+    mainLayout->addLayout(btnRow);
+    setLayout(mainLayout);
+
+    connect(comboPhenotype, &QComboBox::currentTextChanged, this, &TuneDialog::showCurrentProfile);
+    connect(btnStart, &QPushButton::clicked, this, &TuneDialog::startCalibration);
+    connect(btnStop, &QPushButton::clicked, this, &TuneDialog::stopCalibration);
+    connect(tuner, &AutoTuner::probeUpdated, this, &TuneDialog::refreshRow);
+    connect(tuner, &AutoTuner::step1Finished, this, [this](bool ok) {
+        labelStatus->setText(ok ? tr("Relatedness step finished, probing...") : tr("generate_genetic_relatedness.exe failed"));
+    });
+    connect(tuner, &AutoTuner::finished, this, &TuneDialog::onCalibrationFinished);
+    showCurrentProfile();
+}
+
+void TuneDialog::showCurrentProfile()
+{
+    const AutoTuner::Profile profile = AutoTuner::lookup(menetDir, comboPhenotype->currentText());
+    if (!profile.isValid()) {
+        labelCurrent->setText(tr("Not calibrated (%1)").arg(AutoTuner::sizeClassFor(menetDir, comboPhenotype->currentText())));
+        return;
+    }
+    labelCurrent->setText(tr("Batch %1, %2 threads, %3 epochs/s (%4, %5)")
+                              .arg(profile.batchSize).arg(profile.threads)
+                              .arg(profile.epochsPerSec, 0, 'f', 3).arg(profile.sizeClass, profile.measuredAt));
+}
+
+void TuneDialog::startCalibration()
+{
+    AutoTuner::Options options;
+    options.menetDir = menetDir;
+    options.phenotype = comboPhenotype->currentText();
+    bool okBatch = false, okThreads = false;
+    for (double v : SweepRunner::parseValues(editBatchSizes->text(), &okBatch)) {
+        if (v >= 1) options.batchSizes << qRound(v);
+    }
+    for (double v : SweepRunner::parseValues(editThreads->text(), &okThreads)) {
+        if (v >= 1) options.threadCounts << qRound(v);
+    }
+    if (!okBatch || !okThreads || options.batchSizes.isEmpty() || options.threadCounts.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("Please enter batch sizes and thread counts as lists like \"64,128\"."));
+        return;
+    }
+    options.probeSeconds = spinProbeSeconds->value();
+    options.memoryCapMB = spinMemoryCap->value();
+    options.runStep1 = checkStep1->isChecked();
+    QString error;
+    if (!tuner->start(options, &error)) {
+        QMessageBox::warning(this, tr("Error"), error);
+        return;
+    }
+    table->clearContents();
+    table->setRowCount(tuner->probes().size());
+    for (int i = 0; i < tuner->probes().size(); ++i) refreshRow(i);
+    btnStart->setEnabled(false);
+    btnStop->setEnabled(true);
+    comboPhenotype->setEnabled(false);
+    const int minutes = qCeil(tuner->probes().size() * options.probeSeconds / 60.0);
+    labelStatus->setText(tr("Running %1 probes, about %2 minutes...").arg(tuner->probes().size()).arg(minutes));
+}
+
+void TuneDialog::stopCalibration()
+{
+    tuner->cancel();
+    btnStop->setEnabled(false);
+}
+
+void TuneDialog::refreshRow(int index)
+{
+    if (index < 0 || index >= table->rowCount()) return;
+    const AutoTuner::Probe &probe = tuner->probes().at(index);
+    auto stateText = [this](AutoTuner::ProbeState s) {
+        switch (s) {
+        case AutoTuner::ProbeState::Pending: return tr("Pending");
+        case AutoTuner::ProbeState::Running: return tr("Running");
+        case AutoTuner::ProbeState::Done: return tr("Done");
+        case AutoTuner::ProbeState::OverMemory: return tr("Over memory cap");
+        case AutoTuner::ProbeState::Failed: return tr("Failed");
+        case AutoTuner::ProbeState::Skipped: return tr("Skipped");
+        case AutoTuner::ProbeState::Cancelled: return tr("Cancelled");
+        }
+        return QString();
+    };
+    QString status = stateText(probe.state);
+    if (!probe.note.isEmpty()) status += " - " + probe.note;
+    const QStringList cells = {QString::number(probe.batchSize), QString::number(probe.threads),
+                               probe.epochsPerSec > 0 ? QString::number(probe.epochsPerSec, 'f', 3) : QString("-"),
+                               probe.peakMB > 0 ? QString("%1 MB").arg(probe.peakMB, 0, 'f', 0) : QString("-"),
+                               QString::number(probe.epochs), status};
+    for (int col = 0; col < cells.size(); ++col) {
+        QTableWidgetItem *item = table->item(index, col);
+        if (!item) {
+            item = new QTableWidgetItem();
+            table->setItem(index, col, item);
+        }
+        item->setText(cells.at(col));
+    }
+}
+
+void TuneDialog::onCalibrationFinished()
+{
+    btnStart->setEnabled(true);
+    btnStop->setEnabled(false);
+    comboPhenotype->setEnabled(true);
+    const int best = tuner->bestIndex();
+    if (best < 0) {
+        labelStatus->setText(tr("Calibration finished without a usable probe; the default was not changed."));
+        return;
+    }
+    table->selectRow(best);
+    const AutoTuner::Probe &probe = tuner->probes().at(best);
+    const QString saved = tuner->wasCancelled() ? tr("Stopped early; the default was not changed.")
+                                                : tr("Saved as the default for this machine.");
+    labelStatus->setText(tr("Best: batch %1 with %2 threads (%3 epochs/s). %4")
+                             .arg(probe.batchSize).arg(probe.threads).arg(probe.epochsPerSec, 0, 'f', 3).arg(saved));
+    showCurrentProfile();
+}
@@ -0,0 +1,47 @@
+#ifndef TUNEDIALOG_H
+#define TUNEDIALOG_H
+
+#include <QDialog>
+#include "autotuner.h"
+
+class QComboBox;
+class QLineEdit;
+class QSpinBox;
+class QCheckBox;
+class QPushButton;
+class QTableWidget;
+class QLabel;
+
+// 本机校准对话框：选表型和探测网格，逐个短时运行并显示每秒epoch数/峰值内存，
+// 结束后把最佳组合存为本机该规模档的默认值
+class TuneDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit TuneDialog(const QString &menetDir, const QStringList &phenotypes, QWidget *parent = nullptr);
+
+private slots:
+    void showCurrentProfile();
+    void startCalibration();
+    void stopCalibration();
+    void refreshRow(int index);
+    void onCalibrationFinished();
+
+private:
+    QString menetDir;
+    AutoTuner *tuner;
+    QComboBox *comboPhenotype;
+    QLineEdit *editBatchSizes;
+    QLineEdit *editThreads;
+    QSpinBox *spinProbeSeconds;
+    QSpinBox *spinMemoryCap;
+    QCheckBox *checkStep1;
+    QPushButton *btnStart;
+    QPushButton *btnStop;
+    QTableWidget *table;
+    QLabel *labelCurrent;
+    QLabel *labelStatus;
+};
+
+#endif // TUNEDIALOG_H
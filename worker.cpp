@@ -1,5 +1,10 @@
 #include "worker.h"
-#include "mainwindow.h"
+#include "logfollower.h"
+#include "logtail.h"
+#include "processcontrol.h"
+#include "resourcecontrol.h"
+#include "outputcapture.h"
+#include "logcategories.h"
 #include <QProcess>
 #include <QFile>
 #include <QFileInfo>
@@ -9,14 +14,14 @@
 #include <QDir>
 #include <QElapsedTimer>
 #include <QRegularExpression>
-#include <QDebug>
 #include <QThread>
 
-Worker::Worker(QObject *parent) : QObject(parent), main_window(nullptr), current_progress(0) {
-    qDebug() << "[Worker] Constructed, this=" << this << ", thread=" << QThread::currentThread();
+Worker::Worker(QObject *parent) : QObject(parent), current_progress(0) {
+    qRegisterMetaType<EpochMetrics>("EpochMetrics");
+    qCDebug(lcWorker) << "[Worker] Constructed, this=" << this << ", thread=" << QThread::currentThread();
     // 按照参考代码模式：连接内部信号到内部槽
     bool conn = connect(this, SIGNAL(sendProgressSignal()), this, SLOT(updateProgress()));
-    qDebug() << "[Worker] sendProgressSignal->updateProgress connected:" << conn;
+    qCDebug(lcWorker) << "[Worker] sendProgressSignal->updateProgress connected:" << conn;
 }
 
 void Worker::setParams(const QString &exe1, const QString &exe2, const QString &log1, const QString &log2, const QString &json1, const QString &json2, const QString &pheno) {
@@ -27,71 +32,113 @@ void Worker::setParams(const QString &exe1, const QString &exe2, const QString &
     jsonPath1 = json1; 
     jsonPath2 = json2; 
     phenotype = pheno;
-    qDebug() << "[Worker] setParams called, this=" << this << ", exe1=" << exe1 << ", exe2=" << exe2 << ", pheno=" << pheno;
+    qCDebug(lcWorker) << "[Worker] setParams called, this=" << this << ", exe1=" << exe1 << ", exe2=" << exe2 << ", pheno=" << pheno;
 }
 
-void Worker::setMainWindow(MainWindow *mainWin) {
-    main_window = mainWin;
-    qDebug() << "[Worker] setMainWindow called, this=" << this << ", mainWin=" << mainWin;
+void Worker::setEarlyStopping(const EarlyStopper::Config &config) {
+    earlyStopConfig = config;
+    qCDebug(lcWorker) << "[Worker] setEarlyStopping enabled=" << config.enabled << ", patience=" << config.patience << ", minDelta=" << config.minDelta;
+}
+
+void Worker::requestCancel() {
+    // 由GUI线程直接调用，监控循环最多500ms内响应
+    cancelRequested = true;
+    qCDebug(lcWorker) << "[Worker] requestCancel called, this=" << this;
+}
+
+void Worker::setResume(bool skip, const QStringList &extraArgs) {
+    skipStep1 = skip;
+    step2ExtraArgs = extraArgs;
+    qCDebug(lcWorker) << "[Worker] setResume skipStep1=" << skip << ", step2ExtraArgs=" << extraArgs;
+}
+
+void Worker::setStep1Weight(double weight) {
+    step1Weight = qBound(0.0, weight, 1.0);
+    qCDebug(lcWorker) << "[Worker] setStep1Weight:" << step1Weight;
+}
+
+void Worker::setThreadCount(int threads) {
+    threadCount = qMax(0, threads);
+}
+
+void Worker::setProgressChannel(std::shared_ptr<ProgressChannel> channel) {
+    progressChannel = std::move(channel);
 }
 
 void Worker::updateProgress() {
-    qDebug() << "[Worker] updateProgress called, this=" << this << ", progress=" << current_progress << ", thread=" << QThread::currentThread();
-    // 按照参考代码模式：直接调用主窗口的方法更新进度
-    if (main_window) {
-        main_window->changeProgress(current_progress);
-    } else {
-        qDebug() << "[Worker] main_window is nullptr!";
-    }
+    qCDebug(lcProgress) << "[Worker] updateProgress called, this=" << this << ", progress=" << current_progress << ", thread=" << QThread::currentThread();
+    // 不直接操作界面：GUI从进度通道按帧率读取，agent连接信号转发给调度端
+    if (progressChannel) progressChannel->setPercent(current_progress);
+    emit progressChanged(current_progress);
 }
 
 int Worker::calculateOverallProgress(int stepProgress, bool isStep1) {
+    // 两步的区间按预计耗时划分，默认各占一半
+    const double split = step1Weight * 100.0;
     if (isStep1) {
-        // 第一步：0-50%
-        return stepProgress / 2;
+        return qRound(stepProgress * step1Weight);
     } else {
-        // 第二步：50-100%
-        return 50 + stepProgress / 2;
+        return qRound(split + stepProgress * (1.0 - step1Weight));
     }
 }
 
 void Worker::run() {
-    qDebug() << "[Worker] ===== Worker::run() called! ===== this=" << this << ", thread=" << QThread::currentThread() << ", func=" << Q_FUNC_INFO;
-    qDebug() << "[Worker] Start run: " << exePath1 << exePath2;
+    qCDebug(lcWorker) << "[Worker] ===== Worker::run() called! ===== this=" << this << ", thread=" << QThread::currentThread() << ", func=" << Q_FUNC_INFO;
+    qCInfo(lcWorker) << "[Worker] Start run: " << exePath1 << exePath2;
     
     // 检查exe文件是否存在
-    qDebug() << "[Worker] Checking exe files:";
-    qDebug() << "[Worker] exePath1 exists:" << QFile::exists(exePath1) << ", path:" << exePath1;
-    qDebug() << "[Worker] exePath2 exists:" << QFile::exists(exePath2) << ", path:" << exePath2;
+    qCDebug(lcWorker) << "[Worker] Checking exe files:";
+    qCDebug(lcWorker) << "[Worker] exePath1 exists:" << QFile::exists(exePath1) << ", path:" << exePath1;
+    qCDebug(lcWorker) << "[Worker] exePath2 exists:" << QFile::exists(exePath2) << ", path:" << exePath2;
     
-    // 第一步：generate_genetic_relatedness.exe (0-50%)
-    qDebug() << "[Worker] ===== Starting Step 1 =====";
-    StepResult r1 = runStep(exePath1, logPath1, jsonPath1, phenotype, true);
-    qDebug() << "[Worker] runStep1 finished, ok=" << r1.ok << ", seconds=" << r1.seconds;
+    // 第一步：generate_genetic_relatedness.exe（进度条前step1Weight部分）
+    StepResult r1;
+    if (skipStep1) {
+        // 续跑时第一步已在上次运行中完成
+        qCInfo(lcWorker) << "[Worker] ===== Skipping Step 1 (completed before restart) =====";
+        r1 = {true, 0.0, QDateTime::currentDateTime(), QDateTime::currentDateTime()};
+        current_progress = calculateOverallProgress(100, true);
+        emit sendProgressSignal();
+    } else {
+        qCInfo(lcWorker) << "[Worker] ===== Starting Step 1 =====";
+        r1 = runStep(exePath1, logPath1, jsonPath1, phenotype, true);
+    }
+    qCInfo(lcWorker) << "[Worker] runStep1 finished, ok=" << r1.ok << ", seconds=" << r1.seconds;
+    if (r1.cancelled || cancelRequested) {
+        emit finished(false, "训练已取消！", r1.seconds, r1.seconds, 0.0,
+                     r1.startTime, r1.endTime, QDateTime(), QDateTime());
+        return;
+    }
     if (!r1.ok) { 
-        qDebug() << "[Worker] Step 1 failed, stopping execution";
-        qDebug() << "[Worker] Step 1 failure details - check the logs above for process output and errors";
+        qCWarning(lcWorker) << "[Worker] Step 1 failed, stopping execution";
+        qCWarning(lcWorker) << "[Worker] Step 1 failure details - check the logs above for process output and errors";
         emit finished(false, "generate_genetic_relatedness.exe 运行失败！", r1.seconds, r1.seconds, 0.0,
                      r1.startTime, r1.endTime, QDateTime(), QDateTime()); 
         return; 
     } else {
-        qDebug() << "[Worker] Step 1 completed successfully, proceeding to Step 2";
+        qCInfo(lcWorker) << "[Worker] Step 1 completed successfully, proceeding to Step 2";
+        emit step1Completed();
     }
     
-    // 第二步：train_menet.exe (50-100%)
-    qDebug() << "[Worker] ===== Starting Step 2 =====";
+    // 第二步：train_menet.exe（进度条剩余部分）
+    qCInfo(lcWorker) << "[Worker] ===== Starting Step 2 =====";
     StepResult r2 = runStep(exePath2, logPath2, jsonPath2, phenotype, false);
-    qDebug() << "[Worker] runStep2 finished, ok=" << r2.ok << ", seconds=" << r2.seconds;
+    qCInfo(lcWorker) << "[Worker] runStep2 finished, ok=" << r2.ok << ", seconds=" << r2.seconds;
     double totalSeconds = r1.seconds + r2.seconds;
+    if (r2.cancelled) {
+        emit finished(false, "训练已取消！", totalSeconds, r1.seconds, r2.seconds,
+                     r1.startTime, r1.endTime, r2.startTime, r2.endTime);
+        return;
+    }
     if (!r2.ok) { 
-        qDebug() << "[Worker] Step 2 failed";
+        qCWarning(lcWorker) << "[Worker] Step 2 failed";
         emit finished(false, "train_menet.exe 运行失败！", totalSeconds, r1.seconds, r2.seconds,
                      r1.startTime, r1.endTime, r2.startTime, r2.endTime); 
         return; 
     }
     
-    qDebug() << "[Worker] Both steps completed successfully";
-    emit finished(true, "模型训练已完成！", totalSeconds, r1.seconds, r2.seconds,
+    qCInfo(lcWorker) << "[Worker] Both steps completed successfully";
+    emit finished(true, r2.stoppedEarly ? "模型训练已提前停止！" : "模型训练已完成！", totalSeconds, r1.seconds, r2.seconds,
                  r1.startTime, r1.endTime, r2.startTime, r2.endTime);
 }
 
@@ -99,13 +146,14 @@ StepResult Worker::runStep(const QString &exe, const QString &log, const QString
     QElapsedTimer timer;
     timer.start();
     QDateTime startTime = QDateTime::currentDateTime();
-    qDebug() << "[Worker] runStep:" << exe << log << json << pheno;
-    qDebug() << "[Worker] Start time:" << startTime.toString("yyyy-MM-dd hh:mm:ss");
+    if (progressChannel) progressChannel->setStage(isStep1 ? "step1" : "step2");
+    qCDebug(lcWorker) << "[Worker] runStep:" << exe << log << json << pheno;
+    qCDebug(lcWorker) << "[Worker] Start time:" << startTime.toString("yyyy-MM-dd hh:mm:ss");
     
     // 读取配置获取总epoch数
     QFile jsonFile(json);
     if (!jsonFile.open(QIODevice::ReadOnly)) { 
-        qDebug() << "[Worker] Failed to open json:" << json;
+        qCWarning(lcWorker) << "[Worker] Failed to open json:" << json;
         return {false, 0.0}; 
     }
     QJsonDocument doc = QJsonDocument::fromJson(jsonFile.readAll());
@@ -122,34 +170,104 @@ StepResult Worker::runStep(const QString &exe, const QString &log, const QString
     QProcess process;
     process.setWorkingDirectory(QFileInfo(exe).absolutePath());
     process.setProcessChannelMode(QProcess::MergedChannels);
-    qDebug() << "[Worker] Starting process:" << exe;
-    qDebug() << "[Worker] Working directory:" << QFileInfo(exe).absolutePath();
-    qDebug() << "[Worker] Arguments:" << (QStringList() << "--phenotype" << pheno);
-    process.start(exe, QStringList() << "--phenotype" << pheno);
+    qCInfo(lcWorker) << "[Worker] Starting process:" << exe;
+    qCDebug(lcWorker) << "[Worker] Working directory:" << QFileInfo(exe).absolutePath();
+    QStringList args = QStringList() << "--phenotype" << pheno;
+    if (!isStep1) args << step2ExtraArgs;
+    qCDebug(lcWorker) << "[Worker] Arguments:" << args;
+    if (!isStep1 && threadCount > 0) {
+        ProcessControl::setThreadEnvironment(process, threadCount);
+        qCDebug(lcWorker) << "[Worker] Thread count:" << threadCount;
+    }
+    ResourceControl::instance()->prepareProcess(process, isStep1 ? "step1" : "train");
+    process.start(exe, args);
     if (!process.waitForStarted()) { 
-        qDebug() << "[Worker] Failed to start process:" << exe;
-        qDebug() << "[Worker] Error:" << process.errorString();
+        qCWarning(lcWorker) << "[Worker] Failed to start process:" << exe;
+        qCWarning(lcWorker) << "[Worker] Error:" << process.errorString();
         return {false, 0.0}; 
     }
-    qDebug() << "[Worker] Process started, PID:" << process.processId();
+    qCInfo(lcWorker) << "[Worker] Process started, PID:" << process.processId();
+    emit processStarted(QFileInfo(exe).fileName() + " --phenotype " + pheno);
+    emit childStarted(process.processId());
+    // 输出边产生边取走：最近的部分留在固定大小的环形缓冲里，更早的压缩写盘
+    const QString spillPath = QFileInfo(exe).absolutePath() + "/logs/output/" + pheno
+        + (isStep1 ? "_step1_" : "_step2_") + startTime.toString("yyyyMMdd_hhmmss") + ".zlog";
+    OutputCapture capture(spillPath);
+    QByteArray consolePending;
+    QElapsedTimer consoleTimer;
+    consoleTimer.start();
+    auto drainOutput = [&](bool flush) {
+        const QByteArray chunk = process.readAll();
+        if (!chunk.isEmpty()) {
+            capture.append(chunk);
+            consolePending += chunk;
+            // 界面来不及消费时只保留最新的一段，完整内容在capture里
+            if (consolePending.size() > OutputCapture::kSpillChunkBytes) {
+                consolePending.remove(0, consolePending.size() - OutputCapture::kSpillChunkBytes);
+            }
+        }
+        if (!consolePending.isEmpty() && (flush || consoleTimer.elapsed() >= 100)) {
+            emit outputReceived(consolePending);
+            consolePending.clear();
+            consoleTimer.restart();
+        }
+    };
     // 监控进度（只在进程运行时解析log）
     int lastEpoch = -1;
-    qDebug() << "[Worker] Starting monitoring loop for log:" << log << ", isStep1:" << isStep1;
+    qCDebug(lcWorker) << "[Worker] Starting monitoring loop for log:" << log << ", isStep1:" << isStep1;
     int lastPrintedReturned = INT_MIN;
+    // 第二步的日志增量读取，把每个epoch的指标推给实时曲线和早停规则
+    LogFollower follower(log);
+    EarlyStopper stopper(earlyStopConfig);
+    auto emitNewMetrics = [&](bool drain) {
+        if (isStep1) return;
+        for (const QString &line : drain ? follower.drainAll() : follower.readNewLines()) {
+            EpochMetrics metrics;
+            if (!parseEpochMetrics(line, metrics)) continue;
+            if (progressChannel) progressChannel->publishEpoch(metrics);
+            emit epochMetrics(metrics);
+            if (metrics.values.contains("val_R2")) stopper.observe(metrics.epoch, metrics.values.value("val_R2"));
+        }
+    };
+    bool cancelled = false;
+    bool stoppedEarly = false;
+    double stepPeakMB = 0.0;
+    const qint64 pid = process.processId();
+    QElapsedTimer pollTimer;
+    pollTimer.start();
     while (process.state() == QProcess::Running) {
-        process.waitForFinished(500);
+        // 有输出就立即醒来取走，避免堆积在QProcess的缓冲里；其余检查仍按500ms一轮
+        process.waitForReadyRead(100);
+        drainOutput(false);
+        if (process.state() == QProcess::Running && pollTimer.elapsed() < 500) continue;
+        pollTimer.restart();
+        // 峰值内存只能在进程还活着时读取，每轮采样一次
+        if (process.state() == QProcess::Running) stepPeakMB = qMax(stepPeakMB, ProcessControl::peakMemoryMB(pid));
+        emitNewMetrics(false);
+        if (cancelRequested) {
+            qCInfo(lcWorker) << "[Worker] Cancel requested, terminating:" << exe;
+            ProcessControl::terminateTree(process);
+            cancelled = true;
+            break;
+        }
+        if (stopper.hasFired()) {
+            qCInfo(lcWorker) << "[Worker] Early stopping fired, best epoch:" << stopper.bestEpoch() << ", best val_R2:" << stopper.bestValue();
+            ProcessControl::terminateTree(process);
+            stoppedEarly = true;
+            break;
+        }
         int curEpoch = parseEpoch(log);
         if (curEpoch != lastPrintedReturned) {
-            qDebug() << "[Worker] parseEpoch returned:" << curEpoch << "for log:" << log;
+            qCDebug(lcProgress) << "[Worker] parseEpoch returned:" << curEpoch << "for log:" << log;
             lastPrintedReturned = curEpoch;
         }
         if (curEpoch > lastEpoch) {
             lastEpoch = curEpoch;
             // 优化进度百分比计算：(curEpoch+1)/(totalEpoch+1)
             int percent = qMin(100, (int)(((curEpoch + 1) * 100.0) / (totalEpoch + 1)));
-            qDebug() << "[Worker] Step progress:" << percent << "% , isStep1:" << isStep1;
+            qCDebug(lcProgress) << "[Worker] Step progress:" << percent << "% , isStep1:" << isStep1;
             current_progress = calculateOverallProgress(percent, isStep1);
-            qDebug() << "[Worker] Overall progress:" << current_progress << "%";
+            qCDebug(lcProgress) << "[Worker] Overall progress:" << current_progress << "%";
             emit sendProgressSignal();
         }
         // 如果已经到最后一个epoch，提前跳出循环
@@ -157,35 +275,47 @@ StepResult Worker::runStep(const QString &exe, const QString &log, const QString
             break;
         }
     }
-    // 等进程完全退出
-    if (process.state() != QProcess::NotRunning) {
-        process.waitForFinished(-1);
+    // 等进程完全退出，期间的输出照常取走
+    while (process.state() != QProcess::NotRunning) {
+        process.waitForReadyRead(200);
+        drainOutput(false);
     }
+    drainOutput(true);
+    capture.finish();
+    if (capture.hasSpilled()) emit outputSpilled(capture.spillPath());
+    // 上一轮之后可能又写了超过4MB，读到末尾，最后几个epoch的指标不丢
+    emitNewMetrics(true);
+    emit peakMemory(stepPeakMB);
     // 进程结束后，做一次最终进度
     current_progress = calculateOverallProgress(100, isStep1);
-    qDebug() << "[Worker] Final progress for step (isStep1=" << isStep1 << "):" << current_progress << "%";
+    qCDebug(lcProgress) << "[Worker] Final progress for step (isStep1=" << isStep1 << "):" << current_progress << "%";
     emit sendProgressSignal();
     QDateTime endTime = QDateTime::currentDateTime();
-    qDebug() << "[Worker] Process finished, exitCode:" << process.exitCode() << ", exitStatus:" << process.exitStatus();
-    qDebug() << "[Worker] End time:" << endTime.toString("yyyy-MM-dd hh:mm:ss");
-    // 捕获进程的所有输出
-    QByteArray allOutput = process.readAll();
-    if (!allOutput.isEmpty()) {
-        qDebug() << "[Worker] Process output:";
-        qDebug().noquote() << QString::fromLocal8Bit(allOutput);
+    qCInfo(lcWorker) << "[Worker] Process finished, exitCode:" << process.exitCode() << ", exitStatus:" << process.exitStatus();
+    qCDebug(lcWorker) << "[Worker] End time:" << endTime.toString("yyyy-MM-dd hh:mm:ss");
+    // 调试日志里只记录输出的最后一段，完整输出见控制台/溢出文件
+    if (capture.totalBytes() > 0 && lcWorker().isDebugEnabled()) {
+        qCDebug(lcWorker) << "[Worker] Process output:" << capture.totalBytes() << "bytes, last 50 lines:";
+        for (const QString &line : capture.lastLines(50)) {
+            qCDebug(lcWorker).noquote() << line;
+        }
+    }
+    if (capture.hasSpilled()) qCInfo(lcWorker) << "[Worker] Full output saved to:" << capture.spillPath();
+    if (cancelled) {
+        return {false, timer.elapsed() / 1000.0, startTime, endTime, false, true};
+    }
+    // 早停是我们主动终止的，退出码不代表失败；保留子进程已保存的最佳模型
+    if (stoppedEarly) {
+        emit earlyStopped(stopper.bestEpoch(), stopper.bestValue());
+        return {true, timer.elapsed() / 1000.0, startTime, endTime, true, false};
     }
     // 如果进程失败，输出日志最后20行，并立即return
     if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
-        QFile flog(log);
-        if (flog.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QStringList lines;
-            QTextStream ts(&flog);
-            while (!ts.atEnd()) lines << ts.readLine();
-            int n = lines.size();
-            qDebug() << "[Worker] Last 20 lines of log:";
-            for (int i = qMax(0, n-20); i < n; ++i) {
-                qDebug().noquote() << lines[i];
-            }
+        // 从文件末尾倒着读，日志再大也只读最后几块
+        const QStringList lines = LogTail::lastLines(log, 20);
+        qCWarning(lcWorker) << "[Worker] Last 20 lines of log:";
+        for (const QString &line : lines) {
+            qCWarning(lcWorker).noquote() << line;
         }
         double seconds = timer.elapsed() / 1000.0;
         return {false, seconds, startTime, endTime};
@@ -195,28 +325,11 @@ StepResult Worker::runStep(const QString &exe, const QString &log, const QString
 }
 
 int Worker::parseEpoch(const QString &log) {
-    static QMap<QString, int> lastPrintedEpoch; // 记录每个log文件上次打印的epoch
-    QFile f(log);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) { 
-        if (lastPrintedEpoch.value(log, INT_MIN) != -2) {
-            qDebug() << "[Worker] parseEpoch failed to open log:" << log;
-            lastPrintedEpoch[log] = -2;
-        }
-        return -1; 
-    }
-    int lastEpoch = -1;
-    QTextStream in(&f);
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QRegularExpression re("epoch = (\\d+)");
-        auto match = re.match(line);
-        if (match.hasMatch()) {
-            lastEpoch = match.captured(1).toInt();
-        }
-    }
-    // 只有epoch变化时才打印
-    if (lastPrintedEpoch.value(log, INT_MIN) != lastEpoch) {
-        qDebug() << "[Worker] parseEpoch lastEpoch:" << lastEpoch << ", log:" << log;
+    // 只从日志末尾往前找最后一个epoch行，不再每轮整读一遍
+    const int lastEpoch = lastEpochInLog(log);
+    // 只有epoch变化时才打印；progress分类关闭时连比较都省掉
+    if (lcProgress().isDebugEnabled() && lastPrintedEpoch.value(log, INT_MIN) != lastEpoch) {
+        qCDebug(lcProgress) << "[Worker] parseEpoch lastEpoch:" << lastEpoch << ", log:" << log;
         lastPrintedEpoch[log] = lastEpoch;
     }
     return lastEpoch;
@@ -3,17 +3,24 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
+#include <QMap>
+#include <atomic>
+#include <memory>
+#include "metricparser.h"
+#include "earlystopper.h"
+#include "progresschannel.h"
 
 struct StepResult {
     bool ok;
     double seconds;
     QDateTime startTime;
     QDateTime endTime;
+    bool stoppedEarly = false; // 被早停规则终止（保留当前最佳模型，按成功处理）
+    bool cancelled = false;    // 被用户取消
 };
 
-class MainWindow; // 前向声明
-
 class Worker : public QObject
 {
     Q_OBJECT
@@ -21,7 +28,12 @@ class Worker : public QObject
 public:
     explicit Worker(QObject *parent = nullptr);
     void setParams(const QString &exe1, const QString &exe2, const QString &log1, const QString &log2, const QString &json1, const QString &json2, const QString &pheno);
-    void setMainWindow(MainWindow *mainWin); // 设置主窗口指针
+    void setEarlyStopping(const EarlyStopper::Config &config); // 第二步的早停规则
+    void requestCancel(); // 线程安全：终止正在运行的子进程树
+    void setResume(bool skipStep1, const QStringList &step2ExtraArgs); // 续跑：跳过已完成的第一步、从checkpoint续训
+    void setStep1Weight(double weight); // 第一步在进度条上占的比例（0-1），按预计耗时分配
+    void setProgressChannel(std::shared_ptr<ProgressChannel> channel); // 进度和epoch指标同时发布到该通道，界面按帧率读取
+    void setThreadCount(int threads); // 第二步的OMP/MKL线程数，0表示由子进程自己决定
     
 public slots:
     void run();
@@ -29,14 +41,30 @@ public slots:
     
 signals:
     void sendProgressSignal(); // 内部信号
+    void progressChanged(int percent); // 整体进度0-100，界面和agent各自连接
+    void epochMetrics(const EpochMetrics &metrics); // 第二步日志中新解析出的每个epoch指标
+    void earlyStopped(int bestEpoch, double bestValR2); // 早停触发，在finished之前发出
+    void step1Completed(); // 第一步成功结束（或被跳过），供作业日志记录阶段
+    void peakMemory(double megabytes); // 每一步结束时发出该步子进程树的峰值内存，在finished之前
+    void processStarted(const QString &title);     // 子进程启动，控制台据此插入分隔行
+    void childStarted(qint64 pid);                 // 子进程（进程组长）的PID，内存准入据此扣除已用内存
+    void outputReceived(const QByteArray &data);   // 子进程输出，最多每100ms合并发出一次
+    void outputSpilled(const QString &spillPath);  // 输出超出内存缓冲，完整内容已压缩保存到该文件
     void finished(bool success, const QString &msg, double seconds, double exe1Seconds, double exe2Seconds, 
                  const QDateTime &step1Start, const QDateTime &step1End, 
                  const QDateTime &step2Start, const QDateTime &step2End);
     
 private:
     QString exePath1, exePath2, logPath1, logPath2, jsonPath1, jsonPath2, phenotype;
-    MainWindow *main_window; // 主窗口指针
     int current_progress; // 当前进度值
+    EarlyStopper::Config earlyStopConfig;
+    std::atomic<bool> cancelRequested{false};
+    bool skipStep1 = false;
+    double step1Weight = 0.5;
+    int threadCount = 0;
+    QStringList step2ExtraArgs;
+    std::shared_ptr<ProgressChannel> progressChannel;
+    QMap<QString, int> lastPrintedEpoch; // 每个log文件上次打印的epoch；agent里多个Worker并行，不能共用
     
     StepResult runStep(const QString &exe, const QString &log, const QString &json, const QString &pheno, bool isStep1);
     int parseEpoch(const QString &log);